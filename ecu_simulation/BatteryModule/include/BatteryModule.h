@@ -123,7 +123,7 @@ public:
     int getBatterySocket() const;
 
     /**
-     * @brief Write the default_did or the date before reset in battery_data.txt
+     * @brief Write the default_did or the data kept by a key off reset in battery_data.db
      * 
      */
     void writeDataToFile();
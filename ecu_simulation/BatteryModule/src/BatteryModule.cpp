@@ -1,4 +1,5 @@
 #include "BatteryModule.h"
+#include "DidStore.h"
 
 
 Logger* batteryModuleLogger = nullptr;
@@ -12,6 +13,7 @@ std::unordered_map<uint16_t, std::vector<uint8_t>> BatteryModule::default_DID_ba
         {0x01E0, {0}},   /* Temperature (C) */
         {0x01F0, {0}},   /* Life cycle */
         {0xE001, {0}},   /* OTA Status */
+        {0xE002, {0}},   /* OTA Transfer Checkpoint */
 #ifdef SOFTWARE_VERSION
         {0xF1A2, {static_cast<uint8_t>(SOFTWARE_VERSION)}}
 #else
@@ -170,45 +172,19 @@ void BatteryModule::parseBatteryInfo(const std::string &data, float &energy, flo
         }
     }
 
-    /* Path to battery data file */
-    std::string file_path = "battery_data.txt";
-
-    /* Read the current file contents into memory */
-    std::ifstream infile(file_path);
-    std::stringstream buffer;
-    buffer << infile.rdbuf();
-    infile.close();
-
-    std::string file_contents = buffer.str();
-    std::istringstream file_stream(file_contents);
-    std::string updated_file_contents;
-    std::string file_line;
-
-    /* Update the relevant DID values in the file contents */
-    while (std::getline(file_stream, file_line))
+    /* Write the new values in the DID database, the text holds the bytes in hex */
+    DidStore& store = DidStore::forFile("battery_data.db");
+    for (const auto &pair : updated_values)
     {
-        bool updated = false;
-        for (const auto &pair : updated_values)
-        {
-            std::stringstream did_ss;
-            did_ss << std::hex << std::setw(4) << std::setfill('0') << std::uppercase << pair.first;
-            if (file_line.find(did_ss.str()) != std::string::npos)
-            {
-                updated_file_contents += did_ss.str() + " " + pair.second + "\n";
-                updated = true;
-                break;
-            }
-        }
-        if (!updated)
+        std::istringstream value_stream(pair.second);
+        std::vector<uint8_t> value;
+        int byte;
+        while (value_stream >> std::hex >> byte)
         {
-            updated_file_contents += file_line + "\n";
+            value.push_back(static_cast<uint8_t>(byte));
         }
+        store.set(pair.first, value);
     }
-
-    /* Write the updated contents back to the file */
-    std::ofstream outfile(file_path);
-    outfile << updated_file_contents;
-    outfile.close();
 }
 
 /* Function to fetch data from system about battery */
@@ -267,47 +243,9 @@ int BatteryModule::getBatterySocket() const
 
 void BatteryModule::writeDataToFile()
 {
-    /* Insert the default DID values in the file */
-    std::ofstream outfile("battery_data.txt");
-    if (!outfile.is_open())
-    {
-        throw std::runtime_error("Failed to open file: battery_data.txt");
-    }
-
-    /* Check if old_battery_data.txt exists */
-    std::string old_file_path = "old_battery_data.txt";
-    std::ifstream infile(old_file_path);
-
-    if (infile.is_open())
+    /* Values kept by a key off reset, default values otherwise; an interrupted OTA transfer resumes after any restart */
+    if (!DidStore::restore("battery_data.db", default_DID_battery, {OTA_TRANSFER_CHECKPOINT_DID}))
     {
-        /* Read the current file contents into memory */
-        std::stringstream buffer;
-        /* Read the entire file into the buffer */
-        buffer << infile.rdbuf();
-        infile.close();
-
-        /* Store the original content */
-        std::string original_file_contents = buffer.str();
-
-        /* Write the content of old_mcu_data.txt into mcu_data.txt */
-        outfile << original_file_contents;
-
-        /* Delete the old file after reading its contents */
-        std::remove(old_file_path.c_str());
-        outfile.close();
-    }
-    else
-    {
-        for (const auto& [data_identifier, data] : default_DID_battery)
-        {
-            outfile << std::hex << std::setw(4) << std::setfill('0') << std::uppercase << data_identifier << " ";
-            for (uint8_t byte : data)
-            {
-                outfile << std::hex << std::setw(1) << std::setfill('0') << static_cast<int>(byte) << " ";
-            }
-            outfile << "\n";
-        }
-        outfile.close();
         fetchBatteryData("r");
     }
 }
@@ -316,7 +254,7 @@ void BatteryModule::checkDTC()
 {
     /* Check if dtcs.txt exists */
     std::string dtc_file_path = std::string(PROJECT_PATH) + "/backend/ecu_simulation/BatteryModule/dtcs.txt";
-    std::string battery_file_path = std::string(PROJECT_PATH) + "/backend/ecu_simulation/BatteryModule/battery_data.txt";
+    std::string battery_file_path = std::string(PROJECT_PATH) + "/backend/ecu_simulation/BatteryModule/battery_data.db";
     std::ifstream infile(dtc_file_path);
 
     if (!infile.is_open())
@@ -337,8 +275,8 @@ void BatteryModule::checkDTC()
     {
         infile.close();
     }
-    /* Read the map with DIDs from the file */
-    std::unordered_map<uint16_t, std::vector<uint8_t>> current_DID_value = FileManager::readMapFromFile(battery_file_path);
+    /* Map with the DIDs, including the writes not on the file yet */
+    std::unordered_map<uint16_t, std::vector<uint8_t>> current_DID_value = DidStore::forFile(battery_file_path).snapshot();
 
     /* Voltage DTC */
     FileManager::writeDTC(current_DID_value, dtc_file_path, 0x01B0, 12, 13, "P01B0 24");
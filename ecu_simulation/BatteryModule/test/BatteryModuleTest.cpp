@@ -1,5 +1,6 @@
 #include <gtest/gtest.h>
 #include "../include/BatteryModule.h"
+#include "DidStore.h"
 
 bool containsLine(const std::string& output, const std::string& line)
 {
@@ -27,7 +28,7 @@ TEST_F(BatteryModuleTest, ExecFunctionThrow)
 
 TEST_F(BatteryModuleTest, ParseBatteryInfo)
 {
-    auto data_map = FileManager::readMapFromFile("battery_data.txt");
+    auto data_map = DidStore::forFile("battery_data.db").snapshot();
     std::vector<uint8_t> response = data_map[0x01A0];
 
     std::ostringstream oss;
@@ -143,11 +144,15 @@ TEST_F(BatteryModuleTest, CheckPendingDischargeState)
     EXPECT_EQ(state, "pending-discharge");
 }
 
-TEST_F(BatteryModuleTest, CheckOldDataFile)
+TEST_F(BatteryModuleTest, CheckKeptData)
 {
-    std::ofstream outfile("old_battery_data.txt");
+    /* Values marked by a key off reset are kept when the module starts again */
+    DidStore::forFile("battery_data.db").set(0xE001, {0x12});
+    DidStore::forFile("battery_data.db").keepValuesOnRestart();
     battery->writeDataToFile();
-    outfile.close();
+    std::vector<uint8_t> value;
+    EXPECT_TRUE(DidStore::forFile("battery_data.db").get(0xE001, value));
+    EXPECT_EQ(value, std::vector<uint8_t>({0x12}));
 }
 
 TEST_F(BatteryModuleTest, checkDTCLogError)
@@ -178,16 +183,15 @@ TEST_F(BatteryModuleTest, checkDTCCreateFileSuccessfully)
 }
 TEST_F(BatteryModuleTest, BatteryDataFailed)
 {
-    std::string path = "battery_data.txt";
-    std::ofstream outfile(path);
-    chmod(path.c_str(), 0);
+    /* A directory in place of the DID database */
+    std::string path = "battery_data.db";
+    std::remove(path.c_str());
+    mkdir(path.c_str(), 0777);
     EXPECT_THROW(
     {
         battery->writeDataToFile();
     }, std::runtime_error);
-    path = "battery_data.txt";
-    chmod(path.c_str(), 0666);
-    outfile.close();
+    rmdir(path.c_str());
 }
 
 TEST_F(BatteryModuleTest, FetchException)
@@ -64,7 +64,7 @@ public:
     int getDoorsSocket() const;
 
     /**
-     * @brief Write the default_did or the date before reset in doors_data.txt
+     * @brief Write the default_did or the data kept by a key off reset in doors_data.db
      * 
      */
     void writeDataToFile();
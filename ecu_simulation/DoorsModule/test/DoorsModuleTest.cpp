@@ -8,6 +8,7 @@
 
 #include <gtest/gtest.h>
 #include "../include/DoorsModule.h"
+#include "DidStore.h"
 
 bool containsLine(const std::string& output, const std::string& line)
 {
@@ -34,25 +35,28 @@ TEST_F(DoorsModuleTest, DoorsSocket)
     });
 }
 
-TEST_F(DoorsModuleTest, CheckOldDataFile)
+TEST_F(DoorsModuleTest, CheckKeptData)
 {
-    std::ofstream outfile("old_doors_data.txt");
+    /* Values marked by a key off reset are kept when the module starts again */
+    DidStore::forFile("doors_data.db").set(0xE001, {0x12});
+    DidStore::forFile("doors_data.db").keepValuesOnRestart();
     doors->writeDataToFile();
-    outfile.close();
+    std::vector<uint8_t> value;
+    EXPECT_TRUE(DidStore::forFile("doors_data.db").get(0xE001, value));
+    EXPECT_EQ(value, std::vector<uint8_t>({0x12}));
 }
 
 TEST_F(DoorsModuleTest, DoorsDataFailed)
 {
-    std::string path = "doors_data.txt";
-    std::ofstream outfile(path);
-    chmod(path.c_str(), 0);
+    /* A directory in place of the DID database */
+    std::string path = "doors_data.db";
+    std::remove(path.c_str());
+    mkdir(path.c_str(), 0777);
     EXPECT_THROW(
     {
         doors->writeDataToFile();
     }, std::runtime_error);
-    path = "doors_data.txt";
-    chmod(path.c_str(), 0666);
-    outfile.close();
+    rmdir(path.c_str());
 }
 
 /* Main function to run all tests */
@@ -49,7 +49,7 @@ public:
     int getEngineSocket() const;
 
     /**
-     * @brief Write the default_did or the date before reset in engine_data.txt
+     * @brief Write the default_did or the data kept by a key off reset in engine_data.db
      * 
      */
     void writeDataToFile();
@@ -1,4 +1,5 @@
 #include "EngineModule.h"
+#include "DidStore.h"
 
 Logger* engineModuleLogger = nullptr;
 EngineModule* engine = nullptr;
@@ -24,6 +25,8 @@ std::unordered_map<uint16_t, std::vector<uint8_t>> EngineModule::default_DID_eng
         {0x0130, {0}},
         /* OTA Status */
         {0xE001, {0}},
+        /* OTA Transfer Checkpoint */
+        {0xE002, {0}},
 #ifdef SOFTWARE_VERSION
         {0xF1A2, {static_cast<uint8_t>(SOFTWARE_VERSION)}}
 #else
@@ -50,59 +53,23 @@ EngineModule::~EngineModule()
 
 void EngineModule::fetchEngineData()
 {
-    /* Path to engine data file */
-    std::string file_path = "engine_data.txt";
-
     /* Generate random values for each DID */
-    std::unordered_map<uint16_t, std::string> updated_values;
     std::random_device rd;
     std::mt19937 gen(rd());
     std::uniform_int_distribution<> dist(0, 255);
 
+    DidStore& store = DidStore::forFile("engine_data.db");
     for (auto& [did, data] : default_DID_engine)
     {
-        std::stringstream data_ss;
         for (auto& byte : data)
         {
-            byte = dist(gen);  
             /* Generate a random value between 0 and 255 */
-            data_ss << std::hex << std::setw(2) << std::setfill('0') << std::uppercase << static_cast<int>(byte) << " ";
+            byte = dist(gen);
         }
-        updated_values[did] = data_ss.str();
+        store.set(did, data);
     }
 
-    /* Read the current file contents into memory */
-    std::ifstream infile(file_path);
-    std::stringstream buffer;
-    buffer << infile.rdbuf();
-    infile.close();
-
-    std::string file_contents = buffer.str();
-    std::istringstream file_stream(file_contents);
-    std::string updated_file_contents;
-    std::string file_line;
-
-    /* Update the relevant DID values in the file contents */
-    while (std::getline(file_stream, file_line))
-    {
-        for (const auto& pair : updated_values)
-        {
-            std::stringstream did_ss;
-            did_ss << std::hex << std::setw(4) << std::setfill('0') << std::uppercase << pair.first;
-            if (file_line.find(did_ss.str()) != std::string::npos)
-            {
-                updated_file_contents += did_ss.str() + " " + pair.second + "\n";
-                break;
-            }
-        }
-    }
-
-    /* Write the updated contents back to the file */
-    std::ofstream outfile(file_path);
-    outfile << updated_file_contents;
-    outfile.close();
-
-    LOG_INFO(engineModuleLogger->GET_LOGGER(), "Engine data file updated with random values.");
+    LOG_INFO(engineModuleLogger->GET_LOGGER(), "Engine DID database updated with random values.");
 }
 
 int EngineModule::getEngineSocket() const
@@ -112,47 +79,9 @@ int EngineModule::getEngineSocket() const
 
 void EngineModule::writeDataToFile()
 {
-    /* Insert the default DID values in the file */
-    std::ofstream outfile("engine_data.txt");
-    if (!outfile.is_open())
-    {
-        throw std::runtime_error("Failed to open file: engine_data.txt");
-    }
-
-    /* Check if old_engine_data.txt exists */
-    std::string old_file_path = "old_engine_data.txt";
-    std::ifstream infile(old_file_path);
-
-    if (infile.is_open())
+    /* Values kept by a key off reset, default values otherwise; an interrupted OTA transfer resumes after any restart */
+    if (!DidStore::restore("engine_data.db", default_DID_engine, {OTA_TRANSFER_CHECKPOINT_DID}))
     {
-        /* Read the current file contents into memory */
-        std::stringstream buffer;
-        /* Read the entire file into the buffer */
-        buffer << infile.rdbuf();
-        infile.close();
-
-        /* Store the original content */
-        std::string original_file_contents = buffer.str();
-
-        /* Write the content of old_mcu_data.txt into mcu_data.txt */
-        outfile << original_file_contents;
-
-        /* Delete the old file after reading its contents */
-        std::remove(old_file_path.c_str());
-        outfile.close();
-    }
-    else
-    {
-        for (const auto& [data_identifier, data] : default_DID_engine)
-        {
-            outfile << std::hex << std::setw(4) << std::setfill('0') << std::uppercase << data_identifier << " ";
-            for (uint8_t byte : data)
-            {
-                outfile << std::hex << std::setw(1) << std::setfill('0') << static_cast<int>(byte) << " ";
-            }
-            outfile << "\n";
-        }
-        outfile.close();
         fetchEngineData();
     }
 }
@@ -161,7 +90,7 @@ void EngineModule::checkDTC()
 {      
     /* Check if dtcs.txt exists */
     std::string dtc_file_path = std::string(PROJECT_PATH) + "/backend/ecu_simulation/EngineModule/dtcs.txt";
-    std::string engine_file_path = std::string(PROJECT_PATH) + "/backend/ecu_simulation/EngineModule/engine_data.txt";
+    std::string engine_file_path = std::string(PROJECT_PATH) + "/backend/ecu_simulation/EngineModule/engine_data.db";
     std::ifstream infile(dtc_file_path);
 
     if (!infile.is_open())
@@ -182,8 +111,8 @@ void EngineModule::checkDTC()
     {
         infile.close();
     }
-    /* Read the map with DIDs from the file */
-    std::unordered_map<uint16_t, std::vector<uint8_t>> current_DID_value = FileManager::readMapFromFile(engine_file_path);
+    /* Map with the DIDs, including the writes not on the file yet */
+    std::unordered_map<uint16_t, std::vector<uint8_t>> current_DID_value = DidStore::forFile(engine_file_path).snapshot();
 
     /* Fuel Pressure DTC*/
     FileManager::writeDTC(current_DID_value, dtc_file_path, 0x012C, 30, 50, "P0190 24");
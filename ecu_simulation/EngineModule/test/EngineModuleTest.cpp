@@ -1,5 +1,6 @@
 #include <gtest/gtest.h>
 #include "../include/EngineModule.h"
+#include "DidStore.h"
 
 bool containsLine(const std::string& output, const std::string& line)
 {
@@ -27,11 +28,15 @@ TEST_F(EngineModuleTest, EngineSocket)
     });
 }
 
-TEST_F(EngineModuleTest, CheckOldDataFile)
+TEST_F(EngineModuleTest, CheckKeptData)
 {
-    std::ofstream outfile("old_engine_data.txt");
+    /* Values marked by a key off reset are kept when the module starts again */
+    DidStore::forFile("engine_data.db").set(0xE001, {0x12});
+    DidStore::forFile("engine_data.db").keepValuesOnRestart();
     engine->writeDataToFile();
-    outfile.close();
+    std::vector<uint8_t> value;
+    EXPECT_TRUE(DidStore::forFile("engine_data.db").get(0xE001, value));
+    EXPECT_EQ(value, std::vector<uint8_t>({0x12}));
 }
 
  TEST_F(EngineModuleTest, checkDTCLogError)
@@ -63,16 +68,15 @@ TEST_F(EngineModuleTest, checkDTCCreateFileSuccessfully)
 
 TEST_F(EngineModuleTest, BatteryDataFailed)
 {
-    std::string path = "engine_data.txt";
-    std::ofstream outfile(path);
-    chmod(path.c_str(), 0);
+    /* A directory in place of the DID database */
+    std::string path = "engine_data.db";
+    std::remove(path.c_str());
+    mkdir(path.c_str(), 0777);
     EXPECT_THROW(
     {
         engine->writeDataToFile();
     }, std::runtime_error);
-    path = "engine_data.txt";
-    chmod(path.c_str(), 0666);
-    outfile.close();
+    rmdir(path.c_str());
 }
 
 
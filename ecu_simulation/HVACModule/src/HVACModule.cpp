@@ -1,4 +1,5 @@
 #include "HVACModule.h"
+#include "DidStore.h"
 
 Logger *hvacModuleLogger = nullptr;
 HVACModule *hvac = nullptr;
@@ -11,6 +12,7 @@ std::unordered_map<uint16_t, std::vector<uint8_t>> HVACModule::default_DID_hvac
         {FAN_SPEED_DID, {DEFAULT_DID_VALUE}}, /* Fan speed (Duty cycle) */
         {HVAC_MODES_DID, {DEFAULT_DID_VALUE}},  /* HVAC modes */
         {0xE001, {0}}, /* OTA Status */
+        {0xE002, {0}}, /* OTA Transfer Checkpoint */
 #ifdef SOFTWARE_VERSION
         {0xF1A2, {static_cast<uint8_t>(SOFTWARE_VERSION)}}
 #else
@@ -34,48 +36,13 @@ void HVACModule::fetchHvacData()
 {
     generateData();
 
-    /* Path to engine data file */
-    std::string file_path = "hvac_data.txt";
-
-    /* Read the current file contents into memory */
-    std::ifstream infile(file_path);
-    std::stringstream buffer;
-    buffer << infile.rdbuf();
-    infile.close();
-
-    std::string file_contents = buffer.str();
-    std::istringstream file_stream(file_contents);
-    std::string updated_file_contents;
-    std::string file_line;
-
-    /* Update the relevant DID values in the file contents */
-    while (std::getline(file_stream, file_line))
+    DidStore& store = DidStore::forFile("hvac_data.db");
+    for (const auto& [did, data] : default_DID_hvac)
     {
-        for (const auto& pair : default_DID_hvac)
-        {
-            std::stringstream did_ss;
-            did_ss << std::hex << std::setw(4) << std::setfill('0') << std::uppercase << pair.first;
-            if (to_lowercase(file_line).find(to_lowercase(did_ss.str())) != std::string::npos)
-                {
-                    /* Convert the vector<uint8_t> to a string */
-                    std::stringstream value_ss;
-                    for (const auto& byte : pair.second)
-                    {
-                        value_ss << std::hex << std::setw(2) << std::setfill('0') << std::uppercase << static_cast<int>(byte);
-                    }
-
-                    updated_file_contents += did_ss.str() + " " + value_ss.str() + "\n";
-                    break;
-                }
-        }
+        store.set(did, data);
     }
 
-    /* Write the updated contents back to the file */
-    std::ofstream outfile(file_path);
-    outfile << updated_file_contents;
-    outfile.close();
-
-    LOG_INFO(_logger.GET_LOGGER(), "HVAC data file updated with random values.");
+    LOG_INFO(_logger.GET_LOGGER(), "HVAC DID database updated with random values.");
 }
 
 void HVACModule::generateData()
@@ -99,47 +66,9 @@ void HVACModule::generateData()
 
 void HVACModule::writeDataToFile()
 {
-    /* Insert the default DID values in the file */
-    std::ofstream hvac_data_file("hvac_data.txt");
-    if (!hvac_data_file.is_open())
-    {
-        throw std::runtime_error("Failed to open file: hvac_data.txt");
-    }
-
-    /* Check if old_hvac_data.txt exists */
-    std::string old_file_path = "old_hvac_data.txt";
-    std::ifstream infile(old_file_path);
-
-    if (infile.is_open())
-    {
-        /* Read the current file contents into memory */
-        std::stringstream buffer;
-        /* Read the entire file into the buffer */
-        buffer << infile.rdbuf();
-        infile.close();
-
-        /* Store the original content */
-        std::string original_file_contents = buffer.str();
-
-        /* Write the content of old_mcu_data.txt into mcu_data.txt */
-        hvac_data_file << original_file_contents;
-
-        /* Delete the old file after reading its contents */
-        std::remove(old_file_path.c_str());
-        hvac_data_file.close();
-    }
-    else
+    /* Values kept by a key off reset, default values otherwise; an interrupted OTA transfer resumes after any restart */
+    if (!DidStore::restore("hvac_data.db", default_DID_hvac, {OTA_TRANSFER_CHECKPOINT_DID}))
     {
-        for (const auto& [data_identifier, data] : default_DID_hvac)
-        {
-            hvac_data_file << std::hex << std::setw(4) << std::setfill('0') << data_identifier << " ";
-            for (uint8_t byte : data) 
-            {
-                hvac_data_file << std::hex << std::setw(2) << std::setfill('0') << static_cast<int>(byte) << " ";
-            }
-            hvac_data_file << "\n";
-        }
-        hvac_data_file.close();
         fetchHvacData();
     }
 }
@@ -8,6 +8,7 @@
 
 #include <gtest/gtest.h>
 #include "../include/HVACModule.h"
+#include "DidStore.h"
 
 bool containsLine(const std::string& output, const std::string& line)
 {
@@ -34,25 +35,28 @@ TEST_F(HVACModuleTest, HVACSocket)
     });
 }
 
-TEST_F(HVACModuleTest, CheckOldDataFile)
+TEST_F(HVACModuleTest, CheckKeptData)
 {
-    std::ofstream outfile("old_hvac_data.txt");
+    /* Values marked by a key off reset are kept when the module starts again */
+    DidStore::forFile("hvac_data.db").set(0xE001, {0x12});
+    DidStore::forFile("hvac_data.db").keepValuesOnRestart();
     hvac->writeDataToFile();
-    outfile.close();
+    std::vector<uint8_t> value;
+    EXPECT_TRUE(DidStore::forFile("hvac_data.db").get(0xE001, value));
+    EXPECT_EQ(value, std::vector<uint8_t>({0x12}));
 }
 
 TEST_F(HVACModuleTest, HVACDataFailed)
 {
-    std::string path = "hvac_data.txt";
-    std::ofstream outfile(path);
-    chmod(path.c_str(), 0);
+    /* A directory in place of the DID database */
+    std::string path = "hvac_data.db";
+    std::remove(path.c_str());
+    mkdir(path.c_str(), 0777);
     EXPECT_THROW(
     {
         hvac->writeDataToFile();
     }, std::runtime_error);
-    path = "hvac_data.txt";
-    chmod(path.c_str(), 0666);
-    outfile.close();
+    rmdir(path.c_str());
 }
 
 TEST_F(HVACModuleTest, HVACInfo)
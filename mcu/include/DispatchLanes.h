@@ -0,0 +1,127 @@
+/*
+ * The DispatchLanes library spreads the frames taken from the MCU processing queue over
+ * a small pool of worker threads, one lane per destination.
+ *
+ * Every frame is mapped to a lane by its (sender, receiver) pair:
+ *  - frames addressed to the MCU go to the MCU lane, so the MCU services run one at a time;
+ *  - frames addressed to the API go to the lane of the ECU that sent them;
+ *  - every other frame goes to the lane of its receiver.
+ * A pair always lands on the same lane and each lane is processed in order by one worker,
+ * so the order is kept per (sender, receiver) pair, while a slow service on one ECU
+ * (e.g. a flash) does not delay the traffic of the other ECUs.
+ *
+ * How to use example:
+ *    DispatchLanes lanes([](const TimestampedFrame& frame) { ... process ... });
+ *    lanes.start();
+ *    lanes.dispatch(frame);
+ *    lanes.stop();   // processes the frames left in the lanes, then joins the workers
+ *
+ * Author: Dirva Nicolae, 2024
+ */
+
+#ifndef POC_SRC_MCU_DISPATCH_LANES_H
+#define POC_SRC_MCU_DISPATCH_LANES_H
+
+#include <vector>
+#include <memory>
+#include <thread>
+#include <atomic>
+#include <functional>
+
+#include "FrameRingBuffer.h"
+
+/* One lane for the MCU and one for each of the four ECUs */
+#define DEFAULT_DISPATCH_LANES 5
+/* Frames a lane holds before dispatch() waits for its worker */
+#define DISPATCH_LANE_CAPACITY 256
+/* Interval used by the workers to check the stop flag */
+#define DISPATCH_TICK_MS 100
+
+namespace MCU
+{
+  class DispatchLanes
+  {
+  public:
+    /* Callback that processes one frame, called from the lane workers */
+    using FrameHandler = std::function<void(const TimestampedFrame&)>;
+
+    /**
+     * @brief Parameterized constructor. The workers are not started.
+     *
+     * @param handler The function called for every dispatched frame.
+     * @param lane_count Number of lanes (and worker threads).
+     */
+    explicit DispatchLanes(FrameHandler handler, size_t lane_count = DEFAULT_DISPATCH_LANES);
+
+    /**
+     * @brief Destructor. Stops the workers if they are still running.
+     */
+    ~DispatchLanes();
+
+    DispatchLanes(const DispatchLanes&) = delete;
+    DispatchLanes& operator=(const DispatchLanes&) = delete;
+
+    /**
+     * @brief Starts one worker thread per lane.
+     */
+    void start();
+
+    /**
+     * @brief Stops the workers after they processed the frames already dispatched.
+     */
+    void stop();
+
+    /**
+     * @brief Puts a frame on the lane of its (sender, receiver) pair. Waits while the lane is full.
+     *
+     * @param queued_frame The frame to be processed.
+     * @return Returns false if the lanes are stopped and the frame was not dispatched.
+     */
+    bool dispatch(const TimestampedFrame& queued_frame);
+
+    /**
+     * @brief Computes the lane used for a (sender, receiver) pair.
+     *
+     * @param sender_id The sender byte of the frame id.
+     * @param receiver_id The receiver byte of the frame id.
+     * @return Returns the lane index.
+     */
+    size_t laneFor(uint8_t sender_id, uint8_t receiver_id) const;
+
+    /**
+     * @brief Get method for the number of lanes.
+     *
+     * @return Returns the number of lanes.
+     */
+    size_t getLaneCount() const;
+
+    /**
+     * @brief Get method for the number of frames waiting on a lane.
+     *
+     * @param lane The lane index.
+     * @return Returns the occupancy of the lane.
+     */
+    size_t getLaneOccupancy(size_t lane) const;
+
+    /**
+     * @brief Checks if the workers are running.
+     *
+     * @return Returns true between start() and stop().
+     */
+    bool isRunning() const;
+
+  private:
+    FrameHandler handler;
+    std::vector<std::unique_ptr<FrameRingBuffer>> lanes;
+    std::vector<std::thread> workers;
+    std::atomic<bool> running{false};
+
+    /**
+     * @brief Worker loop: processes the frames of one lane in order until stopped and drained.
+     *
+     * @param lane The lane index.
+     */
+    void runLane(size_t lane);
+  };
+}
+#endif
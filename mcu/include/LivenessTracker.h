@@ -0,0 +1,213 @@
+/*
+ * The LivenessTracker library keeps track of the ECUs that are up.
+ *
+ * Every heartbeat (0xD9 frame) of an ECU pushes its next expiry in a min-heap, so the
+ * thread of the tracker sleeps exactly until the earliest deadline instead of scanning
+ * all the ECUs every second:
+ *  - when the heartbeat interval of an ECU elapses, a probe (0x99 frame) is sent to it;
+ *  - if the ECU does not answer within the probe timeout, it is marked as down.
+ * Each ECU can have its own heartbeat interval. Older heap entries of an ECU are left in
+ * the heap and discarded when they come up (they no longer match the ECU generation).
+ *
+ * The tracker has its own lock, so it never stalls the frame readers. The status of the
+ * ECUs is also published in a lock-free bitmap (bit 0 = 0x11, bit 1 = 0x12, ...) which
+ * is read directly by the 0x99 query of the API.
+ *
+ * How to use example:
+ *    LivenessTracker liveness([](uint8_t ecu_id) { ... send 0x99 to ecu_id ... });
+ *    liveness.start();
+ *    liveness.setHeartbeatInterval(0x11, 5000);
+ *    liveness.heartbeat(0x11);      // on every 0xD9 frame
+ *    liveness.isUp(0x11);
+ *    liveness.stop();
+ *
+ * Author: Dirva Nicolae, 2024
+ */
+
+#ifndef POC_SRC_MCU_LIVENESS_TRACKER_H
+#define POC_SRC_MCU_LIVENESS_TRACKER_H
+
+#include <array>
+#include <queue>
+#include <mutex>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <vector>
+#include <cstdint>
+#include <functional>
+#include <condition_variable>
+
+/* Time an ECU may stay silent before it is probed */
+#define DEFAULT_HEARTBEAT_INTERVAL_MS 120000
+/* Time an ECU has to answer a probe before it is marked as down */
+#define LIVENESS_PROBE_TIMEOUT_MS 500
+/* ECU id stored in bit 0 of the status bitmap */
+#define LIVENESS_FIRST_ECU_ID 0x11
+/* Number of ECU ids covered by the status bitmap */
+#define LIVENESS_BITMAP_SIZE 32
+
+namespace MCU
+{
+  class LivenessTracker
+  {
+  public:
+    using Clock = std::chrono::steady_clock;
+    /* Called from the tracker thread to send a probe to an ECU */
+    using ProbeCallback = std::function<void(uint8_t)>;
+    /* Called from the tracker thread when an ECU did not answer the probe */
+    using DownCallback = std::function<void(uint8_t)>;
+
+    /**
+     * @brief Parameterized constructor. The thread is not started.
+     *
+     * @param send_probe The function called to probe a silent ECU.
+     * @param on_down The function called when an ECU is marked as down (optional).
+     * @param default_interval_ms Heartbeat interval used for the ECUs without their own.
+     * @param probe_timeout_ms Time an ECU has to answer a probe.
+     */
+    explicit LivenessTracker(ProbeCallback send_probe, DownCallback on_down = nullptr,
+                             unsigned default_interval_ms = DEFAULT_HEARTBEAT_INTERVAL_MS,
+                             unsigned probe_timeout_ms = LIVENESS_PROBE_TIMEOUT_MS);
+
+    /**
+     * @brief Destructor. Stops the thread if it is still running.
+     */
+    ~LivenessTracker();
+
+    LivenessTracker(const LivenessTracker&) = delete;
+    LivenessTracker& operator=(const LivenessTracker&) = delete;
+
+    /**
+     * @brief Starts the tracker thread. Does nothing if it is already running.
+     */
+    void start();
+
+    /**
+     * @brief Stops the tracker thread. The status of the ECUs is kept.
+     */
+    void stop();
+
+    /**
+     * @brief Marks the ECU as up and pushes its next deadline.
+     *
+     * @param ecu_id The id of the ECU that sent the heartbeat.
+     */
+    void heartbeat(uint8_t ecu_id);
+
+    /**
+     * @brief Set method for the heartbeat interval of one ECU.
+     * Applied from the next heartbeat of the ECU.
+     *
+     * @param ecu_id The id of the ECU.
+     * @param interval_ms The new interval in milliseconds.
+     */
+    void setHeartbeatInterval(uint8_t ecu_id, unsigned interval_ms);
+
+    /**
+     * @brief Get method for the heartbeat interval of one ECU.
+     *
+     * @param ecu_id The id of the ECU.
+     * @return Returns the interval in milliseconds.
+     */
+    unsigned getHeartbeatInterval(uint8_t ecu_id) const;
+
+    /**
+     * @brief Checks if the ECU has a pending deadline (up, or probed and not answered yet).
+     *
+     * @param ecu_id The id of the ECU.
+     * @return Returns true if the ECU is tracked.
+     */
+    bool isTracked(uint8_t ecu_id) const;
+
+    /**
+     * @brief Get method for the current deadline of an ECU.
+     *
+     * @param ecu_id The id of the ECU.
+     * @return Returns the deadline, or a default time point if the ECU is not tracked.
+     */
+    Clock::time_point getDeadline(uint8_t ecu_id) const;
+
+    /**
+     * @brief Checks if the ECU is up. Lock-free.
+     *
+     * @param ecu_id The id of the ECU.
+     * @return Returns true if the bit of the ECU is set in the status bitmap.
+     */
+    bool isUp(uint8_t ecu_id) const;
+
+    /**
+     * @brief Get method for the status bitmap. Lock-free.
+     *
+     * @return Returns the bitmap, bit n set if ECU LIVENESS_FIRST_ECU_ID + n is up.
+     */
+    uint32_t getStatusBitmap() const;
+
+    /**
+     * @brief Get method for the number of entries in the heap (stale ones included).
+     *
+     * @return Returns the size of the heap.
+     */
+    size_t getHeapSize() const;
+
+    /**
+     * @brief Checks if the tracker thread is running.
+     *
+     * @return Returns true between start() and stop().
+     */
+    bool isRunning() const;
+
+  private:
+    struct Deadline
+    {
+      Clock::time_point expiry;
+      uint8_t ecu_id;
+      uint32_t generation;
+      bool operator>(const Deadline& other) const { return expiry > other.expiry; }
+    };
+
+    struct EcuState
+    {
+      Clock::time_point expiry;
+      uint32_t generation = 0;
+      unsigned interval_ms = 0;
+      bool tracked = false;
+      bool probed = false;
+    };
+
+    ProbeCallback send_probe;
+    DownCallback on_down;
+    unsigned default_interval_ms;
+    unsigned probe_timeout_ms;
+    std::priority_queue<Deadline, std::vector<Deadline>, std::greater<Deadline>> deadlines;
+    std::array<EcuState, 256> ecus;
+    std::atomic<uint32_t> status_bitmap{0};
+    mutable std::mutex liveness_mutex;
+    std::condition_variable wake_up;
+    std::thread worker;
+    std::atomic<bool> running{false};
+
+    /**
+     * @brief Thread loop: sleeps until the earliest deadline and handles the expired ones.
+     */
+    void run();
+
+    /**
+     * @brief Pushes the deadline of an ECU and wakes the thread if it is the earliest one.
+     * Called with liveness_mutex locked.
+     *
+     * @param ecu_id The id of the ECU.
+     * @param expiry The new deadline of the ECU.
+     */
+    void pushDeadline(uint8_t ecu_id, Clock::time_point expiry);
+
+    /**
+     * @brief Sets or clears the bit of an ECU in the status bitmap.
+     *
+     * @param ecu_id The id of the ECU.
+     * @param up The new status.
+     */
+    void setStatus(uint8_t ecu_id, bool up);
+  };
+}
+#endif
@@ -15,6 +15,7 @@
 
 #include <thread>
 #include <future>
+#include <array>
 #include <fstream>
 #include <stdexcept>
 #include <filesystem>
@@ -23,12 +24,11 @@ namespace MCU
 {
     class MCUModule {
     public:
-        /* Static dictionary to store SID and processing time */
-        static std::map<uint8_t, double> timing_parameters;
-        /* Store active timers for SIDs */
-        static std::map<uint8_t, std::future<void>> active_timers;
-        /* Stop flags for each SID. */
-        static std::map<uint8_t, std::atomic<bool>> stop_flags;
+        /* Processing time for each SID (start time while the request is pending) */
+        static std::array<std::atomic<double>, SID_COUNT> timing_parameters;
+        /* Stop flags for each SID, indexed by SID so they are cleared in O(1).
+           The pending P2/P2* deadline is dropped once its flag is false. */
+        static std::array<std::atomic<bool>, SID_COUNT> stop_flags;
 
         /* Variable to store mcu data */
         std::unordered_map<uint16_t, std::vector<uint8_t>> default_DID_MCU = 
@@ -73,8 +73,8 @@ namespace MCU
 
         /**
          * @brief Method to receive frames.
-         * This method starts a thread to process the queue and receives frames
-         * from the CAN bus.
+         * This method starts a thread to process the queue and runs the epoll
+         * reactor that receives frames from the CAN bus and the API.
         */
         void recvFrames();
         /**
@@ -106,10 +106,24 @@ namespace MCU
         void setMcuEcuSocket(uint8_t interface_number);
 
         /**
-         * @brief Write the default_did or the date before reset in mcu_data.txt
+         * @brief Write the default_did or the data kept by a key off reset in mcu_data.db
          * 
          */
         void writeDataToFile();
+
+        /**
+         * @brief Kernel receive filters of the CAN bus socket: frames for the MCU, broadcast and API.
+         * 
+         * @return Returns the CAN_RAW_FILTER set.
+         */
+        static std::vector<struct can_filter> canbusReceiveFilters();
+
+        /**
+         * @brief Kernel receive filters of the API socket: everything not addressed to the API.
+         * 
+         * @return Returns the CAN_RAW_FILTER set.
+         */
+        static std::vector<struct can_filter> apiReceiveFilters();
  
     private:
         bool is_running;
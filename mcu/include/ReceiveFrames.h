@@ -4,9 +4,17 @@
  * from the CAN bus and frames from an API, then process them based on specific criteria.
  *
  * The library provides methods for receiving and handling CAN and API frames:
+ *  - receiveFrames: Single epoll reactor that waits on the CAN bus socket, the API socket and a
+ *    timer fd together and queues every ready frame. Used by MCUModule::recvFrames.
  *  - receiveFramesFromCANBus: Continuously reads CAN frames from the specified socket and processes them.
  *  - receiveFramesFromAPI: Continuously reads frames from the API socket and processes them.
  *  - processQueue: Processes frames from the queue and calls HandleFrames and GenerateFrame as needed.
+ *    The queue is a lock-free FrameRingBuffer: the readers push without locking and the
+ *    processing thread sleeps on its eventfd while it is empty.
+ *    The frames are then handed to DispatchLanes, one worker per destination, so a slow
+ *    service for one ECU does not delay the frames for the others.
+ *  - The ECUs that are up are tracked by a LivenessTracker fed by their 0xD9 frames; it probes
+ *    silent ECUs with 0x99 and its status bitmap answers the 0x99 query of the API.
  *  - You can choose to listen to frames from either the CAN bus or the API by setting the corresponding listen flags.
  *
  * How to use example:
@@ -14,6 +22,11 @@
  *    int socketAPI = //... initialize your API socket here
  *    ReceiveFrames rfm(socketCANBus, socketAPI);
  *
+ *    // Listen on both sockets from one thread
+ *    rfm.startListenCANBus();
+ *    rfm.startListenAPI();
+ *    rfm.receiveFrames();
+ *
  *    // Start listening to CAN bus frames
  *    rfm.startListenCANBus();
  *    rfm.receiveFramesFromCANBus();
@@ -53,15 +66,29 @@
 #include <future>
 #include <atomic>
 #include <set>
-#include <future>
-#include <atomic>
-#include <set>
+#include <array>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/timerfd.h>
 
 #include "HandleFrames.h"
 #include "GenerateFrames.h"
+#include "FrameBatchReader.h"
+#include "FrameRingBuffer.h"
+#include "DispatchLanes.h"
+#include "LivenessTracker.h"
+#include "TimerWheel.h"
 #include "MCULogger.h"
 
 
+/* Interval of the reactor timer tick, also used as poll() timeout by the single socket listeners */
+#define REACTOR_TICK_MS 100
+/* Maximum number of ready descriptors handled per epoll_wait() call */
+#define MAX_REACTOR_EVENTS 8
+/* Battery, Engine, Doors, HVAC */
+#define MCU_ECU_COUNT 4
+
 namespace MCU
 {
   /* List of service we have implemented. */
@@ -72,6 +99,10 @@ namespace MCU
       0x10,
       /* Read Data By Identifier */
       0x22,
+      /* Read Data By Periodic Identifier */
+      0x2A,
+      /* Dynamically Define Data Identifier */
+      0x2C,
       /* Authentication */
       0x29,
       /* Routine Control (Testing) -> will be decided */
@@ -106,6 +137,10 @@ namespace MCU
       0x10,
       /* Read Data By Identifier */
       0x22,
+      /* Read Data By Periodic Identifier */
+      0x2A,
+      /* Dynamically Define Data Identifier */
+      0x2C,
       /* Tester Present */
       0x3E,
       /* Read Memory By Address */
@@ -165,19 +200,36 @@ namespace MCU
      */
     bool receiveFramesFromAPI();
 
+    /**
+     * @brief Event reactor that waits on the CANBus socket, the API socket and a timer fd
+     * with a single epoll instance and puts every ready frame in the process queue.
+     * Returns when both listen flags are cleared or when one of the sockets fails.
+     * 
+     * @return Returns false for error and true when stopped normally.
+     */
+    bool receiveFrames();
+
 
     /**
-     * @brief Function that take each frame from process queue and partially parse the frame to know
-      for who is the frame. After, call handle class.
+     * @brief Function that take each frame from process queue and dispatch it on the lane of its
+      destination. Returns after the lanes processed all the dispatched frames.
     */
     void processQueue();
 
+    /**
+     * @brief Function that partially parse a frame to know for who is the frame. After, call handle class.
+     * Called by the lane workers, frames of the same (sender, receiver) pair are processed in order.
+     * 
+     * @param queued_frame The frame taken from the process queue.
+    */
+    void processFrame(const TimestampedFrame& queued_frame);
+
     /**
      * @brief Function that print a frame with all information.
      * 
      * @param frame The frame that will be printed.
      */
-    void printFrames(const struct can_frame &frame);
+    void printFrames(const struct canfd_frame &frame);
 
     /**
      * @brief Set listenAPI member to false.
@@ -221,11 +273,20 @@ namespace MCU
     bool getListenCANBus();
 
     /**
-     * @brief Get method for the list of ECUs that are up.
+     * @brief Get method for the list of ECUs that are up, read from the status bitmap
+     * without locking.
      * 
-     * @return Returns ecus_up (the list of ECUs that are up). 
+     * @return Returns the ids of Battery, Engine, Doors, HVAC, or 0 for the ECUs that are down.
+     */
+    std::array<uint8_t, MCU_ECU_COUNT> getECUsUp() const;
+
+    /**
+     * @brief Set method for the heartbeat interval of one ECU.
+     * 
+     * @param ecu_id The id of the ECU.
+     * @param interval_ms Time the ECU may stay silent before it is probed.
      */
-    const uint8_t* getECUsUp() const;
+    void setHeartbeatInterval(uint8_t ecu_id, unsigned interval_ms);
 
     /**
      * @brief set method used to set the processing flag to false in order to be able to stop mcu module.
@@ -233,46 +294,115 @@ namespace MCU
      * @return Returns ecus_up (the list of ECUs that are up). 
      */
     void stopProcessingQueue();
-    std::map<uint8_t, std::chrono::steady_clock::time_point> ecu_timers;
-    std::chrono::seconds timeout_duration;
-    std::thread timer_thread;
-    bool running;
 
-    /* Method that start time processing frame. */
+    /**
+     * @brief Set the maximum number of frames drained from a socket with one syscall.
+     * Must be called before the receive loop is started.
+     * 
+     * @param batch_size The new batch size, used for both sockets.
+     */
+    void setBatchSize(size_t batch_size);
+
+    /**
+     * @brief Get method for the batch size.
+     * 
+     * @return Returns the number of frames drained from a socket with one syscall.
+     */
+    size_t getBatchSize() const;
+
+    /**
+     * @brief Get method for the number of frames waiting in the process queue.
+     * 
+     * @return Returns the occupancy of the process queue.
+     */
+    size_t getQueueOccupancy() const;
+
+    /**
+     * @brief Get method for the number of frames dropped because the process queue was full.
+     * 
+     * @return Returns the drop counter of the process queue.
+     */
+    uint64_t getDroppedFrames() const;
+    /* Method that start time processing frame: arms the P2/P2* deadline of the SID in the timer wheel. */
     void startTimer(uint8_t sid);
-    /* Method that stop time processing frame. */
+    /* Method that stop time processing frame: sends the response pending frame if the SID is still pending. */
     void stopTimer(uint8_t sid);
 
+    /**
+     * @brief Get method for the number of deadlines in the timer wheel.
+     * 
+     * @return Returns the number of armed response timers.
+     */
+    size_t getPendingTimers() const;
+
   protected:
     /* The socket from where we read the frames */
     int socket_canbus;
     int socket_api;
     const uint32_t hex_value_id = 0x10;
-    std::queue<struct can_frame> frame_queue;
-    std::mutex queue_mutex;
-    std::condition_variable queue_cond_var;
-    bool listen_api;
-    bool listen_canbus;
+    /* Frames waiting to be processed, with the kernel receive timestamp */
+    FrameRingBuffer frame_queue;
+    std::atomic<bool> listen_api{false};
+    std::atomic<bool> listen_canbus{false};
     HandleFrames handler;
     GenerateFrames generate_frames;
-    /* Vector contains all the ECUs up ids */
-    uint8_t ecus_up[4] = {0};
-    bool process_queue = true;
+    /* Batched readers for each socket and their reusable output buffers */
+    FrameBatchReader canbus_reader;
+    FrameBatchReader api_reader;
+    std::vector<TimestampedFrame> canbus_batch;
+    std::vector<TimestampedFrame> api_batch;
+    /* Per destination workers that run processFrame */
+    DispatchLanes dispatch_lanes;
+    /* P2/P2* response deadlines of the requests being processed */
+    TimerWheel response_timers;
+    /* Incremented each time a SID is armed, so a stale deadline does not fire for a newer request */
+    std::array<std::atomic<uint32_t>, SID_COUNT> timer_generations{};
+    /* Heartbeat deadlines and status bitmap of the ECUs */
+    LivenessTracker liveness;
+    std::atomic<bool> process_queue{true};
 
     /**
-     * @brief Starts timer_thread and sets running flag on true.
+     * @brief Waits until the socket has data or the reactor tick elapses.
+     * 
+     * @param socket The socket to wait on.
+     * @return Returns true if the socket is readable (or in error state).
+     */
+    bool waitForFrames(int socket);
+
+    /**
+     * @brief Reads all the frames currently pending on a socket without blocking,
+     * in batches, and puts the accepted ones in the process queue with one lock per batch.
+     * 
+     * @param socket Either socket_canbus or socket_api.
+     * @return Returns false for read error or closed connection, true otherwise.
+     */
+    bool drainSocket(int socket);
+
+    /**
+     * @brief Computes how long a frame waited since the kernel received it.
+     * 
+     * @param queued_frame The frame taken from the process queue.
+     * @return Returns the latency in microseconds.
+     */
+    static long long queueLatencyUs(const TimestampedFrame& queued_frame);
+
+    /**
+     * @brief Starts the liveness tracker thread.
      */
     void startTimerThread();
 
     /**
-     * @brief Stops timer_thread and sets running flag on false.
+     * @brief Stops the liveness tracker thread.
      */
     void stopTimerThread();
 
     /**
-     * @brief Checks timer and send requests to check if the ECUs are up.
+     * @brief Sends the 0x99 request to an ECU that was silent for its heartbeat interval.
+     * Called from the liveness tracker thread.
+     * 
+     * @param ecu_id The identifier of the ECU.
      */
-    void timerCheck();
+    void probeEcu(uint8_t ecu_id);
 
     /**
      * @brief Reset the timer and add the ECU to the list.
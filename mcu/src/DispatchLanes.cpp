@@ -0,0 +1,116 @@
+#include "DispatchLanes.h"
+
+#include <chrono>
+
+namespace MCU
+{
+    DispatchLanes::DispatchLanes(FrameHandler handler, size_t lane_count) : handler(handler)
+    {
+        if (lane_count == 0)
+        {
+            lane_count = 1;
+        }
+        for (size_t lane = 0; lane < lane_count; ++lane)
+        {
+            lanes.emplace_back(new FrameRingBuffer(DISPATCH_LANE_CAPACITY));
+        }
+    }
+
+    DispatchLanes::~DispatchLanes()
+    {
+        stop();
+    }
+
+    void DispatchLanes::start()
+    {
+        if (running.exchange(true))
+        {
+            return;
+        }
+        for (size_t lane = 0; lane < lanes.size(); ++lane)
+        {
+            workers.emplace_back(&DispatchLanes::runLane, this, lane);
+        }
+    }
+
+    void DispatchLanes::stop()
+    {
+        running = false;
+        for (auto& lane : lanes)
+        {
+            lane->wakeUp();
+        }
+        for (std::thread& worker : workers)
+        {
+            if (worker.joinable())
+            {
+                worker.join();
+            }
+        }
+        workers.clear();
+    }
+
+    size_t DispatchLanes::laneFor(uint8_t sender_id, uint8_t receiver_id) const
+    {
+        /* Requests for the MCU share one lane; responses for the API follow the ECU that sent them */
+        uint8_t destination = receiver_id;
+        if (receiver_id == 0xFA)
+        {
+            destination = sender_id;
+        }
+        /* 0x10..0x14 (MCU, Battery, Engine, Doors, HVAC) land on distinct lanes for the default count */
+        return destination % lanes.size();
+    }
+
+    bool DispatchLanes::dispatch(const TimestampedFrame& queued_frame)
+    {
+        uint8_t sender_id = (queued_frame.frame.can_id >> 8) & 0xFF;
+        uint8_t receiver_id = queued_frame.frame.can_id & 0xFF;
+        FrameRingBuffer& lane = *lanes[laneFor(sender_id, receiver_id)];
+
+        /* The frame was already accepted, so wait for room instead of dropping it.
+           A full lane is only backpressure; the frame counts as dropped if the lanes stop first. */
+        while (!lane.offer(queued_frame))
+        {
+            if (!running)
+            {
+                lane.recordDrop();
+                return false;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return true;
+    }
+
+    void DispatchLanes::runLane(size_t lane)
+    {
+        FrameRingBuffer& ring = *lanes[lane];
+        TimestampedFrame queued_frame;
+        while (true)
+        {
+            if (ring.waitPop(queued_frame, DISPATCH_TICK_MS))
+            {
+                handler(queued_frame);
+            }
+            else if (!running && ring.empty())
+            {
+                break;
+            }
+        }
+    }
+
+    size_t DispatchLanes::getLaneCount() const
+    {
+        return lanes.size();
+    }
+
+    size_t DispatchLanes::getLaneOccupancy(size_t lane) const
+    {
+        return lane < lanes.size() ? lanes[lane]->size() : 0;
+    }
+
+    bool DispatchLanes::isRunning() const
+    {
+        return running;
+    }
+}
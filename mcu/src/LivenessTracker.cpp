@@ -0,0 +1,200 @@
+#include "LivenessTracker.h"
+
+namespace MCU
+{
+    LivenessTracker::LivenessTracker(ProbeCallback send_probe, DownCallback on_down,
+                                     unsigned default_interval_ms, unsigned probe_timeout_ms)
+        : send_probe(send_probe), on_down(on_down),
+          default_interval_ms(default_interval_ms == 0 ? 1 : default_interval_ms),
+          probe_timeout_ms(probe_timeout_ms == 0 ? 1 : probe_timeout_ms)
+    {
+    }
+
+    LivenessTracker::~LivenessTracker()
+    {
+        stop();
+    }
+
+    void LivenessTracker::start()
+    {
+        std::lock_guard<std::mutex> lock(liveness_mutex);
+        if (running)
+        {
+            return;
+        }
+        running = true;
+        worker = std::thread(&LivenessTracker::run, this);
+    }
+
+    void LivenessTracker::stop()
+    {
+        {
+            std::lock_guard<std::mutex> lock(liveness_mutex);
+            running = false;
+        }
+        wake_up.notify_all();
+        if (worker.joinable())
+        {
+            worker.join();
+        }
+    }
+
+    void LivenessTracker::heartbeat(uint8_t ecu_id)
+    {
+        std::lock_guard<std::mutex> lock(liveness_mutex);
+        EcuState& ecu = ecus[ecu_id];
+        unsigned interval_ms = ecu.interval_ms != 0 ? ecu.interval_ms : default_interval_ms;
+        ecu.tracked = true;
+        ecu.probed = false;
+        ++ecu.generation;
+        pushDeadline(ecu_id, Clock::now() + std::chrono::milliseconds(interval_ms));
+        setStatus(ecu_id, true);
+    }
+
+    void LivenessTracker::setHeartbeatInterval(uint8_t ecu_id, unsigned interval_ms)
+    {
+        std::lock_guard<std::mutex> lock(liveness_mutex);
+        ecus[ecu_id].interval_ms = interval_ms;
+    }
+
+    unsigned LivenessTracker::getHeartbeatInterval(uint8_t ecu_id) const
+    {
+        std::lock_guard<std::mutex> lock(liveness_mutex);
+        return ecus[ecu_id].interval_ms != 0 ? ecus[ecu_id].interval_ms : default_interval_ms;
+    }
+
+    bool LivenessTracker::isTracked(uint8_t ecu_id) const
+    {
+        std::lock_guard<std::mutex> lock(liveness_mutex);
+        return ecus[ecu_id].tracked;
+    }
+
+    LivenessTracker::Clock::time_point LivenessTracker::getDeadline(uint8_t ecu_id) const
+    {
+        std::lock_guard<std::mutex> lock(liveness_mutex);
+        return ecus[ecu_id].tracked ? ecus[ecu_id].expiry : Clock::time_point();
+    }
+
+    bool LivenessTracker::isUp(uint8_t ecu_id) const
+    {
+        if (ecu_id < LIVENESS_FIRST_ECU_ID || ecu_id >= LIVENESS_FIRST_ECU_ID + LIVENESS_BITMAP_SIZE)
+        {
+            return false;
+        }
+        return (status_bitmap.load(std::memory_order_acquire) >> (ecu_id - LIVENESS_FIRST_ECU_ID)) & 1u;
+    }
+
+    uint32_t LivenessTracker::getStatusBitmap() const
+    {
+        return status_bitmap.load(std::memory_order_acquire);
+    }
+
+    size_t LivenessTracker::getHeapSize() const
+    {
+        std::lock_guard<std::mutex> lock(liveness_mutex);
+        return deadlines.size();
+    }
+
+    bool LivenessTracker::isRunning() const
+    {
+        return running;
+    }
+
+    void LivenessTracker::pushDeadline(uint8_t ecu_id, Clock::time_point expiry)
+    {
+        bool earliest = deadlines.empty() || expiry < deadlines.top().expiry;
+        ecus[ecu_id].expiry = expiry;
+
+        /* An ECU sending heartbeats faster than its interval leaves stale entries behind,
+           rebuild the heap from the current deadlines before it grows without bound */
+        if (deadlines.size() >= 4 * ecus.size())
+        {
+            std::vector<Deadline> current;
+            for (size_t id = 0; id < ecus.size(); ++id)
+            {
+                if (ecus[id].tracked && id != ecu_id)
+                {
+                    current.push_back({ecus[id].expiry, static_cast<uint8_t>(id), ecus[id].generation});
+                }
+            }
+            deadlines = decltype(deadlines)(std::greater<Deadline>(), std::move(current));
+        }
+        deadlines.push({expiry, ecu_id, ecus[ecu_id].generation});
+
+        if (earliest)
+        {
+            /* The thread sleeps until a later deadline, make it sleep until this one */
+            wake_up.notify_one();
+        }
+    }
+
+    void LivenessTracker::setStatus(uint8_t ecu_id, bool up)
+    {
+        if (ecu_id < LIVENESS_FIRST_ECU_ID || ecu_id >= LIVENESS_FIRST_ECU_ID + LIVENESS_BITMAP_SIZE)
+        {
+            return;
+        }
+        uint32_t bit = 1u << (ecu_id - LIVENESS_FIRST_ECU_ID);
+        if (up)
+        {
+            status_bitmap.fetch_or(bit, std::memory_order_release);
+        }
+        else
+        {
+            status_bitmap.fetch_and(~bit, std::memory_order_release);
+        }
+    }
+
+    void LivenessTracker::run()
+    {
+        std::unique_lock<std::mutex> lock(liveness_mutex);
+        while (running)
+        {
+            if (deadlines.empty())
+            {
+                wake_up.wait(lock, [this] { return !running || !deadlines.empty(); });
+                continue;
+            }
+            Deadline next = deadlines.top();
+            if (Clock::now() < next.expiry)
+            {
+                /* Woken up early by a new earliest deadline or by stop() */
+                wake_up.wait_until(lock, next.expiry);
+                continue;
+            }
+            deadlines.pop();
+
+            EcuState& ecu = ecus[next.ecu_id];
+            if (!ecu.tracked || ecu.generation != next.generation)
+            {
+                /* A newer heartbeat replaced this deadline */
+                continue;
+            }
+            if (!ecu.probed)
+            {
+                /* Silent for a whole interval: ask the ECU if it is still up */
+                ecu.probed = true;
+                pushDeadline(next.ecu_id, Clock::now() + std::chrono::milliseconds(probe_timeout_ms));
+                lock.unlock();
+                if (send_probe)
+                {
+                    send_probe(next.ecu_id);
+                }
+                lock.lock();
+            }
+            else
+            {
+                /* The probe was not answered in time */
+                ecu.tracked = false;
+                ecu.probed = false;
+                setStatus(next.ecu_id, false);
+                lock.unlock();
+                if (on_down)
+                {
+                    on_down(next.ecu_id);
+                }
+                lock.lock();
+            }
+        }
+    }
+}
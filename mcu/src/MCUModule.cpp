@@ -1,12 +1,12 @@
 #include "MCUModule.h"
+#include "DidStore.h"
 
 Logger* MCULogger = nullptr;
 namespace MCU
 {
     MCUModule* mcu = nullptr;
-    std::map<uint8_t, double> MCUModule::timing_parameters;
-    std::map<uint8_t, std::future<void>> MCUModule::active_timers;
-    std::map<uint8_t, std::atomic<bool>> MCUModule::stop_flags;
+    std::array<std::atomic<double>, SID_COUNT> MCUModule::timing_parameters;
+    std::array<std::atomic<bool>, SID_COUNT> MCUModule::stop_flags;
     const std::vector<uint16_t> MCUModule::VALID_DID_MCU =
     {
         /* Vehicle Identification Number (VIN) */
@@ -47,9 +47,11 @@ namespace MCU
                     is_running(false),
                     create_interface(CreateInterface::getInstance(interfaces_number, *MCULogger)),
                     receive_frames(nullptr),
-                    mcu_api_socket(create_interface->createSocket(interfaces_number)),
-                    mcu_ecu_socket(create_interface->createSocket(interfaces_number >> 4))
+                    mcu_api_socket(create_interface->createSocket(interfaces_number, apiReceiveFilters())),
+                    mcu_ecu_socket(create_interface->createSocket(interfaces_number >> 4, canbusReceiveFilters()))
                     {
+        /* The ECUs may talk CAN FD, the API bus stays classic */
+        create_interface->enableFdFrames(mcu_ecu_socket, interfaces_number >> 4);
         writeDataToFile();
         receive_frames = new ReceiveFrames(mcu_ecu_socket, mcu_api_socket);
     }
@@ -81,6 +83,18 @@ namespace MCU
         create_interface->setSocketBlocking(mcu_ecu_socket);
     }
 
+    std::vector<struct can_filter> MCUModule::canbusReceiveFilters()
+    {
+        /* Same receivers as the check in ReceiveFrames: MCU, broadcast and API */
+        return CreateInterface::receiverFilters(MCU_ID, {0xFF, API_ID});
+    }
+
+    std::vector<struct can_filter> MCUModule::apiReceiveFilters()
+    {
+        /* Frames addressed to the API are only forwarded, never read back */
+        return CreateInterface::excludeReceiverFilters(API_ID);
+    }
+
     int MCUModule::getMcuApiSocket() const 
     {
         return mcu_api_socket;
@@ -92,12 +106,13 @@ namespace MCU
 
     void MCUModule::setMcuApiSocket(uint8_t interface_number)
     {
-        this->mcu_api_socket = this->create_interface->createSocket(interface_number);
+        this->mcu_api_socket = this->create_interface->createSocket(interface_number, apiReceiveFilters());
     }
     
     void MCUModule::setMcuEcuSocket(uint8_t interface_number)
     {
-        this->mcu_ecu_socket = this->create_interface->createSocket(interface_number >> 4);
+        this->mcu_ecu_socket = this->create_interface->createSocket(interface_number >> 4, canbusReceiveFilters());
+        this->create_interface->enableFdFrames(this->mcu_ecu_socket, interface_number >> 4);
     }
 
     /* Stop the module */
@@ -119,64 +134,19 @@ namespace MCU
             /* Start a thread to process the queue */
             std::thread queue_thread_process(&ReceiveFrames::processQueue, receive_frames);
 
-            /* Start a thread to listen on API socket */
-            std::thread queue_thread_listen(&ReceiveFrames::receiveFramesFromAPI, receive_frames);
-
-            /* Receive frames from the CAN bus */
-            receive_frames->receiveFramesFromCANBus();
+            /* Wait on the CAN bus and API sockets together in this thread */
+            receive_frames->receiveFrames();
 
             receive_frames->stopListenAPI();
             receive_frames->stopListenCANBus();
 
-            /* Wait for the threads to finish */
+            /* Wait for the thread to finish */
             queue_thread_process.join();
-            queue_thread_listen.join();
         }
     }
     void MCUModule::writeDataToFile()
     {
-        std::string file_path = std::string(PROJECT_PATH) + "/backend/mcu/mcu_data.txt";
-        /* Insert the default DID values in the file */
-        std::ofstream outfile(file_path);
-        if (!outfile.is_open())
-        {
-            throw std::runtime_error("Failed to open file: mcu_data.txt");
-        }
-
-        /* Check if old_mcu_data.txt exists */
-        std::string old_file_path = "old_mcu_data.txt";
-        std::ifstream infile(old_file_path);
-
-        if (infile.is_open())
-        {
-            /* Read the current file contents into memory */
-            std::stringstream buffer;
-            /* Read the entire file into the buffer */
-            buffer << infile.rdbuf();
-            infile.close();
-
-            /* Store the original content */
-            std::string original_file_contents = buffer.str();
-
-            /* Write the content of old_mcu_data.txt into mcu_data.txt */
-            outfile << original_file_contents;
-
-            /* Delete the old file after reading its contents */
-            std::remove(old_file_path.c_str());
-        }
-        else
-        {
-            /* Write the default DID values to mcu_data.txt */
-            for (const auto& [data_identifier, data] : default_DID_MCU)
-            {
-                outfile << std::hex << std::setw(4) << std::setfill('0') << std::uppercase << data_identifier << " ";
-                for (uint8_t byte : data)
-                {
-                    outfile << std::hex << std::setw(2) << std::setfill('0') << static_cast<int>(byte) << " ";
-                }
-                outfile << "\n";
-            }
-        }
-        outfile.close();
+        /* Values kept by a key off reset, default values otherwise */
+        DidStore::restore(std::string(PROJECT_PATH) + "/backend/mcu/mcu_data.db", default_DID_MCU);
     }
 }
\ No newline at end of file
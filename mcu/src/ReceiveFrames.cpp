@@ -5,12 +5,23 @@
 namespace MCU
 {
     ReceiveFrames::ReceiveFrames(int socket_canbus, int socket_api)
-        : timeout_duration(120), running(true), socket_canbus(socket_canbus), 
-        socket_api(socket_api), handler(socket_api, *MCULogger),
-        generate_frames(socket_canbus, *MCULogger)
-        
+        : socket_canbus(socket_canbus), socket_api(socket_api), handler(socket_api, *MCULogger),
+        generate_frames(socket_canbus, *MCULogger),
+        canbus_reader(socket_canbus), api_reader(socket_api),
+        dispatch_lanes([this](const TimestampedFrame& queued_frame) { processFrame(queued_frame); }),
+        liveness([this](uint8_t ecu_id) { probeEcu(ecu_id); },
+                 [](uint8_t ecu_id) {
+                     LOG_WARN(MCULogger->GET_LOGGER(), "ECU with ID: 0x{:x} did not answer the probe, marked as down.", ecu_id);
+                 })
     {
+        canbus_batch.reserve(canbus_reader.getBatchSize());
+        api_batch.reserve(api_reader.getBatchSize());
         startTimerThread();
+        /* One thread serves the P2/P2* deadlines of all the requests */
+        if (!response_timers.start())
+        {
+            LOG_ERROR(MCULogger->GET_LOGGER(), "Failed to start the response timers: {}", strerror(errno));
+        }
     }
 
     ReceiveFrames::~ReceiveFrames() 
@@ -18,6 +29,7 @@ namespace MCU
         stopListenAPI();
         stopListenCANBus();
         stopTimerThread();
+        response_timers.stop();
     }
 
     uint32_t ReceiveFrames::gethexValueId()
@@ -27,239 +39,349 @@ namespace MCU
 
     /**
      * Function to read frames from the CAN bus and add them to a queue.
-     * This function runs in a loop and continually reads frames from the CAN bus.
+     * This function runs in a loop and sleeps in poll() until the socket is readable.
      */
-  bool ReceiveFrames::receiveFramesFromCANBus()
-{
-    struct can_frame frame;
-    while (listen_canbus)
+    bool ReceiveFrames::receiveFramesFromCANBus()
     {
-        /* Read frames from the CAN socket */
-        int nbytes = read(socket_canbus, &frame, sizeof(frame));
-        
-        if (nbytes < 0) 
+        while (listen_canbus)
         {
-            if (errno == EWOULDBLOCK || errno == EAGAIN) 
+            if (!waitForFrames(socket_canbus))
             {
-                /* No data available, continue the loop */
                 continue;
-            } 
-            else 
+            }
+            if (!drainSocket(socket_canbus))
             {
-                LOG_ERROR(MCULogger->GET_LOGGER(), "Read error on CANBus socket: {}", strerror(errno));
                 return false;
             }
-        } 
-        else if (nbytes == 0) 
+        }
+        return true;
+    }
+
+    bool ReceiveFrames::receiveFramesFromAPI()
+    {
+        while (listen_api)
         {
-            /* Connection closed */
-            LOG_INFO(MCULogger->GET_LOGGER(), "CANBus connection closed.");
+            if (!waitForFrames(socket_api))
+            {
+                continue;
+            }
+            if (!drainSocket(socket_api))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool ReceiveFrames::receiveFrames()
+    {
+        int epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+        if (epoll_fd < 0)
+        {
+            LOG_ERROR(MCULogger->GET_LOGGER(), "Failed to create epoll instance: {}", strerror(errno));
             return false;
-        } 
-        else 
+        }
+
+        /* Periodic tick so the reactor notices stop requests while the bus is idle */
+        int timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+        if (timer_fd < 0)
+        {
+            LOG_ERROR(MCULogger->GET_LOGGER(), "Failed to create reactor timer: {}", strerror(errno));
+            close(epoll_fd);
+            return false;
+        }
+        struct itimerspec tick = {};
+        tick.it_interval.tv_nsec = REACTOR_TICK_MS * 1000000L;
+        tick.it_value.tv_nsec = REACTOR_TICK_MS * 1000000L;
+        timerfd_settime(timer_fd, 0, &tick, nullptr);
+
+        bool result = true;
+        for (int fd : {socket_canbus, socket_api, timer_fd})
         {
-            LOG_DEBUG(MCULogger->GET_LOGGER(), "Captured a frame on the CANBus socket");
-            /* Lock the queue before adding the frame to ensure thread safety */
+            struct epoll_event event = {};
+            event.events = EPOLLIN;
+            event.data.fd = fd;
+            if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event) < 0)
             {
-                std::lock_guard<std::mutex> lock(queue_mutex);
-                uint8_t receiver_id = frame.can_id & 0xFF;
+                LOG_ERROR(MCULogger->GET_LOGGER(), "Failed to register fd {} in the reactor: {}", fd, strerror(errno));
+                result = false;
+            }
+        }
 
-                /* If frame is for MCU module, for API or test frame */
-                if (receiver_id == hex_value_id || receiver_id == 0xFF || receiver_id == 0xFA) 
+        struct epoll_event events[MAX_REACTOR_EVENTS];
+        while (result && (listen_canbus || listen_api))
+        {
+            int ready = epoll_wait(epoll_fd, events, MAX_REACTOR_EVENTS, -1);
+            if (ready < 0)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+                LOG_ERROR(MCULogger->GET_LOGGER(), "Reactor wait failed: {}", strerror(errno));
+                result = false;
+                break;
+            }
+
+            for (int event_index = 0; event_index < ready && result; ++event_index)
+            {
+                int fd = events[event_index].data.fd;
+                if (fd == timer_fd)
+                {
+                    /* Only acknowledge the tick, the loop condition does the rest */
+                    uint64_t expirations;
+                    if (read(timer_fd, &expirations, sizeof(expirations)) < 0 && errno != EAGAIN)
+                    {
+                        LOG_WARN(MCULogger->GET_LOGGER(), "Failed to acknowledge reactor tick: {}", strerror(errno));
+                    }
+                }
+                else if ((fd == socket_canbus && listen_canbus) || (fd == socket_api && listen_api))
                 {
-                    frame_queue.push(frame);
-                    LOG_DEBUG(MCULogger->GET_LOGGER(), fmt::format("Passed a valid Module ID: 0x{:x} and frame added to the processing queue.", frame.can_id));
+                    result = drainSocket(fd);
                 }
             }
-            /* Notify one waiting thread that a new frame has been added to the queue */
-            queue_cond_var.notify_one();
         }
+
+        close(timer_fd);
+        close(epoll_fd);
+        return result;
     }
-    return true;
-}
 
-bool ReceiveFrames::receiveFramesFromAPI()
-{
-    struct can_frame frame;
-    while (listen_api)
+    bool ReceiveFrames::waitForFrames(int socket)
     {
-        /* Read frames from the CAN socket */
-        int nbytes = read(socket_api, &frame, sizeof(frame));
-        
-        if (nbytes < 0) 
+        struct pollfd poll_fd = {socket, POLLIN, 0};
+        return poll(&poll_fd, 1, REACTOR_TICK_MS) > 0;
+    }
+
+    bool ReceiveFrames::drainSocket(int socket)
+    {
+        bool from_api = (socket == socket_api);
+        FrameBatchReader& reader = from_api ? api_reader : canbus_reader;
+        std::vector<TimestampedFrame>& batch = from_api ? api_batch : canbus_batch;
+        while (true)
         {
-            if (errno == EWOULDBLOCK || errno == EAGAIN) 
+            /* Drain up to batch size frames with one syscall */
+            int received = reader.readBatch(batch);
+            if (received == 0)
             {
-                /* No data available, continue the loop */
-                continue;
-            } 
-            else 
+                /* Socket drained, go back to waiting */
+                return true;
+            }
+            else if (received == BATCH_READ_ERROR)
             {
-                LOG_ERROR(MCULogger->GET_LOGGER(), "Read error on API socket: {}", strerror(errno));
+                LOG_ERROR(MCULogger->GET_LOGGER(), "Read error on {} socket: {}", from_api ? "API" : "CANBus", strerror(errno));
                 return false;
             }
-        } 
-        else if (nbytes == 0) 
-        {
-            /* Connection closed */
-            LOG_INFO(MCULogger->GET_LOGGER(), "API connection closed.");
-            return false;
-        } 
-        else 
-        {
-            LOG_DEBUG(MCULogger->GET_LOGGER(), "Captured a frame on the API socket");
-            /* Lock the queue before adding the frame to ensure thread safety */
+            else if (received == BATCH_CONNECTION_CLOSED)
             {
-                {
-                    /* Lock the queue before adding the frame to ensure thread safety */
-                    std::lock_guard<std::mutex> lock(queue_mutex);
-
-                    /* Take receiver_id */
-                    uint8_t receiver_id = frame.can_id & 0xFF;
+                /* Connection closed */
+                LOG_INFO(MCULogger->GET_LOGGER(), "{} connection closed.", from_api ? "API" : "CANBus");
+                return false;
+            }
 
-                    /* If frame is for MCU module, for API or test frame */
-                    if( receiver_id != 0xFA)
+            LOG_DEBUG(MCULogger->GET_LOGGER(), "Captured a frame on the {} socket ({} in batch)", from_api ? "API" : "CANBus", received);
+            size_t accepted = 0;
+            size_t dropped = 0;
+            for (const TimestampedFrame& received_frame : batch)
+            {
+                uint8_t receiver_id = received_frame.frame.can_id & 0xFF;
+                /* From CANBus keep frames for MCU module, for API or test frames; from API keep everything not addressed to API */
+                /* Same rule as the kernel filters from MCUModule, kept for sockets created without them */
+                bool valid = from_api ? (receiver_id != 0xFA)
+                                      : (receiver_id == hex_value_id || receiver_id == 0xFF || receiver_id == 0xFA);
+                if (valid)
+                {
+                    /* No lock needed, the ring buffer accepts several producers */
+                    if (frame_queue.tryPush(received_frame))
+                    {
+                        ++accepted;
+                    }
+                    else
                     {
-                        frame_queue.push(frame);
-                        LOG_DEBUG(MCULogger->GET_LOGGER(), fmt::format("Pass a valid Module ID: 0x{:x} and frame added to the processing queue.", frame.can_id));
+                        ++dropped;
                     }
                 }
-                /* Notify one waiting thread that a new frame has been added to the queue */
-                queue_cond_var.notify_one();
             }
-            /* Notify one waiting thread that a new frame has been added to the queue */
-            queue_cond_var.notify_one();
+            if (accepted > 0)
+            {
+                LOG_DEBUG(MCULogger->GET_LOGGER(), "Passed a valid Module ID: {} frame(s) added to the processing queue.", accepted);
+                /* Wake up the processing thread once per batch */
+                frame_queue.notify();
+            }
+            if (dropped > 0)
+            {
+                LOG_WARN(MCULogger->GET_LOGGER(), "Processing queue full: dropped {} frame(s) from the {} socket, {} dropped in total.",
+                         dropped, from_api ? "API" : "CANBus", frame_queue.getDroppedFrames());
+            }
         }
     }
-    return true;
-}
+
+    void ReceiveFrames::setBatchSize(size_t batch_size)
+    {
+        canbus_reader.setBatchSize(batch_size);
+        api_reader.setBatchSize(batch_size);
+        canbus_batch.reserve(canbus_reader.getBatchSize());
+        api_batch.reserve(api_reader.getBatchSize());
+    }
+
+    size_t ReceiveFrames::getBatchSize() const
+    {
+        return canbus_reader.getBatchSize();
+    }
 
     /*
     * Function to process frames from the queue.
-    * This function runs in a loop and processes each frame from the queue.
+    * This function runs in a loop, takes each frame from the queue and hands it to
+    * the lane of its destination, where processFrame is called by the lane worker.
     */
     void ReceiveFrames::processQueue() 
     {
         LOG_DEBUG(MCULogger->GET_LOGGER(),"Frame processing method invoked!");
+        dispatch_lanes.start();
         while (true)
         {
-            /* Wait until the queue is not empty, then lock the queue */
-            std::unique_lock<std::mutex> lock(queue_mutex);
-            queue_cond_var.wait(lock, [this]{ return !frame_queue.empty()|| !process_queue; });
-            if (!process_queue && frame_queue.empty()) 
+            /* Sleep on the queue until a frame arrives, waking up every tick to check the stop flags */
+            TimestampedFrame queued_frame;
+            if (!frame_queue.waitPop(queued_frame, REACTOR_TICK_MS))
+            {
+                if (!process_queue || (!listen_api && !listen_canbus))
+                {
+                    break;
+                }
+                continue;
+            }
+            dispatch_lanes.dispatch(queued_frame);
+
+            if (!listen_api && !listen_canbus) 
             {
                 break;
             }
-            /* Extract the first element from the queue */
-            struct can_frame frame = frame_queue.front();
-            frame_queue.pop();
-            LOG_DEBUG(MCULogger->GET_LOGGER(), fmt::format("Frame with ID: 0x{:x} is taken from processing queue", frame.can_id));
-            /* Unlock the queue to allow other threads to add frames */
-            lock.unlock();
+        }
+        /* Let the lanes finish the frames already dispatched */
+        dispatch_lanes.stop();
+    }
 
-            /* Print the received CAN frame details */
-            printFrames(frame);
+    void ReceiveFrames::processFrame(const TimestampedFrame& queued_frame)
+    {
+        const struct canfd_frame& frame = queued_frame.frame;
+        LOG_DEBUG(MCULogger->GET_LOGGER(), fmt::format("Frame with ID: 0x{:x} is taken from processing queue after {} us", frame.can_id, queueLatencyUs(queued_frame)));
 
-            /* Extracting the components from can_id */
+        /* Print the received CAN frame details */
+        printFrames(frame);
 
-            /* Last byte: id_sender */
-            uint8_t sender_id = (frame.can_id >> 8) & 0xFF;
-            /* First byte: id_receiver or id_api */
-            uint8_t receiver_id = frame.can_id & 0xFF;
+        /* Extracting the components from can_id */
 
-            /* Starting frame processing timing if is it a frame request for MCU */
-            auto it = std::find(service_sids.begin(), service_sids.end(), frame.data[1]);
+        /* Last byte: id_sender */
+        uint8_t sender_id = (frame.can_id >> 8) & 0xFF;
+        /* First byte: id_receiver or id_api */
+        uint8_t receiver_id = frame.can_id & 0xFF;
 
-            if (it != service_sids.end() && receiver_id == 0x10) {
-                startTimer(frame.data[1]);
-            }
+        /* Starting frame processing timing if is it a frame request for MCU */
+        auto it = std::find(service_sids.begin(), service_sids.end(), frame.data[1]);
 
-            /* Compare the CAN ID with the expected hexValueId */
-            if (receiver_id == hex_value_id) 
+        if (it != service_sids.end() && receiver_id == 0x10) {
+            startTimer(frame.data[1]);
+        }
+
+        /* Compare the CAN ID with the expected hexValueId */
+        if (receiver_id == hex_value_id) 
+        {
+            if (frame.data[1] == 0xD9) 
+            {
+                LOG_INFO(MCULogger->GET_LOGGER(), fmt::format("Frame received to notify MCU that ECU with ID: 0x{:x} is up", sender_id));
+                /* Marks the ECU as up and pushes its next heartbeat deadline */
+                resetTimer(sender_id);
+                /* An ECU started without CAN FD is answered in classic CAN again */
+                bool fd_capable = frame.len > 2 && (frame.data[2] & CAN_FD_CAPABLE) && CanFd::isSocketFd(socket_canbus);
+                CanFd::setPeerFd(sender_id, fd_capable);
+                LOG_DEBUG(MCULogger->GET_LOGGER(), "ECU with ID: 0x{:x} talks {}", sender_id, fd_capable ? "CAN FD" : "classic CAN");
+            }
+            else 
             {
-                if (frame.data[1] == 0xD9) 
+                LOG_INFO(MCULogger->GET_LOGGER(), fmt::format("Received frame for MCU to execute service with SID: 0x{:x}", frame.data[1]));
+                LOG_INFO(MCULogger->GET_LOGGER(), "Calling HandleFrames module to execute the service and parse the frame.");
+                handler.handleFrame(getMcuSocket(sender_id), frame);
+                std::vector<uint8_t> response;
+                if (!SecurityAccess::getMcuState(*MCULogger))
                 {
-                    LOG_INFO(MCULogger->GET_LOGGER(), fmt::format("Frame received to notify MCU that ECU with ID: 0x{:x} is up", sender_id));
-                    /* Set the corresponding value from the array with the ECU id */
-                    switch(sender_id)
-                    {
-                        case 0x11:
-                            ecus_up[0] = sender_id;
-                            break;
-                        case 0x12:
-                            ecus_up[1] = sender_id;
-                            break;
-                        case 0x13:
-                            ecus_up[2] = sender_id;
-                            break;
-                        case 0x14:
-                            ecus_up[3] = sender_id;
-                            break;
-                        default:
-                            break;
-                    }
-
-                    resetTimer(sender_id);
+                    securityNotifyECU({0x01,0xCF});
+                    LOG_INFO(MCULogger->GET_LOGGER(), "Server is locked.");
                 }
-                else 
+                else
                 {
-                    LOG_INFO(MCULogger->GET_LOGGER(), fmt::format("Received frame for MCU to execute service with SID: 0x{:x}", frame.data[1]));
-                    LOG_INFO(MCULogger->GET_LOGGER(), "Calling HandleFrames module to execute the service and parse the frame.");
-                    handler.handleFrame(getMcuSocket(sender_id), frame);
-                    std::vector<uint8_t> response;
-                    if (!SecurityAccess::getMcuState(*MCULogger))
-                    {
-                        securityNotifyECU({0x01,0xCF});
-                        LOG_INFO(MCULogger->GET_LOGGER(), "Server is locked.");
-                    }
-                    else
-                    {
-                        securityNotifyECU({0x01,0xCE});
-                        LOG_INFO(MCULogger->GET_LOGGER(), "Server is unlocked.");
-                    }
+                    securityNotifyECU({0x01,0xCE});
+                    LOG_INFO(MCULogger->GET_LOGGER(), "Server is unlocked.");
                 }
             }
-            else if (receiver_id == 0xFA) 
+        }
+        else if (receiver_id == 0xFA) 
+        {
+            /* Flow control of an ECU for a multi-frame request forwarded by the MCU (large transfer data blocks) */
+            if ((frame.data[0] & 0xF0) == 0x30 && IsoTpTransmitter::getInstance().onFlowControl(frame))
             {
+                LOG_DEBUG(MCULogger->GET_LOGGER(), fmt::format("Flow control frame from ECU 0x{:x} handled by the MCU", sender_id));
+            }
+            else
+            {
+                if (frame.data[1] == 0x74)
+                {
+                    /* Request Download response: remember the max_number_block of the ECU for the transfer data requests */
+                    size_t length_max_number_block = frame.len > 3 ? std::min<size_t>(frame.data[2] >> 4, frame.len - 3) : 0;
+                    size_t max_number_block = 0;
+                    for (size_t index = 0; index < length_max_number_block; ++index)
+                    {
+                        max_number_block = (max_number_block << 8) | frame.data[3 + index];
+                    }
+                    TransferData::setMaxBlockLength(sender_id, max_number_block);
+                }
                 LOG_DEBUG(MCULogger->GET_LOGGER(), fmt::format("Frame received from device with sender ID: 0x{:x} sent for API processing", sender_id));
-                std::vector<uint8_t> data(frame.data, frame.data + frame.can_dlc);
-                generate_frames.sendFrame(frame.can_id, data, socket_api, DATA_FRAME);
+                /* Forwarded as is, straight from the received frame */
+                generate_frames.sendFrame(frame.can_id, frame.data, frame.len, socket_api, DATA_FRAME);
                 LOG_DEBUG(MCULogger->GET_LOGGER(), fmt::format("Frame with ID: 0x{:x} sent on API socket", frame.can_id));
-            } 
+            }
+        } 
 
-            if (sender_id == 0xFA && receiver_id != hex_value_id) 
+        if (sender_id == 0xFA && receiver_id != hex_value_id) 
+        {
+            if(frame.data[1] == 0x99)
+            {
+                /** sends back to api a response with all ECUs IDs that are up 
+                    response structure: 
+                    id: MCU_id + API_id 
+                    data: {PCI_L, SID(0xD9), MCU_id, BATTERY_id, DOORS_id, ENGINE_id, ECU4_id}
+                */
+                LOG_INFO(MCULogger->GET_LOGGER(), "Received frame to update status of ECUs still up.");
+                std::array<uint8_t, MCU_ECU_COUNT> ecus_up = getECUsUp();
+                generate_frames.sendFrame(0x10FA,{0x06, 0xD9, MCU_ID, ecus_up[0], ecus_up[1], ecus_up[2], ecus_up[3]}, socket_api, DATA_FRAME);
+                LOG_INFO(MCULogger->GET_LOGGER(), "Frame sent to API on API socket to update status of ECUs still up.");
+            }
+            else
             {
-                if(frame.data[1] == 0x99)
+                std::vector<uint8_t> data(frame.data, frame.data + frame.len);
+                LOG_DEBUG(MCULogger->GET_LOGGER(), fmt::format("Received frame for ECU to execute service with SID: 0x{:x}", frame.data[1]));
+                /* Transfer data service need to have the data in the request body.
+                    Here, if we have a transfer data request, we add the data to the request.
+                    This is needed only if the transfer data request does not already contain the data to be sent => it's size == 3 (pci, sid, bl_indx)
+                */
+                if(frame.data[1] == TRANSFER_DATA_SID && data.size() == 3)
+                {
+                    TransferData::processDataForTransfer(receiver_id, data, socket_canbus, *MCULogger);
+                }
+                else if (frame.data[1] == 0x34 && frame.len > 2)
+                {
+                    /* Request Download: with the block compression method the image is compressed while it is sent */
+                    TransferData::setDataFormat(receiver_id, frame.data[2]);
+                }
+                if (data.size() > CAN_MAX_DLEN)
                 {
-                    /** sends back to api a response with all ECUs IDs that are up 
-                        response structure: 
-                        id: MCU_id + API_id 
-                        data: {PCI_L, SID(0xD9), MCU_id, BATTERY_id, DOORS_id, ENGINE_id, ECU4_id}
-                    */
-                    LOG_INFO(MCULogger->GET_LOGGER(), "Received frame to update status of ECUs still up.");
-                    generate_frames.sendFrame(0x10FA,{0x06, 0xD9, MCU_ID, ecus_up[0], ecus_up[1], ecus_up[2], ecus_up[3]}, socket_api, DATA_FRAME);
-                    LOG_INFO(MCULogger->GET_LOGGER(), "Frame sent to API on API socket to update status of ECUs still up.");
+                    /* Transfer data block bigger than a frame: multi-frame request, following the flow control of the ECU */
+                    IsoTpTransmitter::getInstance().send(socket_canbus, frame.can_id, std::vector<uint8_t>(data.begin() + 1, data.end()), *MCULogger);
                 }
                 else
                 {
-                    std::vector<uint8_t> data(frame.data, frame.data + frame.can_dlc);
-                    LOG_DEBUG(MCULogger->GET_LOGGER(), fmt::format("Received frame for ECU to execute service with SID: 0x{:x}", frame.data[1]));
-                    /* Transfer data service need to have the data in the request body.
-                        Here, if we have a transfer data request, we add the data to the request.
-                        This is needed only if the transfer data request does not already contain the data to be sent => it's size == 3 (pci, sid, bl_indx)
-                    */
-                    if(frame.data[1] == TRANSFER_DATA_SID && data.size() == 3)
-                    {
-                        TransferData::processDataForTransfer(receiver_id, data, socket_canbus, *MCULogger);
-                    }
                     generate_frames.sendFrame(frame.can_id, data);
-                    LOG_DEBUG(MCULogger->GET_LOGGER(), fmt::format("Frame with ID: 0x{:x} sent on CANBus socket", frame.can_id));
                 }
-            }
-
-            if (!listen_api && !listen_canbus) 
-            {
-                break;
+                LOG_DEBUG(MCULogger->GET_LOGGER(), fmt::format("Frame with ID: 0x{:x} sent on CANBus socket", frame.can_id));
             }
         }
     }
@@ -277,68 +399,67 @@ bool ReceiveFrames::receiveFramesFromAPI()
         LOG_INFO(MCULogger->GET_LOGGER(), "Started frame processing timing for frame with SID {:x} with max_time = {}.", sid, timer_value);
 
         auto start_time = std::chrono::steady_clock::now();
-        mcu->timing_parameters[sid] = start_time.time_since_epoch().count();
+        MCUModule::timing_parameters[sid] = start_time.time_since_epoch().count();
 
+        /* A new request for the same SID makes the previous deadline stale */
+        uint32_t generation = ++timer_generations[sid];
         /* Initialize stop flag for this SID */
-        mcu->stop_flags[sid] = true;
+        MCUModule::stop_flags[sid] = true;
 
-        mcu->active_timers[sid] = std::async(std::launch::async, [sid, this, start_time, timer_value]()
-        {
-            while (mcu->stop_flags[sid])
-            {
-                auto now = std::chrono::steady_clock::now();
-                std::chrono::duration<double> elapsed = now - start_time;
-                if (elapsed.count() > timer_value / 20.0)
-                { 
-                    stopTimer(sid);
-                }
-                std::this_thread::sleep_for(std::chrono::milliseconds(10));
-            }
-        });
+        /* The deadline is dropped if the service clears the stop flag before it expires */
+        response_timers.schedule(timer_value * P2_TIME_UNIT_MS,
+            [this, sid, generation]() { return MCUModule::stop_flags[sid] && timer_generations[sid] == generation; },
+            [this, sid]() { stopTimer(sid); });
     }
 
     void ReceiveFrames::stopTimer(uint8_t sid) {
         LOG_INFO(MCULogger->GET_LOGGER(), "stopTimer function called for frame with SID {:x}.", sid);
 
         auto end_time = std::chrono::steady_clock::now();
-        auto start_time = std::chrono::steady_clock::time_point(std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::nanoseconds((long long)mcu->timing_parameters[sid])));
+        auto start_time = std::chrono::steady_clock::time_point(std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::nanoseconds((long long)MCUModule::timing_parameters[sid])));
         std::chrono::duration<double> processing_time = end_time - start_time;
 
-        mcu->timing_parameters[sid] = processing_time.count();
+        MCUModule::timing_parameters[sid] = processing_time.count();
 
-        if (mcu->active_timers.find(sid) != mcu->active_timers.end())
+        /* Still pending: the service did not answer in time, tell the client to wait */
+        if (MCUModule::stop_flags[sid].exchange(false))
         {
-            /* Set stop flag to false for this SID */
-            if(mcu->stop_flags[sid])
-            {
-                int id = ((sid & 0xFF) << 8) | ((sid >> 8) & 0xFF);
-                LOG_INFO(MCULogger->GET_LOGGER(), "Service with SID {:x} sent the response pending frame.", sid);
-                NegativeResponse negative_response(socket_api, *MCULogger);
-                negative_response.sendNRC(id, sid, 0x78);
-                mcu->stop_flags[sid] = false;
-            }
-            mcu->stop_flags.erase(sid);
-            mcu->active_timers[sid].wait();
+            int id = ((sid & 0xFF) << 8) | ((sid >> 8) & 0xFF);
+            LOG_INFO(MCULogger->GET_LOGGER(), "Service with SID {:x} sent the response pending frame.", sid);
+            NegativeResponse negative_response(socket_api, *MCULogger);
+            negative_response.sendNRC(id, sid, 0x78);
         }
     }
 
+    size_t ReceiveFrames::getPendingTimers() const
+    {
+        return response_timers.getPendingCount();
+    }
+
+    long long ReceiveFrames::queueLatencyUs(const TimestampedFrame& queued_frame)
+    {
+        struct timespec now;
+        clock_gettime(CLOCK_REALTIME, &now);
+        return (now.tv_sec - queued_frame.timestamp.tv_sec) * 1000000LL +
+               (now.tv_nsec - queued_frame.timestamp.tv_nsec) / 1000;
+    }
+
     void ReceiveFrames::resetTimer(uint8_t ecu_id) {
-        std::lock_guard<std::mutex> lock(queue_mutex);
-        ecu_timers[ecu_id] = std::chrono::steady_clock::now();
+        liveness.heartbeat(ecu_id);
     }
 
     /**
      * Function to print the frames.
      */
-    void ReceiveFrames::printFrames(const struct can_frame &frame)
+    void ReceiveFrames::printFrames(const struct canfd_frame &frame)
     {
         LOG_DEBUG(MCULogger->GET_LOGGER(), "");
         LOG_DEBUG(MCULogger->GET_LOGGER(), "Received CAN frame");
         LOG_DEBUG(MCULogger->GET_LOGGER(), "Module ID: 0x{:x}", frame.can_id);
-        LOG_DEBUG(MCULogger->GET_LOGGER(), "Data Length: {}", int(frame.can_dlc));
+        LOG_DEBUG(MCULogger->GET_LOGGER(), "Data Length: {}", int(frame.len));
         std::ostringstream dataStream;
         dataStream << "Data:";
-        for (int frame_byte = 0; frame_byte < frame.can_dlc; ++frame_byte) 
+        for (int frame_byte = 0; frame_byte < frame.len; ++frame_byte) 
         {
             dataStream << " 0x" << std::hex << int(frame.data[frame_byte]);
         }
@@ -349,25 +470,23 @@ bool ReceiveFrames::receiveFramesFromAPI()
     void ReceiveFrames::stopListenAPI()
     {
         listen_api = false;
-        queue_cond_var.notify_all();
+        frame_queue.wakeUp();
     }
 
     void ReceiveFrames::stopListenCANBus()
     {
         listen_canbus = false;
-        queue_cond_var.notify_all();
+        frame_queue.wakeUp();
     }
 
     void ReceiveFrames::startListenAPI()
     {
         ReceiveFrames::listen_api = true;
-        queue_cond_var.notify_all();
     }
 
     void ReceiveFrames::startListenCANBus()
     {
         listen_canbus = true;
-        queue_cond_var.notify_all();
     }
 
     bool ReceiveFrames::getListenAPI()
@@ -380,45 +499,54 @@ bool ReceiveFrames::receiveFramesFromAPI()
         return listen_canbus;
     }
 
-    const uint8_t* ReceiveFrames::getECUsUp() const {
+    std::array<uint8_t, MCU_ECU_COUNT> ReceiveFrames::getECUsUp() const {
+        std::array<uint8_t, MCU_ECU_COUNT> ecus_up = {0};
+        uint32_t status = liveness.getStatusBitmap();
+        for (uint8_t index = 0; index < MCU_ECU_COUNT; ++index)
+        {
+            if (status & (1u << index))
+            {
+                ecus_up[index] = LIVENESS_FIRST_ECU_ID + index;
+            }
+        }
         return ecus_up;
     }
 
+    void ReceiveFrames::setHeartbeatInterval(uint8_t ecu_id, unsigned interval_ms)
+    {
+        liveness.setHeartbeatInterval(ecu_id, interval_ms);
+    }
+
     void ReceiveFrames::stopProcessingQueue()
     {
         process_queue = false;
+        frame_queue.wakeUp();
+    }
+
+    size_t ReceiveFrames::getQueueOccupancy() const
+    {
+        return frame_queue.size();
+    }
+
+    uint64_t ReceiveFrames::getDroppedFrames() const
+    {
+        return frame_queue.getDroppedFrames();
     }
     void ReceiveFrames::startTimerThread()
     {
-        running = true;
-        timer_thread = std::thread(&ReceiveFrames::timerCheck, this);
+        liveness.start();
     }
 
     void ReceiveFrames::stopTimerThread() {
-        running = false;
-        if (timer_thread.joinable()) {
-            timer_thread.join();
-        }
+        liveness.stop();
     }
 
-    void ReceiveFrames::timerCheck()
+    void ReceiveFrames::probeEcu(uint8_t ecu_id)
     {
-        while (running) {
-            std::this_thread::sleep_for(std::chrono::seconds(1));
-            auto now = std::chrono::steady_clock::now();
-            std::lock_guard<std::mutex> lock(queue_mutex);
-            for (auto it = ecu_timers.begin(); it != ecu_timers.end();) {
-                if (std::chrono::duration_cast<std::chrono::seconds>(now - it->second) >= timeout_duration) {
-                        ecus_up[(it->first-0x11)] = 0;
-                    std::vector<uint8_t> data = {0x01, 0x99};
-                    uint16_t id = (0x10 << 8) | it->first;
-                    ReceiveFrames::generate_frames.sendFrame(id, data);
-                    it = ecu_timers.erase(it);
-                } else {
-                    ++it;
-                }
-            }
-        }
+        LOG_DEBUG(MCULogger->GET_LOGGER(), "ECU with ID: 0x{:x} was silent for {} ms, sending probe.", ecu_id, liveness.getHeartbeatInterval(ecu_id));
+        std::vector<uint8_t> data = {0x01, 0x99};
+        uint16_t id = (0x10 << 8) | ecu_id;
+        generate_frames.sendFrame(id, data);
     }
     void ReceiveFrames::securityNotifyECU(std::vector<uint8_t> response)
     {
@@ -0,0 +1,138 @@
+/**
+ * @file DispatchLanesTest.cpp
+ * @brief Unit test for DispatchLanes
+ * @version 0.1
+ * @date 2024-08-23
+ */
+#include "../include/DispatchLanes.h"
+
+#include <map>
+#include <set>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <chrono>
+#include <gtest/gtest.h>
+
+using namespace MCU;
+
+static TimestampedFrame makeFrame(uint8_t sender_id, uint8_t receiver_id, uint8_t value)
+{
+    struct can_frame frame = {};
+    frame.can_id = (sender_id << 8) | receiver_id;
+    frame.can_dlc = 2;
+    frame.data[0] = 0x01;
+    frame.data[1] = value;
+    return TimestampedFrame(frame);
+}
+
+TEST(DispatchLanesTest, DistinctLanesForModules)
+{
+    DispatchLanes lanes([](const TimestampedFrame&) {});
+    ASSERT_EQ(lanes.getLaneCount(), static_cast<size_t>(DEFAULT_DISPATCH_LANES));
+
+    /* Requests from the API for each module */
+    size_t mcu_lane = lanes.laneFor(0xFA, 0x10);
+    size_t battery_lane = lanes.laneFor(0xFA, 0x11);
+    size_t engine_lane = lanes.laneFor(0xFA, 0x12);
+    size_t doors_lane = lanes.laneFor(0xFA, 0x13);
+    size_t hvac_lane = lanes.laneFor(0xFA, 0x14);
+    std::set<size_t> used = {mcu_lane, battery_lane, engine_lane, doors_lane, hvac_lane};
+    EXPECT_EQ(used.size(), 5u);
+
+    /* Notifications for the MCU share the MCU lane, responses for the API follow their sender */
+    EXPECT_EQ(lanes.laneFor(0x12, 0x10), mcu_lane);
+    EXPECT_EQ(lanes.laneFor(0x12, 0xFA), engine_lane);
+}
+
+TEST(DispatchLanesTest, KeepsOrderPerPair)
+{
+    std::mutex results_mutex;
+    std::map<uint16_t, std::vector<uint8_t>> results;
+    DispatchLanes lanes([&](const TimestampedFrame& queued_frame)
+    {
+        std::lock_guard<std::mutex> lock(results_mutex);
+        results[queued_frame.frame.can_id & 0xFFFF].push_back(queued_frame.frame.data[1]);
+    });
+    lanes.start();
+    for (uint8_t value = 0; value < 100; ++value)
+    {
+        EXPECT_TRUE(lanes.dispatch(makeFrame(0xFA, 0x11, value)));
+        EXPECT_TRUE(lanes.dispatch(makeFrame(0xFA, 0x12, value)));
+        EXPECT_TRUE(lanes.dispatch(makeFrame(0x13, 0xFA, value)));
+    }
+    lanes.stop();
+
+    ASSERT_EQ(results.size(), 3u);
+    for (const auto& pair : results)
+    {
+        ASSERT_EQ(pair.second.size(), 100u);
+        for (uint8_t value = 0; value < 100; ++value)
+        {
+            EXPECT_EQ(pair.second[value], value);
+        }
+    }
+}
+
+TEST(DispatchLanesTest, SlowLaneDoesNotBlockOthers)
+{
+    std::atomic<bool> release_engine{false};
+    std::atomic<int> battery_frames{0};
+    DispatchLanes lanes([&](const TimestampedFrame& queued_frame)
+    {
+        uint8_t receiver_id = queued_frame.frame.can_id & 0xFF;
+        if (receiver_id == 0x12)
+        {
+            /* Simulates a long service (e.g. a flash) on the engine ECU */
+            while (!release_engine)
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        }
+        else
+        {
+            battery_frames++;
+        }
+    });
+    lanes.start();
+    lanes.dispatch(makeFrame(0xFA, 0x12, 0x36));
+    for (uint8_t value = 0; value < 10; ++value)
+    {
+        lanes.dispatch(makeFrame(0xFA, 0x11, value));
+    }
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+    while (battery_frames < 10 && std::chrono::steady_clock::now() < deadline)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    EXPECT_EQ(battery_frames, 10);
+    release_engine = true;
+    lanes.stop();
+}
+
+TEST(DispatchLanesTest, StopDrainsLanes)
+{
+    std::atomic<int> processed{0};
+    DispatchLanes lanes([&](const TimestampedFrame&)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        processed++;
+    }, 2);
+    lanes.start();
+    EXPECT_TRUE(lanes.isRunning());
+    for (uint8_t value = 0; value < 20; ++value)
+    {
+        lanes.dispatch(makeFrame(0xFA, 0x11, value));
+    }
+    lanes.stop();
+    EXPECT_FALSE(lanes.isRunning());
+    EXPECT_EQ(processed, 20);
+    EXPECT_EQ(lanes.getLaneOccupancy(lanes.laneFor(0xFA, 0x11)), 0u);
+}
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,163 @@
+/**
+ * @file LivenessTrackerTest.cpp
+ * @brief Unit test for LivenessTracker
+ * @version 0.1
+ * @date 2024-08-27
+ */
+#include <gtest/gtest.h>
+#include <vector>
+#include <mutex>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include "../include/LivenessTracker.h"
+
+using namespace MCU;
+
+/* Test fixture class for LivenessTracker tests */
+class LivenessTrackerTest : public ::testing::Test
+{
+protected:
+    std::mutex probes_mutex;
+    std::vector<uint8_t> probes;
+    std::vector<uint8_t> downs;
+    LivenessTracker* liveness;
+    std::atomic<bool> answer_probes{false};
+
+    virtual void SetUp()
+    {
+        /* 200 ms heartbeat, 100 ms to answer a probe */
+        liveness = new LivenessTracker(
+            [this](uint8_t ecu_id) {
+                {
+                    std::lock_guard<std::mutex> lock(probes_mutex);
+                    probes.push_back(ecu_id);
+                }
+                if (answer_probes)
+                {
+                    liveness->heartbeat(ecu_id);
+                }
+            },
+            [this](uint8_t ecu_id) {
+                std::lock_guard<std::mutex> lock(probes_mutex);
+                downs.push_back(ecu_id);
+            },
+            200, 100);
+        liveness->start();
+    }
+
+    virtual void TearDown()
+    {
+        delete liveness;
+    }
+};
+
+/* Test that a heartbeat sets the bit of the ECU in the status bitmap */
+TEST_F(LivenessTrackerTest, HeartbeatSetsStatus)
+{
+    EXPECT_EQ(liveness->getStatusBitmap(), 0u);
+    liveness->heartbeat(0x11);
+    liveness->heartbeat(0x14);
+    EXPECT_TRUE(liveness->isUp(0x11));
+    EXPECT_FALSE(liveness->isUp(0x12));
+    EXPECT_TRUE(liveness->isUp(0x14));
+    EXPECT_EQ(liveness->getStatusBitmap(), 0x9u);
+    EXPECT_TRUE(liveness->isTracked(0x14));
+    /* Ids outside the bitmap are tracked but have no status bit */
+    liveness->heartbeat(0xFA);
+    EXPECT_TRUE(liveness->isTracked(0xFA));
+    EXPECT_FALSE(liveness->isUp(0xFA));
+}
+
+/* Test that a silent ECU is probed, then marked as down */
+TEST_F(LivenessTrackerTest, SilentEcuMarkedDown)
+{
+    liveness->heartbeat(0x12);
+    std::this_thread::sleep_for(std::chrono::milliseconds(250));
+    {
+        std::lock_guard<std::mutex> lock(probes_mutex);
+        ASSERT_EQ(probes.size(), 1u);
+        EXPECT_EQ(probes[0], 0x12);
+        EXPECT_TRUE(downs.empty());
+    }
+    /* Still up while the probe can be answered */
+    EXPECT_TRUE(liveness->isUp(0x12));
+    std::this_thread::sleep_for(std::chrono::milliseconds(150));
+    EXPECT_FALSE(liveness->isUp(0x12));
+    EXPECT_FALSE(liveness->isTracked(0x12));
+    std::lock_guard<std::mutex> lock(probes_mutex);
+    ASSERT_EQ(downs.size(), 1u);
+    EXPECT_EQ(downs[0], 0x12);
+}
+
+/* Test that an ECU answering the probes stays up */
+TEST_F(LivenessTrackerTest, AnsweredProbeKeepsEcuUp)
+{
+    answer_probes = true;
+    liveness->heartbeat(0x13);
+    std::this_thread::sleep_for(std::chrono::milliseconds(700));
+    EXPECT_TRUE(liveness->isUp(0x13));
+    std::lock_guard<std::mutex> lock(probes_mutex);
+    EXPECT_GE(probes.size(), 2u);
+    EXPECT_TRUE(downs.empty());
+}
+
+/* Test that heartbeats push the deadline and keep the ECU from being probed */
+TEST_F(LivenessTrackerTest, HeartbeatPushesDeadline)
+{
+    liveness->heartbeat(0x11);
+    auto first_deadline = liveness->getDeadline(0x11);
+    for (int beat = 0; beat < 5; ++beat)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        liveness->heartbeat(0x11);
+    }
+    EXPECT_GT(liveness->getDeadline(0x11), first_deadline);
+    std::lock_guard<std::mutex> lock(probes_mutex);
+    EXPECT_TRUE(probes.empty());
+}
+
+/* Test that each ECU uses its own heartbeat interval */
+TEST_F(LivenessTrackerTest, PerEcuInterval)
+{
+    EXPECT_EQ(liveness->getHeartbeatInterval(0x11), 200u);
+    liveness->setHeartbeatInterval(0x11, 50);
+    liveness->setHeartbeatInterval(0x12, 1000);
+    EXPECT_EQ(liveness->getHeartbeatInterval(0x11), 50u);
+    liveness->heartbeat(0x12);
+    liveness->heartbeat(0x11);
+    std::this_thread::sleep_for(std::chrono::milliseconds(120));
+    std::lock_guard<std::mutex> lock(probes_mutex);
+    ASSERT_EQ(probes.size(), 1u);
+    EXPECT_EQ(probes[0], 0x11);
+}
+
+/* Test that frequent heartbeats do not grow the heap without bound */
+TEST_F(LivenessTrackerTest, HeapStaysBounded)
+{
+    for (int beat = 0; beat < 10000; ++beat)
+    {
+        liveness->heartbeat(0x11 + beat % 4);
+    }
+    EXPECT_LE(liveness->getHeapSize(), 1024u);
+    EXPECT_EQ(liveness->getStatusBitmap(), 0xFu);
+}
+
+/* Test that stop keeps the status and start resumes the deadlines */
+TEST_F(LivenessTrackerTest, StopAndStart)
+{
+    EXPECT_TRUE(liveness->isRunning());
+    liveness->heartbeat(0x11);
+    liveness->stop();
+    EXPECT_FALSE(liveness->isRunning());
+    EXPECT_TRUE(liveness->isUp(0x11));
+    liveness->start();
+    std::this_thread::sleep_for(std::chrono::milliseconds(400));
+    EXPECT_FALSE(liveness->isUp(0x11));
+}
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -4,6 +4,7 @@
 #include <linux/can.h>
 #include "../../utils/include/Logger.h"
 #include "../../utils/include/GenerateFrames.h"
+#include "../../utils/include/DidStore.h"
 #include "../../ecu_simulation/BatteryModule/include/BatteryModule.h"
 
 int socket_canbus = -1;
@@ -226,30 +227,34 @@ TEST_F(MCUModuleTest, GetDIDValue)
     delete MCU::mcu;
 }
 
-TEST_F(MCUModuleTest, WriteFailMCUData)
+TEST_F(MCUModuleTest, WriteKeptMCUData)
 {
-    std::ofstream outfile("old_mcu_data.txt");
+    std::string path = std::string(PROJECT_PATH) + "/backend/mcu/mcu_data.db";
     MCU::mcu = new MCU::MCUModule(0x01);
     createMCUProcess();
+    /* Values marked by a key off reset are kept when the module starts again */
+    DidStore::forFile(path).set(0xE001, {0x12});
+    DidStore::forFile(path).keepValuesOnRestart();
     MCU::mcu->writeDataToFile();
+    std::vector<uint8_t> value;
+    EXPECT_TRUE(DidStore::forFile(path).get(0xE001, value));
+    EXPECT_EQ(value, std::vector<uint8_t>({0x12}));
     delete MCU::mcu;
-    outfile.close();
 }
 
 TEST_F(MCUModuleTest, WriteExceptionThrown)
 {
     MCU::mcu = new MCU::MCUModule(0x01);
     createMCUProcess();
-    std::string path = "mcu_data.txt";
-    std::ofstream outfile(path);
-    chmod(path.c_str(), 0);
+    /* A directory in place of the DID database */
+    std::string path = std::string(PROJECT_PATH) + "/backend/mcu/mcu_data.db";
+    std::remove(path.c_str());
+    mkdir(path.c_str(), 0777);
     EXPECT_THROW(
     {
         MCU::mcu->writeDataToFile();
     }, std::runtime_error);
-    path = "mcu_data.txt";
-    chmod(path.c_str(), 0666);
-    outfile.close();
+    rmdir(path.c_str());
     delete MCU::mcu;
     /* Restore the file */
     MCU::mcu = new MCU::MCUModule(0x01);
@@ -22,15 +22,11 @@ class MockReceiveFrames : public MCU::ReceiveFrames
 public:
     MockReceiveFrames(int socket_api, int socket_canbus) : ReceiveFrames(socket_api, socket_canbus) {}
     using ReceiveFrames::frame_queue;
-    using ReceiveFrames::queue_mutex;
-    using ReceiveFrames::queue_cond_var;
     using ReceiveFrames::printFrames;
     using ReceiveFrames::resetTimer;
     using ReceiveFrames::startTimerThread;
     using ReceiveFrames::stopTimerThread;
-    using ReceiveFrames::ecu_timers;
-    using ReceiveFrames::timeout_duration;
-    using ReceiveFrames::running;
+    using ReceiveFrames::liveness;
 };
 
 class CaptureFrame
@@ -147,12 +143,8 @@ TEST_F(ReceiveFramesTest, TestProcessQueue_SecurityLocked)
     }
     frame.data[1] = 0x34;
     receive_frames->startListenCANBus(); 
-    {
-        std::lock_guard<std::mutex> lock(receive_frames->queue_mutex);
-        /* Push frame to queue */
-        receive_frames->frame_queue.push(frame);
-    }
-    receive_frames->queue_cond_var.notify_one();
+    /* Push frame to queue */
+    receive_frames->frame_queue.push(frame);
     testing::internal::CaptureStdout();
     std::thread processor_thread([this] {
         receive_frames->processQueue();
@@ -177,12 +169,8 @@ TEST_F(ReceiveFramesTest, TestProcessQueue_TransferData)
     }
     frame.data[1] = 0x36;
     receive_frames->startListenCANBus(); 
-    {
-        std::lock_guard<std::mutex> lock(receive_frames->queue_mutex);
-        /* Push frame to queue */
-        receive_frames->frame_queue.push(frame);
-    }
-    receive_frames->queue_cond_var.notify_one();
+    /* Push frame to queue */
+    receive_frames->frame_queue.push(frame);
     testing::internal::CaptureStdout();
     std::thread processor_thread([this] {
         receive_frames->processQueue();
@@ -231,12 +219,8 @@ TEST_F(ReceiveFramesTest, UnlockedSecurity)
     }
     frame.data[1] = 0x22;
     receive_frames->startListenCANBus(); 
-    {
-        std::lock_guard<std::mutex> lock(receive_frames->queue_mutex);
-        /* Push frame to queue */
-        receive_frames->frame_queue.push(frame);
-    }
-    receive_frames->queue_cond_var.notify_one();
+    /* Push frame to queue */
+    receive_frames->frame_queue.push(frame);
     
     testing::internal::CaptureStdout();
     std::thread processor_thread([this] {
@@ -328,6 +312,45 @@ TEST_F(ReceiveFramesTest, TestReceiveFramesFromAPI_Success)
     reader_thread.join();
     std::cerr << "Finished TestReceiveFramesFromAPI_Success" << std::endl;
 }
+/* Test the reactor picks up frames from both sockets */
+TEST_F(ReceiveFramesTest, TestReceiveFramesReactor_Success)
+{
+    std::cerr << "Running TestReceiveFramesReactor_Success" << std::endl;
+    struct can_frame frame;
+    frame.can_id = 0xFA10;
+    frame.can_dlc = 2;
+    frame.data[0] = 0x01;
+    frame.data[1] = 0x3E;
+    write(mock_socket_pair_canbus[1], &frame, sizeof(frame));
+    frame.can_id = 0xFA11;
+    write(mock_socket_pair_api[1], &frame, sizeof(frame));
+
+    receive_frames->startListenCANBus();
+    receive_frames->startListenAPI();
+    std::thread receiver_thread([this]{
+        bool result = receive_frames->receiveFrames();
+        EXPECT_EQ(result, true);
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    receive_frames->stopListenCANBus();
+    receive_frames->stopListenAPI();
+    receiver_thread.join();
+    EXPECT_EQ(receive_frames->frame_queue.size(), 2);
+    std::cerr << "Finished TestReceiveFramesReactor_Success" << std::endl;
+}
+/* Test the reactor reports an invalid socket */
+TEST_F(ReceiveFramesTest, TestReceiveFramesReactor_ReadError)
+{
+    std::cerr << "Running TestReceiveFramesReactor_ReadError" << std::endl;
+    close(mock_socket_canbus);
+    receive_frames->startListenCANBus();
+    receive_frames->startListenAPI();
+    bool result = receive_frames->receiveFrames();
+    receive_frames->stopListenCANBus();
+    receive_frames->stopListenAPI();
+    EXPECT_EQ(result, false);
+    std::cerr << "Finished TestReceiveFramesReactor_ReadError" << std::endl;
+}
 /* Test to process queue with an MCU-specific CAN frame */
 TEST_F(ReceiveFramesTest, TestProcessQueue_ForMCU)
 {
@@ -342,12 +365,8 @@ TEST_F(ReceiveFramesTest, TestProcessQueue_ForMCU)
     }
     frame.data[1] = 0x22;
     receive_frames->startListenCANBus(); 
-    {
-        std::lock_guard<std::mutex> lock(receive_frames->queue_mutex);
-        /* Push frame to queue */
-        receive_frames->frame_queue.push(frame);
-    }
-    receive_frames->queue_cond_var.notify_one();
+    /* Push frame to queue */
+    receive_frames->frame_queue.push(frame);
     testing::internal::CaptureStdout();
     std::thread processor_thread([this] {
         receive_frames->processQueue();
@@ -382,12 +401,8 @@ TEST_F(ReceiveFramesTest, TestProcessQueue_ForBatteryUp)
     }
     frame.data[1] = 0xd9;
     receive_frames->startListenCANBus(); 
-    {
-        std::lock_guard<std::mutex> lock(receive_frames->queue_mutex);
-        /* Push frame to queue */
-        receive_frames->frame_queue.push(frame);
-    }
-    receive_frames->queue_cond_var.notify_one();
+    /* Push frame to queue */
+    receive_frames->frame_queue.push(frame);
     testing::internal::CaptureStdout();
     std::thread processor_thread([this] {
         receive_frames->processQueue();
@@ -418,12 +433,8 @@ TEST_F(ReceiveFramesTest, TestProcessQueue_ForEngineUp)
     }
     frame.data[1] = 0xd9;
     receive_frames->startListenCANBus(); 
-    {
-        std::lock_guard<std::mutex> lock(receive_frames->queue_mutex);
-        /* Push frame to queue */
-        receive_frames->frame_queue.push(frame);
-    }
-    receive_frames->queue_cond_var.notify_one();
+    /* Push frame to queue */
+    receive_frames->frame_queue.push(frame);
     testing::internal::CaptureStdout();
     std::thread processor_thread([this] {
         receive_frames->processQueue();
@@ -455,12 +466,8 @@ TEST_F(ReceiveFramesTest, TestProcessQueue_ForDoorsUp)
     }
     frame.data[1] = 0xd9;
     receive_frames->startListenCANBus(); 
-    {
-        std::lock_guard<std::mutex> lock(receive_frames->queue_mutex);
-        /* Push frame to queue */
-        receive_frames->frame_queue.push(frame);
-    }
-    receive_frames->queue_cond_var.notify_one();
+    /* Push frame to queue */
+    receive_frames->frame_queue.push(frame);
     testing::internal::CaptureStdout();
     std::thread processor_thread([this] {
         receive_frames->processQueue();
@@ -491,12 +498,8 @@ TEST_F(ReceiveFramesTest, TestProcessQueue_ForHVACUp)
     }
     frame.data[1] = 0xd9;
     receive_frames->startListenCANBus(); 
-    {
-        std::lock_guard<std::mutex> lock(receive_frames->queue_mutex);
-        /* Push frame to queue */
-        receive_frames->frame_queue.push(frame);
-    }
-    receive_frames->queue_cond_var.notify_one();
+    /* Push frame to queue */
+    receive_frames->frame_queue.push(frame);
     testing::internal::CaptureStdout();
     std::thread processor_thread([this] {
         receive_frames->processQueue();
@@ -527,12 +530,8 @@ TEST_F(ReceiveFramesTest, TestProcessQueue_ForDefaultUp)
     }
     frame.data[1] = 0xd9;
     receive_frames->startListenCANBus(); 
-    {
-        std::lock_guard<std::mutex> lock(receive_frames->queue_mutex);
-        /* Push frame to queue */
-        receive_frames->frame_queue.push(frame);
-    }
-    receive_frames->queue_cond_var.notify_one();
+    /* Push frame to queue */
+    receive_frames->frame_queue.push(frame);
     testing::internal::CaptureStdout();
     std::thread processor_thread([this] {
         receive_frames->processQueue();
@@ -564,12 +563,8 @@ TEST_F(ReceiveFramesTest, TestProcessQueue_ForECU)
     }
     frame.data[1] = 0x22;
     receive_frames->startListenAPI(); 
-    {
-        std::lock_guard<std::mutex> lock(receive_frames->queue_mutex);
-        /* Push frame to queue */
-        receive_frames->frame_queue.push(frame);
-    }
-    receive_frames->queue_cond_var.notify_one();
+    /* Push frame to queue */
+    receive_frames->frame_queue.push(frame);
     testing::internal::CaptureStdout();
     std::thread processor_thread([this] {
         receive_frames->processQueue();
@@ -602,12 +597,8 @@ TEST_F(ReceiveFramesTest, TestProcessQueue_ForECU2)
     }
     frame.data[1] = 0x27;
     receive_frames->startListenAPI(); 
-    {
-        std::lock_guard<std::mutex> lock(receive_frames->queue_mutex);
-        /* Push frame to queue */
-        receive_frames->frame_queue.push(frame);
-    }
-    receive_frames->queue_cond_var.notify_one();
+    /* Push frame to queue */
+    receive_frames->frame_queue.push(frame);
     testing::internal::CaptureStdout();
     std::thread processor_thread([this] {
         receive_frames->processQueue();
@@ -640,12 +631,8 @@ TEST_F(ReceiveFramesTest, TestProcessQueue_ForResponseWithECUsUp)
     }
     frame.data[1] = 0x99;
     receive_frames->startListenAPI(); 
-    {
-        std::lock_guard<std::mutex> lock(receive_frames->queue_mutex);
-        /* Push frame to queue */
-        receive_frames->frame_queue.push(frame);
-    }
-    receive_frames->queue_cond_var.notify_one();
+    /* Push frame to queue */
+    receive_frames->frame_queue.push(frame);
     testing::internal::CaptureStdout();
     std::thread processor_thread([this] {
         receive_frames->processQueue();
@@ -678,12 +665,8 @@ TEST_F(ReceiveFramesTest, TestProcessQueue_ForAPI)
         frame.data[itr] = itr;
     }
     receive_frames->startListenAPI(); 
-    {
-        std::lock_guard<std::mutex> lock(receive_frames->queue_mutex);
-        /* Push frame to queue */
-        receive_frames->frame_queue.push(frame);
-    }
-    receive_frames->queue_cond_var.notify_one();
+    /* Push frame to queue */
+    receive_frames->frame_queue.push(frame);
     testing::internal::CaptureStdout();
     std::thread processor_thread([this] {
         receive_frames->processQueue();
@@ -715,7 +698,7 @@ TEST_F(ReceiveFramesTest, TestPrintFrames)
         frame.data[itr] = itr;
     }
     testing::internal::CaptureStdout();
-    receive_frames->printFrames(frame);
+    receive_frames->printFrames(CanFd::toFdFrame(frame));
     std::string output = testing::internal::GetCapturedStdout();
     EXPECT_NE(output.find("Received CAN frame"), std::string::npos);
     EXPECT_NE(output.find("Module ID: 0x123"), std::string::npos);
@@ -784,7 +767,7 @@ TEST_F(ReceiveFramesTest, TestGetListenCANBus)
 TEST_F(ReceiveFramesTest, TestGetECUsUp)
 {
     std::cerr << "Running TestGetECUsUp" << std::endl;
-    const uint8_t* ecus_up = receive_frames->getECUsUp();
+    std::array<uint8_t, MCU_ECU_COUNT> ecus_up = receive_frames->getECUsUp();
     // Assuming initial state is all zeros
     for (int i = 0; i < 4; ++i) {
         EXPECT_EQ(ecus_up[i], 0);
@@ -809,10 +792,10 @@ TEST_F(ReceiveFramesTest, TestStartTimerThread)
     std::cerr << "Running TestStartTimerThread" << std::endl;
     receive_frames->stopTimerThread();
     receive_frames->startTimerThread();
-    EXPECT_TRUE(receive_frames->running);
+    EXPECT_TRUE(receive_frames->liveness.isRunning());
     std::this_thread::sleep_for(std::chrono::seconds(2));
     receive_frames->stopTimerThread();
-    EXPECT_FALSE(receive_frames->running);
+    EXPECT_FALSE(receive_frames->liveness.isRunning());
     std::cerr << "Finished TestStartTimerThread" << std::endl;
 }
 
@@ -822,19 +805,13 @@ TEST_F(ReceiveFramesTest, TimerReset)
     std::cerr << "Running TimerReset" << std::endl;
     uint8_t ecu_id = 0x11;
     receive_frames->resetTimer(ecu_id);
-    {
-        std::lock_guard<std::mutex> lock(receive_frames->queue_mutex);
-        auto it = receive_frames->ecu_timers.find(ecu_id);
-        EXPECT_NE(it, receive_frames->ecu_timers.end());
-    }
+    EXPECT_TRUE(receive_frames->liveness.isTracked(ecu_id));
+    EXPECT_EQ(receive_frames->getECUsUp()[0], ecu_id);
     std::this_thread::sleep_for(std::chrono::seconds(1));
-    auto oldTimePoint = receive_frames->ecu_timers[ecu_id];
+    auto oldTimePoint = receive_frames->liveness.getDeadline(ecu_id);
     receive_frames->resetTimer(ecu_id);
-    {
-        std::lock_guard<std::mutex> lock(receive_frames->queue_mutex);
-        auto newTimePoint = receive_frames->ecu_timers[ecu_id];
-        EXPECT_GT(newTimePoint, oldTimePoint);
-    }
+    auto newTimePoint = receive_frames->liveness.getDeadline(ecu_id);
+    EXPECT_GT(newTimePoint, oldTimePoint);
     std::cerr << "Finished TimerReset" << std::endl;
 }
 
@@ -842,14 +819,12 @@ TEST_F(ReceiveFramesTest, TimerExpiryAndFrameSending)
 {
     std::cerr << "Running TimerExpiryAndFrameSending" << std::endl;
     uint8_t ecu_id = 0x11;
-    receive_frames->timeout_duration = std::chrono::seconds(2);
+    receive_frames->setHeartbeatInterval(ecu_id, 2000);
     receive_frames->resetTimer(ecu_id);
     std::this_thread::sleep_for(std::chrono::seconds(3));
-    {
-        std::lock_guard<std::mutex> lock(receive_frames->queue_mutex);
-        auto it = receive_frames->ecu_timers.find(ecu_id);
-        EXPECT_EQ(it, receive_frames->ecu_timers.end());
-    }
+    /* Probed after 2 s, then marked as down since nobody answers the probe */
+    EXPECT_FALSE(receive_frames->liveness.isTracked(ecu_id));
+    EXPECT_EQ(receive_frames->getECUsUp()[0], 0);
     std::cerr << "Finished TimerExpiryAndFrameSending" << std::endl;
 }
 
@@ -866,12 +841,8 @@ TEST_F(ReceiveFramesTest, TestStopTimer)
     }
     frame.data[1] = 0x22;
     receive_frames->startListenCANBus(); 
-    {
-        std::lock_guard<std::mutex> lock(receive_frames->queue_mutex);
-        /* Push frame to queue */
-        receive_frames->frame_queue.push(frame);
-    }
-    receive_frames->queue_cond_var.notify_one();
+    /* Push frame to queue */
+    receive_frames->frame_queue.push(frame);
     testing::internal::CaptureStdout();
     std::thread processor_thread([this] {
         receive_frames->processQueue();
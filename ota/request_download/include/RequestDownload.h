@@ -21,6 +21,8 @@
 #include <string>
 #include <utility>
 #include <chrono>
+#include <future>
+#include <memory>
 #include <sys/ioctl.h>
 #include <linux/can.h>
 #include <net/if.h>
@@ -32,11 +34,22 @@
 #include "SecurityAccess.h"
 #include "ReadDataByIdentifier.h"
 #include "MemoryManager.h"
+#include "IsoTpReassembler.h"
 #include <pybind11/embed.h>
 
 /* ECU permitted transfer data bytes in a request. Set to 5 because we use only 8 bytes for requests (1 pci, 1 sid, 1 blc_indx => remaining 5 bytes)*/
 #define MAX_TRANSER_DATA_BYTES 5
+/* Max data bytes in 1 transfer data sent as a multi-frame message: SID + block sequence counter + data must
+   fit in the 12-bit FF_DL, which is also the receive buffer of every IsoTpReassembler context */
+#define MAX_TRANSFER_DATA_BLOCK_BYTES (ISOTP_MAX_12BIT_LENGTH - 2)
 #define MAXIMUM_ALLOWED_DOWNLOAD_SIZE  50000000
+/* Compression method, upper nibble of the data format identifier:
+   ZIP = the archive is stored as sent and extracted by the write to file routine,
+   BLOCK = stream of BlockCodec frames, decompressed by Transfer Data before it is written in memory,
+   DELTA = DeltaPatch against the installed executable, applied by Transfer Data before it is written in memory */
+#define DATA_FORMAT_COMPRESSION_ZIP 0x1
+#define DATA_FORMAT_COMPRESSION_BLOCK 0x2
+#define DATA_FORMAT_COMPRESSION_DELTA 0x3
 
 /* Structure that contains information about the download. The values are set in the Request Download service.
     This informations are shared with Transfer Data & Routine Control in order to do the actions that are needed.
@@ -168,6 +181,14 @@ private:
      * @return can_frame* 
      */
     can_frame* read_frame(int id, uint8_t sid);
+    /**
+     * @brief Method to wait for the end of a multi-frame transmission. The flow control
+     * frames are handed over to the IsoTpTransmitter by the MCU receive path, not read here.
+     * 
+     * @param done Future set by the completion callback of the transmission.
+     * @return Result of the transmission.
+     */
+    IsoTpTransmitter::TransmitStatus wait_transmission(std::future<IsoTpTransmitter::TransmitStatus>& done);
     /**
      * @brief Method to download data in ECU
      * 
@@ -1,5 +1,6 @@
 #include "MCUModule.h"
 #include "RequestDownload.h"
+#include "TransferData.h"
 #include "BatteryModule.h"
 
 RDSData RequestDownloadService::rds_data = {0, 0, 0, 0};
@@ -79,9 +80,11 @@ void RequestDownloadService::requestDownloadRequest(canid_t id, std::vector<uint
      * 0x11 when both compression and encryption are used
      * 0x01 when only encryption is used
      * 0x10 when only compression is used
+     * 0x20 / 0x21 when the image is sent as a block compressed stream, decompressed while it is received
+     * 0x30 / 0x31 when only a patch against the installed executable is sent (delta update)
      * we can define more values later if needed
      */
-    std::unordered_set<uint8_t> valid_data_format_indentifiers = {0x00, 0x01, 0x10, 0x11};
+    std::unordered_set<uint8_t> valid_data_format_indentifiers = {0x00, 0x01, 0x10, 0x11, 0x20, 0x21, 0x30, 0x31};
     if (valid_data_format_indentifiers.find(stored_data[2]) == valid_data_format_indentifiers.end())
     {
         /* Request out of range - prepare a negative response */
@@ -129,6 +132,9 @@ void RequestDownloadService::requestDownloadRequest(canid_t id, std::vector<uint
         return;
     }
 
+    /* A transfer interrupted after a checkpoint resumes after the image bytes already written */
+    TransferData::validateCheckpoint(aux_can_id, memory_address, data_format_identifier, RDSlogger);
+
     RequestDownloadService::rds_data.max_number_block = calculate_max_number_block(memory_size);
     requestDownloadResponse(id, memory_address, RequestDownloadService::rds_data.max_number_block);
     FileManager::setDidValue(OTA_UPDATE_STATUS_DID, {WAIT_DOWNLOAD_COMPLETED}, aux_can_id, RDSlogger, socket);
@@ -139,9 +145,10 @@ void RequestDownloadService::requestDownloadRequest(canid_t id, std::vector<uint
 int RequestDownloadService::calculate_max_number_block(int memory_size)
 {
     /* max_number_block = maximum number of bytes for 1 transfer data 
-        This is set to 5 because in a transfer data we can send only 5 bytes of data (8 - pci - sid - blc_indx)
+        The transfer data requests are received as multi-frame messages, so a block is limited by the
+        ISO-TP receive buffer of this module, not by the 5 bytes of a single frame (8 - pci - sid - blc_indx).
     */
-    int max_number_block = MAX_TRANSER_DATA_BYTES;
+    int max_number_block = MAX_TRANSFER_DATA_BLOCK_BYTES;
     return max_number_block;    
 }
 
@@ -199,15 +206,17 @@ void RequestDownloadService::downloadInEcu(int id, int memory_address)
         /* Call transferData with the current block_sequence_counter */ 
         if ( data_to_send.size() >  5)
         {
-            generate_frames.transferDataLong(new_id,block_sequence_counter,data_to_send);
-            /* read flow control frame */
-            frame = read_frame(new_id, -0x10);
-            if (frame == NULL)
+            /* The consecutive frames follow the flow control frames of the ECU */
+            auto transmission = std::make_shared<std::promise<IsoTpTransmitter::TransmitStatus>>();
+            std::future<IsoTpTransmitter::TransmitStatus> done = transmission->get_future();
+            generate_frames.transferDataLong(new_id,block_sequence_counter,data_to_send, true,
+                [transmission](IsoTpTransmitter::TransmitStatus status) { transmission->set_value(status); });
+            if (wait_transmission(done) != IsoTpTransmitter::COMPLETE)
             {
+                LOG_ERROR(RDSlogger.GET_LOGGER(), "Timeout. Flow control frame not received!");
                 /* generate error frame*/
                 return;
             }
-            generate_frames.transferDataLong(new_id,block_sequence_counter,data_to_send, false);
         }
         else
         {
@@ -247,17 +256,16 @@ can_frame* RequestDownloadService::read_frame(int id, uint8_t sid)
 
         if (poll_result > 0 && pfd.revents & POLLIN) 
         {
-            can_frame* frame = new can_frame;
-            int nbytes = read(this->socket, frame, sizeof(*frame));
+            /* Room for a CAN FD frame, the ECU may answer in CAN FD */
+            struct canfd_frame received_frame;
+            int nbytes = read(this->socket, &received_frame, sizeof(received_frame));
 
             if (nbytes > 0) 
             {
-                if (((frame->can_id & 0xFF) == 0x10) && (frame->data[1] == sid+0x40))
+                if (((received_frame.can_id & 0xFF) == 0x10) && (received_frame.data[1] == sid+0x40))
                 {
-                    return frame;  
+                    return new can_frame(CanFd::toClassicFrame(received_frame));
                 }
-                /* Clean up if frame is not used */ 
-                delete frame;  
             }
         }
         end = std::chrono::system_clock::now();
@@ -268,6 +276,14 @@ can_frame* RequestDownloadService::read_frame(int id, uint8_t sid)
     return nullptr;
 }
 
+IsoTpTransmitter::TransmitStatus RequestDownloadService::wait_transmission(std::future<IsoTpTransmitter::TransmitStatus>& done)
+{
+    /* The flow control frames of the ECU reach the IsoTpTransmitter through the MCU receive path
+       (ReceiveFrames/HandleFrames); reading them here as well would handle every one twice.
+       The transmitter always ends the transmission, at the latest after N_Bs. */
+    return done.get();
+}
+
 /** RequestDownload -response handle --to be implemented 
  *  Expected response: pci_l + sid +  length_max_number_block*0x10  +  max_number_block
  *  Index              [0]     [1]         [2]                       [3]
@@ -17,6 +17,7 @@
 #include "Logger.h"
 #include "GenerateFrames.h"
 #include "NegativeResponse.h"
+#include "MemoryManager.h"
 
 /* Define the callback function type */
 using transferCompleteCallBack = std::function<bool(bool)>;
@@ -78,6 +78,14 @@ void RequestTransferExit::requestTRansferExitRequest(canid_t can_id, const std::
         /* Check if the transfer data has been completed */
         if (value == PROCESSING_TRANSFER_COMPLETE)        
         {
+            /* Barrier: the transfer data blocks are written in the background, wait until all of them are on the device */
+            if (!MemoryManager::getInstance(RTESLogger)->flushStagedWrites())
+            {
+                /* General programming failure - prepare a negative response */
+                nrc.sendNRC(can_id, RTES_SERVICE_ID, NegativeResponse::GPF);
+                FileManager::setDidValue(OTA_UPDATE_STATUS_DID, {PROCESSING_TRANSFER_FAILED}, aux_can_id, RTESLogger, socket);
+                return;
+            }
             /* prepare positive response */
             response.push_back(0x02); /* PCI */
             response.push_back(0x77); /* Service ID */
@@ -36,6 +36,8 @@
 #define OTA_UPDATE_STATUS_DID 0xE001
 #define OTA_UPDATE_STATUS_DID_MSB ((OTA_UPDATE_STATUS_DID & 0xFF00) >> 8)
 #define OTA_UPDATE_STATUS_DID_LSB (OTA_UPDATE_STATUS_DID & 0x00FF)
+/* Progress of the transfer saved by the ECU, used to resume an interrupted transfer (see TransferData) */
+#define OTA_TRANSFER_CHECKPOINT_DID 0xE002
 
 #define REQUEST_UPDATE_STATUS_SID           0x32
 #define REQUEST_UPDATE_STATUS_SID_SUCCESS   0x72
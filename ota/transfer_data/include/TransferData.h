@@ -9,13 +9,39 @@
 #define TRANSFER_DATA_H
 
 #include <linux/can.h>
+#include <map>
+#include <memory>
+#include <mutex>
 #include "Logger.h"
 #include "GenerateFrames.h"
 #include "MemoryManager.h"
+#include "FirmwareSource.h"
+#include "ImageDigest.h"
+#include "BlockCodec.h"
+#include "DeltaPatch.h"
 #include "NegativeResponse.h"
 #include "RequestTransferExit.h"
 
 #define TRANSFER_DATA_SID 0x36
+/* 1 = the digest record sent after the image has a SHA-256, 0 = CRC32C only */
+#ifndef OTA_SHA256_DIGEST
+#define OTA_SHA256_DIGEST 0
+#endif
+/* Image bytes received between 2 checkpoints of an image sent as it is */
+#define OTA_CHECKPOINT_INTERVAL_BYTES (256 * 1024)
+#define OTA_CHECKPOINT_LENGTH 16
+
+/* Progress of the transfer of an image sent as it is, saved by the ECU in OTA_TRANSFER_CHECKPOINT_DID as 4 numbers of 4 bytes,
+   MSB first. The image bytes before offset are on the device, after the size block written at address. */
+struct TransferCheckpoint
+{
+    uint32_t address = 0;
+    uint32_t image_size = 0;
+    uint32_t offset = 0;
+    /* CRC32C of the image bytes before offset */
+    uint32_t crc = 0;
+};
+
 class TransferData 
 {
 public:
@@ -38,14 +64,20 @@ public:
      */
     void transferData(canid_t can_id, std::vector<uint8_t>& transfer_request);
     /**
-     * @brief Static method to get checksums for validation in transfer exit
-     *    
+     * @brief Static method to get the digest of the image, computed while the blocks are received (ECU)
+     */
+    static const ImageDigest& getImageDigest();
+
+    /**
+     * @brief Static method to get the digest record received after the image, used by verify software.
+     *      Empty if the transfer is not complete.
      */
-    static const std::vector<uint8_t>& getChecksums();
+    static const std::vector<uint8_t>& getImageDigestRecord();
 
     /**
      * @brief Method used for processing data before it is added to the transfer data service request.
-     *      This will be used only in the MCU process, right before sending the request to the ECU
+     *      This will be used only in the MCU process, right before sending the request to the ECU.
+     *      Each ECU has its own transfer context, so the transfers to several ECUs run at the same time.
      * 
      * @param can_id
      * @param current_data
@@ -54,13 +86,57 @@ public:
      */
     static void processDataForTransfer(canid_t can_id, std::vector<uint8_t>& current_data, int socket, Logger& logger);
     /**
-     * @brief method used to compute a simple checksum for a block of data transferred
-     * 
-     * @param data pointer to the data block
-     * @param block_size te size of the data block
-     * @return 1 byte checksum
+     * @brief Method used by the MCU to remember the max_number_block negotiated by an ECU in its
+     *      Request Download response. The next transfer data requests to this ECU carry blocks of this size.
+     * @param ecu_id id of the ECU that sent the Request Download response
+     * @param max_number_block maximum number of data bytes in 1 transfer data
+     */
+    static void setMaxBlockLength(uint8_t ecu_id, size_t max_number_block);
+    /**
+     * @brief Method to get the max_number_block negotiated by an ECU
+     * @param ecu_id id of the ECU
+     * @return maximum number of data bytes in 1 transfer data, MAX_TRANSER_DATA_BYTES if nothing was negotiated
+     */
+    static size_t getMaxBlockLength(uint8_t ecu_id);
+    /**
+     * @brief Method used by the MCU to remember the data format identifier of the Request Download it forwards
+     *      to an ECU. With the BLOCK compression method the image is compressed while it is sent, with the
+     *      DELTA method only a patch against the installed executable of the ECU is sent.
+     * @param ecu_id id of the ECU the Request Download is sent to
+     * @param data_format data format identifier of the request
      */
-    static uint8_t computeChecksum(const uint8_t* data, size_t block_size);
+    static void setDataFormat(uint8_t ecu_id, uint8_t data_format);
+    /**
+     * @brief Method to get the data format identifier of the last Request Download sent to an ECU
+     * @param ecu_id id of the ECU
+     * @return data format identifier, 0x00 (no compression or encryption) if no request was sent
+     */
+    static uint8_t getDataFormat(uint8_t ecu_id);
+    /**
+     * @brief Method to read the transfer checkpoint of an ECU from its OTA_TRANSFER_CHECKPOINT_DID
+     * @param can_id frame id, the receiver is the ECU
+     * @param checkpoint receives the checkpoint
+     * @return true if the ECU has a checkpoint, false if there is none
+     */
+    static bool readCheckpoint(canid_t can_id, TransferCheckpoint& checkpoint, Logger& logger);
+    /**
+     * @brief Method to save or remove (empty offset) the transfer checkpoint of an ECU
+     * @param can_id frame id, the receiver is the ECU
+     * @param checkpoint checkpoint to save
+     */
+    static void writeCheckpoint(canid_t can_id, const TransferCheckpoint& checkpoint, Logger& logger);
+    /**
+     * @brief Method used by Request Download in the ECU to check the checkpoint of an interrupted transfer.
+     *      The image bytes already written are read back from the device and compared with the CRC32C of the
+     *      checkpoint. A valid checkpoint is kept and the transfer resumes after these bytes if the MCU sends
+     *      the same image; otherwise the checkpoint is removed and the transfer starts from byte zero.
+     * @param can_id frame id, the receiver is the ECU
+     * @param address memory address of the Request Download
+     * @param data_format data format identifier of the Request Download, a compressed stream or a delta patch
+     *      is not resumed
+     * @return true if the transfer can resume
+     */
+    static bool validateCheckpoint(canid_t can_id, int address, uint8_t data_format, Logger& logger);
 /********************************************************************/
 /************************* PUBLIC VARIABLES *************************/
 /********************************************************************/
@@ -80,8 +156,53 @@ private:
     size_t total_size;
     size_t bytes_sent;
     bool memory_write_status = false;
-    /* Static vector used in Request Transfer Exit thta contains the checksums for each chunk data transfer */
-    static std::vector<uint8_t>checksums;
+    /* Running digest of the image received (ECU) and the digest record received after it */
+    static ImageDigest image_digest;
+    static std::vector<uint8_t> image_digest_record;
+    /* Transfer from the MCU to one ECU: image, progress, digest and last block sequence counter */
+    struct TransferContext
+    {
+        /* Image sent to the ECU, the transfer data requests are filled from views of it */
+        FirmwareSource source;
+        size_t total_size = 0;
+        size_t bytes_sent = 0;
+        /* Data size of 1 transfer data */
+        size_t chunk_size = 0;
+        /* Image sent as a block compressed stream or as a delta patch: bytes prepared ahead of the requests,
+           part of them already sent */
+        bool compress_image = false;
+        bool delta_image = false;
+        std::vector<uint8_t> stream_data;
+        size_t stream_sent = 0;
+        /* Bytes sent on the bus, lower than bytes_sent when the image is compressed or patched */
+        size_t stream_bytes_sent = 0;
+        ImageDigest digest;
+        uint8_t block_sequence_counter = 0;
+    };
+
+    /**
+     * @brief Method to get the transfer context of an ECU, created on the first transfer to it (MCU).
+     *      The contexts are not removed, so the reference stays valid.
+     */
+    static TransferContext& getTransferContext(uint8_t ecu_id);
+
+    /* Transfer context of each ECU, so the MCU flashes several ECUs at the same time */
+    static std::map<uint8_t, std::unique_ptr<TransferContext>> transfer_contexts;
+    static std::mutex transfer_contexts_mutex;
+    /* max_number_block negotiated by each ECU, used by the MCU to fill the transfer data requests */
+    static std::map<uint8_t, size_t> max_block_lengths;
+    static std::mutex max_block_lengths_mutex;
+    /* Data format identifier of the Request Download sent to each ECU, used by the MCU */
+    static std::map<uint8_t, uint8_t> data_formats;
+    static std::mutex data_formats_mutex;
+    /* Decompression of the received blocks when the image is sent as a block compressed stream (ECU) */
+    static BlockStreamDecoder block_decoder;
+    /* Installed executable, base of a delta update, and the decoder rebuilding the new image from it (ECU) */
+    static FirmwareSource delta_base;
+    static DeltaPatchDecoder delta_decoder;
+    /* Checkpoint validated by Request Download and the digest of the image bytes before it (ECU) */
+    static TransferCheckpoint resume_checkpoint;
+    static ImageDigest resume_digest;
 };
 
 #endif
\ No newline at end of file
@@ -13,47 +13,188 @@ TransferData::TransferData(int socket, Logger transfer_data_logger)
 MemoryManager* TransferData::memory_manager = nullptr;
 uint8_t TransferData::expected_block_sequence_number = 0x01;  /* Start from 1 */
 size_t TransferData::chunk_size = 0;
-/* Static vector to store the checksums */
-std::vector<uint8_t>TransferData::checksums;
+ImageDigest TransferData::image_digest;
+std::vector<uint8_t> TransferData::image_digest_record;
+std::map<uint8_t, std::unique_ptr<TransferData::TransferContext>> TransferData::transfer_contexts;
+std::mutex TransferData::transfer_contexts_mutex;
+std::map<uint8_t, size_t> TransferData::max_block_lengths;
+std::mutex TransferData::max_block_lengths_mutex;
+std::map<uint8_t, uint8_t> TransferData::data_formats;
+std::mutex TransferData::data_formats_mutex;
+BlockStreamDecoder TransferData::block_decoder;
+FirmwareSource TransferData::delta_base;
+DeltaPatchDecoder TransferData::delta_decoder;
+TransferCheckpoint TransferData::resume_checkpoint;
+ImageDigest TransferData::resume_digest;
 
-/* Method to compute a simple XOR checksum for a block of data */
-uint8_t TransferData::computeChecksum(const uint8_t* data, size_t block_size)
+const ImageDigest& TransferData::getImageDigest()
 {
-    uint8_t checksum = 0;
-    for (size_t i = 0; i < block_size; ++i)
+    return image_digest;
+}
+
+const std::vector<uint8_t>& TransferData::getImageDigestRecord()
+{
+    return image_digest_record;
+}
+
+void TransferData::setMaxBlockLength(uint8_t ecu_id, size_t max_number_block)
+{
+    std::lock_guard<std::mutex> lock(max_block_lengths_mutex);
+    max_block_lengths[ecu_id] = std::max(static_cast<size_t>(MAX_TRANSER_DATA_BYTES), std::min(max_number_block, static_cast<size_t>(MAX_TRANSFER_DATA_BLOCK_BYTES)));
+}
+
+size_t TransferData::getMaxBlockLength(uint8_t ecu_id)
+{
+    std::lock_guard<std::mutex> lock(max_block_lengths_mutex);
+    auto it = max_block_lengths.find(ecu_id);
+    return it != max_block_lengths.end() ? it->second : MAX_TRANSER_DATA_BYTES;
+}
+
+void TransferData::setDataFormat(uint8_t ecu_id, uint8_t data_format)
+{
+    std::lock_guard<std::mutex> lock(data_formats_mutex);
+    data_formats[ecu_id] = data_format;
+}
+
+uint8_t TransferData::getDataFormat(uint8_t ecu_id)
+{
+    std::lock_guard<std::mutex> lock(data_formats_mutex);
+    auto it = data_formats.find(ecu_id);
+    return it != data_formats.end() ? it->second : 0x00;
+}
+
+bool TransferData::readCheckpoint(canid_t can_id, TransferCheckpoint& checkpoint, Logger& logger)
+{
+    std::vector<uint8_t> value;
+    try
+    {
+        value = FileManager::getDidValue(OTA_TRANSFER_CHECKPOINT_DID, can_id, logger);
+    }
+    catch (const std::exception&)
+    {
+        /* Data file of a module without checkpoints */
+        return false;
+    }
+    if (value.size() != OTA_CHECKPOINT_LENGTH)
+    {
+        return false;
+    }
+    uint32_t* fields[] = {&checkpoint.address, &checkpoint.image_size, &checkpoint.offset, &checkpoint.crc};
+    for (size_t field = 0; field < 4; ++field)
+    {
+        *fields[field] = (value[4 * field] << 24) | (value[4 * field + 1] << 16) | (value[4 * field + 2] << 8) | value[4 * field + 3];
+    }
+    return checkpoint.offset != 0;
+}
+
+void TransferData::writeCheckpoint(canid_t can_id, const TransferCheckpoint& checkpoint, Logger& logger)
+{
+    std::vector<uint8_t> value = {0};
+    if (checkpoint.offset != 0)
+    {
+        value.clear();
+        for (uint32_t field : {checkpoint.address, checkpoint.image_size, checkpoint.offset, checkpoint.crc})
+        {
+            for (int byte = 3; byte >= 0; --byte)
+            {
+                value.push_back(static_cast<uint8_t>(field >> (8 * byte)));
+            }
+        }
+    }
+    /* Not sent to the MCU, it reads the checkpoint from the data file of the ECU */
+    FileManager::setDidValue(OTA_TRANSFER_CHECKPOINT_DID, value, can_id, logger, -1);
+}
+
+bool TransferData::validateCheckpoint(canid_t can_id, int address, uint8_t data_format, Logger& logger)
+{
+    resume_checkpoint = TransferCheckpoint();
+    TransferCheckpoint checkpoint;
+    if (!readCheckpoint(can_id, checkpoint, logger))
+    {
+        return false;
+    }
+    /* Only an image sent as it is has its bytes at the same offsets on the device */
+    uint8_t compression = data_format >> 4;
+    bool valid = compression != DATA_FORMAT_COMPRESSION_BLOCK && compression != DATA_FORMAT_COMPRESSION_DELTA &&
+                 checkpoint.address == static_cast<uint32_t>(address) &&
+                 checkpoint.offset < checkpoint.image_size;
+    /* The staged writes of the interrupted transfer are read back too */
+    MemoryManager::getInstance(address, DEV_LOOP, logger)->flushStagedWrites();
+    /* The size block written before the image: {size format, size bytes} */
+    std::vector<uint8_t> size_block;
+    if (valid)
+    {
+        size_block = MemoryManager::readFromAddress(DEV_LOOP, address, 1, logger);
+        valid = size_block.size() == 1 && size_block[0] >= 1 && size_block[0] <= sizeof(uint32_t);
+    }
+    if (valid)
+    {
+        size_block = MemoryManager::readFromAddress(DEV_LOOP, address, 1 + size_block[0], logger);
+        uint32_t image_size = 0;
+        for (size_t index = 1; index < size_block.size(); ++index)
+        {
+            image_size = (image_size << 8) | size_block[index];
+        }
+        valid = size_block.size() > 1 && image_size == checkpoint.image_size;
+    }
+    /* The image bytes already written, read back in parts */
+    ImageDigest digest(OTA_SHA256_DIGEST);
+    size_t position = 0;
+    while (valid && position < checkpoint.offset)
+    {
+        size_t part_size = std::min(static_cast<size_t>(OTA_CHECKPOINT_INTERVAL_BYTES), checkpoint.offset - position);
+        std::vector<uint8_t> part = MemoryManager::readFromAddress(DEV_LOOP, address + size_block.size() + position, part_size, logger);
+        valid = part.size() == part_size;
+        digest.update(part.data(), part.size());
+        position += part.size();
+    }
+    if (!valid || digest.getCrc32c() != checkpoint.crc)
     {
-        checksum ^= *(data + i);
+        LOG_WARN(logger.GET_LOGGER(), "Transfer checkpoint at byte {} not valid for this download, the transfer starts from byte 0.", checkpoint.offset);
+        writeCheckpoint(can_id, TransferCheckpoint(), logger);
+        return false;
     }
-    /* Return the checksum */
-    return checksum;
+    resume_checkpoint = checkpoint;
+    resume_digest = digest;
+    LOG_INFO(logger.GET_LOGGER(), "Transfer can resume at byte {} of {}.", checkpoint.offset, checkpoint.image_size);
+    return true;
 }
 
-/* Retrieve the checksum vector */
-const std::vector<uint8_t>&TransferData::getChecksums()
+TransferData::TransferContext& TransferData::getTransferContext(uint8_t ecu_id)
 {
-    return checksums;
+    std::lock_guard<std::mutex> lock(transfer_contexts_mutex);
+    std::unique_ptr<TransferContext>& context = transfer_contexts[ecu_id];
+    if (!context)
+    {
+        context = std::make_unique<TransferContext>();
+    }
+    return *context;
 }
 
 void TransferData::processDataForTransfer(canid_t can_id, std::vector<uint8_t>& current_data, int socket, Logger& logger)
 {
-    static std::vector<uint8_t> data = {};  
-    /* Total size of data */
-    static size_t total_size = 0;
-    /* Total bytes sent */
-    static size_t bytes_sent = 0;
-    /* Data size of 1 transfer data */
-    static uint8_t chunk_size = 0;
     /* Extract the receiver */
     uint8_t receiver_id = can_id  & 0xFF;
+    /* Each ECU has its own transfer, its requests are processed in order on the dispatch lane of the ECU */
+    TransferContext& context = getTransferContext(receiver_id);
+    context.block_sequence_counter = current_data[2];
 
     OtaUpdateStatesEnum ota_state = static_cast<OtaUpdateStatesEnum>(FileManager::getDidValue(OTA_UPDATE_STATUS_DID, can_id, logger)[0]);
 
     if(ota_state == WAIT_DOWNLOAD_COMPLETED)
     {
-        /* Get chunk_size from request download */
-        chunk_size = 0x05;
+        /* Get chunk_size negotiated by the ECU in its request download response */
+        context.chunk_size = TransferData::getMaxBlockLength(receiver_id);
+        LOG_INFO(logger.GET_LOGGER(), "Transfer data blocks of {} bytes for ECU 0x{:x} over {}.", context.chunk_size, receiver_id,
+                 CanFd::useFd(socket, receiver_id) ? "CAN FD" : "classic CAN");
         /* Initialize the bytes sent */
-        bytes_sent = 0;
+        context.bytes_sent = 0;
+        context.stream_bytes_sent = 0;
+        uint8_t compression = TransferData::getDataFormat(receiver_id) >> 4;
+        context.compress_image = compression == DATA_FORMAT_COMPRESSION_BLOCK;
+        context.delta_image = compression == DATA_FORMAT_COMPRESSION_DELTA;
+        context.stream_data.clear();
+        context.stream_sent = 0;
 
         std::string path_to_main;
         if(FileManager::getEcuPath(receiver_id, path_to_main, 3, logger) == 0)
@@ -62,20 +203,78 @@ void TransferData::processDataForTransfer(canid_t can_id, std::vector<uint8_t>&
             return;
         }
 
-        /* Read data from the extracted binary */
-        TransferData::checksums.clear();
-        data.clear();
-        data = MemoryManager::readBinary(path_to_main, logger);
-        total_size = data.size();
+        /* Map the extracted binary, the blocks are read from it without loading the whole image */
+        context.digest.reset(OTA_SHA256_DIGEST);
+        if (!context.source.open(path_to_main, logger))
+        {
+            FileManager::setDidValue(OTA_UPDATE_STATUS_DID, {PROCESSING_TRANSFER_FAILED}, can_id, logger, socket);
+            return;
+        }
+        context.total_size = context.source.size();
+
+        /* Resume after the image bytes checkpointed by the ECU if the same image is sent as it is.
+           Otherwise the checkpoint is removed and the ECU starts from byte 0 as well. */
+        TransferCheckpoint checkpoint;
+        if (TransferData::readCheckpoint(can_id, checkpoint, logger))
+        {
+            bool resume = !context.compress_image && !context.delta_image && checkpoint.image_size == context.total_size && checkpoint.offset < context.total_size;
+            if (resume)
+            {
+                FirmwareSource::Chunk written = context.source.chunk(0, checkpoint.offset);
+                context.digest.update(written.data, written.size);
+                resume = written.size == checkpoint.offset && context.digest.getCrc32c() == checkpoint.crc;
+            }
+            if (resume)
+            {
+                context.bytes_sent = checkpoint.offset;
+                LOG_INFO(logger.GET_LOGGER(), "Transfer to ECU 0x{:x} resumes at byte {} of {}.", receiver_id, context.bytes_sent, context.total_size);
+            }
+            else
+            {
+                context.digest.reset(OTA_SHA256_DIGEST);
+                TransferData::writeCheckpoint(can_id, TransferCheckpoint(), logger);
+                LOG_INFO(logger.GET_LOGGER(), "Transfer checkpoint of ECU 0x{:x} does not match the image, the transfer starts from byte 0.", receiver_id);
+            }
+        }
+
+        if (context.delta_image)
+        {
+            /* The whole patch is made now, it is sent like the image */
+            std::string path_to_installed;
+            FirmwareSource installed;
+            if (FileManager::getEcuPath(receiver_id, path_to_installed, 4, logger) == 0 || !installed.open(path_to_installed, logger))
+            {
+                LOG_ERROR(logger.GET_LOGGER(), "Installed executable of ECU 0x{:x} not available for a delta update.", receiver_id);
+                context.source.close();
+                FileManager::setDidValue(OTA_UPDATE_STATUS_DID, {PROCESSING_TRANSFER_FAILED}, can_id, logger, socket);
+                return;
+            }
+            FirmwareSource::Chunk base = installed.chunk(0, installed.size());
+            FirmwareSource::Chunk target = context.source.chunk(0, context.total_size);
+            if (base.size != installed.size() || target.size != context.total_size)
+            {
+                LOG_ERROR(logger.GET_LOGGER(), "Failed to read the images for the delta update.");
+                installed.close();
+                context.source.close();
+                FileManager::setDidValue(OTA_UPDATE_STATUS_DID, {PROCESSING_TRANSFER_FAILED}, can_id, logger, socket);
+                return;
+            }
+            DeltaPatch::create(base.data, base.size, target.data, target.size, context.stream_data);
+            context.digest.update(target.data, target.size);
+            context.bytes_sent = context.total_size;
+            installed.close();
+            LOG_INFO(logger.GET_LOGGER(), "Delta patch of {} bytes for an image of {} bytes ({} bytes installed).",
+                     context.stream_data.size(), context.total_size, base.size);
+        }
 
         /* Determine how many bytes are needed to represent the size */
         std::vector<uint8_t>binary_data_size_bytes;                
         uint8_t byte;
         bool first_byte_found = false;
 
-        for(int i = sizeof(total_size) - 1; i >=0; --i)
+        for(int i = sizeof(context.total_size) - 1; i >=0; --i)
         {
-            byte = (total_size >> (i * 8)) & 0xFF;
+            byte = (context.total_size >> (i * 8)) & 0xFF;
             if(byte != 0 || first_byte_found == true)
             {
                 binary_data_size_bytes.emplace_back(byte);
@@ -95,32 +294,94 @@ void TransferData::processDataForTransfer(canid_t can_id, std::vector<uint8_t>&
         return;
     }
     
-    size_t current_chunk_size = std::min(static_cast<size_t>(chunk_size), total_size - bytes_sent);
-    if (bytes_sent >= total_size)
+    /* Bytes of the next transfer data block, from the image or from its compressed stream */
+    const uint8_t* block_data = nullptr;
+    size_t block_size = 0;
+    if (context.compress_image || context.delta_image)
+    {
+        if (context.compress_image && context.stream_data.size() - context.stream_sent < context.chunk_size && context.bytes_sent < context.total_size)
+        {
+            /* Drop the frames already sent and compress windows of the image until a whole block is ready */
+            context.stream_data.erase(context.stream_data.begin(), context.stream_data.begin() + context.stream_sent);
+            context.stream_sent = 0;
+            while (context.stream_data.size() < context.chunk_size && context.bytes_sent < context.total_size)
+            {
+                size_t window_size = std::min(static_cast<size_t>(BLOCK_CODEC_WINDOW_BYTES), context.total_size - context.bytes_sent);
+                FirmwareSource::Chunk chunk = context.source.chunk(context.bytes_sent, window_size);
+                if (chunk.size != window_size)
+                {
+                    LOG_ERROR(logger.GET_LOGGER(), "Failed to read {} bytes of the image at offset {}.", window_size, context.bytes_sent);
+                    context.source.close();
+                    FileManager::setDidValue(OTA_UPDATE_STATUS_DID, {PROCESSING_TRANSFER_FAILED}, can_id, logger, socket);
+                    return;
+                }
+                context.digest.update(chunk.data, chunk.size);
+                BlockCodec::appendFrame(chunk.data, chunk.size, context.stream_data);
+                context.bytes_sent += chunk.size;
+            }
+        }
+        block_size = std::min(context.chunk_size, context.stream_data.size() - context.stream_sent);
+        block_data = context.stream_data.data() + context.stream_sent;
+        context.stream_sent += block_size;
+    }
+    else if (context.bytes_sent < context.total_size)
+    {
+        size_t current_chunk_size = std::min(static_cast<size_t>(context.chunk_size), context.total_size - context.bytes_sent);
+        FirmwareSource::Chunk chunk = context.source.chunk(context.bytes_sent, current_chunk_size);
+        if (chunk.size != current_chunk_size)
+        {
+            LOG_ERROR(logger.GET_LOGGER(), "Failed to read {} bytes of the image at offset {}.", current_chunk_size, context.bytes_sent);
+            context.source.close();
+            FileManager::setDidValue(OTA_UPDATE_STATUS_DID, {PROCESSING_TRANSFER_FAILED}, can_id, logger, socket);
+            return;
+        }
+        context.digest.update(chunk.data, chunk.size);
+        context.bytes_sent += chunk.size;
+        block_data = chunk.data;
+        block_size = chunk.size;
+    }
+
+    if (block_size == 0)
     {   
-        current_data.emplace_back(TransferData::computeChecksum(TransferData::checksums.data(), TransferData::checksums.size()));
+        /* Last request: digest record of the whole image */
+        std::vector<uint8_t> record = context.digest.getRecord();
+        current_data.insert(current_data.end(), record.begin(), record.end());
+        context.source.close();
+        if (context.compress_image || context.delta_image)
+        {
+            LOG_INFO(logger.GET_LOGGER(), "Image of {} bytes sent as {} bytes of {}.", context.total_size, context.stream_bytes_sent,
+                     context.compress_image ? "compressed stream" : "delta patch");
+        }
         canid_t aux_can_id = ((can_id & 0xFF) << 16) | ((can_id & 0xFF00)) | 0X10;
         FileManager::setDidValue(OTA_UPDATE_STATUS_DID, {PROCESSING_TRANSFER_COMPLETE}, aux_can_id, logger, socket);
     }
     else
     {
-        current_data.insert(current_data.end(), data.begin() + bytes_sent, data.begin() + bytes_sent + current_chunk_size);
-        TransferData::checksums.emplace_back(TransferData::computeChecksum(data.data() + bytes_sent, current_chunk_size));
-        bytes_sent += current_chunk_size;
+        current_data.insert(current_data.end(), block_data, block_data + block_size);
+        context.stream_bytes_sent += block_size;
     }
     current_data[0] = static_cast<uint8_t>(current_data.size() - 1);
-    /* Display progress */
-    std::cout << "\rProgress: " << static_cast<int>((static_cast<double>(bytes_sent) / total_size) * 100) << "% "
-                << "Sent: " << bytes_sent << " / " << total_size
-                << std::flush;
+    /* Progress of each ECU in the log, on the patch for a delta update */
+    size_t progress = context.delta_image ? context.stream_bytes_sent : context.bytes_sent;
+    size_t progress_total = context.delta_image ? context.stream_data.size() : context.total_size;
+    LOG_INFO(logger.GET_LOGGER(), "ECU 0x{:x} block {} progress: {}% Sent: {} / {}", receiver_id, context.block_sequence_counter,
+             progress_total != 0 ? progress * 100 / progress_total : 100, progress, progress_total);
+    if (block_size == 0)
+    {
+        /* The stream of a finished transfer is not kept until the next update of the ECU */
+        std::vector<uint8_t>().swap(context.stream_data);
+    }
 }
 
 /* method used to transfer the data */
 /* frame format = {PCI_L, SID(0x36), block_sequence_counter, transfer_request_parameter_record}*/
 void TransferData::transferData(canid_t can_id, std::vector<uint8_t>& transfer_request)
 {
-    /* Declaration of data as static in order to retain its value between calls */
-    static std::vector<uint8_t> data;
+    /* Number of bytes received, retained between calls */
+    static size_t bytes_received = 0;
+    /* Progress of an image sent as it is and the image bytes of the last checkpoint saved */
+    static TransferCheckpoint progress;
+    static size_t checkpoint_offset = 0;
     /* Auxiliary variable used for can_id in setDidValue method */
     canid_t aux_can_id = can_id;
     NegativeResponse nrc(socket, transfer_data_logger);
@@ -144,10 +405,15 @@ void TransferData::transferData(canid_t can_id, std::vector<uint8_t>& transfer_r
     }
 
     OtaUpdateStatesEnum ota_state = static_cast<OtaUpdateStatesEnum>(FileManager::getDidValue(OTA_UPDATE_STATUS_DID, aux_can_id, transfer_data_logger)[0]);
+    /* The first block holds the size of the image, the last one its digest record */
+    bool size_block = ota_state == WAIT_DOWNLOAD_COMPLETED;
     if(ota_state == WAIT_DOWNLOAD_COMPLETED)
     {
         /* Clear old data */
-        data.clear();
+        bytes_received = 0;
+        image_digest.reset(OTA_SHA256_DIGEST);
+        image_digest_record.clear();
+        block_decoder.reset();
         /* Request Download informations */
         RDSData rds_data = RequestDownloadService::getRdsData();
         /* Get chunk_size from request download */
@@ -159,11 +425,46 @@ void TransferData::transferData(canid_t can_id, std::vector<uint8_t>& transfer_r
         if(memory_manager->getAddress() != rds_data.address || memory_manager->getPath() != DEV_LOOP)
         {
             LOG_WARN(transfer_data_logger.GET_LOGGER(), "Transfer Data initialized without setting address and path in Request Download. Initialization done in Transfer Data.");
-            memory_manager->setAddress(rds_data.address);
             memory_manager->setPath(DEV_LOOP);
         }
+        /* The size block is written at the download address, also after an earlier transfer to the same address */
+        memory_manager->setAddress(rds_data.address);
         memory_write_status = false;
 
+        /* Size of the image from the size block {size format, size bytes} */
+        progress = TransferCheckpoint();
+        progress.address = rds_data.address;
+        for (size_t index = 4; index < transfer_request.size() && index < 4 + static_cast<size_t>(transfer_request[3]); ++index)
+        {
+            progress.image_size = (progress.image_size << 8) | transfer_request[index];
+        }
+        checkpoint_offset = 0;
+        /* Resume only if the checkpoint validated by Request Download was kept by the MCU for this image */
+        TransferCheckpoint saved;
+        if (resume_checkpoint.offset != 0 &&
+            (!readCheckpoint(aux_can_id, saved, transfer_data_logger) || saved.offset != resume_checkpoint.offset ||
+             saved.crc != resume_checkpoint.crc || saved.image_size != progress.image_size))
+        {
+            resume_checkpoint = TransferCheckpoint();
+        }
+
+        if ((rds_data.data_format >> 4) == DATA_FORMAT_COMPRESSION_DELTA)
+        {
+            /* Delta update: the new image is rebuilt from the installed executable */
+            std::string path_to_installed;
+            if (FileManager::getEcuPath(receiver_id, path_to_installed, 4, transfer_data_logger) == 0 ||
+                !delta_base.open(path_to_installed, transfer_data_logger))
+            {
+                LOG_ERROR(transfer_data_logger.GET_LOGGER(), "Installed executable not available for a delta update.");
+                nrc.sendNRC(can_id, TD_SID, NegativeResponse::UDNA);
+                FileManager::setDidValue(OTA_UPDATE_STATUS_DID, {PROCESSING_TRANSFER_FAILED}, aux_can_id, transfer_data_logger, socket);
+                AccessTimingParameter::stopTimingFlag(receiver_id, TRANSFER_DATA_SID);
+                return;
+            }
+            FirmwareSource::Chunk base = delta_base.chunk(0, delta_base.size());
+            delta_decoder.reset(base.data, base.size);
+        }
+
         FileManager::setDidValue(OTA_UPDATE_STATUS_DID, {PROCESSING}, aux_can_id, transfer_data_logger, socket);
         ota_state = PROCESSING;
 
@@ -179,6 +480,15 @@ void TransferData::transferData(canid_t can_id, std::vector<uint8_t>& transfer_r
         return;
     }
 
+    if (chunk_size != 0 && transfer_request.size() - 3 > chunk_size)
+    {
+        /* Block longer than the max_number_block sent in the Request Download response */
+        LOG_WARN(transfer_data_logger.GET_LOGGER(), "Transfer data block of {} bytes, max_number_block is {}.", transfer_request.size() - 3, chunk_size);
+        nrc.sendNRC(can_id, TD_SID, NegativeResponse::IMLOIF);
+        AccessTimingParameter::stopTimingFlag(receiver_id, TRANSFER_DATA_SID);
+        return;
+    }
+
     if (expected_block_sequence_number != block_sequence_counter)
     {
         /* Wrong block sequence counter - prepare a negative response */
@@ -187,24 +497,103 @@ void TransferData::transferData(canid_t can_id, std::vector<uint8_t>& transfer_r
         return;
     }
 
-    /* Write the chunk to the vector */
-    data.insert(data.end(), transfer_request.begin() + 3, transfer_request.end());
+    /* With the BLOCK and DELTA methods the image blocks carry a compressed stream or a patch, the size block
+       and the digest record are sent as they are */
+    uint8_t compression = RequestDownloadService::getRdsData().data_format >> 4;
+    bool stream_block = !size_block && ota_state != PROCESSING_TRANSFER_COMPLETE &&
+                        (compression == DATA_FORMAT_COMPRESSION_BLOCK || compression == DATA_FORMAT_COMPRESSION_DELTA);
+    /* Rebuilt parts of the image are staged as they complete, the digest is on the rebuilt image */
+    auto stage_image = [](const uint8_t* data, size_t size)
+    {
+        image_digest.update(data, size);
+        return memory_manager->stageWrite(data, size);
+    };
+    /* Stage the chunk, it is written on the device in the background. The response does not wait for the
+       device; Request Transfer Exit waits until all the data is written */
+    bool staged;
+    if (stream_block && compression == DATA_FORMAT_COMPRESSION_BLOCK)
+    {
+        staged = block_decoder.feed(transfer_request.data() + 3, transfer_request.size() - 3, stage_image);
+    }
+    else if (stream_block)
+    {
+        staged = delta_decoder.feed(transfer_request.data() + 3, transfer_request.size() - 3, stage_image);
+        if (!staged)
+        {
+            LOG_ERROR(transfer_data_logger.GET_LOGGER(), "Delta patch rejected: {}", delta_decoder.getError());
+        }
+    }
+    else if (ota_state == PROCESSING_TRANSFER_COMPLETE &&
+             (!block_decoder.isEmpty() || (compression == DATA_FORMAT_COMPRESSION_DELTA && !delta_decoder.isEmpty())))
+    {
+        LOG_ERROR(transfer_data_logger.GET_LOGGER(), "Image stream ended in the middle of a frame or patch instruction.");
+        staged = false;
+    }
+    else
+    {
+        staged = memory_manager->stageWrite(transfer_request.data() + 3, transfer_request.size() - 3);
+    }
+    if (staged && size_block && resume_checkpoint.offset != 0)
+    {
+        /* The image bytes before the checkpoint are on the device already */
+        staged = memory_manager->skipWrite(resume_checkpoint.offset);
+        image_digest = resume_digest;
+        progress.offset = resume_checkpoint.offset;
+        checkpoint_offset = progress.offset;
+        resume_checkpoint = TransferCheckpoint();
+        LOG_INFO(transfer_data_logger.GET_LOGGER(), "Data transfer resumed at byte {} of {}.", progress.offset, progress.image_size);
+    }
+    else if (staged && !size_block && !stream_block && ota_state != PROCESSING_TRANSFER_COMPLETE)
+    {
+        /* The digest is computed while the image arrives, verify software does not read it again */
+        image_digest.update(transfer_request.data() + 3, transfer_request.size() - 3);
+        progress.offset += transfer_request.size() - 3;
+        if (compression != DATA_FORMAT_COMPRESSION_BLOCK && compression != DATA_FORMAT_COMPRESSION_DELTA &&
+            progress.offset - checkpoint_offset >= OTA_CHECKPOINT_INTERVAL_BYTES)
+        {
+            /* Only the bytes synced on the device are checkpointed */
+            staged = memory_manager->flushStagedWrites();
+            if (staged)
+            {
+                progress.crc = image_digest.getCrc32c();
+                writeCheckpoint(aux_can_id, progress, transfer_data_logger);
+                checkpoint_offset = progress.offset;
+            }
+        }
+    }
+    if (ota_state == PROCESSING_TRANSFER_COMPLETE && checkpoint_offset != 0)
+    {
+        /* The whole image is received, an interrupted transfer starts from byte 0 again */
+        writeCheckpoint(aux_can_id, TransferCheckpoint(), transfer_data_logger);
+        checkpoint_offset = 0;
+    }
+    if (ota_state == PROCESSING_TRANSFER_COMPLETE || !staged)
+    {
+        /* The installed executable is not needed after the last block */
+        delta_base.close();
+    }
+    if (!staged)
+    {
+        nrc.sendNRC(can_id, TD_SID, NegativeResponse::TDS);
+        FileManager::setDidValue(OTA_UPDATE_STATUS_DID, {PROCESSING_TRANSFER_FAILED}, aux_can_id, transfer_data_logger, socket);
+        AccessTimingParameter::stopTimingFlag(receiver_id, TRANSFER_DATA_SID);
+        LOG_INFO(transfer_data_logger.GET_LOGGER(), "Data transfer failed at writting in memory.");
+        return;
+    }
+    bytes_received += transfer_request.size() - 3;
+    if (ota_state == PROCESSING_TRANSFER_COMPLETE)
+    {
+        image_digest_record.assign(transfer_request.begin() + 3, transfer_request.end());
+    }
     /* Display bytes received */
-    std::cout << "\rBytes received: " << data.size()
+    std::cout << "\rBytes received: " << bytes_received
                 << std::flush;
     if(ota_state == PROCESSING_TRANSFER_COMPLETE)
     {
         if(memory_write_status == false)
         {
-            memory_write_status = memory_manager->writeToAddress(data);
-            if(memory_write_status == false)
-            {
-                nrc.sendNRC(can_id, TD_SID, NegativeResponse::TDS);
-               FileManager::setDidValue(OTA_UPDATE_STATUS_DID, {PROCESSING_TRANSFER_FAILED}, aux_can_id, transfer_data_logger, socket);
-                AccessTimingParameter::stopTimingFlag(receiver_id, TRANSFER_DATA_SID);
-                LOG_INFO(transfer_data_logger.GET_LOGGER(), "Data transfer failed at writting in memory.");
-                return;
-            }
+            /* Last block staged, the data is complete */
+            memory_write_status = true;
             /* Status remains PROCESSING_TRANSFER_COMPLETE */
             response.clear();
             /* prepare positive response */
@@ -2,13 +2,18 @@
 #include <vector>
 #include <cstdint>
 #include <string>
+#include <fstream>
 #include <gtest/gtest.h>
 #include <linux/can.h>
 #include <fcntl.h>
 #include <sys/ioctl.h>
 #include <net/if.h>
 #include "../include/TransferData.h"
+#include "../../request_download/include/RequestDownload.h"
 #include "../../../utils/include/Logger.h"
+#include "../../../utils/include/DidStore.h"
+#include "../../../utils/include/ImageDigest.h"
+#include "../../../utils/include/ReceiveFrames.h"
 
 int socket_;
 int socket2_;
@@ -138,6 +143,174 @@ TEST_F(TransferDataTest, PositiveResponseTest) {
     }
 }
 
+/* Test for the max block length negotiated with Request Download */
+TEST_F(TransferDataTest, MaxBlockLengthTest) {
+
+    /* Single frame blocks until the ECU answered the request download */
+    EXPECT_EQ(TransferData::getMaxBlockLength(0x12), MAX_TRANSER_DATA_BYTES);
+    TransferData::setMaxBlockLength(0x12, 4093);
+    EXPECT_EQ(TransferData::getMaxBlockLength(0x12), 4093u);
+    /* Clamped to what fits in a 12-bit multi-frame message and to at least one frame */
+    TransferData::setMaxBlockLength(0x12, 0x10000);
+    EXPECT_EQ(TransferData::getMaxBlockLength(0x12), MAX_TRANSFER_DATA_BLOCK_BYTES);
+    TransferData::setMaxBlockLength(0x12, 1);
+    EXPECT_EQ(TransferData::getMaxBlockLength(0x12), MAX_TRANSER_DATA_BYTES);
+}
+
+/* Data file of the battery module with the DIDs used by the transfer */
+void restoreBatteryData()
+{
+    DidStore::restore(std::string(PROJECT_PATH) + "/backend/ecu_simulation/BatteryModule/battery_data.db",
+                      {{OTA_UPDATE_STATUS_DID, {IDLE}}, {OTA_TRANSFER_CHECKPOINT_DID, {0x00}}});
+}
+
+/* Image bytes of an interrupted transfer on the device: the size block {size format, size} and 4 of the 8 image bytes */
+const int checkpoint_address = 0x0800;
+const std::vector<uint8_t> written_bytes = {0x11, 0x22, 0x33, 0x44};
+
+TransferCheckpoint writeInterruptedTransfer(Logger& logger)
+{
+    MemoryManager* memory = MemoryManager::getInstance(checkpoint_address, DEV_LOOP, logger);
+    memory->setAddress(checkpoint_address);
+    memory->setPath(DEV_LOOP);
+    std::vector<uint8_t> device_data = {0x01, 0x08};
+    device_data.insert(device_data.end(), written_bytes.begin(), written_bytes.end());
+    memory->stageWrite(device_data.data(), device_data.size());
+    memory->flushStagedWrites();
+    ImageDigest digest(OTA_SHA256_DIGEST);
+    digest.update(written_bytes.data(), written_bytes.size());
+    TransferCheckpoint checkpoint;
+    checkpoint.address = checkpoint_address;
+    checkpoint.image_size = 8;
+    checkpoint.offset = written_bytes.size();
+    checkpoint.crc = digest.getCrc32c();
+    return checkpoint;
+}
+
+/* Test for the 16 bytes of the transfer checkpoint */
+TEST_F(TransferDataTest, CheckpointRoundTripTest) {
+
+    restoreBatteryData();
+    TransferCheckpoint checkpoint;
+    checkpoint.address = 0x00012345;
+    checkpoint.image_size = 0x00400000;
+    checkpoint.offset = 0x00040000;
+    checkpoint.crc = 0xA1B2C3D4;
+    TransferData::writeCheckpoint(id, checkpoint, mockLogger);
+
+    std::vector<uint8_t> expected_value = {0x00, 0x01, 0x23, 0x45, 0x00, 0x40, 0x00, 0x00,
+                                           0x00, 0x04, 0x00, 0x00, 0xA1, 0xB2, 0xC3, 0xD4};
+    EXPECT_EQ(FileManager::getDidValue(OTA_TRANSFER_CHECKPOINT_DID, id, mockLogger), expected_value);
+    TransferCheckpoint read_checkpoint;
+    ASSERT_TRUE(TransferData::readCheckpoint(id, read_checkpoint, mockLogger));
+    EXPECT_EQ(read_checkpoint.address, checkpoint.address);
+    EXPECT_EQ(read_checkpoint.image_size, checkpoint.image_size);
+    EXPECT_EQ(read_checkpoint.offset, checkpoint.offset);
+    EXPECT_EQ(read_checkpoint.crc, checkpoint.crc);
+
+    /* A checkpoint without image bytes removes it */
+    TransferData::writeCheckpoint(id, TransferCheckpoint(), mockLogger);
+    EXPECT_FALSE(TransferData::readCheckpoint(id, read_checkpoint, mockLogger));
+}
+
+/* Test that a checkpoint with a CRC different from the bytes on the device is removed */
+TEST_F(TransferDataTest, CheckpointCrcMismatchTest) {
+
+    restoreBatteryData();
+    TransferCheckpoint checkpoint = writeInterruptedTransfer(mockLogger);
+    checkpoint.crc ^= 0x01;
+    TransferData::writeCheckpoint(id, checkpoint, mockLogger);
+
+    EXPECT_FALSE(TransferData::validateCheckpoint(id, checkpoint_address, 0x00, mockLogger));
+    TransferCheckpoint read_checkpoint;
+    EXPECT_FALSE(TransferData::readCheckpoint(id, read_checkpoint, mockLogger));
+}
+
+/* Test that a block compressed stream or a delta patch is not resumed */
+TEST_F(TransferDataTest, CheckpointCompressedFormatTest) {
+
+    restoreBatteryData();
+    TransferCheckpoint checkpoint = writeInterruptedTransfer(mockLogger);
+    TransferCheckpoint read_checkpoint;
+    for (uint8_t data_format : {0x20, 0x30})
+    {
+        TransferData::writeCheckpoint(id, checkpoint, mockLogger);
+        EXPECT_FALSE(TransferData::validateCheckpoint(id, checkpoint_address, data_format, mockLogger));
+        EXPECT_FALSE(TransferData::readCheckpoint(id, read_checkpoint, mockLogger));
+    }
+}
+
+/* Test that a resumed transfer writes the next blocks after the image bytes of the checkpoint */
+TEST_F(TransferDataTest, ResumeAtCheckpointTest) {
+
+    restoreBatteryData();
+    TransferCheckpoint checkpoint = writeInterruptedTransfer(mockLogger);
+    TransferData::writeCheckpoint(id, checkpoint, mockLogger);
+
+    /* Request Download of the same image: address 0x0800 on 2 bytes, size 0x08 on 1 byte */
+    ReceiveFrames::setEcuState(true);
+    RequestDownloadService request_download(socket_, mockLogger);
+    request_download.requestDownloadRequest(id, {0x06, 0x34, 0x00, 0x21, 0x08, 0x00, 0x08});
+    ASSERT_EQ(RequestDownloadService::getRdsData().address, checkpoint_address);
+
+    /* Size block, then the last 4 image bytes */
+    std::vector<uint8_t> size_block = {0x04, 0x36, 0x01, 0x01, 0x08};
+    transfer_data->transferData(id, size_block);
+    std::vector<uint8_t> image_block = {0x06, 0x36, 0x02, 0x55, 0x66, 0x77, 0x88};
+    transfer_data->transferData(id, image_block);
+    ASSERT_TRUE(TransferData::memory_manager->flushStagedWrites());
+
+    std::vector<uint8_t> expected_device_data = {0x01, 0x08, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88};
+    EXPECT_EQ(MemoryManager::readFromAddress(DEV_LOOP, checkpoint_address, expected_device_data.size(), mockLogger), expected_device_data);
+    ReceiveFrames::setEcuState(false);
+}
+
+/* Test that the transfers to 2 ECUs, with their requests interleaved in the MCU, keep their own progress */
+TEST_F(TransferDataTest, InterleavedTransfersTest) {
+
+    /* Image sent to both ECUs */
+    std::vector<uint8_t> image(100);
+    for (size_t index = 0; index < image.size(); ++index)
+    {
+        image[index] = static_cast<uint8_t>(index);
+    }
+    std::string image_path;
+    FileManager::getEcuPath(0x11, image_path, 0, mockLogger, "transfer_data_test");
+    std::ofstream(image_path, std::ios::binary).write(reinterpret_cast<const char*>(image.data()), image.size());
+
+    const canid_t can_ids[] = {0x1011, 0x1012};
+    const size_t block_lengths[] = {10, 7};
+    const std::string data_files[] = {"/backend/ecu_simulation/BatteryModule/battery_data.db",
+                                      "/backend/ecu_simulation/EngineModule/engine_data.db"};
+    for (size_t ecu = 0; ecu < 2; ++ecu)
+    {
+        DidStore::restore(std::string(PROJECT_PATH) + data_files[ecu],
+                          {{OTA_UPDATE_STATUS_DID, {WAIT_DOWNLOAD_COMPLETED}}, {OTA_TRANSFER_CHECKPOINT_DID, {0x00}}});
+        TransferData::setMaxBlockLength(can_ids[ecu] & 0xFF, block_lengths[ecu]);
+        /* Size block: size format, then the size */
+        std::vector<uint8_t> request = {0x02, 0x36, 0x01};
+        TransferData::processDataForTransfer(can_ids[ecu], request, socket_, mockLogger);
+        EXPECT_EQ(std::vector<uint8_t>(request.begin() + 1, request.end()), std::vector<uint8_t>({0x36, 0x01, 0x01, 0x64}));
+        FileManager::setDidValue(OTA_UPDATE_STATUS_DID, {PROCESSING}, can_ids[ecu], mockLogger, -1);
+    }
+
+    /* Each ECU gets the next bytes of the image, whatever was sent to the other ECU in between */
+    size_t offsets[] = {0, 0};
+    for (uint8_t block_sequence_counter = 2; block_sequence_counter < 7; ++block_sequence_counter)
+    {
+        for (size_t ecu = 0; ecu < 2; ++ecu)
+        {
+            std::vector<uint8_t> request = {0x02, 0x36, block_sequence_counter};
+            TransferData::processDataForTransfer(can_ids[ecu], request, socket_, mockLogger);
+            std::vector<uint8_t> expected_request = {static_cast<uint8_t>(2 + block_lengths[ecu]), 0x36, block_sequence_counter};
+            expected_request.insert(expected_request.end(), image.begin() + offsets[ecu], image.begin() + offsets[ecu] + block_lengths[ecu]);
+            EXPECT_EQ(request, expected_request);
+            offsets[ecu] += block_lengths[ecu];
+        }
+    }
+    std::remove(image_path.c_str());
+}
+
 int main(int argc, char **argv) {
     socket_ = createSocket();
     socket2_ = createSocket();
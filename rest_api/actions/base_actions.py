@@ -112,6 +112,12 @@ class Action(GF):
                 self.last_msg = msg
                 continue
 
+            # Flow control frames answer our own multi-frame requests, they are not a response
+            if 0x30 <= msg.data[0] <= 0x32:
+                msg = self.bus.recv(Config.BUS_RECEIVE_TIMEOUT)
+                self.last_msg = msg
+                continue
+
             # First Frame (starts with 0x10)
             if msg.data[0] == 0x10:
                 total_data_length = msg.data[1]  # Total length from the first frame (byte 1 and 2)
@@ -119,9 +125,13 @@ class Action(GF):
                 log_info_message(logger, f"[Collect Response] First frame received. \
                                  Total length expected: {total_data_length}, \
                                  Data: {[hex(byte) for byte in collected_data]}")
+                # The ECU sends the consecutive frames only after the flow control frame
+                sender = (msg.arbitration_id >> 8) & 0xFF
+                receiver = msg.arbitration_id & 0xFF
+                self.control_frame((msg.arbitration_id & ~0xFFFF) | (receiver << 8) | sender)
 
             # Consecutive Frames
-            elif 0x20 <= msg.data[0] <= 0x30:
+            elif 0x20 <= msg.data[0] <= 0x2F:
                 collected_data += msg.data[1:]  # Append the data from the consecutive frames
                 log_info_message(logger, f"[Collect Response] Consecutive frame received {[hex(byte) for byte in collected_data]}")
 
@@ -100,11 +100,11 @@ class GenerateFrame(CanBridge):
         else:
             last_data = response[bytes_first_frame:]
             for i in range(0, len(last_data) // 7):
-                data = [0x21 + i] + last_data[i * 7: (i+1) * 7]
+                data = [0x20 | ((i + 1) & 0x0F)] + last_data[i * 7: (i+1) * 7]
                 self.send(id, data)
             # Send remaining data
             if len(last_data) % 7:
-                data = [0x21 + len(last_data) // 7] + last_data[len(last_data) - len(last_data) % 7:]
+                data = [0x20 | ((len(last_data) // 7 + 1) & 0x0F)] + last_data[len(last_data) - len(last_data) % 7:]
         self.send(id, data)
 
     def request_transfer_exit(self, id, response=False):
@@ -162,7 +162,13 @@ class GenerateFrame(CanBridge):
             "zip": 0x10,
             0x01: "Only encryption",
             0x10: "Only compression",
-            0x11: "Both encryption and compression"
+            0x11: "Both encryption and compression",
+            "block": 0x20,
+            0x20: "Block compression, decompressed during the transfer",
+            0x21: "Block compression and encryption",
+            "delta": 0x30,
+            0x30: "Delta update against the installed software",
+            0x31: "Delta update and encryption"
         }
 
         # Constants
@@ -233,11 +239,11 @@ class GenerateFrame(CanBridge):
             # Delete first 3 byts of data
             last_data = transfer_data[4:]
             for i in range(0, len(last_data) // 7):
-                data = [0x21 + i] + last_data[i * 7: (i + 1) * 7]
+                data = [0x20 | ((i + 1) & 0x0F)] + last_data[i * 7: (i + 1) * 7]
                 self.send(id, data)
             # Send remaining data
             if len(last_data) % 7:
-                data = [0x21 + len(last_data)//7] + last_data[len(last_data) - len(last_data) % 7:]
+                data = [0x20 | ((len(last_data) // 7 + 1) & 0x0F)] + last_data[len(last_data) - len(last_data) % 7:]
                 self.send(id, data)
 
     def write_data_by_identifier(self, id, identifier, data_parameter):
@@ -285,10 +291,10 @@ class GenerateFrame(CanBridge):
         else:
             last_data = response[3:]
             for i in range(0, len(last_data)//7):
-                data = [(0x21 + i % 8)] + last_data[i * 7 : (i+1) * 7]
+                data = [0x20 | ((i + 1) & 0x0F)] + last_data[i * 7 : (i+1) * 7]
                 self.send(id, data)
             if len(last_data) % 7:
-                data = [0x21 + len(last_data) // 7] + last_data[len(last_data) - len(last_data) % 7:]
+                data = [0x20 | ((len(last_data) // 7 + 1) & 0x0F)] + last_data[len(last_data) - len(last_data) % 7:]
                 self.send(id, data)
 
     def __add_to_list(self, data_list, number):
@@ -128,6 +128,8 @@ class Updates(Action):
         0x01 means that only encryption is used
         0x10 means that only compression is used
         0x11 means that both encryption and compression are used
+        0x20 means that the image is block compressed by the MCU and decompressed by the ECU while it is received
+        0x30 means that only a patch against the installed software is sent (delta update)
             -> for now use 0x00 because compression/encryption are not defined
             -> we can define more values if needed
         Address and Length format identifier 1-byte
@@ -32,6 +32,11 @@
 #include <sys/ioctl.h>
 #include <sys/socket.h>
 
+/* Number of possible service identifiers, size of the per SID timing tables */
+#define SID_COUNT 256
+/* The response timers wait P2 * P2_TIME_UNIT_MS milliseconds before sending the response pending NRC */
+#define P2_TIME_UNIT_MS 50
+
 class AccessTimingParameter
 {
 public:
@@ -98,9 +103,12 @@ public:
     void setTimingParameters(canid_t frame_id, std::vector<uint8_t> data_frame);
 
     /**
-     * @brief Stop the processing timer for the module with an id equal to the receiver id
+     * @brief Stop the processing timer for the module with an id equal to the receiver id.
+     * Clears the stop flag of the SID in O(1); the deadline left in the timer wheel
+     * is discarded when it comes up, without sending the response pending frame.
      * 
-     * @param receiver_id 
+     * @param receiver_id The id of the module that processed the request.
+     * @param sid The SID of the request.
      */
     static void stopTimingFlag(uint8_t receiver_id, uint8_t sid);
     
@@ -144,17 +144,18 @@ void SecurityAccess::securityAccess(canid_t can_id, const std::vector<uint8_t>&
         /** Incorrect message length or invalid format.
          *  Frame data must have at least pci_length + SID + subfunction.
          *  If subfunction is 2, we must have at least 1 byte with key.
-         *  Size of the framedata must be always pci_length + 1.
+         *  Size of a single frame must be always pci_length + 1; a reassembled
+         *  multi-frame key keeps only the low byte of FF_DL, so its size is used.
         */
         if ((request.size() < 3) ||
-            (request[2] == 0x02 && request[0] == 2)
-            || (request.size() != static_cast<size_t>(request[0] + 1)))
+            (request[2] == 0x02 && request.size() == 3)
+            || (request.size() <= CAN_MAX_DLEN && request.size() != static_cast<size_t>(request[0] + 1)))
         {
             nrc.sendNRC(can_id,SECURITY_ACCESS_SID,NegativeResponse::IMLOIF);
         }
         else
         {
-            uint8_t pci_length = request[0];
+            size_t pci_length = request.size() - 1;
             uint8_t sf = request[2];
             /* Subfunction not supported, we use only 1st lvl of security access. */
             if (sf != 0x01 && sf != 0x02)
@@ -199,7 +200,7 @@ void SecurityAccess::securityAccess(canid_t can_id, const std::vector<uint8_t>&
                 {
                     std::vector<uint8_t> computed_key = computeKey(security_access_seed);
                     std::vector<uint8_t> received_key;
-                    for (int i = 3; i <= pci_length; i++)
+                    for (size_t i = 3; i <= pci_length; i++)
                     {
                         received_key.push_back(request[i]);
                     }
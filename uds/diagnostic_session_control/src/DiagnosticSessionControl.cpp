@@ -4,6 +4,8 @@
 #include "DoorsModule.h"
 #include "HVACModule.h"
 #include "MCUModule.h"
+#include "PeriodicScheduler.h"
+#include "DynamicDidTable.h"
 
 // Initialize current_session
 #ifndef UNIT_TESTING_MODE
@@ -54,6 +56,12 @@ void DiagnosticSessionControl::sessionControl(canid_t frame_id, uint8_t sub_func
 
 void DiagnosticSessionControl::switchSession(canid_t frame_id, DiagnosticSession session, bool is_tp)
 {
+    if (session == DEFAULT_SESSION && current_session != DEFAULT_SESSION)
+    {
+        /* The periodic and dynamic DIDs live only in a non-default session, also removed when S3 expires (is_tp) */
+        PeriodicScheduler::getInstance().clear();
+        DynamicDidTable::getInstance().clear(frame_id & 0xFF);
+    }
     if (!is_tp)
     {
         LOG_INFO(dsc_logger.GET_LOGGER(), "Session before change: {}", getCurrentSessionToString());
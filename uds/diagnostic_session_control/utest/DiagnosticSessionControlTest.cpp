@@ -7,6 +7,8 @@
 #include <net/if.h>
 
 #include "../include/DiagnosticSessionControl.h"
+#include "../../../utils/include/PeriodicScheduler.h"
+#include "../../../utils/include/DynamicDidTable.h"
 
 int socket1;
 int socket2;
@@ -188,6 +190,23 @@ TEST_F(DiagnosticSessionControlTest, UnsupportedSubfunction) {
     std::cerr << "Finished UnsupportedSubfunction" << std::endl;
 }
 
+/* Test that the periodic and dynamic DIDs are removed when the session goes back to the default session */
+TEST_F(DiagnosticSessionControlTest, SwitchToDefaultSessionStopsPeriodicDids) {
+    dsc->sessionControl(0xFA10, 0x03, true);
+    PeriodicScheduler& scheduler = PeriodicScheduler::getInstance();
+    ASSERT_EQ(scheduler.subscribe(-1, 0x10FA, "dsc_test_data.db", {0x01A0}, PeriodicScheduler::SLOW_RATE, *logger),
+              PeriodicScheduler::ACCEPTED);
+    DidStore::restore("dsc_test_data.db", {{0x01A0, {0x30}}});
+    DynamicDidTable& table = DynamicDidTable::getInstance();
+    ASSERT_TRUE(table.defineByIdentifier(0x10, 0xF300, DidStore::forFile("dsc_test_data.db"), {{0x01A0, 1, 1}}, *logger));
+
+    /* S3 timeout */
+    dsc->sessionControl(0xFA10, 0x01, true);
+    EXPECT_EQ(scheduler.getSubscriptionCount(), 0u);
+    EXPECT_FALSE(table.isDefined(0x10, 0xF300));
+    std::remove("dsc_test_data.db");
+}
+
 int main(int argc, char* argv[])
 {
     socket1 = createSocket();
@@ -0,0 +1,83 @@
+/**
+ * @file DynamicallyDefineDataIdentifier.h
+ * @brief This library represents the DynamicallyDefineDataIdentifier UDS service.
+ * It defines a DID (0xF200 - 0xF3FF) whose value is a bundle of byte ranges of other DIDs of the module
+ * and of memory ranges, so a dashboard reads all its values with one ReadDataByIdentifier request.
+ * For example, 0xF300 can hold the battery voltage (0x01B0), percentage (0x01C0), temperature (0x01E0)
+ * and state of charge (0x01D0).
+ * The request frame receive by the service will have the format:
+ *     define by identifier:     frame.data = {PCI_L(1byte), SID(1byte = 0x2C), 0x01, DYNAMIC_DID(2bytes),
+ *                                             [SOURCE_DID(2bytes), POSITION(1byte, from 1), SIZE(1byte)] ...}
+ *     define by memory address: frame.data = {PCI_L(1byte), SID(1byte = 0x2C), 0x02, DYNAMIC_DID(2bytes),
+ *                                             ADDRESS_AND_LENGTH_FORMAT(1byte), [ADDRESS, SIZE] ...}
+ *     clear:                    frame.data = {PCI_L(1byte), SID(1byte = 0x2C), 0x03, DYNAMIC_DID(2bytes, optional)}
+ * The low nibble of ADDRESS_AND_LENGTH_FORMAT is the length of each ADDRESS, the high nibble the length of each SIZE.
+ * A definition of a DID that is already defined appends the new ranges; clear without a DID removes all the
+ * dynamic DIDs of the module.
+ * The positive response frame sent by the service will have the format: frame.data = {PCI_L(1byte), RESPONSE_SID(1byte = 0x6C), SUB_FUNCTION(1byte), DYNAMIC_DID(2bytes)}
+ * The negative response frame sent by the service will have the format: frame.data = {PCI_L(1byte), 0x7F, SID(1byte = 0x2C), NRC(1byte)}
+ * The definition is compiled into a gather list (DynamicDidTable) used by ReadDataByIdentifier.
+ * @version 0.1
+ * @date 2024-09-18
+ * @copyright Copyright (c) 2024
+ */
+
+#ifndef UDS_DYNAMICALLY_DEFINE_DATA_IDENTIFIER_H
+#define UDS_DYNAMICALLY_DEFINE_DATA_IDENTIFIER_H
+
+#include <linux/can.h>
+#include <vector>
+#include <string>
+
+#include "GenerateFrames.h"
+#include "Logger.h"
+#include "NegativeResponse.h"
+#include "SecurityAccess.h"
+#include "DynamicDidTable.h"
+
+class DynamicallyDefineDataIdentifier
+{
+    public:
+    /* Define the service identifier for Dynamically Define Data Identifier */
+    static constexpr uint8_t DDDI_SERVICE_ID = 0x2C;
+    /* Sub-functions */
+    static constexpr uint8_t DEFINE_BY_IDENTIFIER = 0x01;
+    static constexpr uint8_t DEFINE_BY_MEMORY_ADDRESS = 0x02;
+    static constexpr uint8_t CLEAR_DYNAMICALLY_DEFINED_DID = 0x03;
+    /**
+    * @brief Default constructor
+    *
+    * @param socket The socket descriptor used for communication over the CAN bus.
+    * @param dddi_logger A logger instance used to record information and errors during the execution.
+    */
+    DynamicallyDefineDataIdentifier(int socket, Logger& dddi_logger);
+    /**
+    * @brief Method that defines or clears a dynamic DID.
+    *
+    * @param frame_id The frame id.
+    * @param request Data from a can frame that contains PCI, SID, sub-function, dynamic DID and its definition.
+    */
+    void dynamicallyDefineDataIdentifier(canid_t frame_id, const std::vector<uint8_t>& request);
+
+    private:
+    /**
+    * @brief Sends a negative response and stops the response timer of the service.
+    */
+    void sendNegativeResponse(canid_t can_id, uint8_t receiver_id, uint8_t nrc);
+
+    /**
+    * @brief Extracts the memory ranges of a define by memory address request.
+    *
+    * @param request Data from a can frame, starting with the PCI.
+    * @param length Bytes of the request after the PCI.
+    * @param ranges Receives the memory ranges.
+    * @return Returns false if the format or the length of the request is not valid.
+    */
+    static bool parseMemoryRanges(const std::vector<uint8_t>& request, size_t length, std::vector<DynamicDidTable::MemoryRange>& ranges);
+
+    GenerateFrames generate_frames;
+    int socket = -1;
+    Logger& dddi_logger;
+};
+
+#endif
@@ -0,0 +1,195 @@
+#include "DynamicallyDefineDataIdentifier.h"
+#include "BatteryModule.h"
+#include "EngineModule.h"
+#include "DoorsModule.h"
+#include "HVACModule.h"
+#include "MCUModule.h"
+#include "DidStore.h"
+
+DynamicallyDefineDataIdentifier::DynamicallyDefineDataIdentifier(int socket, Logger& dddi_logger)
+            : generate_frames(socket, dddi_logger), dddi_logger(dddi_logger)
+{
+    this->socket = socket;
+}
+
+void DynamicallyDefineDataIdentifier::sendNegativeResponse(canid_t can_id, uint8_t receiver_id, uint8_t nrc)
+{
+    NegativeResponse negative_response(socket, dddi_logger);
+    negative_response.sendNRC(can_id, DDDI_SERVICE_ID, nrc);
+    AccessTimingParameter::stopTimingFlag(receiver_id, DDDI_SERVICE_ID);
+}
+
+/* Function to extract the memory ranges of a define by memory address request */
+bool DynamicallyDefineDataIdentifier::parseMemoryRanges(const std::vector<uint8_t>& request, size_t length, std::vector<DynamicDidTable::MemoryRange>& ranges)
+{
+    /* SID, sub-function, dynamic DID and format */
+    if (length < 5)
+    {
+        return false;
+    }
+    uint8_t address_length = request[5] & 0x0F;
+    uint8_t size_length = request[5] >> 4;
+    size_t range_length = address_length + size_length;
+    if (address_length == 0 || address_length > 4 || size_length == 0 || size_length > 2 ||
+        length == 5 || (length - 5) % range_length != 0)
+    {
+        return false;
+    }
+    ranges.clear();
+    for (size_t index = 6; index + range_length <= length + 1; index += range_length)
+    {
+        DynamicDidTable::MemoryRange range = {0, 0};
+        for (size_t byte = 0; byte < address_length; ++byte)
+        {
+            range.address = (range.address << 8) | request[index + byte];
+        }
+        for (size_t byte = 0; byte < size_length; ++byte)
+        {
+            range.size = (range.size << 8) | request[index + address_length + byte];
+        }
+        ranges.push_back(range);
+    }
+    return true;
+}
+
+/* Function to handle the Dynamically Define Data Identifier request */
+void DynamicallyDefineDataIdentifier::dynamicallyDefineDataIdentifier(canid_t frame_id, const std::vector<uint8_t>& request)
+{
+    /* Extract the first 8 bits of frame_id */
+    uint8_t lowerbits = frame_id & 0xFF;
+    uint8_t upperbits = frame_id >> 8 & 0xFF;
+
+    /* Reverse IDs */
+    canid_t can_id = ((lowerbits << 8) | upperbits);
+
+    /* Bytes after the PCI; a single frame can be padded, then its PCI gives the length */
+    size_t length = request.empty() ? 0 : request.size() - 1;
+    if (request.size() <= CAN_MAX_DLEN && !request.empty() && request[0] < length)
+    {
+        length = request[0];
+    }
+    if (length < 2)
+    {
+        sendNegativeResponse(can_id, lowerbits, NegativeResponse::IMLOIF);
+        return;
+    }
+    uint8_t sub_function = request[2];
+    if (sub_function != DEFINE_BY_IDENTIFIER && sub_function != DEFINE_BY_MEMORY_ADDRESS &&
+        sub_function != CLEAR_DYNAMICALLY_DEFINED_DID)
+    {
+        sendNegativeResponse(can_id, lowerbits, NegativeResponse::SFNS);
+        return;
+    }
+    std::vector<DynamicDidTable::SourceRange> source_ranges;
+    std::vector<DynamicDidTable::MemoryRange> memory_ranges;
+    bool valid_length = false;
+    if (sub_function == CLEAR_DYNAMICALLY_DEFINED_DID)
+    {
+        valid_length = length == 2 || length == 4;
+    }
+    else if (sub_function == DEFINE_BY_IDENTIFIER)
+    {
+        /* SID, sub-function and dynamic DID, followed by 4 bytes per source DID */
+        valid_length = length > 4 && (length - 4) % 4 == 0;
+        for (size_t index = 5; valid_length && index + 4 <= length + 1; index += 4)
+        {
+            source_ranges.push_back({static_cast<uint16_t>((request[index] << 8) | request[index + 1]),
+                                     request[index + 2], request[index + 3]});
+        }
+    }
+    else
+    {
+        valid_length = parseMemoryRanges(request, length, memory_ranges);
+    }
+    if (!valid_length)
+    {
+        sendNegativeResponse(can_id, lowerbits, NegativeResponse::IMLOIF);
+        return;
+    }
+    if (lowerbits == 0x10 && !SecurityAccess::getMcuState(dddi_logger))
+    {
+        sendNegativeResponse(can_id, lowerbits, NegativeResponse::SAD);
+        return;
+    }
+    if ((lowerbits == 0x11 || lowerbits == 0x12 ||
+         lowerbits == 0x13 || lowerbits == 0x14) &&
+         !ReceiveFrames::getEcuState())
+    {
+        sendNegativeResponse(can_id, lowerbits, NegativeResponse::SAD);
+        return;
+    }
+
+    DynamicDidTable& table = DynamicDidTable::getInstance();
+    uint16_t dynamic_did = length >= 4 ? (request[3] << 8) | request[4] : 0;
+    if (length >= 4 && !DynamicDidTable::isDynamic(dynamic_did))
+    {
+        LOG_ERROR(dddi_logger.GET_LOGGER(), "DID 0x{:04X} is not a dynamically defined DID.", dynamic_did);
+        sendNegativeResponse(can_id, lowerbits, NegativeResponse::ROOR);
+        return;
+    }
+    if (sub_function == CLEAR_DYNAMICALLY_DEFINED_DID)
+    {
+        size_t cleared = length == 2 ? table.clear(lowerbits) : table.clear(lowerbits, dynamic_did);
+        LOG_INFO(dddi_logger.GET_LOGGER(), "{} dynamic DID(s) cleared for 0x{:x}.", cleared, lowerbits);
+        std::vector<uint8_t> cleared_did;
+        if (length == 4)
+        {
+            cleared_did = {request[3], request[4]};
+        }
+        generate_frames.dynamicallyDefineDataIdentifier(can_id, sub_function, cleared_did, true);
+        AccessTimingParameter::stopTimingFlag(lowerbits, DDDI_SERVICE_ID);
+        return;
+    }
+
+    std::string file_name = std::string(PROJECT_PATH);
+    if (lowerbits == 0x10)
+    {
+        file_name += "/backend/mcu/mcu_data.db";
+    }
+    else if (lowerbits == 0x11)
+    {
+        file_name += "/backend/ecu_simulation/BatteryModule/battery_data.db";
+    }
+    else if (lowerbits == 0x12)
+    {
+        file_name += "/backend/ecu_simulation/EngineModule/engine_data.db";
+    }
+    else if (lowerbits == 0x13)
+    {
+        file_name += "/backend/ecu_simulation/DoorsModule/doors_data.db";
+    }
+    else if (lowerbits == 0x14)
+    {
+        file_name += "/backend/ecu_simulation/HVACModule/hvac_data.db";
+    }
+    else
+    {
+        sendNegativeResponse(can_id, lowerbits, NegativeResponse::ROOR);
+        return;
+    }
+
+    bool defined = false;
+    try
+    {
+        if (sub_function == DEFINE_BY_IDENTIFIER)
+        {
+            defined = table.defineByIdentifier(lowerbits, dynamic_did, DidStore::forFile(file_name), source_ranges, dddi_logger);
+        }
+        else
+        {
+            defined = table.defineByMemoryAddress(lowerbits, dynamic_did, memory_ranges, dddi_logger);
+        }
+    } catch (const std::exception& e)
+    {
+        LOG_ERROR(dddi_logger.GET_LOGGER(), "Error reading from file: {}", e.what());
+    }
+    if (!defined)
+    {
+        sendNegativeResponse(can_id, lowerbits, NegativeResponse::ROOR);
+        return;
+    }
+
+    generate_frames.dynamicallyDefineDataIdentifier(can_id, sub_function, {request[3], request[4]}, true);
+    LOG_INFO(dddi_logger.GET_LOGGER(), "Service with SID {:x} successfully sent the response frame.", DDDI_SERVICE_ID);
+    AccessTimingParameter::stopTimingFlag(lowerbits, DDDI_SERVICE_ID);
+}
@@ -0,0 +1,209 @@
+/**
+ * @file DynamicallyDefineDataIdentifierTest.cpp
+ * @brief Unit test for Dynamically Define Data Identifier Service
+ * @version 0.1
+ * @date 2024-09-18
+ */
+#include <gtest/gtest.h>
+#include "../include/DynamicallyDefineDataIdentifier.h"
+#include "../../read_data_by_identifier/include/ReadDataByIdentifier.h"
+#include "../../../utils/include/ReceiveFrames.h"
+#include "../../../utils/include/DidStore.h"
+
+int socket1;
+int socket2;
+
+class CaptureFrame
+{
+    public:
+        struct can_frame frame;
+        void capture()
+        {
+            read(socket1, &frame, sizeof(struct can_frame));
+        }
+};
+
+struct can_frame createFrame(uint16_t can_id ,std::vector<uint8_t> test_data)
+{
+    struct can_frame result_frame;
+    result_frame.can_id = can_id;
+    int i=0;
+    for (auto d : test_data)
+    {
+        result_frame.data[i++] = d;
+    }
+    result_frame.can_dlc = test_data.size();
+    return result_frame;
+}
+
+int createSocket()
+{
+    /* Create socket */
+    std::string name_interface = "vcan1";
+    struct sockaddr_can addr;
+    struct ifreq ifr;
+    int s;
+
+    s = socket(PF_CAN, SOCK_RAW, CAN_RAW);
+    if (s < 0)
+    {
+        std::cout<<"Error trying to create the socket\n";
+        return 1;
+    }
+    /* Giving name and index to the interface created */
+    strcpy(ifr.ifr_name, name_interface.c_str() );
+    ioctl(s, SIOCGIFINDEX, &ifr);
+    /* Set addr structure with info. of the CAN interface */
+    addr.can_family = AF_CAN;
+    addr.can_ifindex = ifr.ifr_ifindex;
+    /* Bind the socket to the CAN interface */
+    int b = bind(s, (struct sockaddr*)&addr, sizeof(addr));
+    if( b < 0 )
+    {
+        std::cout<<"Error binding\n";
+        return 1;
+    }
+    int flags = fcntl(s, F_GETFL, 0);
+    if (flags == -1)
+    {
+        return 1;
+    }
+    /* Set the O_NONBLOCK flag to make the socket non-blocking */
+    flags |= O_NONBLOCK;
+    if (fcntl(s, F_SETFL, flags) == -1)
+    {
+        return -1;
+    }
+    return s;
+}
+
+void testFrames(struct can_frame expected_frame, CaptureFrame &c1 )
+{
+    EXPECT_EQ(expected_frame.can_id & 0xFFFF, c1.frame.can_id & 0xFFFF);
+    EXPECT_EQ(expected_frame.can_dlc, c1.frame.can_dlc);
+    for (int i = 0; i < expected_frame.can_dlc; ++i)
+    {
+        EXPECT_EQ(expected_frame.data[i], c1.frame.data[i]);
+    }
+}
+
+struct DynamicallyDefineDataIdentifierTest : testing::Test
+{
+    DynamicallyDefineDataIdentifier* dddi;
+    ReadDataByIdentifier* rdbi;
+    CaptureFrame* c1;
+    Logger* logger;
+    DynamicallyDefineDataIdentifierTest()
+    {
+        logger = new Logger();
+        dddi = new DynamicallyDefineDataIdentifier(socket2, *logger);
+        rdbi = new ReadDataByIdentifier(socket2, *logger);
+        c1 = new CaptureFrame();
+    }
+    ~DynamicallyDefineDataIdentifierTest()
+    {
+        DynamicDidTable::getInstance().clear(0x11);
+        delete dddi;
+        delete rdbi;
+        delete c1;
+        delete logger;
+    }
+};
+
+TEST_F(DynamicallyDefineDataIdentifierTest, IncorrectMessageLength)
+{
+    struct can_frame result_frame = createFrame(0x11FA, {0x03, 0x7F, 0x2C, NegativeResponse::IMLOIF});
+    dddi->dynamicallyDefineDataIdentifier(0xFA11, {0x01, 0x2C});
+    c1->capture();
+    testFrames(result_frame, *c1);
+
+    /* Incomplete source range */
+    dddi->dynamicallyDefineDataIdentifier(0xFA11, {0x07, 0x2C, 0x01, 0xF3, 0x00, 0x01, 0xB0, 0x01});
+    c1->capture();
+    testFrames(result_frame, *c1);
+
+    /* Memory range without size */
+    dddi->dynamicallyDefineDataIdentifier(0xFA11, {0x07, 0x2C, 0x02, 0xF3, 0x00, 0x12, 0x10, 0x00});
+    c1->capture();
+    testFrames(result_frame, *c1);
+}
+
+TEST_F(DynamicallyDefineDataIdentifierTest, SubFunctionNotSupported)
+{
+    struct can_frame result_frame = createFrame(0x11FA, {0x03, 0x7F, 0x2C, NegativeResponse::SFNS});
+    dddi->dynamicallyDefineDataIdentifier(0xFA11, {0x04, 0x2C, 0x04, 0xF3, 0x00});
+    c1->capture();
+    testFrames(result_frame, *c1);
+}
+
+TEST_F(DynamicallyDefineDataIdentifierTest, ECUsSecurity)
+{
+    ReceiveFrames* receiveFrames = new ReceiveFrames(socket2, 0x11, *logger);
+    receiveFrames->setEcuState(false);
+    struct can_frame result_frame = createFrame(0x11FA, {0x03, 0x7F, 0x2C, NegativeResponse::SAD});
+    dddi->dynamicallyDefineDataIdentifier(0xFA11, {0x04, 0x2C, 0x03, 0xF3, 0x00});
+    c1->capture();
+    testFrames(result_frame, *c1);
+    delete receiveFrames;
+}
+
+TEST_F(DynamicallyDefineDataIdentifierTest, RequestOutOfRangeBattery)
+{
+    ReceiveFrames* receiveFrames = new ReceiveFrames(socket2, 0x11, *logger);
+    receiveFrames->setEcuState(true);
+    struct can_frame result_frame = createFrame(0x11FA, {0x03, 0x7F, 0x2C, NegativeResponse::ROOR});
+
+    /* Not a dynamic DID */
+    dddi->dynamicallyDefineDataIdentifier(0xFA11, {0x08, 0x2C, 0x01, 0x01, 0xB0, 0x01, 0xC0, 0x01, 0x01});
+    c1->capture();
+    testFrames(result_frame, *c1);
+
+    /* Unknown source DID */
+    dddi->dynamicallyDefineDataIdentifier(0xFA11, {0x08, 0x2C, 0x01, 0xF3, 0x00, 0x11, 0x11, 0x01, 0x01});
+    c1->capture();
+    testFrames(result_frame, *c1);
+    delete receiveFrames;
+}
+
+/* Test a battery bundle defined, read with one ReadDataByIdentifier request and cleared */
+TEST_F(DynamicallyDefineDataIdentifierTest, BatteryBundle)
+{
+    ReceiveFrames* receiveFrames = new ReceiveFrames(socket2, 0x11, *logger);
+    receiveFrames->setEcuState(true);
+    DidStore& store = DidStore::forFile(std::string(PROJECT_PATH) + "/backend/ecu_simulation/BatteryModule/battery_data.db", true);
+    store.set(0x01B0, {0x0C, 0x80}, true);
+    store.set(0x01C0, {0x5A}, true);
+
+    struct can_frame result_frame = createFrame(0x11FA, {0x04, 0x6C, 0x01, 0xF3, 0x00});
+    /* Reassembled multi-frame request: voltage and percentage */
+    dddi->dynamicallyDefineDataIdentifier(0xFA11, {0x0C, 0x2C, 0x01, 0xF3, 0x00, 0x01, 0xB0, 0x01, 0x02, 0x01, 0xC0, 0x01, 0x01});
+    c1->capture();
+    testFrames(result_frame, *c1);
+
+    std::vector<uint8_t> value = rdbi->readDataByIdentifier(0xFA11, {0x03, 0x22, 0xF3, 0x00}, false);
+    EXPECT_EQ(value, std::vector<uint8_t>({0x0C, 0x80, 0x5A}));
+
+    result_frame = createFrame(0x11FA, {0x04, 0x6C, 0x03, 0xF3, 0x00});
+    dddi->dynamicallyDefineDataIdentifier(0xFA11, {0x04, 0x2C, 0x03, 0xF3, 0x00});
+    c1->capture();
+    testFrames(result_frame, *c1);
+    EXPECT_FALSE(DynamicDidTable::getInstance().isDefined(0x11, 0xF300));
+    delete receiveFrames;
+}
+
+int main(int argc, char* argv[])
+{
+    socket1 = createSocket();
+    socket2 = createSocket();
+    testing::InitGoogleTest(&argc, argv);
+    int result = RUN_ALL_TESTS();
+    if (socket1 > 0)
+    {
+        close(socket1);
+    }
+    if (socket2 > 0)
+    {
+        close(socket2);
+    }
+    return result;
+}
@@ -4,6 +4,9 @@
 #include "EngineModule.h"
 #include "DoorsModule.h"
 #include "HVACModule.h"
+#include "DidStore.h"
+#include "PeriodicScheduler.h"
+#include "DynamicDidTable.h"
 
 EcuReset::EcuReset(uint32_t can_id, uint8_t sub_function, int socket, Logger &logger)
     : can_id(can_id), sub_function(sub_function), socket(socket), ECUResetLog(logger)
@@ -64,6 +67,11 @@ void EcuReset::ecuResetRequest(const std::vector<uint8_t>& request)
 void EcuReset::hardReset()
 {  
     uint8_t lowerbits = can_id & 0xFF;
+    /* No periodic DID is sent after the response, the module starts again in the default session */
+    PeriodicScheduler::getInstance().clear();
+    DynamicDidTable::getInstance().clear(lowerbits);
+    /* The DID database is written on the disk before the process is replaced */
+    DidStore::flushAll();
     /* Send response */
     this->ecuResetResponse();
     switch(lowerbits)
@@ -133,81 +141,39 @@ void EcuReset::keyOffReset()
     uint8_t lowerbits = can_id & 0xFF;
 
     std::string file_path;
-    /* Path to the data file */
+    /* Path to the DID database */
     switch (lowerbits)
     {
     case 0x10:
-        file_path = "mcu_data.txt";
+        file_path = "mcu_data.db";
         break;
     case 0x11:
-        file_path = "battery_data.txt";
+        file_path = "battery_data.db";
         break;
     case 0x12:
-        file_path = "engine_data.txt";
+        file_path = "engine_data.db";
         break;
     case 0x13:
-        file_path = "doors_data.txt";
+        file_path = "doors_data.db";
         break;
     case 0x14:
-        file_path = "hvac_data.txt";
+        file_path = "hvac_data.db";
         break;
     default:
         LOG_ERROR(ECUResetLog.GET_LOGGER(), "ECU doesn't exist");
         break;
     }
 
-    /* Read the current file contents into memory */
-    std::ifstream infile(file_path);
-    std::stringstream buffer;
-    /* Read the entire file into the buffer */
-    buffer << infile.rdbuf();
-    infile.close();
-
-    /* Store the original content */
-    std::string original_file_contents = buffer.str(); 
-
-    switch (lowerbits)
-    {
-    case 0x10:
-    {
-        std::ofstream outfile("old_mcu_data.txt");
-        outfile << original_file_contents;
-        outfile.close();
-        break;
-    }
-    case 0x11:
-    {
-        std::ofstream outfile("old_battery_data.txt");
-        outfile << original_file_contents;
-        outfile.close();
-        break;
-    }
-    case 0x12:
+    /* The module keeps the values of its DID database when it starts again */
+    try
     {
-        std::ofstream outfile("old_engine_data.txt");
-        outfile << original_file_contents;
-        outfile.close();
-        break;
+        DidStore::forFile(file_path).keepValuesOnRestart();
     }
-    case 0x13:
+    catch (const std::exception& e)
     {
-        std::ofstream outfile("old_doors_data.txt");
-        outfile << original_file_contents;
-        outfile.close();
-        break;
-    }
-    case 0x14:
-    {
-        std::ofstream outfile("old_hvac_data.txt");
-        outfile << original_file_contents;
-        outfile.close();
-        break;
+        LOG_ERROR(ECUResetLog.GET_LOGGER(), "Error marking the DID database: {}", e.what());
     }
-    default:
-        LOG_ERROR(ECUResetLog.GET_LOGGER(), "ECU doesn't exist");
-        break;
-    }
-    
+
     /* Reset the program */
     hardReset();
 }
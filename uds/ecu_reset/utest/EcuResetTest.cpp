@@ -8,6 +8,8 @@
 #include <gtest/gtest.h>
 #include "../include/EcuReset.h"
 #include "../../../utils/include/ReceiveFrames.h"
+#include "../../../utils/include/PeriodicScheduler.h"
+#include "../../../utils/include/DynamicDidTable.h"
 
 int socket1;
 int socket2;
@@ -330,6 +332,23 @@ TEST_F(EcuResetTest, SoftResetECU)
     delete ecuReset;
 }
 
+TEST_F(EcuResetTest, HardResetStopsPeriodicDids)
+{
+    ReceiveFrames::setEcuState(true);
+    PeriodicScheduler& scheduler = PeriodicScheduler::getInstance();
+    ASSERT_EQ(scheduler.subscribe(-1, 0x11FA, "ecu_reset_test_data.db", {0x01A0}, PeriodicScheduler::SLOW_RATE, *logger),
+              PeriodicScheduler::ACCEPTED);
+    DidStore::restore("ecu_reset_test_data.db", {{0x01A0, {0x30}}});
+    DynamicDidTable& table = DynamicDidTable::getInstance();
+    ASSERT_TRUE(table.defineByIdentifier(0x11, 0xF300, DidStore::forFile("ecu_reset_test_data.db"), {{0x01A0, 1, 1}}, *logger));
+    EcuReset ecuReset(0xFA11, 0x01, socket2, *logger);
+    ecuReset.ecuResetRequest({0x02, 0x11, 0x01});
+    c1->capture();
+    EXPECT_EQ(scheduler.getSubscriptionCount(), 0u);
+    EXPECT_FALSE(table.isDefined(0x11, 0xF300));
+    std::remove("ecu_reset_test_data.db");
+}
+
 int main(int argc, char* argv[])
 {
     socket1 = createSocket();
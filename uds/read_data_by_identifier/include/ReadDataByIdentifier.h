@@ -7,6 +7,13 @@
  * The request frame receive by the service will have the format: frame.data = {PCI_L(1byte), SID(1byte = 0x22), DID(2bytes),Padding(4bytes)}
  * The positive response frame sent by the service will have the format: frame.data = {PCI_L(1byte), RESPONSE_SID(1byte = 0x62), DID(2bytes), DATA}
  * The negative response frame sent by the service will have the format: frame.data = {PCI_L(1byte), 0x7F, SID(1byte = 0x22), NRC(1byte)}
+ * A request can also hold a list of DIDs: {PCI_L, 0x22, DID_1(2bytes), ..., DID_n(2bytes)}, sent as a multi-frame
+ * request above 3 DIDs. All the DIDs are read in one pass from the DID database of the module and the response
+ * holds a record for each supported DID: {0x62, DID_1, DATA_1, ..., DID_n, DATA_n}, sent as a multi-frame response
+ * when it does not fit in a single frame. The DIDs that are not supported are left out of the response;
+ * the request is answered with a negative response (ROOR) only if none of them is supported.
+ * A DID defined with DynamicallyDefineDataIdentifier (0xF200 - 0xF3FF) is read like the others; its data is
+ * gathered from the DIDs and memory ranges of its definition.
  */
 
 #ifndef UDS_READ_DATA_BY_IDENTIFIER_H
@@ -30,6 +37,8 @@ class ReadDataByIdentifier
     public:
     /* Define the service identifier for Read Data By Identifier */
     static constexpr uint8_t RDBI_SERVICE_ID = 0x22;
+    /* Maximum number of DIDs in a request */
+    static constexpr size_t RDBI_MAX_DIDS = 32;
     /**
     * @brief Default constructor
     * 
@@ -41,12 +50,25 @@ class ReadDataByIdentifier
     * @brief Method that retrieves some data based on a DID.
     * 
     * @param can_id The frame id.
-    * @param request Data from a can frame that contains PCI, SID and DID.
+    * @param request Data from a can frame that contains PCI, SID and one or more DIDs.
     * @param use_send_frame true if you want to send a response frame, false if you need only the return
+    * @return For a single DID, the data of the DID. For several DIDs, the records of the supported DIDs
+    *      (DID followed by its data). The negative response frame if the request is rejected.
     */
     std::vector<uint8_t> readDataByIdentifier(canid_t can_id, const std::vector<uint8_t>& request, bool use_send_frame);
     
     private:
+    /**
+    * @brief Extracts the DIDs of a request. The length of a single frame request is taken from its PCI,
+    *      so the padding bytes are not read as DIDs.
+    *
+    * @param request Data from a can frame that contains PCI, SID and DIDs.
+    * @param data_identifiers Receives the DIDs, in the order of the request.
+    * @return Returns false if the length of the request is not SID + 2 bytes per DID,
+    *      or if the request holds more than RDBI_MAX_DIDS DIDs.
+    */
+    static bool parseDataIdentifiers(const std::vector<uint8_t>& request, std::vector<uint16_t>& data_identifiers);
+
     GenerateFrames generate_frames;
     int socket = -1;
     Logger& rdbi_logger;
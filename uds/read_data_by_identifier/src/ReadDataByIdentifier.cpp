@@ -4,6 +4,8 @@
 #include "DoorsModule.h"
 #include "HVACModule.h"
 #include "MCUModule.h"
+#include "DidStore.h"
+#include "DynamicDidTable.h"
 
 ReadDataByIdentifier::ReadDataByIdentifier(int socket, Logger& rdbi_logger) 
             : generate_frames(socket, rdbi_logger), rdbi_logger(rdbi_logger)
@@ -24,8 +26,9 @@ std::vector<uint8_t> ReadDataByIdentifier::readDataByIdentifier(canid_t frame_id
     /* Reverse IDs */
     canid_t can_id = ((lowerbits << 8) | upperbits);
 
-    /* Check if the request size is less than 4 */
-    if (request.size() < 4)
+    /* Check if the request holds at least one DID */
+    std::vector<uint16_t> data_identifiers;
+    if (request.size() < 4 || !parseDataIdentifiers(request, data_identifiers))
     {
         /* Invalid request length - prepare a negative response */
         response.push_back(0x03); /* PCI */
@@ -71,28 +74,26 @@ std::vector<uint8_t> ReadDataByIdentifier::readDataByIdentifier(canid_t frame_id
         return response;
     }
 
-    /* Extract the data identifier from the request */
-    uint16_t data_identifier = (request[2] << 8) | request[3];
     std::string file_name = std::string(PROJECT_PATH);
     if (lowerbits == 0x10)
     {
-        file_name += "/backend/mcu/mcu_data.txt";
+        file_name += "/backend/mcu/mcu_data.db";
     }
     else if (lowerbits == 0x11)
     {
-        file_name += "/backend/ecu_simulation/BatteryModule/battery_data.txt";
+        file_name += "/backend/ecu_simulation/BatteryModule/battery_data.db";
     }
     else if (lowerbits == 0x12)
     {
-        file_name += "/backend/ecu_simulation/EngineModule/engine_data.txt";
+        file_name += "/backend/ecu_simulation/EngineModule/engine_data.db";
     }
     else if (lowerbits == 0x13)
     {
-        file_name += "/backend/ecu_simulation/DoorsModule/doors_data.txt";
+        file_name += "/backend/ecu_simulation/DoorsModule/doors_data.db";
     }
     else if (lowerbits == 0x14)
     {
-        file_name += "/backend/ecu_simulation/HVACModule/hvac_data.txt";
+        file_name += "/backend/ecu_simulation/HVACModule/hvac_data.db";
     }
     else
     {
@@ -108,13 +109,38 @@ std::vector<uint8_t> ReadDataByIdentifier::readDataByIdentifier(canid_t frame_id
         return response;
     }
 
+    /* Records of the supported DIDs: DID followed by its data */
+    std::vector<uint8_t> records;
     try
     {
-        auto data_map = FileManager::readMapFromFile(file_name);
-        response = data_map[data_identifier];
+        /* Read all the DIDs in one pass from the shared DID database of the module, without lock */
+        DidStore& store = DidStore::forFile(file_name);
+        DynamicDidTable& dynamic_dids = DynamicDidTable::getInstance();
+        std::vector<uint8_t> value;
+        for (uint16_t data_identifier : data_identifiers)
+        {
+            /* A dynamically defined DID is gathered from its compiled list of sources */
+            bool found = DynamicDidTable::isDynamic(data_identifier)
+                ? dynamic_dids.read(lowerbits, data_identifier, store, value, rdbi_logger)
+                : store.get(data_identifier, value);
+            if (!found || value.empty())
+            {
+                /* Unsupported DIDs are left out of the response */
+                LOG_WARN(rdbi_logger.GET_LOGGER(), "DID 0x{:04X} not found in {}", data_identifier, file_name);
+                continue;
+            }
+            records.push_back(data_identifier >> 8);
+            records.push_back(data_identifier & 0xFF);
+            records.insert(records.end(), value.begin(), value.end());
+            if (data_identifiers.size() == 1)
+            {
+                response = value;
+            }
+        }
     } catch (const std::exception& e)
     {
         LOG_ERROR(rdbi_logger.GET_LOGGER(), "Error reading from file: {}", e.what());
+        response.clear();
         response.push_back(0x03); /* PCI */
         response.push_back(0x7F); /* Negative response */
         response.push_back(RDBI_SERVICE_ID); /* Service ID */
@@ -127,9 +153,9 @@ std::vector<uint8_t> ReadDataByIdentifier::readDataByIdentifier(canid_t frame_id
         return response;
     }
 
-    if (response.empty())
+    if (records.empty())
     {
-        /* Data identifier not found */
+        /* None of the data identifiers was found */
         response.push_back(0x03); /* PCI */
         response.push_back(0x7F); /* Negative response */
         response.push_back(RDBI_SERVICE_ID); /* Service ID */
@@ -141,23 +167,64 @@ std::vector<uint8_t> ReadDataByIdentifier::readDataByIdentifier(canid_t frame_id
         }
         return response;
     }
+    if (data_identifiers.size() > 1)
+    {
+        response = records;
+    }
 
     // Convert the response vector to a string for logging
     std::ostringstream oss;
-    for (const auto& byte : response)
+    for (const auto& byte : records)
     {
         oss << std::hex << std::setw(2) << std::setfill('0') << static_cast<int>(byte) << " ";
     }
 
     // Log the data
-    LOG_INFO(rdbi_logger.GET_LOGGER(), "Data for DID 0x{:04X} from {}: {}", data_identifier, file_name, oss.str());
+    LOG_INFO(rdbi_logger.GET_LOGGER(), "Data for {} DID(s) from {}: {}", data_identifiers.size(), file_name, oss.str());
 
     if (use_send_frame)
     {
-        /* Send response frame */
-        generate_frames.readDataByIdentifier(can_id, data_identifier, response);
+        /* Send the response: a single frame, or the first frame and the consecutive frames after the flow control of the client */
+        Logger log = rdbi_logger;
+        generate_frames.readDataByIdentifierRecords(can_id, records,
+            [log](IsoTpTransmitter::TransmitStatus status)
+            {
+                if (status == IsoTpTransmitter::COMPLETE)
+                {
+                    LOG_INFO(log.GET_LOGGER(), "Service with SID {:x} successfully sent the consecutive response frames.", 0x22);
+                }
+                else
+                {
+                    LOG_ERROR(log.GET_LOGGER(), "Service with SID {:x} failed to send the consecutive response frames: {}", 0x22,
+                              status == IsoTpTransmitter::TIMEOUT ? "timeout, flow control frame not received" : "transmission aborted");
+                }
+            });
         LOG_INFO(rdbi_logger.GET_LOGGER(), "Service with SID {:x} successfully sent the response frame.", 0x22);
         AccessTimingParameter::stopTimingFlag(lowerbits, 0x22);
     }
     return response;
-}
\ No newline at end of file
+}
+
+/* Function to extract the DIDs of a request */
+bool ReadDataByIdentifier::parseDataIdentifiers(const std::vector<uint8_t>& request, std::vector<uint16_t>& data_identifiers)
+{
+    /* Bytes after the PCI; a single frame can be padded, then its PCI gives the length */
+    size_t length = request.size() - 1;
+    if (request.size() <= CAN_MAX_DLEN && request[0] >= 3 && request[0] < length)
+    {
+        length = request[0];
+    }
+    /* SID followed by 2 bytes per DID */
+    size_t count = (length - 1) / 2;
+    if ((length - 1) % 2 != 0 || count == 0 || count > RDBI_MAX_DIDS)
+    {
+        return false;
+    }
+    data_identifiers.clear();
+    data_identifiers.reserve(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        data_identifiers.push_back((request[2 + 2 * i] << 8) | request[3 + 2 * i]);
+    }
+    return true;
+}
@@ -8,6 +8,7 @@
 #include <gtest/gtest.h>
 #include "../include/ReadDataByIdentifier.h"
 #include "../../../utils/include/ReceiveFrames.h"
+#include "../../../utils/include/DidStore.h"
 
 int socket1;
 int socket2;
@@ -128,10 +129,19 @@ TEST_F(ReadDataByIdentifierTest, IncorrectMessageLength)
     testFrames(result_frame, *c1);
 }
 
+/* Test a request with a DID cut in half */
+TEST_F(ReadDataByIdentifierTest, OddRequestLength)
+{
+    struct can_frame result_frame = createFrame(0x10FA, {0x03, 0x7F, 0x22, NegativeResponse::IMLOIF});
+    rdbi->readDataByIdentifier(0xFA10, {0x04, 0x22, 0xF1, 0xA2, 0xF1}, true);
+    c1->capture();
+    testFrames(result_frame, *c1);
+}
+
 TEST_F(ReadDataByIdentifierTest, MCUSecurity)
 {
     struct can_frame result_frame = createFrame(0x10FA, {0x03, 0x7F, 0x22, NegativeResponse::SAD});
-    rdbi->readDataByIdentifier(0xFA10, {0x04, 0x22, 0xf1, 0x90, 0x11}, true);
+    rdbi->readDataByIdentifier(0xFA10, {0x03, 0x22, 0xf1, 0x90}, true);
     c1->capture();
     testFrames(result_frame, *c1);
 }
@@ -141,27 +151,27 @@ TEST_F(ReadDataByIdentifierTest, ECUsSecurity)
     /* Battery Module */
     struct can_frame result_frame = createFrame(0x11FA, {0x03, 0x7F, 0x22, NegativeResponse::SAD});
 
-    rdbi->readDataByIdentifier(0xFA11, {0x04, 0x22, 0xf1, 0x90, 0x11}, true);
+    rdbi->readDataByIdentifier(0xFA11, {0x03, 0x22, 0xf1, 0x90}, true);
     c1->capture();
     testFrames(result_frame, *c1);
 
     /* Engine Module */
     result_frame = createFrame(0x12FA, {0x03, 0x7F, 0x22, NegativeResponse::SAD});
 
-    rdbi->readDataByIdentifier(0xFA12, {0x04, 0x22, 0xf1, 0x90, 0x11}, true);
+    rdbi->readDataByIdentifier(0xFA12, {0x03, 0x22, 0xf1, 0x90}, true);
     c1->capture();
     testFrames(result_frame, *c1);
 
     /* Doors Module */
     result_frame = createFrame(0x13FA, {0x03, 0x7F, 0x22, NegativeResponse::SAD});
 
-    rdbi->readDataByIdentifier(0xFA13, {0x04, 0x22, 0xf1, 0x90, 0x11}, true);
+    rdbi->readDataByIdentifier(0xFA13, {0x03, 0x22, 0xf1, 0x90}, true);
     c1->capture();
     testFrames(result_frame, *c1);
 
     /* HVAC Module */
     result_frame = createFrame(0x14FA, {0x03, 0x7F, 0x22, NegativeResponse::SAD});
-    rdbi->readDataByIdentifier(0xFA14, {0x04, 0x22, 0xf1, 0x90, 0x11}, true);
+    rdbi->readDataByIdentifier(0xFA14, {0x03, 0x22, 0xf1, 0x90}, true);
     c1->capture();
     testFrames(result_frame, *c1);
 }
@@ -195,7 +205,7 @@ TEST_F(ReadDataByIdentifierTest, RequestOutOfRangeMCU)
     security->securityAccess(0xFA10, data_frame);
     c1->capture();
 
-    rdbi->readDataByIdentifier(0xFA10, {0x04, 0x22, 0x11, 0x11, 0x11}, true);
+    rdbi->readDataByIdentifier(0xFA10, {0x03, 0x22, 0x11, 0x11}, true);
     c1->capture();
     testFrames(result_frame, *c1);
 }
@@ -206,7 +216,7 @@ TEST_F(ReadDataByIdentifierTest, RequestOutOfRangeBattery)
     ReceiveFrames* receiveFrames = new ReceiveFrames(socket2, 0x11, *logger);
     receiveFrames->setEcuState(true);
     struct can_frame result_frame = createFrame(0x11FA, {0x03, 0x7F, 0x22, NegativeResponse::ROOR});
-    rdbi->readDataByIdentifier(0xFA11, {0x04, 0x22, 0x11, 0x11, 0x11}, true);
+    rdbi->readDataByIdentifier(0xFA11, {0x03, 0x22, 0x11, 0x11}, true);
     c1->capture();
     testFrames(result_frame, *c1);
     delete receiveFrames;
@@ -216,7 +226,7 @@ TEST_F(ReadDataByIdentifierTest, RequestOutOfRangeBattery)
 TEST_F(ReadDataByIdentifierTest, RequestOutOfRangeEngine)
 {
     struct can_frame result_frame = createFrame(0x12FA, {0x03, 0x7F, 0x22, NegativeResponse::ROOR});
-    rdbi->readDataByIdentifier(0xFA12, {0x04, 0x22, 0x11, 0x11, 0x11}, true);
+    rdbi->readDataByIdentifier(0xFA12, {0x03, 0x22, 0x11, 0x11}, true);
     c1->capture();
     testFrames(result_frame, *c1);
 }
@@ -225,7 +235,7 @@ TEST_F(ReadDataByIdentifierTest, RequestOutOfRangeEngine)
 TEST_F(ReadDataByIdentifierTest, RequestOutOfRangeDoors)
 {
     struct can_frame result_frame = createFrame(0x13FA, {0x03, 0x7F, 0x22, NegativeResponse::ROOR});
-    rdbi->readDataByIdentifier(0xFA13, {0x04, 0x22, 0x11, 0x11, 0x11}, true);
+    rdbi->readDataByIdentifier(0xFA13, {0x03, 0x22, 0x11, 0x11}, true);
     c1->capture();
     testFrames(result_frame, *c1);
 }
@@ -234,7 +244,7 @@ TEST_F(ReadDataByIdentifierTest, RequestOutOfRangeDoors)
 TEST_F(ReadDataByIdentifierTest, RequestOutOfRangeHVAC)
 {
     struct can_frame result_frame = createFrame(0x14FA, {0x03, 0x7F, 0x22, NegativeResponse::ROOR});
-    rdbi->readDataByIdentifier(0xFA14, {0x04, 0x22, 0x11, 0x11, 0x11}, true);
+    rdbi->readDataByIdentifier(0xFA14, {0x03, 0x22, 0x11, 0x11}, true);
     c1->capture();
     testFrames(result_frame, *c1);
 }
@@ -244,14 +254,14 @@ TEST_F(ReadDataByIdentifierTest, ModuleNotSupported)
 {
     struct can_frame result_frame = createFrame(0x15FA, {0x03, 0x7F, 0x22, NegativeResponse::ROOR});
 
-    rdbi->readDataByIdentifier(0xFA15, {0x04, 0x22, 0x11, 0x11, 0x11}, true);
+    rdbi->readDataByIdentifier(0xFA15, {0x03, 0x22, 0x11, 0x11}, true);
     c1->capture();
     testFrames(result_frame, *c1);
 }
 
 TEST_F(ReadDataByIdentifierTest, ErrorReadingFromFile)
 {
-    std::string file_name = std::string(PROJECT_PATH) + "/backend/mcu/mcu_data.txt";
+    std::string file_name = std::string(PROJECT_PATH) + "/backend/mcu/mcu_data.db";
     std::string original_content;
     std::ifstream original_file(file_name);
     if (original_file)
@@ -263,7 +273,7 @@ TEST_F(ReadDataByIdentifierTest, ErrorReadingFromFile)
     std::remove(file_name.c_str());
 
     struct can_frame result_frame = createFrame(0x10FA, {0x03, 0x7F, 0x22, NegativeResponse::ROOR});
-    rdbi->readDataByIdentifier(0xFA10, {0x04, 0x22, 0x11, 0x11, 0x11}, true);
+    rdbi->readDataByIdentifier(0xFA10, {0x03, 0x22, 0x11, 0x11}, true);
     c1->capture();
 
     std::ofstream new_file(file_name);
@@ -300,6 +310,70 @@ TEST_F(ReadDataByIdentifierTest, CorectDIDMCU)
     testFrames(result_frame, *c1);
 }
 
+/* Test several DIDs read with a single request */
+TEST_F(ReadDataByIdentifierTest, MultipleDIDsMCU)
+{
+    DidStore& store = DidStore::forFile(std::string(PROJECT_PATH) + "/backend/mcu/mcu_data.db", true);
+    store.set(0xF1A2, {0x00}, true);
+    store.set(0xF1A1, {0x01}, true);
+
+    struct can_frame result_frame = createFrame(0x10FA, {0x07, 0x62, 0xF1, 0xA2, 0x00, 0xF1, 0xA1, 0x01});
+    rdbi->readDataByIdentifier(0xFA10, {0x05, 0x22, 0xF1, 0xA2, 0xF1, 0xA1}, true);
+    c1->capture();
+    testFrames(result_frame, *c1);
+
+    /* Without the response frame, the records are returned */
+    std::vector<uint8_t> records = rdbi->readDataByIdentifier(0xFA10, {0x05, 0x22, 0xF1, 0xA2, 0xF1, 0xA1}, false);
+    EXPECT_EQ(records, std::vector<uint8_t>({0xF1, 0xA2, 0x00, 0xF1, 0xA1, 0x01}));
+}
+
+/* Test the unsupported DIDs are left out of the response */
+TEST_F(ReadDataByIdentifierTest, PartiallySupportedDIDsMCU)
+{
+    DidStore::forFile(std::string(PROJECT_PATH) + "/backend/mcu/mcu_data.db", true).set(0xF1A2, {0x00}, true);
+
+    struct can_frame result_frame = createFrame(0x10FA, {0x04, 0x62, 0xF1, 0xA2, 0x00});
+    rdbi->readDataByIdentifier(0xFA10, {0x07, 0x22, 0x11, 0x11, 0xF1, 0xA2, 0x11, 0x12}, true);
+    c1->capture();
+    testFrames(result_frame, *c1);
+
+    result_frame = createFrame(0x10FA, {0x03, 0x7F, 0x22, NegativeResponse::ROOR});
+    rdbi->readDataByIdentifier(0xFA10, {0x05, 0x22, 0x11, 0x11, 0x11, 0x12}, true);
+    c1->capture();
+    testFrames(result_frame, *c1);
+}
+
+/* Test a multi-frame request answered with a multi-frame response */
+TEST_F(ReadDataByIdentifierTest, MultiFrameDIDsMCU)
+{
+    DidStore& store = DidStore::forFile(std::string(PROJECT_PATH) + "/backend/mcu/mcu_data.db", true);
+    store.set(0xF1A2, {0x00}, true);
+    store.set(0xF1A1, {0x01}, true);
+    store.set(0xF1A4, {0x02}, true);
+    store.set(0xF1A5, {0x03}, true);
+
+    /* Reassembled request: length byte, SID and 4 DIDs */
+    struct can_frame result_frame = createFrame(0x10FA, {0x10, 0x0D, 0x62, 0xF1, 0xA2, 0x00, 0xF1, 0xA1});
+    rdbi->readDataByIdentifier(0xFA10, {0x09, 0x22, 0xF1, 0xA2, 0xF1, 0xA1, 0xF1, 0xA4, 0xF1, 0xA5}, true);
+    c1->capture();
+    testFrames(result_frame, *c1);
+}
+
+/* Test a request with too many DIDs */
+TEST_F(ReadDataByIdentifierTest, TooManyDIDs)
+{
+    std::vector<uint8_t> request = {static_cast<uint8_t>(1 + 2 * (ReadDataByIdentifier::RDBI_MAX_DIDS + 1)), 0x22};
+    for (size_t i = 0; i <= ReadDataByIdentifier::RDBI_MAX_DIDS; ++i)
+    {
+        request.push_back(0xF1);
+        request.push_back(0xA2);
+    }
+    struct can_frame result_frame = createFrame(0x10FA, {0x03, 0x7F, 0x22, NegativeResponse::IMLOIF});
+    rdbi->readDataByIdentifier(0xFA10, request, true);
+    c1->capture();
+    testFrames(result_frame, *c1);
+}
+
 int main(int argc, char* argv[])
 {
     socket1 = createSocket();
@@ -0,0 +1,66 @@
+/**
+ * @file ReadDataByPeriodicIdentifier.h
+ * @brief This library represents the ReadDataByPeriodicIdentifier UDS service.
+ * It schedules DIDs of the module, so their values are pushed to the tester at a fixed rate
+ * instead of being polled with ReadDataByIdentifier requests.
+ * For example, the battery voltage (0x01B0) and percentage (0x01C0) can be sent every 50 ms.
+ * The request frame receive by the service will have the format: frame.data = {PCI_L(1byte), SID(1byte = 0x2A), TRANSMISSION_MODE(1byte), DID_1(2bytes), ..., DID_n(2bytes)}
+ * Transmission modes: 0x01 send at slow rate, 0x02 send at medium rate, 0x03 send at fast rate, 0x04 stop sending
+ * (stop sending without DIDs stops all the DIDs of the tester).
+ * The positive response frame sent by the service will have the format: frame.data = {PCI_L(1byte), RESPONSE_SID(1byte = 0x6A)}
+ * Then each scheduled DID is sent by the PeriodicScheduler in a periodic frame: frame.data = {PCI_L(1byte), 0x6A, DID(2bytes), DATA}
+ * The negative response frame sent by the service will have the format: frame.data = {PCI_L(1byte), 0x7F, SID(1byte = 0x2A), NRC(1byte)}
+ * A DID that is not in the module, or whose data does not fit in a periodic frame, is rejected with ROOR,
+ * as well as a request that would exceed the DIDs or the bus budget of the scheduler.
+ * @version 0.1
+ * @date 2024-09-17
+ * @copyright Copyright (c) 2024
+ */
+
+#ifndef UDS_READ_DATA_BY_PERIODIC_IDENTIFIER_H
+#define UDS_READ_DATA_BY_PERIODIC_IDENTIFIER_H
+
+#include <linux/can.h>
+#include <vector>
+#include <string>
+
+#include "GenerateFrames.h"
+#include "Logger.h"
+#include "NegativeResponse.h"
+#include "SecurityAccess.h"
+#include "PeriodicScheduler.h"
+
+class ReadDataByPeriodicIdentifier
+{
+    public:
+    /* Define the service identifier for Read Data By Periodic Identifier */
+    static constexpr uint8_t RDBPI_SERVICE_ID = 0x2A;
+    /* Transmission mode to stop the periodic frames */
+    static constexpr uint8_t STOP_SENDING = 0x04;
+    /**
+    * @brief Default constructor
+    * 
+    * @param socket The socket descriptor used for communication over the CAN bus.
+    * @param rdbpi_logger A logger instance used to record information and errors during the execution.
+    */
+    ReadDataByPeriodicIdentifier(int socket, Logger& rdbpi_logger);
+    /**
+    * @brief Method that schedules or stops the periodic frames of some DIDs.
+    * 
+    * @param frame_id The frame id.
+    * @param request Data from a can frame that contains PCI, SID, transmission mode and DIDs.
+    */
+    void readDataByPeriodicIdentifier(canid_t frame_id, const std::vector<uint8_t>& request);
+
+    private:
+    /**
+    * @brief Sends a negative response and stops the response timer of the service.
+    */
+    void sendNegativeResponse(canid_t can_id, uint8_t receiver_id, uint8_t nrc);
+
+    GenerateFrames generate_frames;
+    int socket = -1;
+    Logger& rdbpi_logger;
+};
+
+#endif
@@ -0,0 +1,152 @@
+#include "ReadDataByPeriodicIdentifier.h"
+#include "BatteryModule.h"
+#include "EngineModule.h"
+#include "DoorsModule.h"
+#include "HVACModule.h"
+#include "MCUModule.h"
+#include "DidStore.h"
+#include "DynamicDidTable.h"
+
+ReadDataByPeriodicIdentifier::ReadDataByPeriodicIdentifier(int socket, Logger& rdbpi_logger)
+            : generate_frames(socket, rdbpi_logger), rdbpi_logger(rdbpi_logger)
+{
+    this->socket = socket;
+}
+
+void ReadDataByPeriodicIdentifier::sendNegativeResponse(canid_t can_id, uint8_t receiver_id, uint8_t nrc)
+{
+    NegativeResponse negative_response(socket, rdbpi_logger);
+    negative_response.sendNRC(can_id, RDBPI_SERVICE_ID, nrc);
+    AccessTimingParameter::stopTimingFlag(receiver_id, RDBPI_SERVICE_ID);
+}
+
+/* Function to handle the Read Data By Periodic Identifier request */
+void ReadDataByPeriodicIdentifier::readDataByPeriodicIdentifier(canid_t frame_id, const std::vector<uint8_t>& request)
+{
+    /* Extract the first 8 bits of frame_id */
+    uint8_t lowerbits = frame_id & 0xFF;
+    uint8_t upperbits = frame_id >> 8 & 0xFF;
+
+    /* Reverse IDs */
+    canid_t can_id = ((lowerbits << 8) | upperbits);
+
+    /* Bytes after the PCI; a single frame can be padded, then its PCI gives the length */
+    size_t length = request.empty() ? 0 : request.size() - 1;
+    if (request.size() <= CAN_MAX_DLEN && !request.empty() && request[0] < length)
+    {
+        length = request[0];
+    }
+    /* SID, transmission mode and 2 bytes per DID */
+    if (length < 2 || (length - 2) % 2 != 0)
+    {
+        sendNegativeResponse(can_id, lowerbits, NegativeResponse::IMLOIF);
+        return;
+    }
+    uint8_t transmission_mode = request[2];
+    std::vector<uint16_t> data_identifiers;
+    for (size_t index = 3; index + 1 <= length; index += 2)
+    {
+        data_identifiers.push_back((request[index] << 8) | request[index + 1]);
+    }
+    if (transmission_mode < PeriodicScheduler::SLOW_RATE || transmission_mode > STOP_SENDING)
+    {
+        sendNegativeResponse(can_id, lowerbits, NegativeResponse::ROOR);
+        return;
+    }
+    if (transmission_mode != STOP_SENDING && data_identifiers.empty())
+    {
+        sendNegativeResponse(can_id, lowerbits, NegativeResponse::IMLOIF);
+        return;
+    }
+    if (lowerbits == 0x10 && !SecurityAccess::getMcuState(rdbpi_logger))
+    {
+        sendNegativeResponse(can_id, lowerbits, NegativeResponse::SAD);
+        return;
+    }
+    if ((lowerbits == 0x11 || lowerbits == 0x12 ||
+         lowerbits == 0x13 || lowerbits == 0x14) &&
+         !ReceiveFrames::getEcuState())
+    {
+        sendNegativeResponse(can_id, lowerbits, NegativeResponse::SAD);
+        return;
+    }
+
+    PeriodicScheduler& scheduler = PeriodicScheduler::getInstance();
+    if (transmission_mode == STOP_SENDING)
+    {
+        size_t stopped = scheduler.unsubscribe(can_id, data_identifiers);
+        LOG_INFO(rdbpi_logger.GET_LOGGER(), "Periodic frames of {} DID(s) stopped for 0x{:x}.", stopped, can_id);
+        generate_frames.readDataByPeriodicIdentifier(can_id, transmission_mode, {}, true);
+        AccessTimingParameter::stopTimingFlag(lowerbits, RDBPI_SERVICE_ID);
+        return;
+    }
+
+    std::string file_name = std::string(PROJECT_PATH);
+    if (lowerbits == 0x10)
+    {
+        file_name += "/backend/mcu/mcu_data.db";
+    }
+    else if (lowerbits == 0x11)
+    {
+        file_name += "/backend/ecu_simulation/BatteryModule/battery_data.db";
+    }
+    else if (lowerbits == 0x12)
+    {
+        file_name += "/backend/ecu_simulation/EngineModule/engine_data.db";
+    }
+    else if (lowerbits == 0x13)
+    {
+        file_name += "/backend/ecu_simulation/DoorsModule/doors_data.db";
+    }
+    else if (lowerbits == 0x14)
+    {
+        file_name += "/backend/ecu_simulation/HVACModule/hvac_data.db";
+    }
+    else
+    {
+        sendNegativeResponse(can_id, lowerbits, NegativeResponse::ROOR);
+        return;
+    }
+
+    try
+    {
+        /* Only the DIDs of the module whose data fits in a periodic frame can be scheduled */
+        DidStore& store = DidStore::forFile(file_name);
+        DynamicDidTable& dynamic_dids = DynamicDidTable::getInstance();
+        std::vector<uint8_t> value;
+        for (uint16_t data_identifier : data_identifiers)
+        {
+            bool found = DynamicDidTable::isDynamic(data_identifier)
+                ? dynamic_dids.read(lowerbits, data_identifier, store, value, rdbpi_logger)
+                : store.get(data_identifier, value);
+            if (!found || value.empty() || value.size() > PERIODIC_MAX_DATA_LENGTH)
+            {
+                LOG_ERROR(rdbpi_logger.GET_LOGGER(), "DID 0x{:04X} can not be sent periodically.", data_identifier);
+                sendNegativeResponse(can_id, lowerbits, NegativeResponse::ROOR);
+                return;
+            }
+        }
+    } catch (const std::exception& e)
+    {
+        LOG_ERROR(rdbpi_logger.GET_LOGGER(), "Error reading from file: {}", e.what());
+        sendNegativeResponse(can_id, lowerbits, NegativeResponse::ROOR);
+        return;
+    }
+
+    PeriodicScheduler::Rate rate = static_cast<PeriodicScheduler::Rate>(transmission_mode);
+    PeriodicScheduler::Status status = scheduler.subscribe(socket, can_id, file_name, data_identifiers, rate, rdbpi_logger);
+    if (status != PeriodicScheduler::ACCEPTED)
+    {
+        LOG_ERROR(rdbpi_logger.GET_LOGGER(), "Periodic DIDs not scheduled: {}",
+                  status == PeriodicScheduler::BUDGET_EXCEEDED ? "bus budget exceeded" :
+                  status == PeriodicScheduler::TOO_MANY_DIDS ? "too many DIDs" : "scheduler not running");
+        sendNegativeResponse(can_id, lowerbits, NegativeResponse::ROOR);
+        return;
+    }
+    LOG_INFO(rdbpi_logger.GET_LOGGER(), "{} DID(s) sent every {} ms to 0x{:x}, {} periodic frames per second.",
+             data_identifiers.size(), PeriodicScheduler::getPeriodMs(rate), can_id, scheduler.getFramesPerSecond());
+
+    generate_frames.readDataByPeriodicIdentifier(can_id, transmission_mode, {}, true);
+    LOG_INFO(rdbpi_logger.GET_LOGGER(), "Service with SID {:x} successfully sent the response frame.", RDBPI_SERVICE_ID);
+    AccessTimingParameter::stopTimingFlag(lowerbits, RDBPI_SERVICE_ID);
+}
@@ -0,0 +1,218 @@
+/**
+ * @file ReadDataByPeriodicIdentifierTest.cpp
+ * @brief Unit test for Read Data By Periodic Identifier Service
+ * @version 0.1
+ * @date 2024-09-17
+ */
+#include <gtest/gtest.h>
+#include "../include/ReadDataByPeriodicIdentifier.h"
+#include "../../../utils/include/ReceiveFrames.h"
+#include "../../../utils/include/DidStore.h"
+#include "../../../utils/include/DynamicDidTable.h"
+
+int socket1;
+int socket2;
+
+class CaptureFrame
+{
+    public:
+        struct can_frame frame;
+        void capture()
+        {
+            read(socket1, &frame, sizeof(struct can_frame));
+        }
+};
+
+struct can_frame createFrame(uint16_t can_id ,std::vector<uint8_t> test_data)
+{
+    struct can_frame result_frame;
+    result_frame.can_id = can_id;
+    int i=0;
+    for (auto d : test_data)
+    {
+        result_frame.data[i++] = d;
+    }
+    result_frame.can_dlc = test_data.size();
+    return result_frame;
+}
+
+int createSocket()
+{
+    /* Create socket */
+    std::string name_interface = "vcan1";
+    struct sockaddr_can addr;
+    struct ifreq ifr;
+    int s;
+
+    s = socket(PF_CAN, SOCK_RAW, CAN_RAW);
+    if (s < 0)
+    {
+        std::cout<<"Error trying to create the socket\n";
+        return 1;
+    }
+    /* Giving name and index to the interface created */
+    strcpy(ifr.ifr_name, name_interface.c_str() );
+    ioctl(s, SIOCGIFINDEX, &ifr);
+    /* Set addr structure with info. of the CAN interface */
+    addr.can_family = AF_CAN;
+    addr.can_ifindex = ifr.ifr_ifindex;
+    /* Bind the socket to the CAN interface */
+    int b = bind(s, (struct sockaddr*)&addr, sizeof(addr));
+    if( b < 0 )
+    {
+        std::cout<<"Error binding\n";
+        return 1;
+    }
+    int flags = fcntl(s, F_GETFL, 0);
+    if (flags == -1)
+    {
+        return 1;
+    }
+    /* Set the O_NONBLOCK flag to make the socket non-blocking */
+    flags |= O_NONBLOCK;
+    if (fcntl(s, F_SETFL, flags) == -1)
+    {
+        return -1;
+    }
+    return s;
+}
+
+void testFrames(struct can_frame expected_frame, CaptureFrame &c1 )
+{
+    EXPECT_EQ(expected_frame.can_id & 0xFFFF, c1.frame.can_id & 0xFFFF);
+    EXPECT_EQ(expected_frame.can_dlc, c1.frame.can_dlc);
+    for (int i = 0; i < expected_frame.can_dlc; ++i)
+    {
+        EXPECT_EQ(expected_frame.data[i], c1.frame.data[i]);
+    }
+}
+
+struct ReadDataByPeriodicIdentifierTest : testing::Test
+{
+    ReadDataByPeriodicIdentifier* rdbpi;
+    CaptureFrame* c1;
+    Logger* logger;
+    ReadDataByPeriodicIdentifierTest()
+    {
+        logger = new Logger();
+        rdbpi = new ReadDataByPeriodicIdentifier(socket2, *logger);
+        c1 = new CaptureFrame();
+    }
+    ~ReadDataByPeriodicIdentifierTest()
+    {
+        PeriodicScheduler::getInstance().clear();
+        delete rdbpi;
+        delete c1;
+        delete logger;
+    }
+};
+
+TEST_F(ReadDataByPeriodicIdentifierTest, IncorrectMessageLength)
+{
+    struct can_frame result_frame = createFrame(0x11FA, {0x03, 0x7F, 0x2A, NegativeResponse::IMLOIF});
+    rdbpi->readDataByPeriodicIdentifier(0xFA11, {0x01, 0x2A});
+    c1->capture();
+    testFrames(result_frame, *c1);
+
+    /* Odd DID bytes */
+    rdbpi->readDataByPeriodicIdentifier(0xFA11, {0x03, 0x2A, 0x03, 0x01});
+    c1->capture();
+    testFrames(result_frame, *c1);
+
+    /* A rate without DIDs */
+    rdbpi->readDataByPeriodicIdentifier(0xFA11, {0x02, 0x2A, 0x03});
+    c1->capture();
+    testFrames(result_frame, *c1);
+}
+
+TEST_F(ReadDataByPeriodicIdentifierTest, InvalidTransmissionMode)
+{
+    struct can_frame result_frame = createFrame(0x11FA, {0x03, 0x7F, 0x2A, NegativeResponse::ROOR});
+    rdbpi->readDataByPeriodicIdentifier(0xFA11, {0x04, 0x2A, 0x05, 0x01, 0xA0});
+    c1->capture();
+    testFrames(result_frame, *c1);
+}
+
+TEST_F(ReadDataByPeriodicIdentifierTest, ECUsSecurity)
+{
+    ReceiveFrames* receiveFrames = new ReceiveFrames(socket2, 0x11, *logger);
+    receiveFrames->setEcuState(false);
+    struct can_frame result_frame = createFrame(0x11FA, {0x03, 0x7F, 0x2A, NegativeResponse::SAD});
+    rdbpi->readDataByPeriodicIdentifier(0xFA11, {0x04, 0x2A, 0x03, 0x01, 0xA0});
+    c1->capture();
+    testFrames(result_frame, *c1);
+    delete receiveFrames;
+}
+
+TEST_F(ReadDataByPeriodicIdentifierTest, RequestOutOfRangeBattery)
+{
+    ReceiveFrames* receiveFrames = new ReceiveFrames(socket2, 0x11, *logger);
+    receiveFrames->setEcuState(true);
+    struct can_frame result_frame = createFrame(0x11FA, {0x03, 0x7F, 0x2A, NegativeResponse::ROOR});
+    rdbpi->readDataByPeriodicIdentifier(0xFA11, {0x04, 0x2A, 0x03, 0x11, 0x11});
+    c1->capture();
+    testFrames(result_frame, *c1);
+    delete receiveFrames;
+}
+
+TEST_F(ReadDataByPeriodicIdentifierTest, StartAndStopBattery)
+{
+    ReceiveFrames* receiveFrames = new ReceiveFrames(socket2, 0x11, *logger);
+    receiveFrames->setEcuState(true);
+    DidStore::forFile(std::string(PROJECT_PATH) + "/backend/ecu_simulation/BatteryModule/battery_data.db", true)
+        .set(0x01A0, {0x30}, true);
+
+    struct can_frame result_frame = createFrame(0x11FA, {0x01, 0x6A});
+    rdbpi->readDataByPeriodicIdentifier(0xFA11, {0x04, 0x2A, 0x03, 0x01, 0xA0});
+    c1->capture();
+    testFrames(result_frame, *c1);
+    EXPECT_EQ(PeriodicScheduler::getInstance().getSubscriptionCount(), 1u);
+
+    rdbpi->readDataByPeriodicIdentifier(0xFA11, {0x02, 0x2A, 0x04});
+    c1->capture();
+    testFrames(result_frame, *c1);
+    EXPECT_EQ(PeriodicScheduler::getInstance().getSubscriptionCount(), 0u);
+    delete receiveFrames;
+}
+
+TEST_F(ReadDataByPeriodicIdentifierTest, DynamicDidBattery)
+{
+    ReceiveFrames* receiveFrames = new ReceiveFrames(socket2, 0x11, *logger);
+    receiveFrames->setEcuState(true);
+    DidStore& store = DidStore::forFile(std::string(PROJECT_PATH) + "/backend/ecu_simulation/BatteryModule/battery_data.db", true);
+    store.set(0x01A0, {0x30}, true);
+
+    /* Not defined yet */
+    struct can_frame result_frame = createFrame(0x11FA, {0x03, 0x7F, 0x2A, NegativeResponse::ROOR});
+    rdbpi->readDataByPeriodicIdentifier(0xFA11, {0x04, 0x2A, 0x03, 0xF3, 0x00});
+    c1->capture();
+    testFrames(result_frame, *c1);
+    EXPECT_EQ(PeriodicScheduler::getInstance().getSubscriptionCount(), 0u);
+
+    DynamicDidTable& table = DynamicDidTable::getInstance();
+    ASSERT_TRUE(table.defineByIdentifier(0x11, 0xF300, store, {{0x01A0, 1, 1}}, *logger));
+    result_frame = createFrame(0x11FA, {0x01, 0x6A});
+    rdbpi->readDataByPeriodicIdentifier(0xFA11, {0x04, 0x2A, 0x03, 0xF3, 0x00});
+    c1->capture();
+    testFrames(result_frame, *c1);
+    EXPECT_EQ(PeriodicScheduler::getInstance().getSubscriptionCount(), 1u);
+    table.clear(0x11);
+    delete receiveFrames;
+}
+
+int main(int argc, char* argv[])
+{
+    socket1 = createSocket();
+    socket2 = createSocket();
+    testing::InitGoogleTest(&argc, argv);
+    int result = RUN_ALL_TESTS();
+    if (socket1 > 0)
+    {
+        close(socket1);
+    }
+    if (socket2 > 0)
+    {
+        close(socket2);
+    }
+    return result;
+}
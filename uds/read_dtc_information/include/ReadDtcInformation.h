@@ -77,14 +77,6 @@ class ReadDTC
          * @return int
          */
         int to_int(char c);
-        /**
-         * @brief Receive through the can-bus the flow control frame
-         * 
-         * @param id_module module id
-         * @return true 
-         * @return false 
-         */
-        bool receive_flow_control(int id_module);
         /**
          * @brief Transform the raw DTCs in to hex values
          * 
@@ -145,43 +145,27 @@ void ReadDTC::report_dtcs(int id, int dtc_status_mask)
     {   
         uint8_t lowerbits = id & 0xFF;
 
-        this->generate->readDtcInformationResponse02Long(new_id,status_availability_mask,dtc_and_status_list,true);
-        this->generate->readDtcInformationResponse02Long(new_id,status_availability_mask,dtc_and_status_list,false);
+        /* The consecutive frames are sent when the flow control frame of the client arrives */
+        Logger log = logger;
+        this->generate->readDtcInformationResponse02Long(new_id,status_availability_mask,dtc_and_status_list,true,
+            [log](IsoTpTransmitter::TransmitStatus status)
+            {
+                if (status == IsoTpTransmitter::COMPLETE)
+                {
+                    LOG_INFO(log.GET_LOGGER(), "Service with SID {:x} successfully sent the consecutive response frames.", 0x19);
+                }
+                else if (status == IsoTpTransmitter::TIMEOUT)
+                {
+                    LOG_ERROR(log.GET_LOGGER(), "Timeout. Flow control frame not received!");
+                }
+                else
+                {
+                    LOG_ERROR(log.GET_LOGGER(), "Service with SID {:x} failed to send the consecutive response frames.", 0x19);
+                }
+            });
         LOG_INFO(logger.GET_LOGGER(), "Service with SID {:x} successfully sent the first response frame.", 0x19);
 
         AccessTimingParameter::stopTimingFlag(lowerbits, 0x19);
-                
-/** flow control frame not implemented yet -> uncomment this when ready
-        if (receive_flow_control(id / 0x100))
-        {
-            uint8_t lowerbits = id & 0xFF;
-            switch(lowerbits)
-            {
-                case 0x10:
-                    this->generate->readDtcInformationResponse02Long(id,status_availability_mask,dtc_and_status_list,false);
-                    LOG_INFO(logger.GET_LOGGER(), "Service with SID {:x} successfully sent a consecutive response frame.", 0x19);
-                    MCU::mcu->stop_flags[0x19] = false;
-                    break;
-                case 0x11:
-                    this->generate->readDtcInformationResponse02Long(id,status_availability_mask,dtc_and_status_list,false);
-                    LOG_INFO(logger.GET_LOGGER(), "Service with SID {:x} successfully sent a consecutive response frame.", 0x19);
-                    battery->stop_flags[0x19] = false;
-                    break;
-                case 0x12:
-                    this->generate->readDtcInformationResponse02Long(id,status_availability_mask,dtc_and_status_list,false);
-                    LOG_INFO(logger.GET_LOGGER(), "Service with SID {:x} successfully sent a consecutive response frame.", 0x19);
-                    engine->stop_flags[0x19] = false;
-                    break;
-                default:
-                    LOG_ERROR(logger.GET_LOGGER(), "Module with id {:x} not supported.", lowerbits);
-            }
-            
-        }
-        else
-        {
-            LOG_ERROR(logger.GET_LOGGER(), "Timeout. FLow control frame not received!");
-        } 
-*/
     }
     else 
     {
@@ -205,44 +189,6 @@ int ReadDTC::dtc_to_hex(std::string dtc)
     return hex;
 }
 
-// bool ReadDTC::receive_flow_control(int id_module)
-// {
-//     /* Define a pollfd structure to monitor the socket */ 
-//     struct pollfd pfd;
-//     /* Set the socket file descriptor */ 
-//     pfd.fd = this->socket; 
-//     /* We are interested in read events -use POLLING */ 
-//     pfd.events = POLLIN;
-
-//     auto start = std::chrono::system_clock::now();
-//     auto end = std::chrono::system_clock::now();
-//     LOG_INFO(logger.GET_LOGGER(), "Waiting 6 sec until recive flow control frame...");
-//     while (true)
-//     {
-//         /* Use poll to wait for data to be available with a timeout of 1000ms (1 second) */ 
-//         int poll_result = poll(&pfd, 1, 1000);
-
-//         if (poll_result > 0 && pfd.revents & POLLIN) 
-//         {
-//             struct can_frame frame ;
-//             int nbytes = read(this->socket, &frame, sizeof(frame));
-
-//             if (nbytes > 0) 
-//             {
-//                 if ((int)frame.can_id % 0x100 == id_module && frame.data[0] == 0x30)
-//                 {
-//                     LOG_INFO(logger.GET_LOGGER(), "Flow controll frame recived...");
-//                     return true;
-//                 }    
-//             }
-//         }
-//         end = std::chrono::system_clock::now();
-//         if((std::chrono::duration_cast<std::chrono::seconds>(end - start).count() > 6)) 
-//             break;
-//     }
-//     return false;
-// }
-
 int ReadDTC::to_int(char c)
 {
     return (c >= 'A') ? (c - 'A' + 10) : (c - '0');
@@ -39,9 +39,17 @@ void ReadMemoryByAddress::handleRequest(int can_id, off_t memory_address, off_t
 
     /* Send the data back as a response depending on the size (if it's more than 6 bytes, split it into multiple frames) */
     if (data.size() > 6) {
-        frameGenerator.readMemoryByAddressLongResponse(can_id, memory_address, memory_size, data, true); /* First frame */
-        /* !!!! IMPORTANT: Wait for the Flow control frame from the Client !!!! */
-        frameGenerator.readMemoryByAddressLongResponse(can_id, memory_address, memory_size, data, false); /* Remaining frames */
+        /* The remaining frames are sent when the flow control frame of the client arrives */
+        Logger& log = logger;
+        frameGenerator.readMemoryByAddressLongResponse(can_id, memory_address, memory_size, data, true,
+            [&log](IsoTpTransmitter::TransmitStatus status) {
+                if (status == IsoTpTransmitter::COMPLETE) {
+                    LOG_INFO(log.GET_LOGGER(), "ReadMemoryByAddress consecutive frames sent.");
+                } else {
+                    LOG_ERROR(log.GET_LOGGER(), "ReadMemoryByAddress response not sent: {}",
+                              status == IsoTpTransmitter::TIMEOUT ? "timeout, flow control frame not received" : "transmission aborted");
+                }
+            });
     } else {
         frameGenerator.readMemoryByAddress(can_id, memory_address, memory_size, data);
     }
@@ -14,6 +14,7 @@
 #include "GenerateFrames.h"
 #include "Logger.h"
 #include "MemoryManager.h"
+#include "ImageDigest.h"
 #include "NegativeResponse.h"
 #include "SecurityAccess.h"
 
@@ -24,6 +25,8 @@
 #define VERIFY_SW_RC_ID (0x0501)
 #define ROLLBACK_SW_RC_ID (0x0601)
 #define ACTIVATE_SW_RC_ID (0x0701)
+/* Bytes read at once when the digest of a binary is computed from memory */
+#define VERIFY_READ_BYTES (64 * 1024)
 
 class RoutineControl
 {
@@ -90,7 +93,8 @@ private:
     /**
      * @brief Method used for checking data before using it. 
      * This method checks for 2 data signatures: ELF or ZIP and
-     * compares the sent checksum calculated when transferring data with the new one calculated after the transfer is completed.
+     * compares the digest record (CRC32C, optional SHA-256) sent after the image with the digest computed while the
+     * blocks were received. The binary is read again from memory only if that digest is not available.
      * 
      * If the software is intended for MCU, only 
      * 
@@ -29,7 +29,8 @@ void RoutineControl::routineControl(canid_t can_id, const std::vector<uint8_t>&
     can_id = receiver_id << 8 | sender_id;
     OtaUpdateStatesEnum ota_state = static_cast<OtaUpdateStatesEnum>(FileManager::getDidValue(OTA_UPDATE_STATUS_DID, aux_can_id, rc_logger)[0]);
 
-    if (request.size() < 6 || (request.size() - 1 != request[0]))
+    /* The PCI length is checked only for a single frame: a reassembled message keeps just the low byte of FF_DL */
+    if (request.size() < 6 || (request.size() <= CAN_MAX_DLEN && request.size() - 1 != request[0]))
     {
         /* Incorrect message length or invalid format - prepare a negative response */
         nrc.sendNRC(can_id,ROUTINE_CONTROL_SID,NegativeResponse::IMLOIF);
@@ -403,14 +404,52 @@ bool RoutineControl::verifySoftware(uint8_t receiver_id)
         {
             binary_size |= (binary_size_bytes[i] << ((binary_size_format - i - 1) * 8));
         }
-        /* Read the binary data from memory */
-        binary_data = MemoryManager::readFromAddress(DEV_LOOP, memory_manager->getAddress() + binary_offset, binary_size, rc_logger);
+        off_t binary_address = memory_manager->getAddress() + binary_offset;
+        /* Only the signature of the binary is needed below */
+        binary_data = MemoryManager::readFromAddress(DEV_LOOP, binary_address, std::min<size_t>(binary_size, 4), rc_logger);
+
+        /* Digest record stored after the binary */
+        auto digest_type = MemoryManager::readFromAddress(DEV_LOOP, binary_address + binary_size, 1, rc_logger);
+        size_t record_length = digest_type.empty() ? 0 : ImageDigest::getRecordLength(digest_type[0]);
+        if (record_length == 0)
+        {
+            LOG_ERROR(rc_logger.GET_LOGGER(), "Error in digest verification. Unknown digest record.");
+            return 0;
+        }
+        auto record = MemoryManager::readFromAddress(DEV_LOOP, binary_address + binary_size, record_length, rc_logger);
+        if (record.size() != record_length)
+        {
+            return 0;
+        }
 
-        uint8_t checksum = MemoryManager::readFromAddress(DEV_LOOP, memory_manager->getAddress() + 1 + binary_size_format + binary_size, 1, rc_logger)[0];
-        uint8_t recomputed_checksum = TransferData::computeChecksum(binary_data.data(), binary_data.size());
-        if(checksum != recomputed_checksum)
+        const ImageDigest& transfer_digest = TransferData::getImageDigest();
+        bool valid_digest = false;
+        if (TransferData::getImageDigestRecord() == record && transfer_digest.getLength() == binary_size)
         {
-            LOG_ERROR(rc_logger.GET_LOGGER(),"Error in checksum verification. Sent checksum = 0b{:b}, recomputed checksum = 0b{:b}", checksum, recomputed_checksum);
+            /* Digest computed while the blocks were received */
+            valid_digest = transfer_digest.matches(record);
+        }
+        else
+        {
+            /* The transfer was done before this process started: digest of the binary in memory */
+            LOG_WARN(rc_logger.GET_LOGGER(), "No digest from the transfer, reading the binary from memory.");
+            ImageDigest stored_digest(record[0] == IMAGE_DIGEST_CRC32C_SHA256);
+            for (size_t offset = 0; offset < binary_size; offset += VERIFY_READ_BYTES)
+            {
+                size_t size = std::min<size_t>(VERIFY_READ_BYTES, binary_size - offset);
+                auto part = MemoryManager::readFromAddress(DEV_LOOP, binary_address + offset, size, rc_logger);
+                if (part.size() != size)
+                {
+                    return 0;
+                }
+                stored_digest.update(part.data(), part.size());
+            }
+            valid_digest = stored_digest.matches(record);
+        }
+        if (!valid_digest)
+        {
+            LOG_ERROR(rc_logger.GET_LOGGER(), "Error in digest verification. Sent CRC32C = 0x{:02x}{:02x}{:02x}{:02x}.",
+                      record[1], record[2], record[3], record[4]);
             return 0;
         }
     }
@@ -436,7 +475,10 @@ bool RoutineControl::verifySoftware(uint8_t receiver_id)
         switch(data_format)
         {
             case 0x00:
+            case (DATA_FORMAT_COMPRESSION_BLOCK << 4):
+            case (DATA_FORMAT_COMPRESSION_DELTA << 4):
             {
+                /* Block compressed and delta images are stored rebuilt */
                 check_signature = FileManager::validateData(binary_data, FileType::ELF_FILE);
                 break;
             }
@@ -607,6 +649,14 @@ bool RoutineControl::handleDataCompressionEncryption(uint8_t receiver_id)
     {
         LOG_INFO(rc_logger.GET_LOGGER(), "No compression used.");
     }
+    else if(compression == DATA_FORMAT_COMPRESSION_BLOCK)
+    {
+        LOG_INFO(rc_logger.GET_LOGGER(), "Block compressed image, decompressed during the transfer.");
+    }
+    else if(compression == DATA_FORMAT_COMPRESSION_DELTA)
+    {
+        LOG_INFO(rc_logger.GET_LOGGER(), "Delta update, image rebuilt from the installed executable during the transfer.");
+    }
     else
     {
         std::string zipFilePath;
@@ -1,6 +1,7 @@
 #include "../include/RoutineControl.h"
 #include "../../diagnostic_session_control/include/DiagnosticSessionControl.h"
 #include "../../utils/include/FileManager.h"
+#include "../../utils/include/DidStore.h"
 
 #include <cstring>
 #include <string>
@@ -14,7 +15,7 @@
 int socket_;
 int socket2_;
 std::vector<uint8_t> seed;
-std::string file_path = std::string(PROJECT_PATH) + "/backend/mcu/mcu_data.txt";
+std::string file_path = std::string(PROJECT_PATH) + "/backend/mcu/mcu_data.db";
 
 /* Class to capture the frame sin the can-bus */
 class CaptureFrame
@@ -232,7 +233,7 @@ TEST_F(RoutineControlTest, OTAStateAlreadyInitialised)
     checkSecurity();
 
     std::unordered_map<uint16_t, std::vector<uint8_t>> data_map = {{0x01E0, {0x40}}};
-    FileManager::writeMapToFile(file_path, data_map);
+    DidStore::restore(file_path, data_map);
 
     routine_control->routineControl(0x0010FA10, {0x05, 0x31, 0x01, 0x02, 0x01, 0x00});
     capture_frame->capture();
@@ -242,7 +243,7 @@ TEST_F(RoutineControlTest, OTAStateAlreadyInitialised)
 TEST_F(RoutineControlTest, VersionNotFound )
 {
     std::unordered_map<uint16_t, std::vector<uint8_t>> data_map = {{0x01E0, {0xff}}};
-    FileManager::writeMapToFile(file_path, data_map);
+    DidStore::restore(file_path, data_map);
     struct can_frame expected_frame = createFrame(0x001010FA, {0x03, 0x7F, 0x31, NegativeResponse::IMLOIF});
     checkSecurity();
 
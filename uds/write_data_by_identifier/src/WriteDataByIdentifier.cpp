@@ -6,6 +6,7 @@
 #include "DoorsModule.h"
 #include "HVACModule.h"
 #include "MCUModule.h"
+#include "DidStore.h"
 
 WriteDataByIdentifier::WriteDataByIdentifier(Logger& wdbi_logger, int socket)
             : generate_frames(socket, wdbi_logger), wdbi_logger(wdbi_logger)
@@ -113,23 +114,23 @@ void WriteDataByIdentifier::WriteDataByIdentifierService(canid_t frame_id, std::
         std::string file_name = std::string(PROJECT_PATH);
         if (receiver_id == 0x10)
         {
-            file_name += "/backend/mcu/mcu_data.txt";
+            file_name += "/backend/mcu/mcu_data.db";
         }
         else if (receiver_id == 0x11)
         {
-            file_name += "/backend/ecu_simulation/BatteryModule/battery_data.txt";
+            file_name += "/backend/ecu_simulation/BatteryModule/battery_data.db";
         }
         else if (receiver_id == 0x12)
         {
-            file_name += "/backend/ecu_simulation/EngineModule/engine_data.txt";
+            file_name += "/backend/ecu_simulation/EngineModule/engine_data.db";
         }
         else if (receiver_id == 0x13)
         {
-            file_name += "/backend/ecu_simulation/DoorsModule/doors_data.txt";
+            file_name += "/backend/ecu_simulation/DoorsModule/doors_data.db";
         }
         else if (receiver_id == 0x14)
         {
-            file_name += "/backend/ecu_simulation/HVACModule/hvac_data.txt";
+            file_name += "/backend/ecu_simulation/HVACModule/hvac_data.db";
         }
         else
         {
@@ -141,14 +142,8 @@ void WriteDataByIdentifier::WriteDataByIdentifierService(canid_t frame_id, std::
 
         try
         {
-            /* Load current data from the file */
-            auto data_map = FileManager::readMapFromFile(file_name);
-
-            // Update or add the new data for the given DID
-            data_map[did] = data_parameter;
-
-            /* Save the updated data back to the file */
-            FileManager::writeMapToFile(file_name, data_map);
+            /* Update or add the new data for the given DID in the DID database of the module */
+            DidStore::forFile(file_name).set(did, data_parameter, true);
 
             /* Check the new value */
             switch (receiver_id)
@@ -311,7 +311,7 @@ TEST_F(WriteDataByIdentifierTest, ModuleNotSupported) {
 
 TEST_F(WriteDataByIdentifierTest, ErrorReadingFromFile)
 {
-    std::string file_name = std::string(PROJECT_PATH) + "/backend/mcu/mcu_data.txt";
+    std::string file_name = std::string(PROJECT_PATH) + "/backend/mcu/mcu_data.db";
     std::string original_content;
     std::ifstream original_file(file_name);
     if (original_file)
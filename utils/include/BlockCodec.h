@@ -0,0 +1,95 @@
+/**
+ * @file BlockCodec.h
+ * @brief Fast block compression for the OTA transfer, in the LZ4 block format (greedy hash matching,
+ * no entropy coding), so the decompression keeps up with the transfer data blocks.
+ * The image is compressed in windows of BLOCK_CODEC_WINDOW_BYTES. Each window is a frame of the stream:
+ *     {raw size - 1 (2 bytes, MSB first), payload size (2 bytes, MSB first), payload}
+ * A payload size of 0 means the window did not compress and the payload is the raw window.
+ * The frames are cut in transfer data blocks without alignment; BlockStreamDecoder keeps the partial frame
+ * of a block until the next one completes it.
+ * How to use example:
+ *     std::vector<uint8_t> stream;
+ *     BlockCodec::appendFrame(window.data(), window.size(), stream);
+ *     BlockStreamDecoder decoder;
+ *     decoder.feed(block.data(), block.size(), [](const uint8_t* data, size_t size) { ... return true; });
+ * @version 0.1
+ * @date 2024-09-09
+ * @copyright Copyright (c) 2024
+ */
+#ifndef POC_INCLUDE_BLOCK_CODEC_H_
+#define POC_INCLUDE_BLOCK_CODEC_H_
+
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+/* Raw bytes in a frame of the compressed stream, matches are searched only inside a window */
+#define BLOCK_CODEC_WINDOW_BYTES (64 * 1024)
+#define BLOCK_CODEC_FRAME_HEADER_BYTES 4
+
+class BlockCodec
+{
+public:
+    /**
+     * @brief Compresses a buffer in the LZ4 block format.
+     *
+     * @param data Raw bytes.
+     * @param size Number of raw bytes.
+     * @param compressed Receives the compressed bytes (replaced).
+     */
+    static void compress(const uint8_t* data, size_t size, std::vector<uint8_t>& compressed);
+
+    /**
+     * @brief Decompresses a buffer in the LZ4 block format. The input is not trusted: every length and
+     *      offset is checked against the buffers.
+     *
+     * @param compressed Compressed bytes.
+     * @param compressed_size Number of compressed bytes.
+     * @param data Output buffer.
+     * @param size Expected number of raw bytes.
+     * @return Returns true if exactly size bytes were decompressed.
+     */
+    static bool decompress(const uint8_t* compressed, size_t compressed_size, uint8_t* data, size_t size);
+
+    /**
+     * @brief Compresses a window of the image and appends it as a frame of the stream.
+     *
+     * @param data Raw bytes of the window, at most BLOCK_CODEC_WINDOW_BYTES.
+     * @param size Number of raw bytes, at least 1.
+     * @param stream Stream the frame is appended to.
+     */
+    static void appendFrame(const uint8_t* data, size_t size, std::vector<uint8_t>& stream);
+};
+
+class BlockStreamDecoder
+{
+public:
+    /* Receives the raw bytes of each decompressed frame, returns false to stop the stream */
+    using Sink = std::function<bool(const uint8_t*, size_t)>;
+
+    /**
+     * @brief Drops a partial frame and starts a new stream.
+     */
+    void reset();
+
+    /**
+     * @brief Adds the next bytes of the stream and passes the raw bytes of every completed frame to the sink.
+     *
+     * @return Returns false if a frame is corrupted or the sink failed.
+     */
+    bool feed(const uint8_t* data, size_t size, const Sink& sink);
+
+    /**
+     * @brief Checks if the stream ends on a frame boundary.
+     */
+    bool isEmpty() const;
+
+private:
+    /* Start of a frame not complete yet */
+    std::vector<uint8_t> pending;
+    /* Raw bytes of the last decompressed frame */
+    std::vector<uint8_t> window;
+};
+
+#endif /* POC_INCLUDE_BLOCK_CODEC_H_ */
@@ -0,0 +1,138 @@
+/**
+ * @file CanFd.h
+ * @brief CAN FD (64-byte frames) support shared by the sockets, the frame generation and ISO-TP.
+ * A socket talks CAN FD once CAN_RAW_FD_FRAMES is enabled on it and its interface has the
+ * CAN FD MTU (see CreateInterface::enableFdFrames). Even then, a frame goes out in the CAN FD
+ * format only if its receiver supports it, so every peer falls back to classic CAN on its own:
+ *  - an ECU announces CAN FD in its 0xD9 notification to the MCU (CAN_FD_CAPABLE bit);
+ *  - a module that receives a CAN FD frame from a peer answers that peer in CAN FD too.
+ * The API (tester) always talks classic CAN; the frames it sends through the MCU do not
+ * make the ECUs answer it in CAN FD.
+ * CAN FD data lengths above 8 bytes are limited to 12, 16, 20, 24, 32, 48 and 64 bytes
+ * (DLC 9..15), the frames are padded up to the next valid length.
+ * How to use example:
+ *     if (CanFd::useFd(socket, can_id)) { ... format a canfd_frame, up to 64 bytes ... }
+ *     struct canfd_frame frame = CanFd::toFdFrame(classic_frame);
+ * @version 0.1
+ * @date 2024-08-30
+ * @copyright Copyright (c) 2024
+ */
+#ifndef POC_INCLUDE_CAN_FD_H_
+#define POC_INCLUDE_CAN_FD_H_
+
+#include <linux/can.h>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+
+/* 1 = the CAN bus sockets try to enable CAN FD, 0 = classic CAN only */
+#ifndef CAN_FD_ENABLED
+#define CAN_FD_ENABLED 1
+#endif
+/* Byte used to pad a CAN FD frame up to a valid data length */
+#define CAN_FD_PADDING 0xCC
+/* Bit of the third byte of the 0xD9 notification: the ECU talks CAN FD */
+#define CAN_FD_CAPABLE 0x01
+/* Sockets whose CAN FD state is kept; higher descriptors stay classic */
+#define CAN_FD_SOCKETS 256
+/* The tester side of the MCU, always classic CAN */
+#define CAN_FD_CLASSIC_PEER 0xFA
+
+class CanFd
+{
+public:
+    /**
+     * @brief Converts a data length to the DLC of a CAN FD frame.
+     *
+     * @param length Number of data bytes (at most CANFD_MAX_DLEN).
+     * @return Returns the DLC (0..15) of the smallest frame that holds the data.
+     */
+    static uint8_t lengthToDlc(size_t length);
+
+    /**
+     * @brief Converts the DLC of a CAN FD frame to its data length.
+     *
+     * @param dlc The DLC (values above 15 are treated as 15).
+     * @return Returns the number of data bytes of the frame.
+     */
+    static size_t dlcToLength(uint8_t dlc);
+
+    /**
+     * @brief Rounds a data length up to a valid CAN FD data length.
+     *
+     * @param length Number of data bytes.
+     * @return Returns the length of the frame that holds the data.
+     */
+    static size_t paddedLength(size_t length);
+
+    /**
+     * @brief Set method for the CAN FD state of a socket.
+     *
+     * @param socket The socket descriptor.
+     * @param enabled True if the socket can send and receive CAN FD frames.
+     */
+    static void setSocketFd(int socket, bool enabled);
+
+    /**
+     * @brief Get method for the CAN FD state of a socket.
+     *
+     * @param socket The socket descriptor.
+     * @return Returns true if the socket can send and receive CAN FD frames.
+     */
+    static bool isSocketFd(int socket);
+
+    /**
+     * @brief Set method for the CAN FD support of a peer.
+     *
+     * @param node_id The id of the peer (sender or receiver byte of the CAN id).
+     * @param enabled True if the peer talks CAN FD. Ignored for the tester, always classic.
+     */
+    static void setPeerFd(uint8_t node_id, bool enabled);
+
+    /**
+     * @brief Get method for the CAN FD support of a peer.
+     *
+     * @param node_id The id of the peer.
+     * @return Returns true if the peer talks CAN FD.
+     */
+    static bool isPeerFd(uint8_t node_id);
+
+    /**
+     * @brief Checks if a frame sent on a socket goes out in the CAN FD format.
+     *
+     * @param socket The socket the frame is written to.
+     * @param can_id The CAN id of the frame; its lowest byte is the receiver.
+     * @return Returns true if both the socket and the receiver talk CAN FD.
+     */
+    static bool useFd(int socket, canid_t can_id);
+
+    /**
+     * @brief Records that the sender of a frame received in the CAN FD format talks CAN FD.
+     *
+     * @param socket The socket the frame was read from.
+     * @param can_id The CAN id of the frame; its second byte is the sender.
+     */
+    static void learnPeer(int socket, canid_t can_id);
+
+    /**
+     * @brief Copies a classic frame in a CAN FD frame (same id, length and data).
+     */
+    static struct canfd_frame toFdFrame(const struct can_frame& frame);
+
+    /**
+     * @brief Copies the first CAN_MAX_DLEN data bytes of a CAN FD frame in a classic frame.
+     */
+    static struct can_frame toClassicFrame(const struct canfd_frame& frame);
+
+    /**
+     * @brief Forgets the CAN FD state of all the sockets and peers (tests, interface reset).
+     */
+    static void reset();
+
+private:
+    static std::array<std::atomic<bool>, CAN_FD_SOCKETS> fd_sockets;
+    static std::array<std::atomic<bool>, 256> fd_peers;
+};
+
+#endif /* POC_INCLUDE_CAN_FD_H_ */
@@ -8,6 +8,11 @@
  *        The method stop_interface is used to bring the vcan interfaces down.
  *        The method delete_interface is used to delete the vcan interfaces.
  *        The method get_socket is used to return the sockets file descriptor.
+ *        The sockets can be created with a CAN_RAW_FILTER set, so the kernel only
+ *        delivers the frames addressed to the module and the process does not wake up
+ *        for the rest of the bus traffic.
+ *        The ECU interface is created with the CAN FD MTU and the CAN bus sockets can
+ *        be switched to CAN FD frames (see CanFd.h).
  */
 
 
@@ -23,9 +28,16 @@
 #include <net/if.h>
 
 #include<linux/can.h>
+#include<linux/can/raw.h>
 #include<string.h>
+#include <vector>
 #include <fcntl.h>
 #include "Logger.h"
+#include "CanFd.h"
+
+/* Mask selecting the receiver byte (lowest 8 bits) of a frame id */
+#define CAN_RECEIVER_MASK 0xFF
+
 /* class designed to manage the virtual CAN network interface (vcan) */
 class CreateInterface
 {   
@@ -72,6 +84,50 @@ class CreateInterface
          * @return Returns the socket file descriptor.
          */
         int createSocket(uint8_t interface_number);
+        /**
+         * @brief Create the socket and install a receive filter set before binding it,
+         * so no frame outside the filters is ever queued on the socket.
+         * 
+         * @param interface_number The interface indicator number.
+         * @param filters The CAN_RAW_FILTER set; an empty set keeps the default (receive everything).
+         * @return Returns the socket file descriptor.
+         */
+        int createSocket(uint8_t interface_number, const std::vector<struct can_filter>& filters);
+        /**
+         * @brief Replace the receive filter set of an existing CAN_RAW socket.
+         * 
+         * @param socket socket file descriptor.
+         * @param filters The CAN_RAW_FILTER set; an empty set keeps the default (receive everything).
+         * @return Returns true if the filters were installed and false if an error was encountered.
+         */
+        bool setReceiveFilters(int socket, const std::vector<struct can_filter>& filters);
+        /**
+         * @brief Build the filter set that accepts only the frames whose receiver byte is
+         * the module id or one of the extra receivers (e.g. broadcast 0xFF, API 0xFA).
+         * The notifications from the MCU are addressed to the module id, so they pass too.
+         * 
+         * @param module_id The id of the module that owns the socket.
+         * @param extra_receivers Other receiver ids accepted by the module.
+         * @return Returns the filter set.
+         */
+        static std::vector<struct can_filter> receiverFilters(uint8_t module_id, const std::vector<uint8_t>& extra_receivers = {});
+        /**
+         * @brief Build the filter set that accepts every frame except those addressed to the receiver.
+         * 
+         * @param receiver_id The receiver id to reject.
+         * @return Returns the filter set.
+         */
+        static std::vector<struct can_filter> excludeReceiverFilters(uint8_t receiver_id);
+        /**
+         * @brief Enable CAN FD frames (CAN_RAW_FD_FRAMES) on a bound socket. The socket stays
+         * classic if CAN FD is disabled at build time or if the interface does not have the
+         * CAN FD MTU; classic frames are received either way.
+         * 
+         * @param socket socket file descriptor.
+         * @param interface_number The interface indicator number the socket is bound to.
+         * @return Returns true if the socket sends and receives CAN FD frames.
+         */
+        bool enableFdFrames(int socket, uint8_t interface_number);
         /**
         * @brief Set the socket to not block in the reading operation.
         * 
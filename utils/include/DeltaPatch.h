@@ -0,0 +1,108 @@
+/**
+ * @file DeltaPatch.h
+ * @brief Binary patch between the installed image of an ECU (base) and a new version (target), so only
+ * the changed parts of the image are sent in a delta update.
+ * The patch is a list of copy/insert instructions (VCDIFF style), all numbers on 4 bytes, MSB first:
+ *     header:  {base size, base CRC32C}
+ *     copy:    {DELTA_PATCH_COPY, base offset, length}      bytes taken from the base image
+ *     insert:  {DELTA_PATCH_INSERT, length, bytes...}       new bytes
+ * DeltaPatchDecoder rebuilds the target while the patch arrives in transfer data blocks of any size; the
+ * header makes sure the patch is applied on the image it was made from.
+ * How to use example:
+ *     std::vector<uint8_t> patch;
+ *     DeltaPatch::create(base, base_size, target, target_size, patch);
+ *     DeltaPatchDecoder decoder;
+ *     decoder.reset(base, base_size);
+ *     decoder.feed(block.data(), block.size(), [](const uint8_t* data, size_t size) { ... return true; });
+ * @version 0.1
+ * @date 2024-09-10
+ * @copyright Copyright (c) 2024
+ */
+#ifndef POC_INCLUDE_DELTA_PATCH_H_
+#define POC_INCLUDE_DELTA_PATCH_H_
+
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+#define DELTA_PATCH_COPY 0x01
+#define DELTA_PATCH_INSERT 0x02
+#define DELTA_PATCH_HEADER_BYTES 8
+/* Shortest part of the target searched in the base; base positions are indexed every DELTA_PATCH_INDEX_STEP
+   bytes, so every common part of at least DELTA_PATCH_SEED_BYTES + DELTA_PATCH_INDEX_STEP - 1 bytes is found */
+#define DELTA_PATCH_SEED_BYTES 16
+#define DELTA_PATCH_INDEX_STEP 8
+
+class DeltaPatch
+{
+public:
+    /**
+     * @brief Creates the patch that rebuilds the target image from the base image.
+     *
+     * @param base Installed image.
+     * @param base_size Size of the installed image.
+     * @param target New image.
+     * @param target_size Size of the new image.
+     * @param patch Receives the patch (replaced).
+     */
+    static void create(const uint8_t* base, size_t base_size, const uint8_t* target, size_t target_size, std::vector<uint8_t>& patch);
+};
+
+class DeltaPatchDecoder
+{
+public:
+    /* Receives the next bytes of the target image, returns false to stop the patch */
+    using Sink = std::function<bool(const uint8_t*, size_t)>;
+
+    /**
+     * @brief Starts a new patch applied on a base image. The base must stay valid until the patch is complete.
+     */
+    void reset(const uint8_t* base, size_t base_size);
+
+    /**
+     * @brief Adds the next bytes of the patch and passes the rebuilt bytes of the target to the sink.
+     *
+     * @return Returns false if the patch is invalid for the base image or the sink failed, see getError().
+     */
+    bool feed(const uint8_t* data, size_t size, const Sink& sink);
+
+    /**
+     * @brief Checks if the patch ends on an instruction boundary.
+     */
+    bool isEmpty() const;
+
+    /**
+     * @brief Get method for the number of target bytes rebuilt so far.
+     */
+    uint64_t getOutputSize() const;
+
+    /**
+     * @brief Get method for the reason the last feed failed.
+     */
+    const std::string& getError() const;
+
+private:
+    /**
+     * @brief Size of the fields of an instruction, opcode included. 0 for an unknown opcode.
+     */
+    static size_t instructionSize(uint8_t opcode);
+
+    /**
+     * @brief Marks the patch as invalid.
+     */
+    bool fail(const std::string& reason);
+
+    const uint8_t* base = nullptr;
+    size_t base_size = 0;
+    bool header_checked = false;
+    /* Fields of the header or of the current instruction, not complete yet */
+    std::vector<uint8_t> fields;
+    /* Bytes of the current insert instruction not received yet */
+    size_t insert_remaining = 0;
+    uint64_t output_size = 0;
+    std::string error;
+};
+
+#endif /* POC_INCLUDE_DELTA_PATCH_H_ */
@@ -0,0 +1,137 @@
+/**
+ * @file DeviceSession.h
+ * @brief Open session on the device (sd card, loop device or image file) used by the MemoryManager.
+ * The device is opened once and kept open; its partition table is read once, from the MBR or from
+ * the GPT behind a protective MBR, so the address and size checks are done in memory, without
+ * running fdisk. The data is written and read with pwrite/pread at the given offsets.
+ * Logical partitions of an extended MBR partition are not listed.
+ * How to use example:
+ *     DeviceSession device;
+ *     if (device.open("/dev/loop20", logger) && device.contains(offset, data.size()))
+ *     {
+ *         device.write(offset, data.data(), data.size());
+ *     }
+ * @version 0.1
+ * @date 2024-09-04
+ * @copyright Copyright (c) 2024
+ */
+#ifndef POC_INCLUDE_DEVICE_SESSION_H_
+#define POC_INCLUDE_DEVICE_SESSION_H_
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include <sys/types.h>
+
+#include "Logger.h"
+
+class DeviceSession
+{
+public:
+    /* Partition of the device, in bytes */
+    struct Partition
+    {
+        off_t start = 0;
+        /* First byte after the partition */
+        off_t end = 0;
+        bool boot = false;
+    };
+
+    DeviceSession() = default;
+    ~DeviceSession();
+    DeviceSession(const DeviceSession&) = delete;
+    DeviceSession& operator=(const DeviceSession&) = delete;
+
+    /**
+     * @brief Opens the device and reads its partition table. A session already opened is closed first.
+     *
+     * @param path Path to the device.
+     * @param logger Logger used for the errors.
+     * @return Returns true if the device is opened for reading and writing.
+     */
+    bool open(const std::string& path, Logger& logger);
+
+    /**
+     * @brief Closes the device and forgets its partition table.
+     */
+    void close();
+
+    /**
+     * @brief Checks if a device is opened.
+     */
+    bool isOpen() const;
+
+    /**
+     * @brief Get method for the path of the opened device (empty if none).
+     */
+    const std::string& getPath() const;
+
+    /**
+     * @brief Get method for the size of the device, in bytes.
+     */
+    off_t getDeviceSize() const;
+
+    /**
+     * @brief Get method for the partitions read from the partition table.
+     */
+    const std::vector<Partition>& getPartitions() const;
+
+    /**
+     * @brief Get method for the end of the boot partition.
+     *
+     * @return Returns the first byte after the boot partition, -1 if there is no boot partition.
+     */
+    off_t getBootEnd() const;
+
+    /**
+     * @brief Checks if a range of bytes is inside one data (not boot) partition.
+     *
+     * @param offset First byte of the range.
+     * @param size Number of bytes of the range.
+     * @return Returns true if the whole range fits in the partition that holds its first byte.
+     */
+    bool contains(off_t offset, size_t size) const;
+
+    /**
+     * @brief Writes data at an offset of the device.
+     *
+     * @return Returns true if all the bytes were written.
+     */
+    bool write(off_t offset, const uint8_t* data, size_t size);
+
+    /**
+     * @brief Reads data from an offset of the device.
+     *
+     * @return Returns true if all the bytes were read.
+     */
+    bool read(off_t offset, uint8_t* data, size_t size);
+
+    /**
+     * @brief Flushes the data written on the device (fdatasync).
+     *
+     * @return Returns true if the data reached the device.
+     */
+    bool sync();
+
+private:
+    /**
+     * @brief Reads the partitions from the MBR, or from the GPT if the MBR is a protective one.
+     */
+    void readPartitionTable();
+
+    /**
+     * @brief Reads the partitions from the GPT header at the second sector.
+     */
+    void readGpt();
+
+    int fd = -1;
+    std::string path;
+    off_t device_size = 0;
+    size_t sector_size = 512;
+    std::vector<Partition> partitions;
+    Logger* logger = nullptr;
+};
+
+#endif /* POC_INCLUDE_DEVICE_SESSION_H_ */
@@ -0,0 +1,181 @@
+/**
+ * @file DidStore.h
+ * @brief DID database of a module (mcu_data.db, battery_data.db, ...), shared by all the processes.
+ * The database is a small binary file mapped in memory (MAP_SHARED): a header and a fixed table of
+ * records, one per DID, found by open addressing. The MCU and the ECUs map the same file, so a value
+ * written by one process is seen by the others without reading or parsing a file.
+ * Each record is protected by a sequence lock: a writer makes the sequence odd, writes the value and
+ * makes it even again; a reader copies the value and tries again if the sequence was odd or changed.
+ * Readers take no lock and never block a writer. Writers of all the processes are serialized with
+ * flock() on the file. Records are never removed, a record becomes visible only after its first value.
+ * The file keeps the values across resets; a key off reset marks the database so that the module keeps
+ * its values when it starts again, otherwise the module starts with its default values (restore()),
+ * except for the DIDs it asks to keep on every restart (e.g. the OTA transfer checkpoint).
+ * How to use example:
+ *     DidStore::restore(file_name, default_values);   at the start of the module
+ *     DidStore& store = DidStore::forFile(file_name);
+ *     std::vector<uint8_t> value;
+ *     if (store.get(0xE001, value)) { ... }
+ *     store.set(0xE001, {0x20});
+ * @version 0.2
+ * @date 2024-09-13
+ * @copyright Copyright (c) 2024
+ */
+#ifndef POC_INCLUDE_DID_STORE_H_
+#define POC_INCLUDE_DID_STORE_H_
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <sys/stat.h>
+
+/* "DIDS" */
+#define DID_STORE_MAGIC 0x44494453
+#define DID_STORE_VERSION 1
+/* Records of a database, a power of two */
+#define DID_STORE_CAPACITY 256
+/* Longest value of a DID, a record takes 64 bytes */
+#define DID_STORE_MAX_VALUE 56
+
+class DidStore
+{
+public:
+    /**
+     * @brief Get method for the database of a file, mapped on the first use. Each call checks with a
+     *      stat() that the file is still the mapped one and maps it again if another process replaced it,
+     *      callers that read many values should keep the reference.
+     *
+     * @param file_name Path of the database.
+     * @param create True to create an empty database if the file does not exist.
+     * @return The store. Throws std::runtime_error if the file does not exist or is not a database.
+     */
+    static DidStore& forFile(const std::string& file_name, bool create = false);
+
+    /**
+     * @brief Opens the database of a module when it starts. If a key off reset marked the database,
+     *      its values are kept and only the missing DIDs get their default value; otherwise a new
+     *      database holding the default values replaces the file (rename, the other processes see the
+     *      old or the new database, never a part of it). The DIDs of kept_dids keep their value in
+     *      the new database too.
+     *
+     * @param file_name Path of the database.
+     * @param default_values Default value of each DID of the module.
+     * @param kept_dids DIDs that keep their previous value on every restart.
+     * @return Returns true if the values were kept. Throws std::runtime_error if the file cannot be written.
+     */
+    static bool restore(const std::string& file_name, const std::unordered_map<uint16_t, std::vector<uint8_t>>& default_values,
+                        const std::vector<uint16_t>& kept_dids = {});
+
+    /**
+     * @brief Writes the databases mapped by the process on the disk (msync).
+     */
+    static void flushAll();
+
+    ~DidStore();
+    DidStore(const DidStore&) = delete;
+    DidStore& operator=(const DidStore&) = delete;
+
+    /**
+     * @brief Reads the value of a DID, without lock.
+     *
+     * @param did Data identifier.
+     * @param value Receives the value.
+     * @return Returns false if the DID is not in the database.
+     */
+    bool get(uint16_t did, std::vector<uint8_t>& value) const;
+
+    /**
+     * @brief Copies a byte range of the value of a DID, without lock and without an intermediate vector.
+     *
+     * @param did Data identifier.
+     * @param position Offset of the first byte in the value.
+     * @param size Number of bytes.
+     * @param destination Receives the bytes.
+     * @return Returns false if the DID is not in the database or its value is shorter than position + size.
+     */
+    bool read(uint16_t did, size_t position, size_t size, uint8_t* destination) const;
+
+    /**
+     * @brief Writes the value of a DID; the readers see the old or the new value.
+     *
+     * @param did Data identifier.
+     * @param value New value, at most DID_STORE_MAX_VALUE bytes.
+     * @param add True to add the DID if it is not in the database.
+     * @return Returns false if the DID is not in the database and add is false. Throws std::runtime_error
+     *      if the value is too long or the database is full.
+     */
+    bool set(uint16_t did, const std::vector<uint8_t>& value, bool add = false);
+
+    /**
+     * @brief Copy of all the DIDs and their values.
+     */
+    std::unordered_map<uint16_t, std::vector<uint8_t>> snapshot() const;
+
+    /**
+     * @brief Writes the database on the disk (msync).
+     */
+    void flush();
+
+    /**
+     * @brief Marks the database so that the next restore() keeps the values (key off reset).
+     */
+    void keepValuesOnRestart();
+
+private:
+    struct Record
+    {
+        /* Odd while the value is written */
+        std::atomic<uint32_t> sequence;
+        std::atomic<uint16_t> did;
+        /* 0 = free, 1 = used; set once, after the first value */
+        std::atomic<uint8_t> used;
+        std::atomic<uint8_t> length;
+        std::atomic<uint8_t> value[DID_STORE_MAX_VALUE];
+    };
+
+    struct Header
+    {
+        uint32_t magic;
+        uint16_t version;
+        uint16_t record_size;
+        uint32_t capacity;
+        std::atomic<uint32_t> keep_values;
+        uint8_t reserved[48];
+    };
+
+    /**
+     * @brief Maps the file; creates the database if create is true and the file is empty or not a
+     *      database, throws std::runtime_error otherwise.
+     */
+    DidStore(const std::string& file_name, bool create);
+
+    /**
+     * @brief Finds the record of a DID, nullptr if it is not in the database.
+     */
+    Record* find(uint16_t did) const;
+
+    /**
+     * @brief Writes the value of a record. Called with the file locked.
+     */
+    static void write(Record& record, const std::vector<uint8_t>& value);
+
+    /**
+     * @brief True if the mapped file is the one described by file_status.
+     */
+    bool isFile(const struct stat& file_status) const;
+
+    std::string file_name;
+    int file_descriptor = -1;
+    dev_t file_device = 0;
+    ino_t file_inode = 0;
+    Header* header = nullptr;
+    Record* records = nullptr;
+    /* Writers of the process; flock() serializes the processes */
+    std::mutex write_mutex;
+};
+
+#endif /* POC_INCLUDE_DID_STORE_H_ */
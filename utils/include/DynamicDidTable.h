@@ -0,0 +1,196 @@
+/**
+ * @file DynamicDidTable.h
+ * @brief Definitions of the dynamic DIDs of the DynamicallyDefineDataIdentifier (0x2C) service.
+ * A dynamic DID (0xF200 - 0xF3FF) is the concatenation of byte ranges of other DIDs of the module
+ * and of memory ranges of the device. When a DID is defined, each range is checked once and the
+ * definition is compiled into a gather list: the source of each field, the bytes to take and their
+ * offset in the value, adjacent ranges of the same source merged into one field. A ReadDataByIdentifier
+ * (0x22) of the dynamic DID sizes the value once and copies every field to its offset in one pass over
+ * the list, without parsing the definition again.
+ * A new definition of a defined DID appends its fields, like the service does. There is one table per
+ * process; the definitions are kept per server (receiver id of the requests).
+ * How to use example:
+ *     DynamicDidTable& table = DynamicDidTable::getInstance();
+ *     DidStore& store = DidStore::forFile(file_name);
+ *     table.defineByIdentifier(0x11, 0xF300, store, {{0x01B0, 1, 2}, {0x01C0, 1, 1}}, logger);
+ *     std::vector<uint8_t> value;
+ *     table.read(0x11, 0xF300, store, value, logger);   // voltage and percentage
+ *     table.clear(0x11, 0xF300);
+ * @version 0.1
+ * @date 2024-09-18
+ * @copyright Copyright (c) 2024
+ */
+#ifndef POC_INCLUDE_DYNAMIC_DID_TABLE_H_
+#define POC_INCLUDE_DYNAMIC_DID_TABLE_H_
+
+#include <sys/types.h>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "DidStore.h"
+#include "Logger.h"
+
+/* Range of the dynamically defined DIDs */
+#define DYNAMIC_DID_FIRST 0xF200
+#define DYNAMIC_DID_LAST 0xF3FF
+/* Dynamic DIDs of a server */
+#define DYNAMIC_DID_MAX_DEFINITIONS 16
+/* Fields of a dynamic DID, after the adjacent ranges are merged */
+#define DYNAMIC_DID_MAX_FIELDS 32
+/* Longest value of a dynamic DID */
+#define DYNAMIC_DID_MAX_LENGTH 255
+
+class DynamicDidTable
+{
+public:
+    /* Byte range of a source DID, as in the 0x2C request */
+    struct SourceRange
+    {
+        uint16_t did;
+        /* First byte of the range in the value of the DID, starting at 1 */
+        uint8_t position;
+        uint8_t size;
+    };
+
+    /* Memory range of the device */
+    struct MemoryRange
+    {
+        off_t address;
+        off_t size;
+    };
+
+    /**
+     * @brief Get method for the table of the process.
+     *
+     * @return Returns the table.
+     */
+    static DynamicDidTable& getInstance();
+
+    DynamicDidTable(const DynamicDidTable&) = delete;
+    DynamicDidTable& operator=(const DynamicDidTable&) = delete;
+
+    /**
+     * @brief True if the DID is in the range of the dynamically defined DIDs.
+     */
+    static bool isDynamic(uint16_t did);
+
+    /**
+     * @brief Defines a dynamic DID from byte ranges of DIDs of the module, or appends them to its definition.
+     *      Either all the ranges are added or none of them.
+     *
+     * @param server The receiver id of the requests (0x10 MCU, 0x11 battery, ...).
+     * @param dynamic_did The DID to define.
+     * @param store The DID database of the module.
+     * @param ranges The byte ranges, in the order of the value.
+     * @param logger The logger of the calling service.
+     * @return Returns false if a source DID is missing or too short, or if the definition is too long.
+     */
+    bool defineByIdentifier(uint8_t server, uint16_t dynamic_did, const DidStore& store, const std::vector<SourceRange>& ranges, Logger& logger);
+
+    /**
+     * @brief Defines a dynamic DID from memory ranges of the device, or appends them to its definition.
+     *      Either all the ranges are added or none of them.
+     *
+     * @param server The receiver id of the requests.
+     * @param dynamic_did The DID to define.
+     * @param ranges The memory ranges, in the order of the value.
+     * @param logger The logger of the calling service.
+     * @return Returns false if an address is not available or if the definition is too long.
+     */
+    bool defineByMemoryAddress(uint8_t server, uint16_t dynamic_did, const std::vector<MemoryRange>& ranges, Logger& logger);
+
+    /**
+     * @brief Removes the definition of a dynamic DID.
+     *
+     * @return Returns the number of definitions removed.
+     */
+    size_t clear(uint8_t server, uint16_t dynamic_did);
+
+    /**
+     * @brief Removes all the dynamic DIDs of a server.
+     *
+     * @return Returns the number of definitions removed.
+     */
+    size_t clear(uint8_t server);
+
+    /**
+     * @brief True if the dynamic DID is defined for the server.
+     */
+    bool isDefined(uint8_t server, uint16_t dynamic_did) const;
+
+    /**
+     * @brief Get method for the number of fields of the gather list of a dynamic DID, 0 if it is not defined.
+     */
+    size_t getFieldCount(uint8_t server, uint16_t dynamic_did) const;
+
+    /**
+     * @brief Reads the value of a dynamic DID: the fields of its gather list, copied to their offsets.
+     *
+     * @param server The receiver id of the requests.
+     * @param dynamic_did The dynamic DID.
+     * @param store The DID database of the module.
+     * @param value Receives the value.
+     * @param logger The logger of the calling service.
+     * @return Returns false if the DID is not defined or if a source can no longer be read.
+     */
+    bool read(uint8_t server, uint16_t dynamic_did, const DidStore& store, std::vector<uint8_t>& value, Logger& logger) const;
+
+private:
+    /* Entry of a gather list */
+    struct Field
+    {
+        enum Source : uint8_t
+        {
+            SOURCE_DID,
+            SOURCE_MEMORY
+        };
+        Source source = SOURCE_DID;
+        uint16_t did = 0;
+        /* Offset of the bytes in the value of the DID, or address on the device */
+        off_t offset = 0;
+        size_t size = 0;
+        /* Offset of the bytes in the value of the dynamic DID */
+        size_t destination = 0;
+    };
+
+    struct Definition
+    {
+        std::vector<Field> fields;
+        size_t length = 0;
+        /* Device of the memory fields */
+        std::string device;
+    };
+
+    /* Definitions by server (high byte) and dynamic DID */
+    std::unordered_map<uint32_t, Definition> definitions;
+    mutable std::mutex table_mutex;
+
+    DynamicDidTable() = default;
+
+    static uint32_t key(uint8_t server, uint16_t dynamic_did);
+
+    /**
+     * @brief Appends a field to a gather list, merged with the last field if the bytes follow it in the same source.
+     */
+    static void append(Definition& definition, const Field& field);
+
+    /**
+     * @brief Stores a compiled definition if the server has room for it. Called with table_mutex locked.
+     */
+    bool commit(uint8_t server, uint16_t dynamic_did, Definition&& definition, Logger& logger);
+
+    /**
+     * @brief Copy of the definition of a dynamic DID, empty if it is not defined.
+     */
+    Definition find(uint8_t server, uint16_t dynamic_did) const;
+
+    /**
+     * @brief Count of the dynamic DIDs of a server. Called with table_mutex locked.
+     */
+    size_t countDefinitions(uint8_t server) const;
+};
+
+#endif /* POC_INCLUDE_DYNAMIC_DID_TABLE_H_ */
@@ -13,6 +13,7 @@
 #define ECU_H
 
 #include <iostream>
+#include <array>
 #include "Logger.h"
 #include "GenerateFrames.h"
 #include "CreateInterface.h"
@@ -30,12 +31,11 @@ public:
     CreateInterface *_can_interface;
     Logger& _logger;
 
-    /* Static dictionary to store SID and processing time */
-    static std::map<uint8_t, double> timing_parameters;
-    /* Store active timers for SIDs */
-    static std::map<uint8_t, std::future<void>> active_timers;
-    /* Stop flags for each SID. */
-    static std::map<uint8_t, std::atomic<bool>> stop_flags;
+    /* Processing time for each SID (start time while the request is pending) */
+    static std::array<std::atomic<double>, SID_COUNT> timing_parameters;
+    /* Stop flags for each SID, indexed by SID so they are cleared in O(1).
+       The pending P2/P2* deadline is dropped once its flag is false. */
+    static std::array<std::atomic<bool>, SID_COUNT> stop_flags;
 
     /**
      * @brief Construct a new ECU object
@@ -84,7 +84,8 @@ public:
      * 
      * @param ecu_id 
      * @param ecu_path 
-     * @param param 
+     * @param param 0 = zip of a version, 1 = received zip, 2 = directory of the extracted software,
+     *      3 = downloaded zip, 4 = installed executable (base of the delta updates)
      * @param rc_logger 
      * @param version 
      * @return true 
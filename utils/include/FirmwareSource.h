@@ -0,0 +1,108 @@
+/**
+ * @file FirmwareSource.h
+ * @brief Read-only view over a firmware image, used by the MCU to fill the transfer data requests.
+ * A regular file is memory-mapped: the chunks are pointers in the mapping, the kernel reads the pages
+ * on demand and the pages already sent are released, so the memory used does not grow with the image.
+ * A source that cannot be mapped (block device, mmap failure) is read through a bounded
+ * read-ahead window of FIRMWARE_READ_AHEAD_BYTES instead.
+ * How to use example:
+ *     FirmwareSource source;
+ *     if (source.open(path, logger))
+ *     {
+ *         FirmwareSource::Chunk chunk = source.chunk(offset, length);
+ *         ... use chunk.data / chunk.size until the next call of chunk() or close() ...
+ *     }
+ * @version 0.1
+ * @date 2024-09-02
+ * @copyright Copyright (c) 2024
+ */
+#ifndef POC_INCLUDE_FIRMWARE_SOURCE_H_
+#define POC_INCLUDE_FIRMWARE_SOURCE_H_
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "Logger.h"
+
+/* Size of the window used for the sources that cannot be mapped */
+#define FIRMWARE_READ_AHEAD_BYTES (64 * 1024)
+
+class FirmwareSource
+{
+public:
+    /* Zero-copy view of a part of the image */
+    struct Chunk
+    {
+        const uint8_t* data = nullptr;
+        size_t size = 0;
+    };
+
+    FirmwareSource() = default;
+    ~FirmwareSource();
+    FirmwareSource(const FirmwareSource&) = delete;
+    FirmwareSource& operator=(const FirmwareSource&) = delete;
+
+    /**
+     * @brief Opens a firmware image. A source already opened is closed first.
+     *
+     * @param path Path to the image.
+     * @param logger Logger used for the errors.
+     * @return Returns true if the image can be read.
+     */
+    bool open(const std::string& path, Logger& logger);
+
+    /**
+     * @brief Returns a view of the image, valid until the next call of chunk() or close().
+     *
+     * @param offset Offset of the first byte in the image.
+     * @param length Number of bytes wanted; the view is shorter at the end of the image.
+     * @return Returns the view, empty if the offset is past the end or the read failed.
+     */
+    Chunk chunk(size_t offset, size_t length);
+
+    /**
+     * @brief Releases the mapping or the read-ahead window and the file descriptor.
+     */
+    void close();
+
+    /**
+     * @brief Get method for the size of the image.
+     */
+    size_t size() const;
+
+    /**
+     * @brief Checks if the image is memory-mapped (false for the read-ahead window).
+     */
+    bool isMapped() const;
+
+    /**
+     * @brief Checks if a source is opened.
+     */
+    bool isOpen() const;
+
+private:
+    /**
+     * @brief Releases the mapped pages that are before an offset; they are not read again.
+     */
+    void releaseBefore(size_t offset);
+
+    /**
+     * @brief Fills the read-ahead window starting from an offset.
+     */
+    bool readAhead(size_t offset, size_t length);
+
+    int fd = -1;
+    size_t image_size = 0;
+    /* Mapping of the whole image, nullptr when the read-ahead window is used */
+    const uint8_t* mapping = nullptr;
+    /* Offset of the first mapped page that was not released yet */
+    size_t released = 0;
+    /* Read-ahead window and its offset in the image */
+    std::vector<uint8_t> window;
+    size_t window_offset = 0;
+    Logger* logger = nullptr;
+};
+
+#endif /* POC_INCLUDE_FIRMWARE_SOURCE_H_ */
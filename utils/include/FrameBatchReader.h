@@ -0,0 +1,124 @@
+/**
+ * @file FrameBatchReader.h
+ * @brief Batched reception of CAN frames from a socket.
+ * The reader drains up to batch_size frames with a single recvmmsg() call and keeps
+ * the kernel receive timestamp (SO_TIMESTAMPNS) of every frame. All the buffers used
+ * by recvmmsg() are allocated once, when the batch size is set.
+ * The buffers hold CAN FD frames, so a socket with CAN_RAW_FD_FRAMES enabled delivers
+ * both formats; a CAN FD frame marks its sender as a CAN FD peer (see CanFd.h).
+ * How to use example:
+ *     FrameBatchReader reader(socket, 32);
+ *     std::vector<TimestampedFrame> frames;
+ *     while (reader.readBatch(frames) > 0)
+ *     {
+ *         // push all the frames in the processing queue with one lock
+ *     }
+ * @version 0.1
+ * @date 2024-08-20
+ * @copyright Copyright (c) 2024
+ */
+#ifndef POC_INCLUDE_FRAME_BATCH_READER_H_
+#define POC_INCLUDE_FRAME_BATCH_READER_H_
+
+#include <vector>
+#include <cstdint>
+#include <ctime>
+#include <linux/can.h>
+#include <sys/socket.h>
+
+#include "CanFd.h"
+
+/* Number of frames drained with one syscall if no other value is configured */
+#define DEFAULT_RECV_BATCH_SIZE 32
+/* Upper limit for the configurable batch size */
+#define MAX_RECV_BATCH_SIZE 1024
+
+/* Return values of FrameBatchReader::readBatch */
+#define BATCH_READ_ERROR -1
+#define BATCH_CONNECTION_CLOSED -2
+
+/* A frame read from the socket together with the time when the kernel received it.
+   Classic frames are kept in the CAN FD layout too (len = can_dlc, at most 8 bytes). */
+struct TimestampedFrame
+{
+    struct canfd_frame frame;
+    struct timespec timestamp;
+
+    TimestampedFrame() : frame{}, timestamp{} {}
+
+    /* Frames that do not come from a socket (tests, internal frames) are stamped with the current time */
+    TimestampedFrame(const struct can_frame& frame) : frame(CanFd::toFdFrame(frame))
+    {
+        clock_gettime(CLOCK_REALTIME, &timestamp);
+    }
+
+    TimestampedFrame(const struct canfd_frame& frame) : frame(frame)
+    {
+        clock_gettime(CLOCK_REALTIME, &timestamp);
+    }
+
+    TimestampedFrame(const struct canfd_frame& frame, const struct timespec& timestamp)
+        : frame(frame), timestamp(timestamp) {}
+};
+
+class FrameBatchReader
+{
+public:
+    /**
+     * @brief Parameterized constructor. Enables kernel receive timestamps on the socket.
+     *
+     * @param socket The socket from where the frames are read.
+     * @param batch_size Maximum number of frames read with one syscall.
+     */
+    FrameBatchReader(int socket, size_t batch_size = DEFAULT_RECV_BATCH_SIZE);
+
+    /**
+     * @brief Reads all the frames available on the socket, up to batch_size, without blocking.
+     *
+     * @param frames Vector filled with the frames read (cleared first).
+     * @return Returns the number of frames read, 0 if no frame is pending,
+     * BATCH_READ_ERROR for a read error (errno is kept) or BATCH_CONNECTION_CLOSED.
+     */
+    int readBatch(std::vector<TimestampedFrame>& frames);
+
+    /**
+     * @brief Changes the number of frames read with one syscall and reallocates the buffers.
+     * Values of 0 or above MAX_RECV_BATCH_SIZE are clamped.
+     *
+     * @param batch_size The new batch size.
+     */
+    void setBatchSize(size_t batch_size);
+
+    /**
+     * @brief Get method for the batch size.
+     *
+     * @return Returns the number of frames read with one syscall.
+     */
+    size_t getBatchSize() const;
+
+    /**
+     * @brief Get method for the socket.
+     *
+     * @return Returns the socket used by the reader.
+     */
+    int getSocket() const;
+
+private:
+    int socket;
+    size_t batch_size;
+    /* Preallocated buffers used by recvmmsg */
+    std::vector<struct canfd_frame> frame_buffers;
+    std::vector<struct iovec> iovecs;
+    std::vector<struct mmsghdr> messages;
+    std::vector<uint8_t> control_buffers;
+
+    /**
+     * @brief Extracts the SO_TIMESTAMPNS value from the ancillary data of a message.
+     *
+     * @param message The message header filled by recvmmsg.
+     * @param timestamp Output timestamp; the current time if the kernel did not provide one.
+     */
+    static void extractTimestamp(const struct msghdr& message, struct timespec& timestamp);
+};
+
+#endif /* POC_INCLUDE_FRAME_BATCH_READER_H_ */
@@ -0,0 +1,179 @@
+/**
+ * @file FrameRingBuffer.h
+ * @brief Bounded ring buffer of CAN frames used between the threads that read the
+ * sockets and the thread that processes the frames.
+ * Producers never take a lock: each slot has its own sequence number, so several
+ * readers (CANBus and API) can push at the same time while one consumer pops.
+ * The consumer sleeps on an eventfd when the buffer is empty and is woken up only
+ * if it is really waiting. When the buffer is full the frame is dropped and counted.
+ * How to use example:
+ *     FrameRingBuffer ring(1024);
+ *     // reader thread
+ *     ring.tryPush(frame1);
+ *     ring.tryPush(frame2);
+ *     ring.notify();
+ *     // processing thread
+ *     TimestampedFrame frame;
+ *     if (ring.waitPop(frame, 100)) { ... }
+ * @version 0.1
+ * @date 2024-08-22
+ * @copyright Copyright (c) 2024
+ */
+#ifndef POC_INCLUDE_FRAME_RING_BUFFER_H_
+#define POC_INCLUDE_FRAME_RING_BUFFER_H_
+
+#include <atomic>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+
+#include "FrameBatchReader.h"
+
+/* Size of a cache line, used to keep the producer and consumer indexes apart */
+#define CACHE_LINE_SIZE 64
+/* Number of frames the buffer holds if no other value is configured */
+#define DEFAULT_RING_CAPACITY 1024
+
+class FrameRingBuffer
+{
+public:
+    /**
+     * @brief Parameterized constructor.
+     *
+     * @param capacity Maximum number of frames, rounded up to a power of two.
+     */
+    explicit FrameRingBuffer(size_t capacity = DEFAULT_RING_CAPACITY);
+
+    /**
+     * @brief Destructor. Closes the eventfd.
+     */
+    ~FrameRingBuffer();
+
+    FrameRingBuffer(const FrameRingBuffer&) = delete;
+    FrameRingBuffer& operator=(const FrameRingBuffer&) = delete;
+
+    /**
+     * @brief Adds a frame without waking up the consumer. Safe to call from several threads.
+     *
+     * @param frame The frame to be added.
+     * @return Returns false if the buffer is full (the frame is counted as dropped).
+     */
+    bool tryPush(const TimestampedFrame& frame);
+
+    /**
+     * @brief Adds a frame and wakes up the consumer if it is waiting.
+     *
+     * @param frame The frame to be added.
+     * @return Returns false if the buffer is full (the frame is counted as dropped).
+     */
+    bool push(const TimestampedFrame& frame);
+
+    /**
+     * @brief Adds a frame and wakes up the consumer, without counting a drop if the buffer is full.
+     * Used by producers that wait for room and retry, so backpressure is not reported as loss.
+     *
+     * @param frame The frame to be added.
+     * @return Returns false if the buffer is full.
+     */
+    bool offer(const TimestampedFrame& frame);
+
+    /**
+     * @brief Counts a frame that a retrying producer finally gave up on.
+     */
+    void recordDrop();
+
+    /**
+     * @brief Takes the oldest frame without blocking.
+     *
+     * @param frame Output frame.
+     * @return Returns false if the buffer is empty.
+     */
+    bool tryPop(TimestampedFrame& frame);
+
+    /**
+     * @brief Takes the oldest frame, sleeping on the eventfd while the buffer is empty.
+     *
+     * @param frame Output frame.
+     * @param timeout_ms Maximum time to wait, -1 to wait until a frame or a wake up arrives.
+     * @return Returns false if no frame arrived in time or the consumer was woken up by wakeUp().
+     */
+    bool waitPop(TimestampedFrame& frame, int timeout_ms);
+
+    /**
+     * @brief Wakes up the consumer if it sleeps in waitPop. Call it once after a batch of tryPush.
+     */
+    void notify();
+
+    /**
+     * @brief Wakes up the consumer unconditionally, used when stopping the processing thread.
+     */
+    void wakeUp();
+
+    /**
+     * @brief Get method for the number of frames currently stored.
+     *
+     * @return Returns the occupancy of the buffer.
+     */
+    size_t size() const;
+
+    /**
+     * @brief Checks if the buffer has no frames.
+     *
+     * @return Returns true if the buffer is empty.
+     */
+    bool empty() const;
+
+    /**
+     * @brief Get method for the capacity.
+     *
+     * @return Returns the maximum number of frames the buffer can hold.
+     */
+    size_t capacity() const;
+
+    /**
+     * @brief Get method for the highest occupancy reached since creation.
+     *
+     * @return Returns the peak number of frames stored at the same time.
+     */
+    size_t getPeakOccupancy() const;
+
+    /**
+     * @brief Get method for the drop counter.
+     *
+     * @return Returns the number of frames rejected because the buffer was full.
+     */
+    uint64_t getDroppedFrames() const;
+
+    /**
+     * @brief Get method for the eventfd, so the consumer can also wait on it with poll/epoll.
+     *
+     * @return Returns the eventfd used for wake ups.
+     */
+    int getEventFd() const;
+
+private:
+    /**
+     * @brief Claims a slot and stores the frame. Does not touch the drop counter.
+     *
+     * @param frame The frame to be added.
+     * @return Returns false if the buffer is full.
+     */
+    bool enqueue(const TimestampedFrame& frame);
+
+    struct alignas(CACHE_LINE_SIZE) Slot
+    {
+        std::atomic<size_t> sequence;
+        TimestampedFrame value;
+    };
+
+    std::unique_ptr<Slot[]> slots;
+    size_t mask;
+    int event_fd;
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> enqueue_position;
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> dequeue_position;
+    alignas(CACHE_LINE_SIZE) std::atomic<bool> consumer_waiting;
+    alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> dropped_frames;
+    std::atomic<size_t> peak_occupancy;
+};
+
+#endif /* POC_INCLUDE_FRAME_RING_BUFFER_H_ */
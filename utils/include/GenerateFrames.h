@@ -5,11 +5,21 @@
  * frames through an interface utilizing sockets.
  * The library also gives some methods for the creation of specific 
  * frames for the main services.
+ * The frames are formatted directly into can_frame slots from a pointer and a length,
+ * so no temporary vector is needed on the send path, and the multi-frame messages
+ * (first frame + consecutive frames) are handed to the kernel in batches with sendmmsg().
+ * Failed writes are counted per socket (see getTransmitStats()) instead of being
+ * printed one by one.
+ * The frames addressed to a CAN FD peer go out in the CAN FD format (see CanFd.h);
+ * the CAN FD frames of more than 8 bytes are formatted in canfd_frame slots.
  * How to use example:
  *     GenerateFrames g1 = GenerateFrames(socket);
  *     std::vector<uint8_t> x = {0x11, 0x34, 0x56};
  *     g1.SendFrame(0x23, x);
  *     g1.SessionControl(0x34A, 0x1);
+ *     const uint8_t payload[] = {0x02, 0x3E, 0x00};
+ *     g1.sendFrame(0x23, payload, sizeof(payload), socket);
+ *     g1.sendMultiFrame(0x23, long_payload.data(), long_payload.size(), socket);
  * @version 0.1
  * @date 2024-05-27
  * @copyright Copyright (c) 2024
@@ -19,11 +29,22 @@
 
 #include <iostream>
 #include <cstdlib>
+#include <cstdint>
 #include <vector>
 
 #include <unistd.h>
+#include <sys/socket.h>
 #include <linux/can.h>
 #include "Logger.h"
+#include "CanFd.h"
+#include "IsoTpTransmitter.h"
+
+/* Frames handed to the kernel with one sendmmsg() call */
+#define TX_BATCH_SIZE 32
+/* Sockets with their own transmit counters; higher descriptors share the last slot */
+#define TX_STATS_SOCKETS 256
+/* Retries of a batch when the CAN transmit queue is full (ENOBUFS) */
+#define TX_RETRY_LIMIT 3
 /* Enumeration for frame types */
 enum FrameType {
     DATA_FRAME,
@@ -32,6 +53,15 @@ enum FrameType {
     OVERLOAD_FRAME
 };
 
+/* Transmit counters of one socket */
+struct TransmitStats
+{
+    uint64_t frames_sent = 0;
+    uint64_t send_errors = 0;
+    /* errno of the last failed write, 0 if none */
+    int last_error = 0;
+};
+
 class GenerateFrames
 {
     private:
@@ -61,7 +91,84 @@ class GenerateFrames
          * @param s socket needed for sendFrame
          * @param frameType default value: DATA_FRAME. More values: REMOTE_FRAME, ERROR_FRAME
          */
-        int sendFrame(int can_id, std::vector<uint8_t> data, int s, FrameType frameType = DATA_FRAME);
+        int sendFrame(int can_id, const std::vector<uint8_t>& data, int s, FrameType frameType = DATA_FRAME);
+        /**
+         * @brief Method for creation of custom frames, without temporary vector
+         * 
+         * @param can_id id of the frame
+         * @param data pointer to the data to be sent through CAN
+         * @param length number of bytes of data (at most CAN_MAX_DLEN)
+         * @param s socket needed for sendFrame
+         * @param frameType default value: DATA_FRAME. More values: REMOTE_FRAME, ERROR_FRAME
+         * @return Returns 0 if the frame was sent, -1 otherwise
+         */
+        int sendFrame(int can_id, const uint8_t* data, size_t length, int s, FrameType frameType = DATA_FRAME);
+        /**
+         * @brief Sends already formatted frames with as few sendmmsg() calls as possible
+         * (TX_BATCH_SIZE frames per call).
+         * 
+         * @param frames the frames to be sent, in order
+         * @param count number of frames
+         * @param s socket used to send the frames
+         * @return Returns the number of frames sent; less than count if a write failed
+         */
+        int sendFrames(const struct can_frame* frames, size_t count, int s);
+        /**
+         * @brief Sends already formatted CAN FD frames. The frames of up to 8 bytes go out
+         * in the classic format unless the receiver is a CAN FD peer.
+         * 
+         * @param frames the frames to be sent, in order
+         * @param count number of frames
+         * @param s socket used to send the frames
+         * @return Returns the number of frames sent; less than count if a write failed
+         */
+        int sendFrames(const struct canfd_frame* frames, size_t count, int s);
+        /**
+         * @brief Sends a long message as a first frame followed by all its consecutive frames,
+         * in one batch. Use it when the receiver does not need to answer with a flow control frame.
+         * 
+         * @param id id of the frame(sender id and receiver id)
+         * @param data the message, starting with its length byte
+         * @param length number of bytes of the message
+         * @param s socket used to send the frames
+         * @return Returns the number of frames sent
+         */
+        int sendMultiFrame(int id, const uint8_t* data, size_t length, int s);
+        /**
+         * @brief Formats a frame in place, e.g. in a preallocated array for sendFrames()
+         * 
+         * @param[out] frame the frame to be filled
+         * @param id id of the frame
+         * @param data pointer to the data to be put in the frame
+         * @param length number of bytes of data
+         * @param frameType type of frame
+         * @return Returns false if length is bigger than CAN_MAX_DLEN (the data is truncated)
+         */
+        static bool fillFrame(struct can_frame& frame, int id, const uint8_t* data, size_t length, FrameType frameType = DATA_FRAME);
+        /**
+         * @brief Formats a CAN FD data frame in place. Above 8 bytes the frame is padded
+         * with CAN_FD_PADDING up to the next valid CAN FD data length.
+         * 
+         * @param[out] frame the frame to be filled
+         * @param id id of the frame
+         * @param data pointer to the data to be put in the frame
+         * @param length number of bytes of data
+         * @return Returns false if length is bigger than CANFD_MAX_DLEN (the data is truncated)
+         */
+        static bool fillFrame(struct canfd_frame& frame, int id, const uint8_t* data, size_t length);
+        /**
+         * @brief Get method for the transmit counters of a socket
+         * 
+         * @param socket the socket descriptor
+         * @return Returns the frames sent and the failed writes on the socket
+         */
+        static TransmitStats getTransmitStats(int socket);
+        /**
+         * @brief Resets the transmit counters of a socket
+         * 
+         * @param socket the socket descriptor
+         */
+        static void resetTransmitStats(int socket);
         /**
          * @brief Method for creation of custom frames
          * 
@@ -70,7 +177,7 @@ class GenerateFrames
          * @param frameType default value: DATA_FRAME. More values: REMOTE_FRAME, ERROR_FRAME
          * @return Returns a boolean if the CAN frame was send or not
          */
-        bool sendFrame(int id, std::vector<uint8_t > data, FrameType frameType = DATA_FRAME);
+        bool sendFrame(int id, const std::vector<uint8_t>& data, FrameType frameType = DATA_FRAME);
         /**
          * !!! IMPORTANT: FOR ALL METHODS: !!!
          * Most of the methods can be used to send a request or a response frame 
@@ -125,12 +232,13 @@ class GenerateFrames
          * @brief Frame for Read data by Identifier Service
          * Consider using the method readDataByIdentifierLongResponse(), if the response
          * is longer than 5 bytes, to split the response into multiple frames.
+         * The long methods send the first frame; the consecutive frames follow the flow
+         * control frames of the client (see IsoTpTransmitter) and on_done gets the result.
          * Example:
          *     if (response.size() > 5)
          *     {
-         *         gf.readDataByIdentifierLongResponse(0x0, 0x0, response, true); // First frame
-         *         // !!!! IMPORTANT: Wait for the Flow control frame from the Client !!!!
-         *         gf.readDataByIdentifierLongResponse(0x0, 0x0, response, false); // Remaining frames
+         *         gf.readDataByIdentifierLongResponse(0x0, 0x0, response, true,
+         *             [](IsoTpTransmitter::TransmitStatus status) { ... });
          *     }
          *     else
          *     {
@@ -152,8 +260,50 @@ class GenerateFrames
          * @param identifier identifier of the data to be read
          * @param response the data that is sent 
          * @param first_frame set as true if it is the first frame (default) or false for the rest of the frames.
+         * @param on_done called with the result of the transmission, when first_frame is true (optional)
          */
-        void readDataByIdentifierLongResponse(int id, uint16_t identifier, std::vector<uint8_t> response, bool first_frame = true);
+        void readDataByIdentifierLongResponse(int id, uint16_t identifier, std::vector<uint8_t> response, bool first_frame = true, IsoTpTransmitter::CompletionCallback on_done = nullptr);
+        /**
+         * @brief Request frame(s) for Read data by Identifier Service with several DIDs.
+         * Up to 3 DIDs fit in a single frame, more DIDs are sent as a multi-frame request.
+         *
+         * @param id id of the frame(sender id and receiver id)
+         * @param identifiers identifiers of the data to be read, in the order of the response
+         * @param on_done called with the result of the transmission, for a multi-frame request (optional)
+         */
+        void readDataByIdentifier(int id, const std::vector<uint16_t>& identifiers, IsoTpTransmitter::CompletionCallback on_done = nullptr);
+        /**
+         * @brief Response frame(s) for Read data by Identifier Service, for one or more DIDs.
+         * The records are sent in a single frame when they fit, otherwise the first frame is
+         * sent now and the consecutive frames follow the flow control frames of the client.
+         *
+         * @param id id of the frame(sender id and receiver id)
+         * @param records for each DID of the response: DID (2 bytes) followed by its data
+         * @param on_done called with the result of the transmission, for a multi-frame response (optional)
+         */
+        void readDataByIdentifierRecords(int id, const std::vector<uint8_t>& records, IsoTpTransmitter::CompletionCallback on_done = nullptr);
+        /**
+         * @brief Frame for Read data by Periodic Identifier Service
+         * Up to 2 DIDs fit in a single frame, more DIDs are sent as a multi-frame request.
+         * The periodic frames themselves are sent by the PeriodicScheduler.
+         *
+         * @param id id of the frame(sender id and receiver id)
+         * @param transmission_mode 0x01 slow rate, 0x02 medium rate, 0x03 fast rate, 0x04 stop sending
+         * @param identifiers DIDs to send periodically or to stop (request only)
+         * @param response variable for request or response frame
+         */
+        void readDataByPeriodicIdentifier(int id, uint8_t transmission_mode, const std::vector<uint16_t>& identifiers = {}, bool response=false);
+        /**
+         * @brief Frame for Dynamically Define Data Identifier Service
+         * A request that does not fit in a single frame is sent as a multi-frame request.
+         *
+         * @param id id of the frame(sender id and receiver id)
+         * @param sub_function 0x01 define by identifier, 0x02 define by memory address, 0x03 clear
+         * @param definition bytes after the sub-function: the dynamic DID and, for a request, its
+         *      source ranges (may be empty for a clear)
+         * @param response variable for request or response frame
+         */
+        void dynamicallyDefineDataIdentifier(int id, uint8_t sub_function, const std::vector<uint8_t>& definition = {}, bool response=false);
         /**
          * @brief This frame is sent as a response to a FirstFrame
          * 
@@ -164,16 +314,20 @@ class GenerateFrames
          * @brief Frame for Authentication Service, sub-function 0x01(Request seed)
          * 
          * @param id id of the frame(sender id and receiver id)
-         * @param seed the requested seed(if not set the frame is a request)
+         * @param seed the requested seed(if not set the frame is a request). A seed longer than
+         *             5 bytes is sent as a multi-frame message.
+         * @param on_done called with the result of a multi-frame transmission
         Response&Request */
-        void securityAccessRequestSeed(int id, const std::vector<uint8_t>& seed = {});
+        void securityAccessRequestSeed(int id, const std::vector<uint8_t>& seed = {}, IsoTpTransmitter::CompletionCallback on_done = nullptr);
         /**
          * @brief Frame for Authentication Service, sub-function 0x01(Request seed)
          * 
          * @param id id of the frame(sender id and receiver id)
-         * @param key if not set, the frame is a response
+         * @param key if not set, the frame is a response. A key longer than 5 bytes is sent
+         *            as a multi-frame message.
+         * @param on_done called with the result of a multi-frame transmission
         Response&Request */
-        void securityAccessSendKey(int id, const std::vector<uint8_t>& key = {});
+        void securityAccessSendKey(int id, const std::vector<uint8_t>& key = {}, IsoTpTransmitter::CompletionCallback on_done = nullptr);
         /**
          * @brief Frame for Routine Control Service
          * 
@@ -209,8 +363,9 @@ class GenerateFrames
          * @param memory_address Memory address variable
          * @param response variable for request or response frame
          * @param first_frame set as true if it is the first frame (default) or false for the rest of the frames.
+         * @param on_done called with the result of the transmission, when first_frame is true (optional)
          */
-        void readMemoryByAddressLongResponse(int id, int memory_address, int memory_size, std::vector<uint8_t> response, bool first_frame = true);
+        void readMemoryByAddressLongResponse(int id, int memory_address, int memory_size, std::vector<uint8_t> response, bool first_frame = true, IsoTpTransmitter::CompletionCallback on_done = nullptr);
         /**
          * @brief Frame for Write data by Identifier. Check the commentary from the readDataByIdentifier() method
          * 
@@ -227,8 +382,9 @@ class GenerateFrames
          * @param identifier identifier of the data to be read
          * @param data_parameter data to be write in the identifier
          * @param first_frame set as true if it is the first frame (default) or false for the rest of the frames.
+         * @param on_done called with the result of the transmission, when first_frame is true (optional)
          */
-        void writeDataByIdentifierLongData(int id, uint16_t identifier, std::vector<uint8_t> data_parameter, bool first_frame = true);
+        void writeDataByIdentifierLongData(int id, uint16_t identifier, std::vector<uint8_t> data_parameter, bool first_frame = true, IsoTpTransmitter::CompletionCallback on_done = nullptr);
         /**
          * @brief Frame for Read DTC Information Request
          * 
@@ -262,8 +418,9 @@ class GenerateFrames
          * @param status_availability_mask Status availability mask variable
          * @param dtc_and_status_list list of pairs of dtc and its status mask
          * @param first_frame set as true if it is the first frame (default) or false for the rest of the frames.
+         * @param on_done called with the result of the transmission, when first_frame is true (optional)
          */
-        void readDtcInformationResponse02Long(int id, uint8_t status_availability_mask, std::vector<std::pair<int,int>> dtc_and_status_list, bool first_frame = true);
+        void readDtcInformationResponse02Long(int id, uint8_t status_availability_mask, std::vector<std::pair<int,int>> dtc_and_status_list, bool first_frame = true, IsoTpTransmitter::CompletionCallback on_done = nullptr);
         /**
          * @brief Frame for Clear Diagnostic Information Service
          * 
@@ -313,8 +470,10 @@ class GenerateFrames
          * @param memory_address Memory address variable
          * @param memory_size Memory size variable
          * @param download_type The type of download: manual or automatic
+         * @param first_frame set as true if it is the first frame (default) or false for the rest of the frames.
+         * @param on_done called with the result of the transmission, when first_frame is true (optional)
          */
-        void requestDownloadLong(int id, uint8_t data_format_identifier, int memory_address, int memory_size, uint8_t download_type, bool first_frame = true);
+        void requestDownloadLong(int id, uint8_t data_format_identifier, int memory_address, int memory_size, uint8_t download_type, bool first_frame = true, IsoTpTransmitter::CompletionCallback on_done = nullptr);
         /**
          * @brief Response to requestDownload
          * 
@@ -338,8 +497,9 @@ class GenerateFrames
          * @param block_sequence_counter Block sequence counter variable
          * @param transfer_request Data to be transfer
          * @param first_frame set as true if it is the first frame (default) or false for the rest of the frames.
+         * @param on_done called with the result of the transmission, when first_frame is true (optional)
          */
-        void transferDataLong(int id, uint8_t block_sequence_counter, std::vector<uint8_t> transfer_request, bool first_frame = true);
+        void transferDataLong(int id, uint8_t block_sequence_counter, std::vector<uint8_t> transfer_request, bool first_frame = true, IsoTpTransmitter::CompletionCallback on_done = nullptr);
         /**
          * @brief Frame for Request transfer exit service
          * 
@@ -360,14 +520,74 @@ class GenerateFrames
         void addSocket(int socket);
     private:
         /**
-         * @brief Create a Frame object
+         * @brief Formats a frame from a pointer and a length and sends it on the socket of the object
          * 
-         * @param id if of the frame
-         * @param data data to be put in the frame
+         * @param id id of the frame
+         * @param data pointer to the data to be sent
+         * @param length number of bytes of data
          * @param frameType type of frame
-         * @return struct can_frame 
+         * @return Returns true if the frame was sent
+         */
+        bool sendPayload(int id, const uint8_t* data, size_t length, FrameType frameType = DATA_FRAME);
+        /**
+         * @brief Writes the frames on the socket, without checking the socket
+         * 
+         * @param frames the frames to be sent, in order
+         * @param count number of frames
+         * @param s socket used to send the frames
+         * @return Returns the number of frames sent
+         */
+        int transmit(const struct can_frame* frames, size_t count, int s);
+        /**
+         * @brief Writes CAN FD frames on the socket, in the classic format when they fit and the
+         * receiver talks classic CAN. If the interface refuses CAN FD frames, the socket
+         * falls back to classic CAN.
+         * 
+         * @param frames the frames to be sent, in order
+         * @param count number of frames
+         * @param s socket used to send the frames
+         * @return Returns the number of frames sent
+         */
+        int transmitFd(const struct canfd_frame* frames, size_t count, int s);
+        /**
+         * @brief Writes frames of one size (CAN_MTU or CANFD_MTU) with sendmmsg() batches
+         * 
+         * @param frames the frames to be sent, in order
+         * @param mtu size of one frame
+         * @param count number of frames
+         * @param s socket used to send the frames
+         * @return Returns the number of frames sent; errno is kept if a write failed
+         */
+        int writeFrames(const void* frames, size_t mtu, size_t count, int s);
+        /**
+         * @brief Updates the transmit counters of a socket and logs the failures
+         * (only the first one and then every power of two, to not flood the log)
+         * 
+         * @param s the socket descriptor
+         * @param sent number of frames sent
+         * @param error errno of the failed write, 0 if none
+         */
+        void recordTransmit(int s, size_t sent, int error);
+        /**
+         * @brief Counts and logs a payload too long for a single frame
+         * 
+         * @param s the socket descriptor
+         * @param length number of bytes of the rejected payload
+         */
+        void rejectOversized(int s, size_t length);
+        /**
+         * @brief Formats the first frame and/or the consecutive frames of a long message
+         * directly in a frame array and sends them in batches
+         * 
+         * @param id id of the frame(sender id and receiver id)
+         * @param data the message, starting with its length byte
+         * @param length number of bytes of the message
+         * @param first_frame true to send the first frame
+         * @param consecutive_frames true to send the consecutive frames
+         * @param s socket used to send the frames
+         * @return Returns the number of frames sent
          */
-        struct can_frame createFrame(int& id, std::vector<uint8_t>& data, FrameType frameType = DATA_FRAME);
+        int sendSegmented(int id, const uint8_t* data, size_t length, bool first_frame, bool consecutive_frames, int s);
         /**
          * @brief Count the number of digits in a number
          * 
@@ -389,8 +609,9 @@ class GenerateFrames
          * @param id id of the frame(sender id and receiver id)
          * @param data Data to be put in to the frame
          * @param first_frame set as true if it is the first frame (default) or false for the rest of the frames.
+         * @param on_done called with the result of the transmission, when first_frame is true (optional)
          */
-        void GenerateConsecutiveFrames(int id, std::vector<uint8_t> data, bool first_frame);
+        void GenerateConsecutiveFrames(int id, const std::vector<uint8_t>& data, bool first_frame, IsoTpTransmitter::CompletionCallback on_done = nullptr);
 };
 
 #endif
\ No newline at end of file
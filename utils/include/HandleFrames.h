@@ -22,6 +22,8 @@
 #include <chrono>
 
 #include "ReadDataByIdentifier.h"
+#include "ReadDataByPeriodicIdentifier.h"
+#include "DynamicallyDefineDataIdentifier.h"
 #include "WriteDataByIdentifier.h"
 #include "EcuReset.h"
 #include "TesterPresent.h"
@@ -36,6 +38,9 @@
 #include "TransferData.h"
 #include "ClearDtc.h"
 #include "MemoryManager.h"
+#include "IsoTpReassembler.h"
+#include "IsoTpTransmitter.h"
+#include "CanFd.h"
 
 class HandleFrames 
 {
@@ -44,6 +49,17 @@ private:
     int _socket = -1;
     Logger& _logger;
     DiagnosticSessionControl mcuDiagnosticSessionControl;
+    /* Reassembly contexts of the multi-frame sequences, one per sender */
+    IsoTpReassembler iso_tp;
+
+    /**
+     * @brief Method used to send the flow control frame prepared by the reassembler
+     * back to the sender of a multi-frame sequence.
+     *
+     * @param[in] can_socket The socket identifier used to communicate over the CAN bus.
+     * @param[in] result The result of the reassembler holding the flow control frame.
+    */
+    void sendFlowControl(int can_socket, const IsoTpReassembler::Result& result);
 public:
     /**
      * @brief Default constructor for Handle Frames object.
@@ -55,12 +71,23 @@ public:
     /**
      * @brief Method used to handle a can frame received from the ReceiveFrame class.
      * Takes a can_frame as parameter, checks if the frame is complete and then calls
-     * processFrameData() with either a single or multi frame.
+     * processFrameData() with either a single or multi frame. First and consecutive
+     * frames are reassembled per sender (ISO-TP), a flow control frame is sent back
+     * after the first frame and after every block.
      * 
      * @param[in] can_socket The socket identifier used to communicate over the CAN bus.
      * @param[in] frame The received frame.
     */
     void handleFrame(int can_socket, const struct can_frame &frame);
+    /**
+     * @brief Method used to handle a CAN FD frame, or a classic frame in the CAN FD layout.
+     * Besides the classic single frames, accepts the CAN FD single frames
+     * (0x00, SF_DL, up to 62 bytes) and the first/consecutive frames of up to 64 bytes.
+     * 
+     * @param[in] can_socket The socket identifier used to communicate over the CAN bus.
+     * @param[in] frame The received frame.
+    */
+    void handleFrame(int can_socket, const struct canfd_frame &frame);
     /**
      * @brief Method used to call a service or handle a response.
      * It takes frame_id, service id(sid) and frame_data and calls the right service or
@@ -0,0 +1,113 @@
+/**
+ * @file ImageDigest.h
+ * @brief Streaming digest of a software image, updated block by block during the transfer.
+ * The CRC32C (Castagnoli) uses the SSE4.2 crc32 instruction when the CPU has it (checked at run time)
+ * or the ARMv8 CRC instructions when the build targets them, and a table (slicing-by-8) otherwise.
+ * A SHA-256 of the image can be computed as well.
+ * The digest record sent after the last transfer data block and stored after the image is:
+ *     {IMAGE_DIGEST_CRC32C, CRC32C (4 bytes, MSB first)}
+ *     {IMAGE_DIGEST_CRC32C_SHA256, CRC32C (4 bytes, MSB first), SHA-256 (32 bytes)}
+ * How to use example:
+ *     ImageDigest digest(true);
+ *     digest.update(block.data(), block.size());    ... for every block ...
+ *     std::vector<uint8_t> record = digest.getRecord();
+ *     bool valid = digest.matches(received_record);
+ * @version 0.1
+ * @date 2024-09-06
+ * @copyright Copyright (c) 2024
+ */
+#ifndef POC_INCLUDE_IMAGE_DIGEST_H_
+#define POC_INCLUDE_IMAGE_DIGEST_H_
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+/* First byte of the digest record */
+#define IMAGE_DIGEST_CRC32C 0x01
+#define IMAGE_DIGEST_CRC32C_SHA256 0x02
+#define IMAGE_DIGEST_CRC32C_LENGTH 4
+#define IMAGE_DIGEST_SHA256_LENGTH 32
+
+class ImageDigest
+{
+public:
+    /**
+     * @brief Constructor.
+     *
+     * @param sha256 True to compute the SHA-256 of the image as well as the CRC32C.
+     */
+    explicit ImageDigest(bool sha256 = false);
+
+    /**
+     * @brief Starts a new image.
+     *
+     * @param sha256 True to compute the SHA-256 of the image as well as the CRC32C.
+     */
+    void reset(bool sha256);
+
+    /**
+     * @brief Adds the next bytes of the image.
+     */
+    void update(const uint8_t* data, size_t size);
+
+    /**
+     * @brief Get method for the CRC32C of the bytes added so far.
+     */
+    uint32_t getCrc32c() const;
+
+    /**
+     * @brief Get method for the SHA-256 of the bytes added so far (the digest itself is not finalized).
+     *
+     * @return Returns the 32 bytes of the SHA-256, empty if it is not computed.
+     */
+    std::vector<uint8_t> getSha256() const;
+
+    /**
+     * @brief Get method for the number of bytes added so far.
+     */
+    uint64_t getLength() const;
+
+    /**
+     * @brief Builds the digest record of the bytes added so far.
+     */
+    std::vector<uint8_t> getRecord() const;
+
+    /**
+     * @brief Compares a received digest record with the digest of the bytes added so far.
+     *      A CRC32C-only record is compared on the CRC32C.
+     *
+     * @return Returns true if the record is valid and matches.
+     */
+    bool matches(const std::vector<uint8_t>& record) const;
+
+    /**
+     * @brief Returns the length of a digest record from its first byte, 0 for an unknown type.
+     */
+    static size_t getRecordLength(uint8_t type);
+
+    /**
+     * @brief Updates a CRC32C (no initial or final inversion), with the fastest implementation available.
+     */
+    static uint32_t updateCrc32c(uint32_t crc, const uint8_t* data, size_t size);
+
+    /**
+     * @brief Checks if the CRC32C uses CPU instructions.
+     */
+    static bool hasHardwareCrc32c();
+
+private:
+    /**
+     * @brief Processes one 64-byte block of the SHA-256.
+     */
+    static void sha256Transform(uint32_t state[8], const uint8_t block[64]);
+
+    uint32_t crc = 0xFFFFFFFF;
+    uint64_t length = 0;
+    bool sha256_enabled = false;
+    uint32_t sha256_state[8];
+    uint8_t sha256_block[64];
+    size_t sha256_block_size = 0;
+};
+
+#endif /* POC_INCLUDE_IMAGE_DIGEST_H_ */
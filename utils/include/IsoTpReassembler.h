@@ -0,0 +1,215 @@
+/**
+ * @file IsoTpReassembler.h
+ * @brief Receive side of ISO 15765-2 (ISO-TP): rebuilds the multi-frame messages.
+ * Every (sender, receiver) pair of CAN ids gets its own reassembly context, so several
+ * testers can stream long DID, DTC or TransferData messages at the same time. The contexts
+ * come from a fixed pool and their buffers are preallocated for the 12-bit FF_DL (4095 bytes);
+ * a 32-bit FF_DL (escape sequence) grows the buffer up to ISOTP_MAX_MESSAGE_SIZE.
+ * After the first frame, and after every block of block_size consecutive frames, a flow
+ * control frame (ContinueToSend, BS, STmin) is prepared for the sender. A context whose
+ * next consecutive frame does not arrive within N_Cr is dropped.
+ * CAN FD frames are accepted too: the first and consecutive frames then carry up to
+ * 64 bytes (the length of the first frame is the TX_DL of the sender).
+ *
+ * The reassembled message keeps the layout of a single frame, so the services can index it
+ * the same way: message[0] is the low byte of FF_DL, followed by the FF_DL payload bytes
+ * (message[1] is the SID). message[0] is not the length of a message longer than 255 bytes,
+ * so the services take the length from message.size() and check message[0] only for a
+ * single frame.
+ * How to use example:
+ *     IsoTpReassembler iso_tp;
+ *     std::vector<uint8_t> message;
+ *     IsoTpReassembler::Result result = iso_tp.handleFrame(frame, message);
+ *     if (result.send_flow_control) { ... send result.flow_control to result.flow_control_id ... }
+ *     if (result.status == IsoTpReassembler::COMPLETE) { ... process message ... }
+ * @version 0.1
+ * @date 2024-08-28
+ * @copyright Copyright (c) 2024
+ */
+#ifndef POC_INCLUDE_ISO_TP_REASSEMBLER_H_
+#define POC_INCLUDE_ISO_TP_REASSEMBLER_H_
+
+#include <linux/can.h>
+#include <array>
+#include <mutex>
+#include <chrono>
+#include <vector>
+#include <cstdint>
+
+/* Number of messages that can be reassembled at the same time */
+#define ISOTP_MAX_CONTEXTS 16
+/* Largest FF_DL of a 12-bit first frame, preallocated for every context */
+#define ISOTP_MAX_12BIT_LENGTH 4095
+/* Largest FF_DL accepted with the 32-bit escape sequence */
+#define ISOTP_MAX_MESSAGE_SIZE 0x10000
+/* N_Cr: time the receiver waits for the next consecutive frame */
+#define ISOTP_N_CR_TIMEOUT_MS 1000
+/* Block size sent in the flow control frames, 0 = send all the frames without waiting */
+#define ISOTP_DEFAULT_BLOCK_SIZE 0
+/* Minimum separation time sent in the flow control frames, in milliseconds */
+#define ISOTP_DEFAULT_ST_MIN 0
+
+/* Flow status of the flow control frame */
+#define ISOTP_FLOW_CONTINUE 0x30
+#define ISOTP_FLOW_WAIT 0x31
+#define ISOTP_FLOW_OVERFLOW 0x32
+
+class IsoTpReassembler
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    enum Status
+    {
+        /* Not a first or consecutive frame, or a first frame with an invalid FF_DL */
+        IGNORED,
+        /* First frame accepted, the context is waiting for the consecutive frames */
+        FIRST_FRAME,
+        /* Consecutive frame appended, more are expected */
+        IN_PROGRESS,
+        /* Last consecutive frame received, the message is complete */
+        COMPLETE,
+        /* Consecutive frame without a first frame for its CAN id */
+        NO_CONTEXT,
+        /* Consecutive frame received after N_Cr, the context was dropped */
+        TIMEOUT,
+        /* Consecutive frame with the wrong sequence number, the context was dropped */
+        WRONG_SEQUENCE,
+        /* FF_DL too big or no free context, an overflow flow control is sent */
+        BUFFER_OVERFLOW
+    };
+
+    struct Result
+    {
+        Status status = IGNORED;
+        /* FF_DL of the message */
+        size_t message_length = 0;
+        /* Number of frames of the message, first frame included */
+        size_t frame_count = 0;
+        /* PCI byte expected and received, set for WRONG_SEQUENCE */
+        uint8_t expected_pci = 0;
+        uint8_t received_pci = 0;
+        /* Flow control frame to send back to the sender */
+        bool send_flow_control = false;
+        canid_t flow_control_id = 0;
+        std::array<uint8_t, 3> flow_control = {};
+    };
+
+    /**
+     * @brief Parameterized constructor. Preallocates the buffers of all the contexts.
+     *
+     * @param block_size Number of consecutive frames sent between two flow control frames.
+     * @param st_min Minimum separation time between two consecutive frames (STmin encoding).
+     * @param n_cr_ms Time to wait for the next consecutive frame.
+     */
+    explicit IsoTpReassembler(uint8_t block_size = ISOTP_DEFAULT_BLOCK_SIZE, uint8_t st_min = ISOTP_DEFAULT_ST_MIN,
+                              unsigned n_cr_ms = ISOTP_N_CR_TIMEOUT_MS);
+
+    IsoTpReassembler(const IsoTpReassembler&) = delete;
+    IsoTpReassembler& operator=(const IsoTpReassembler&) = delete;
+
+    /**
+     * @brief Handles a first or a consecutive frame.
+     *
+     * @param[in] frame The received frame.
+     * @param[out] message Filled with the whole message when the status is COMPLETE.
+     * @return Returns the status of the frame and the flow control frame to send, if any.
+     */
+    Result handleFrame(const struct can_frame& frame, std::vector<uint8_t>& message);
+
+    /**
+     * @brief Handles a first or a consecutive frame received in the CAN FD layout.
+     *
+     * @param[in] frame The received frame (classic or CAN FD).
+     * @param[out] message Filled with the whole message when the status is COMPLETE.
+     * @return Returns the status of the frame and the flow control frame to send, if any.
+     */
+    Result handleFrame(const struct canfd_frame& frame, std::vector<uint8_t>& message);
+
+    /**
+     * @brief Set method for the parameters sent in the next flow control frames.
+     *
+     * @param block_size Number of consecutive frames between two flow control frames.
+     * @param st_min Minimum separation time (STmin encoding).
+     */
+    void setFlowControl(uint8_t block_size, uint8_t st_min);
+
+    /**
+     * @brief Get method for the number of messages being reassembled (expired ones included
+     * until their context is reused).
+     *
+     * @return Returns the number of active contexts.
+     */
+    size_t getActiveCount() const;
+
+    /**
+     * @brief Builds the CAN id of the answer to a frame: sender and receiver are swapped,
+     * the other bits are kept.
+     *
+     * @param can_id The CAN id of the received frame.
+     * @return Returns the CAN id to answer on.
+     */
+    static canid_t reverseId(canid_t can_id);
+
+private:
+    struct Context
+    {
+        /* CAN id of the frames, without the EFF flag */
+        canid_t id = 0;
+        bool active = false;
+        /* Message in the layout given to the services, see above */
+        std::vector<uint8_t> buffer;
+        size_t expected_length = 0;
+        /* Sequence number of the next consecutive frame (0..15) */
+        uint8_t next_sequence = 1;
+        /* Consecutive frames received in the current block */
+        uint8_t block_count = 0;
+        /* Block size announced in the last flow control frame */
+        uint8_t block_size = 0;
+        Clock::time_point deadline;
+    };
+
+    std::array<Context, ISOTP_MAX_CONTEXTS> contexts;
+    uint8_t block_size;
+    uint8_t st_min;
+    unsigned n_cr_ms;
+    mutable std::mutex contexts_mutex;
+
+    /**
+     * @brief Opens (or restarts) the context of the sender with a first frame.
+     *
+     * @param frame The first frame.
+     * @param length Number of valid bytes in the frame.
+     */
+    Result handleFirstFrame(const struct canfd_frame& frame, size_t length);
+
+    /**
+     * @brief Appends a consecutive frame to the context of the sender.
+     *
+     * @param frame The consecutive frame.
+     * @param length Number of valid bytes in the frame.
+     * @param message Filled with the whole message when the last frame is received.
+     */
+    Result handleConsecutiveFrame(const struct canfd_frame& frame, size_t length, std::vector<uint8_t>& message);
+
+    /**
+     * @brief Looks for the context of a CAN id. Called with contexts_mutex locked.
+     *
+     * @return Returns the active context of the id, or nullptr.
+     */
+    Context* findContext(canid_t id);
+
+    /**
+     * @brief Takes a free or expired context for a new message. Called with contexts_mutex locked.
+     *
+     * @return Returns the context, or nullptr if all of them are busy.
+     */
+    Context* acquireContext(canid_t id, Clock::time_point now);
+
+    /**
+     * @brief Fills the flow control frame of the result.
+     */
+    void setFlowControlFrame(Result& result, canid_t id, uint8_t flow_status) const;
+};
+
+#endif /* POC_INCLUDE_ISO_TP_REASSEMBLER_H_ */
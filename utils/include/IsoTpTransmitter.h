@@ -0,0 +1,196 @@
+/**
+ * @file IsoTpTransmitter.h
+ * @brief Send side of ISO 15765-2 (ISO-TP): sends the multi-frame messages following the
+ * flow control frames of the receiver.
+ * send() writes the first frame and returns; the service thread is never blocked. When the
+ * flow control frame of the receiver arrives (handed over by HandleFrames), the consecutive
+ * frames are sent block by block (BS frames, then wait for the next flow control frame).
+ * The separation time (STmin) between two consecutive frames is served by a TimerWheel
+ * instead of sleeping. If the receiver does not answer within N_Bs, or answers with an
+ * overflow, the transmission is dropped. The completion callback of the service is called
+ * once, with the result of the transmission.
+ * There is one transmitter per process, shared by all the services and sockets; the
+ * transmissions are identified by their CAN id.
+ * If the receiver talks CAN FD (see CanFd.h), the frames carry up to 64 bytes: single
+ * frames up to 62 bytes, then first and consecutive frames of 64 bytes.
+ * How to use example:
+ *     IsoTpTransmitter::getInstance().send(socket, 0x10FA, payload, logger,
+ *         [](IsoTpTransmitter::TransmitStatus status) { ... });
+ *     IsoTpTransmitter::getInstance().onFlowControl(frame);   // in HandleFrames
+ * @version 0.1
+ * @date 2024-08-29
+ * @copyright Copyright (c) 2024
+ */
+#ifndef POC_INCLUDE_ISO_TP_TRANSMITTER_H_
+#define POC_INCLUDE_ISO_TP_TRANSMITTER_H_
+
+#include <linux/can.h>
+#include <mutex>
+#include <vector>
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+
+#include "Logger.h"
+#include "TimerWheel.h"
+
+/* N_Bs: time the sender waits for a flow control frame */
+#define ISOTP_N_BS_TIMEOUT_MS 1000
+/* Number of flow control WAIT frames accepted in a row before giving up */
+#define ISOTP_MAX_WAIT_FRAMES 10
+/* Resolution of the separation time between two consecutive frames */
+#define ISOTP_TX_TICK_MS 1
+
+class IsoTpTransmitter
+{
+public:
+    enum TransmitStatus
+    {
+        /* All the consecutive frames were sent */
+        COMPLETE,
+        /* No flow control frame within N_Bs, or too many WAIT frames */
+        TIMEOUT,
+        /* The receiver has no buffer for the message */
+        RECEIVER_OVERFLOW,
+        /* Replaced by a new message on the same CAN id, or invalid flow status */
+        ABORTED,
+        /* The socket refused a frame */
+        SEND_ERROR
+    };
+
+    /* Called once per message, from the thread that ends the transmission */
+    using CompletionCallback = std::function<void(TransmitStatus)>;
+
+    /**
+     * @brief Get method for the transmitter of the process. Starts its timer wheel on first use.
+     *
+     * @return Returns the transmitter.
+     */
+    static IsoTpTransmitter& getInstance();
+
+    IsoTpTransmitter(const IsoTpTransmitter&) = delete;
+    IsoTpTransmitter& operator=(const IsoTpTransmitter&) = delete;
+
+    /**
+     * @brief Sends the first frame of a message and waits (without blocking) for the flow
+     * control frame of the receiver. A message still in progress on the same CAN id is aborted.
+     *
+     * @param s The socket the frames are written to.
+     * @param id The CAN id of the frames.
+     * @param payload The message, without PCI (the first byte is the SID).
+     * @param logger The logger of the calling service (copied for the transmission).
+     * @param on_done Called with the result of the transmission (optional).
+     * @return Returns false if the first frame could not be sent (on_done is called too).
+     */
+    bool send(int s, canid_t id, std::vector<uint8_t> payload, Logger& logger, CompletionCallback on_done = nullptr);
+
+    /**
+     * @brief Handles a flow control frame received from the receiver of a message.
+     *
+     * @param frame The flow control frame.
+     * @return Returns true if the frame belongs to a message waiting for it.
+     */
+    bool onFlowControl(const struct can_frame& frame);
+
+    /**
+     * @brief Handles a flow control frame received in the CAN FD layout.
+     *
+     * @param frame The flow control frame (classic or CAN FD).
+     * @return Returns true if the frame belongs to a message waiting for it.
+     */
+    bool onFlowControl(const struct canfd_frame& frame);
+
+    /**
+     * @brief Checks if a message is being sent on a CAN id.
+     *
+     * @param id The CAN id of the frames.
+     * @return Returns true until the transmission ends.
+     */
+    bool isBusy(canid_t id) const;
+
+    /**
+     * @brief Get method for the number of messages being sent.
+     *
+     * @return Returns the number of transmissions in progress.
+     */
+    size_t getActiveCount() const;
+
+    /**
+     * @brief Converts an STmin value of a flow control frame to milliseconds.
+     * The 100-900 microseconds values are rounded up to 1 ms, the reserved values
+     * give the maximum of 127 ms.
+     *
+     * @param st_min The STmin byte.
+     * @return Returns the separation time in milliseconds.
+     */
+    static unsigned decodeStMin(uint8_t st_min);
+
+private:
+    struct Session
+    {
+        int socket = -1;
+        canid_t id = 0;
+        /* Copy of the logger of the service, the service may be gone when the transmission ends */
+        Logger logger;
+        std::vector<uint8_t> payload;
+        size_t offset = 0;
+        /* TX_DL: length of the first and consecutive frames */
+        size_t frame_length = CAN_MAX_DLEN;
+        /* Sequence number of the next consecutive frame (0..15) */
+        uint8_t sequence = 1;
+        /* Parameters of the last flow control frame */
+        uint8_t block_size = 0;
+        unsigned st_min_ms = 0;
+        /* Consecutive frames sent in the current block */
+        uint8_t block_sent = 0;
+        unsigned wait_count = 0;
+        bool waiting_flow_control = true;
+        /* Changed on every step, so older timer entries do nothing */
+        uint32_t generation = 0;
+        CompletionCallback on_done;
+    };
+
+    /* Result of a transmission, reported once the lock is released */
+    struct Completion
+    {
+        CompletionCallback on_done;
+        TransmitStatus status = COMPLETE;
+    };
+
+    std::unordered_map<canid_t, Session> sessions;
+    uint32_t next_generation = 0;
+    TimerWheel wheel;
+    mutable std::mutex sessions_mutex;
+
+    IsoTpTransmitter();
+    ~IsoTpTransmitter();
+
+    /**
+     * @brief Sends the next consecutive frames of the block: all of them at once without
+     * STmin, otherwise one and schedules the next. Called with sessions_mutex locked.
+     *
+     * @param session The session to continue.
+     * @return Returns the completion to report if the transmission ended.
+     */
+    Completion sendBlock(Session& session);
+
+    /**
+     * @brief Starts N_Bs for a session waiting for a flow control frame.
+     * Called with sessions_mutex locked.
+     */
+    void armFlowControlTimeout(Session& session);
+
+    /**
+     * @brief Ends a session. Called with sessions_mutex locked.
+     *
+     * @return Returns the completion to report.
+     */
+    Completion finish(canid_t id, TransmitStatus status);
+
+    /**
+     * @brief Calls the completion callback, without the lock.
+     */
+    static void notify(Completion& completion);
+};
+
+#endif /* POC_INCLUDE_ISO_TP_TRANSMITTER_H_ */
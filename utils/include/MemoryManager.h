@@ -81,6 +81,8 @@
 #include <fcntl.h>
 
 #include "Logger.h"
+#include "DeviceSession.h"
+#include "WriteBehind.h"
 
 #define DEV_LOOP "/dev/loop20"
 
@@ -104,22 +106,18 @@ class MemoryManager
         off_t address_continue_to_write = -1;
         static MemoryManager* instance;
         Logger& logger;
+        /* Device kept open between the writes, with its partition table read once */
+        DeviceSession device;
+        /* Staged writes of the current transfer, written by the I/O thread */
+        WriteBehind write_behind;
+        bool staging = false;
 
         /**
-         * @brief Method to transform a string number to type integer
+         * @brief Method to open the device of the current path, if it is not already opened
          * 
-         * @param number 
-         * @return int 
+         * @return true if the device is opened
          */
-        int to_int(std::string number);
-
-        /**
-         * @brief Method to run a command in the bash terminal
-         * 
-         * @param command 
-         * @return std::string 
-         */
-        std::string runCommand(char command[]);
+        bool openDevice();
 
     public:
         /**
@@ -194,7 +192,8 @@ class MemoryManager
         static std::vector<uint8_t> readBinary(std::string path_to_binary, Logger& logger);
 
         /**
-         * @brief Method to check if the address is available
+         * @brief Method to check if the address is available (not in the boot partition).
+         *      The partition table is read once, when the device is opened.
          * 
          * @param address 
          * @return true or false
@@ -202,7 +201,8 @@ class MemoryManager
         bool availableAddress(off_t address);
 
         /**
-         * @brief Method to check if the amount of memory is available
+         * @brief Method to check if the amount of memory is available after the current write address,
+         *      in the partition that holds it
          * 
          * @param size_of_data 
          * @return true or false
@@ -228,6 +228,32 @@ class MemoryManager
          */
         bool writeToAddress(std::vector<uint8_t> &data);
 
+        /**
+         * @brief Method to stage data after the last written data. The data is written on the device
+         *      by the write-behind I/O thread; the caller does not wait for the device.
+         * 
+         * @param data Pointer to the data to be written
+         * @param size Number of bytes
+         * @return true -if data was staged or false -if the address is not valid or a previous write failed
+         */
+        bool stageWrite(const uint8_t* data, size_t size);
+
+        /**
+         * @brief Method to write all the staged data on the device and sync it (barrier used by Request Transfer Exit).
+         * 
+         * @return true -if all the staged data is on the device or false -if a write failed
+         */
+        bool flushStagedWrites();
+
+        /**
+         * @brief Method to continue the writes after data that is already on the device, used when an
+         *      interrupted transfer is resumed. The staged data is written first.
+         * 
+         * @param size Number of bytes kept on the device
+         * @return true -if the staged data was written or false -if a write failed
+         */
+        bool skipWrite(size_t size);
+
         /**
          * @brief Method to write data in a specific file. This is a static method.
          * 
@@ -0,0 +1,180 @@
+/**
+ * @file PeriodicScheduler.h
+ * @brief Scheduler of the ReadDataByPeriodicIdentifier (0x2A) service: pushes the values of the
+ * subscribed DIDs to the testers at a slow, medium or fast rate, without any request.
+ * There is one scheduler per process, so one per ECU. Each rate has a recurring deadline in a
+ * TimerWheel; when it expires, the values of all the DIDs of the rate are read from the DID
+ * database of the module (DidStore, no lock, no file parsing) and their periodic frames are sent
+ * together, with one sendmmsg() per socket. The next deadline is computed from the previous one,
+ * not from the end of the sends, so the period does not drift.
+ * The subscriptions are kept per tester (CAN id of the periodic frames) and DID; a DID subscribed
+ * again by the same tester only changes its rate. The scheduled frames per second are capped by
+ * PERIODIC_MAX_FRAMES_PER_SECOND, so the periodic traffic keeps a bounded part of the bus.
+ * Periodic frame: frame.data = {PCI_L(1byte), 0x6A, DID(2bytes), DATA(up to 4 bytes)}
+ * How to use example:
+ *     PeriodicScheduler& scheduler = PeriodicScheduler::getInstance();
+ *     scheduler.subscribe(socket, 0x11FA, file_name, {0x01B0, 0x01C0}, PeriodicScheduler::FAST_RATE, logger);
+ *     scheduler.unsubscribe(0x11FA, {0x01B0});
+ *     scheduler.unsubscribe(0x11FA);   // all the DIDs of the tester
+ * @version 0.1
+ * @date 2024-09-17
+ * @copyright Copyright (c) 2024
+ */
+#ifndef POC_INCLUDE_PERIODIC_SCHEDULER_H_
+#define POC_INCLUDE_PERIODIC_SCHEDULER_H_
+
+#include <linux/can.h>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "Logger.h"
+#include "TimerWheel.h"
+
+/* Periods of the transmission rates */
+#define PERIODIC_SLOW_RATE_MS 1000
+#define PERIODIC_MEDIUM_RATE_MS 200
+#define PERIODIC_FAST_RATE_MS 50
+/* Maximum number of scheduled DIDs, all the testers together */
+#define PERIODIC_MAX_DIDS 16
+/* Bus budget of the periodic frames of the module */
+#define PERIODIC_MAX_FRAMES_PER_SECOND 100
+/* Longest value sent in a periodic frame (single frame) */
+#define PERIODIC_MAX_DATA_LENGTH 4
+
+class PeriodicScheduler
+{
+public:
+    /* Transmission modes of the 0x2A request */
+    enum Rate : uint8_t
+    {
+        SLOW_RATE = 0x01,
+        MEDIUM_RATE = 0x02,
+        FAST_RATE = 0x03
+    };
+
+    enum Status
+    {
+        ACCEPTED,
+        /* More than PERIODIC_MAX_DIDS scheduled DIDs */
+        TOO_MANY_DIDS,
+        /* More than PERIODIC_MAX_FRAMES_PER_SECOND */
+        BUDGET_EXCEEDED,
+        /* The timer wheel could not be started */
+        NOT_RUNNING
+    };
+
+    /**
+     * @brief Get method for the scheduler of the process. Starts its timer wheel on first use.
+     *
+     * @return Returns the scheduler.
+     */
+    static PeriodicScheduler& getInstance();
+
+    PeriodicScheduler(const PeriodicScheduler&) = delete;
+    PeriodicScheduler& operator=(const PeriodicScheduler&) = delete;
+
+    /**
+     * @brief Schedules DIDs for a tester. Either all the DIDs are scheduled or none of them.
+     *
+     * @param s The socket the periodic frames are written to.
+     * @param response_id The CAN id of the periodic frames (server id and tester id).
+     * @param file_name The DID database the values are read from.
+     * @param dids The DIDs to send.
+     * @param rate The transmission rate of the DIDs.
+     * @param logger The logger of the calling service (copied for the transmissions).
+     * @return Returns ACCEPTED, or the reason the DIDs were not scheduled.
+     */
+    Status subscribe(int s, canid_t response_id, const std::string& file_name, const std::vector<uint16_t>& dids, Rate rate, Logger& logger);
+
+    /**
+     * @brief Stops sending DIDs to a tester.
+     *
+     * @param response_id The CAN id of the periodic frames of the tester.
+     * @param dids The DIDs to stop; all the DIDs of the tester if empty.
+     * @return Returns the number of DIDs no longer sent.
+     */
+    size_t unsubscribe(canid_t response_id, const std::vector<uint16_t>& dids = {});
+
+    /**
+     * @brief Stops sending all the DIDs, to all the testers.
+     */
+    void clear();
+
+    /**
+     * @brief Get method for the number of scheduled DIDs, all the testers together.
+     */
+    size_t getSubscriptionCount() const;
+
+    /**
+     * @brief Get method for the periodic frames sent per second by the current subscriptions.
+     */
+    unsigned getFramesPerSecond() const;
+
+    /**
+     * @brief Get method for the period of a rate.
+     *
+     * @param rate The transmission rate.
+     * @return Returns the period in milliseconds.
+     */
+    static unsigned getPeriodMs(Rate rate);
+
+private:
+    struct Subscription
+    {
+        int socket = -1;
+        canid_t response_id = 0;
+        std::string file_name;
+        uint16_t did = 0;
+        Rate rate = SLOW_RATE;
+    };
+
+    /* Recurring deadline of a rate */
+    struct RateTimer
+    {
+        bool armed = false;
+        /* Changed when the timer is armed or cleared, so older wheel entries do nothing */
+        std::atomic<uint32_t> generation{0};
+        std::chrono::steady_clock::time_point next_due;
+    };
+
+    std::vector<Subscription> subscriptions;
+    /* One timer per rate, indexed by rate - 1 */
+    std::array<RateTimer, 3> timers;
+    /* Copy of the logger of the last subscriber */
+    Logger logger;
+    TimerWheel wheel;
+    mutable std::mutex scheduler_mutex;
+
+    PeriodicScheduler();
+    ~PeriodicScheduler();
+
+    /**
+     * @brief Frames per second of a set of subscriptions.
+     */
+    static unsigned framesPerSecond(const std::vector<Subscription>& subscriptions);
+
+    /**
+     * @brief Arms the timer of a rate if it is not armed. Called with scheduler_mutex locked.
+     */
+    void arm(Rate rate);
+
+    /**
+     * @brief Sends the periodic frames of a rate and arms its next deadline.
+     *
+     * @param rate The transmission rate.
+     * @param generation The generation of the timer when the deadline was armed.
+     */
+    void onTick(Rate rate, uint32_t generation);
+
+    /**
+     * @brief Reads the values of the DIDs and sends their periodic frames, one batch per socket.
+     */
+    void send(const std::vector<Subscription>& due, Logger& tick_logger);
+};
+
+#endif /* POC_INCLUDE_PERIODIC_SCHEDULER_H_ */
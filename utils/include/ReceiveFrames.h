@@ -32,9 +32,13 @@
 #include <poll.h> 
 #include <future>
 #include <set>
+#include <array>
 
 #include "HandleFrames.h"
 #include "GenerateFrames.h"
+#include "FrameBatchReader.h"
+#include "FrameRingBuffer.h"
+#include "TimerWheel.h"
 #include "Logger.h"
 
 /* List of service we have implemented. */
@@ -45,6 +49,10 @@ const std::vector<uint8_t> service_sids = {
     0x10,
     /* Read Data By Identifier */
     0x22,
+    /* Read Data By Periodic Identifier */
+    0x2A,
+    /* Dynamically Define Data Identifier */
+    0x2C,
     /* Authentication */
     0x27,
     /* Routine Control (Testing) -> will be decided */
@@ -79,6 +87,10 @@ static const std::set<uint8_t> sids_using_p2_max_time = {
     0x10,
     /* Read Data By Identifier */
     0x22,
+    /* Read Data By Periodic Identifier */
+    0x2A,
+    /* Dynamically Define Data Identifier */
+    0x2C,
     /* Tester Present */
     0x3E,
     /* Read Memory By Address */
@@ -115,20 +127,30 @@ private:
     int socket = -1;             
     /* Battery Module ID for filtering frames for this module */              
     int current_module_id;                 
-    /* Define frame_buffer as a deque of tuples */ 
-    std::deque<std::tuple<can_frame, int>> frame_buffer; 
-    /* Mutex for ensuring thread safety when accessing the frame buffer */   
-    std::mutex mtx;              
-    /* Condition variable for thread synchronization */                 
-    std::condition_variable cv;               
+    /* Frames waiting to be processed, with the kernel receive timestamp */ 
+    FrameRingBuffer frame_buffer; 
     /* Flag indicating whether the receive threads should continue running */     
     std::atomic<bool> running;                
     /* Thread for buffering in receiving frames */                
     std::thread bufferFrameInThread;
     /* The logger used to write the logs. */
     Logger& receive_logger;
+    /* Reads the frames from the socket in batches */
+    FrameBatchReader frame_reader;
     /* Update security for ECU based on notify */
     static bool ecu_state;
+    /* P2/P2* response deadlines of the requests being processed */
+    TimerWheel response_timers;
+    /* Incremented each time a SID is armed, so a stale deadline does not fire for a newer request */
+    std::array<std::atomic<uint32_t>, SID_COUNT> timer_generations{};
+
+    /**
+     * @brief Checks if the id belongs to one of the ECUs (Battery, Engine, Doors, HVAC).
+     * 
+     * @param module_id The id to check.
+     * @return Returns true for a known ECU id.
+     */
+    static bool isEcuId(uint8_t module_id);
 
     /**
      * @brief bufferFrameIn thread function that reads frames from the socket and adds them to the buffer.
@@ -166,7 +188,7 @@ public:
      * 
      * @param frame The CAN frame to be printed.
      */
-    void printFrame(const struct can_frame &frame);
+    void printFrame(const struct canfd_frame &frame);
 
     /**
      * @brief Gets the current state of the ecu security system.
@@ -187,15 +209,51 @@ public:
      */
     void receive(HandleFrames &handle_frame);
 
-    /* Method that start time processing frame. */
+    /* Method that start time processing frame: arms the P2/P2* deadline of the SID in the timer wheel. */
     void startTimer(uint8_t frame_dest_id, uint8_t sid);
-    /* Method that stop time processing frame. */
+    /* Method that stop time processing frame: sends the response pending frame if the SID is still pending. */
     void stopTimer(uint8_t frame_dest_id, uint8_t sid);
 
+    /**
+     * @brief Get method for the number of deadlines in the timer wheel.
+     * 
+     * @return Returns the number of armed response timers.
+     */
+    size_t getPendingTimers() const;
+
     /**
      * @brief Stops the receive process gracefully.
      */
     void stop();
+
+    /**
+     * @brief Set the maximum number of frames read from the socket with one syscall.
+     * Must be called before the receive loop is started.
+     * 
+     * @param batch_size The new batch size.
+     */
+    void setBatchSize(size_t batch_size);
+
+    /**
+     * @brief Get method for the batch size.
+     * 
+     * @return Returns the number of frames read from the socket with one syscall.
+     */
+    size_t getBatchSize() const;
+
+    /**
+     * @brief Get method for the number of frames waiting to be processed.
+     * 
+     * @return Returns the occupancy of the frame buffer.
+     */
+    size_t getQueueOccupancy() const;
+
+    /**
+     * @brief Get method for the number of frames dropped because the frame buffer was full.
+     * 
+     * @return Returns the drop counter of the frame buffer.
+     */
+    uint64_t getDroppedFrames() const;
 };
 
 #endif
\ No newline at end of file
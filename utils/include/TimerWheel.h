@@ -0,0 +1,142 @@
+/**
+ * @file TimerWheel.h
+ * @brief Hashed timing wheel driven by a timerfd, used for the P2/P2* response deadlines.
+ * One thread serves all the deadlines of a module instead of a polling thread per request.
+ * Scheduling a deadline is O(1) (append in the bucket of its expiry tick). A deadline is
+ * cancelled in O(1) by clearing the flag checked by its still_pending function (the
+ * stop_flags cleared by AccessTimingParameter::stopTimingFlag); cancelled entries are
+ * simply discarded when their bucket comes up. The timerfd ticks only while deadlines
+ * are pending, so an idle module does not wake up.
+ * How to use example:
+ *     TimerWheel wheel;
+ *     wheel.start();
+ *     wheel.schedule(2000, [] { return stop_flags[sid].load(); }, [] { sendResponsePending(); });
+ *     stop_flags[sid] = false;   // response sent in time, the deadline is dropped
+ *     wheel.stop();
+ * @version 0.1
+ * @date 2024-08-26
+ * @copyright Copyright (c) 2024
+ */
+#ifndef POC_INCLUDE_TIMER_WHEEL_H_
+#define POC_INCLUDE_TIMER_WHEEL_H_
+
+#include <vector>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+
+/* Resolution of the deadlines */
+#define DEFAULT_TIMER_WHEEL_TICK_MS 5
+/* Number of buckets; longer deadlines wrap around and wait for their round */
+#define DEFAULT_TIMER_WHEEL_SLOTS 512
+
+class TimerWheel
+{
+public:
+    /* Returns true while the deadline is still wanted */
+    using PendingCheck = std::function<bool()>;
+    /* Called from the wheel thread when a pending deadline expires */
+    using ExpiryCallback = std::function<void()>;
+
+    /**
+     * @brief Parameterized constructor. The thread is not started.
+     *
+     * @param tick_ms Resolution of the wheel in milliseconds.
+     * @param slot_count Number of buckets of the wheel.
+     */
+    explicit TimerWheel(unsigned tick_ms = DEFAULT_TIMER_WHEEL_TICK_MS, size_t slot_count = DEFAULT_TIMER_WHEEL_SLOTS);
+
+    /**
+     * @brief Destructor. Stops the thread and closes the timerfd.
+     */
+    ~TimerWheel();
+
+    TimerWheel(const TimerWheel&) = delete;
+    TimerWheel& operator=(const TimerWheel&) = delete;
+
+    /**
+     * @brief Starts the wheel thread. Does nothing if it is already running.
+     *
+     * @return Returns false if the timerfd could not be created.
+     */
+    bool start();
+
+    /**
+     * @brief Stops the wheel thread. The pending deadlines are dropped without callback.
+     */
+    void stop();
+
+    /**
+     * @brief Arms a deadline.
+     *
+     * @param delay_ms Time until the deadline, rounded up to the tick.
+     * @param still_pending Checked at expiry; if it returns false the deadline was cancelled.
+     * @param on_expiry Called from the wheel thread if the deadline is still pending.
+     * @return Returns false if the wheel is not running.
+     */
+    bool schedule(unsigned delay_ms, PendingCheck still_pending, ExpiryCallback on_expiry);
+
+    /**
+     * @brief Get method for the number of deadlines in the wheel (cancelled ones included
+     * until their bucket comes up).
+     *
+     * @return Returns the number of entries in the wheel.
+     */
+    size_t getPendingCount() const;
+
+    /**
+     * @brief Get method for the resolution of the wheel.
+     *
+     * @return Returns the tick in milliseconds.
+     */
+    unsigned getTickMs() const;
+
+    /**
+     * @brief Checks if the wheel thread is running.
+     *
+     * @return Returns true between start() and stop().
+     */
+    bool isRunning() const;
+
+private:
+    struct Entry
+    {
+        uint64_t expiry_tick;
+        PendingCheck still_pending;
+        ExpiryCallback on_expiry;
+    };
+
+    unsigned tick_ms;
+    std::vector<std::vector<Entry>> slots;
+    uint64_t current_tick;
+    size_t pending;
+    bool ticking;
+    mutable std::mutex wheel_mutex;
+    int timer_fd;
+    int wake_fd;
+    std::atomic<bool> running;
+    std::thread worker;
+
+    /**
+     * @brief Thread loop: waits on the timerfd and advances the wheel.
+     */
+    void run();
+
+    /**
+     * @brief Moves the wheel forward and runs the callbacks of the expired deadlines.
+     *
+     * @param ticks Number of ticks elapsed since the last call.
+     */
+    void advance(uint64_t ticks);
+
+    /**
+     * @brief Starts or stops the periodic timerfd. Called with wheel_mutex locked.
+     *
+     * @param enable True to tick every tick_ms, false to disarm.
+     */
+    void setTicking(bool enable);
+};
+
+#endif /* POC_INCLUDE_TIMER_WHEEL_H_ */
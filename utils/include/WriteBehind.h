@@ -0,0 +1,125 @@
+/**
+ * @file WriteBehind.h
+ * @brief Write-behind staging of the data written on the device during a transfer.
+ * The blocks received by TransferData are copied in buffers of WRITE_BEHIND_BUFFER_BYTES whose
+ * limits are aligned on the device (the first buffer ends at the first aligned offset), and the
+ * full buffers are written by a dedicated I/O thread. The CAN response of a block does not wait
+ * for the device, only for a free buffer when WRITE_BEHIND_MAX_BUFFERS are already queued.
+ * flush() is the barrier: it writes the last partial buffer, waits for the I/O thread and
+ * syncs the device. It is called by Request Transfer Exit before the positive response.
+ * How to use example:
+ *     WriteBehind write_behind(logger);
+ *     write_behind.begin(device, address);
+ *     write_behind.append(data, size);    ... for every block ...
+ *     bool written = write_behind.flush();
+ * @version 0.1
+ * @date 2024-09-05
+ * @copyright Copyright (c) 2024
+ */
+#ifndef POC_INCLUDE_WRITE_BEHIND_H_
+#define POC_INCLUDE_WRITE_BEHIND_H_
+
+#include <condition_variable>
+#include <cstdint>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Logger.h"
+#include "DeviceSession.h"
+
+/* Size and alignment of the buffers written by the I/O thread (multiple of the sector and page sizes) */
+#define WRITE_BEHIND_BUFFER_BYTES (64 * 1024)
+/* Buffers queued at most; the next block waits for the I/O thread */
+#define WRITE_BEHIND_MAX_BUFFERS 8
+
+class WriteBehind
+{
+public:
+    /**
+     * @brief Constructor. The I/O thread is started by the first begin().
+     *
+     * @param logger Logger used for the write errors.
+     */
+    explicit WriteBehind(Logger& logger);
+
+    /**
+     * @brief Destructor. The queued buffers are written before the I/O thread stops.
+     */
+    ~WriteBehind();
+
+    WriteBehind(const WriteBehind&) = delete;
+    WriteBehind& operator=(const WriteBehind&) = delete;
+
+    /**
+     * @brief Starts staging the writes of a transfer. A previous transfer is flushed first.
+     *
+     * @param device The opened device; it must stay opened until flush().
+     * @param offset Offset of the first byte written.
+     */
+    void begin(DeviceSession& device, off_t offset);
+
+    /**
+     * @brief Copies data after the previously staged data.
+     *
+     * @param data Pointer to the data.
+     * @param size Number of bytes.
+     * @return Returns false if a previous write of this transfer failed.
+     */
+    bool append(const uint8_t* data, size_t size);
+
+    /**
+     * @brief Writes all the staged data and syncs the device.
+     *
+     * @return Returns true if all the data staged since begin() is on the device.
+     */
+    bool flush();
+
+    /**
+     * @brief Checks if data was staged since the last flush().
+     */
+    bool hasPending() const;
+
+private:
+    struct Buffer
+    {
+        off_t offset = 0;
+        std::vector<uint8_t> data;
+    };
+
+    /**
+     * @brief Gets a free buffer, waits for the I/O thread if all of them are queued.
+     */
+    std::unique_ptr<Buffer> takeBuffer(std::unique_lock<std::mutex>& lock);
+
+    /**
+     * @brief Queues the current buffer for the I/O thread.
+     */
+    void queueCurrent();
+
+    /**
+     * @brief Loop of the I/O thread.
+     */
+    void run();
+
+    Logger& logger;
+    DeviceSession* device = nullptr;
+    /* Offset of the next staged byte */
+    off_t next_offset = 0;
+    std::unique_ptr<Buffer> current;
+    std::deque<std::unique_ptr<Buffer>> queue;
+    std::vector<std::unique_ptr<Buffer>> free_buffers;
+    size_t allocated_buffers = 0;
+    bool writing = false;
+    bool failed = false;
+    bool stopping = false;
+    mutable std::mutex mutex;
+    std::condition_variable work_condition;
+    std::condition_variable done_condition;
+    std::thread io_thread;
+};
+
+#endif /* POC_INCLUDE_WRITE_BEHIND_H_ */
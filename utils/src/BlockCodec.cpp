@@ -0,0 +1,262 @@
+#include "BlockCodec.h"
+
+#include <cstring>
+
+namespace
+{
+    const size_t MIN_MATCH = 4;
+    /* The last 5 bytes are always literals and the last match starts at least 12 bytes before the end */
+    const size_t LAST_LITERALS = 5;
+    const size_t MATCH_FIND_LIMIT = 12;
+    const size_t MAX_OFFSET = 65535;
+    const int HASH_LOG = 14;
+
+    inline uint32_t read32(const uint8_t* data)
+    {
+        uint32_t value;
+        memcpy(&value, data, sizeof(value));
+        return value;
+    }
+
+    inline uint32_t hashSequence(uint32_t sequence)
+    {
+        return (sequence * 2654435761u) >> (32 - HASH_LOG);
+    }
+
+    void writeLength(std::vector<uint8_t>& out, size_t length)
+    {
+        while (length >= 255)
+        {
+            out.push_back(255);
+            length -= 255;
+        }
+        out.push_back(static_cast<uint8_t>(length));
+    }
+
+    /* Token, literals and, if match_length is not 0, the match */
+    void writeSequence(std::vector<uint8_t>& out, const uint8_t* literals, size_t literal_length, size_t offset, size_t match_length)
+    {
+        size_t token_index = out.size();
+        out.push_back(0);
+        uint8_t token = static_cast<uint8_t>((literal_length < 15 ? literal_length : 15) << 4);
+        if (literal_length >= 15)
+        {
+            writeLength(out, literal_length - 15);
+        }
+        out.insert(out.end(), literals, literals + literal_length);
+        if (match_length != 0)
+        {
+            out.push_back(static_cast<uint8_t>(offset & 0xFF));
+            out.push_back(static_cast<uint8_t>(offset >> 8));
+            size_t length = match_length - MIN_MATCH;
+            token |= static_cast<uint8_t>(length < 15 ? length : 15);
+            if (length >= 15)
+            {
+                writeLength(out, length - 15);
+            }
+        }
+        out[token_index] = token;
+    }
+
+    /* Reads the extra bytes of a length, false if the input ends before */
+    bool readLength(const uint8_t* in, size_t size, size_t& index, size_t& length)
+    {
+        uint8_t byte;
+        do
+        {
+            if (index >= size)
+            {
+                return false;
+            }
+            byte = in[index++];
+            length += byte;
+        } while (byte == 255);
+        return true;
+    }
+}
+
+void BlockCodec::compress(const uint8_t* data, size_t size, std::vector<uint8_t>& compressed)
+{
+    compressed.clear();
+    compressed.reserve(size + size / 255 + 16);
+    size_t anchor = 0;
+    if (size > MATCH_FIND_LIMIT)
+    {
+        /* Position + 1 of the last sequence with each hash, 0 = empty */
+        std::vector<uint32_t> table(1 << HASH_LOG, 0);
+        size_t match_start_limit = size - MATCH_FIND_LIMIT;
+        size_t match_end_limit = size - LAST_LITERALS;
+        size_t position = 0;
+        while (position < match_start_limit)
+        {
+            uint32_t sequence = read32(data + position);
+            uint32_t& entry = table[hashSequence(sequence)];
+            size_t candidate = entry;
+            entry = static_cast<uint32_t>(position + 1);
+            if (candidate == 0 || position - (candidate - 1) > MAX_OFFSET || read32(data + candidate - 1) != sequence)
+            {
+                /* Faster steps on data that does not compress */
+                position += 1 + ((position - anchor) >> 6);
+                continue;
+            }
+            size_t reference = candidate - 1;
+            while (position > anchor && reference > 0 && data[position - 1] == data[reference - 1])
+            {
+                --position;
+                --reference;
+            }
+            size_t length = MIN_MATCH;
+            while (position + length < match_end_limit && data[position + length] == data[reference + length])
+            {
+                ++length;
+            }
+            writeSequence(compressed, data + anchor, position - anchor, position - reference, length);
+            position += length;
+            anchor = position;
+        }
+    }
+    writeSequence(compressed, data + anchor, size - anchor, 0, 0);
+}
+
+bool BlockCodec::decompress(const uint8_t* compressed, size_t compressed_size, uint8_t* data, size_t size)
+{
+    size_t in = 0;
+    size_t out = 0;
+    while (in < compressed_size)
+    {
+        uint8_t token = compressed[in++];
+        size_t literal_length = token >> 4;
+        if (literal_length == 15 && !readLength(compressed, compressed_size, in, literal_length))
+        {
+            return false;
+        }
+        if (literal_length > compressed_size - in || literal_length > size - out)
+        {
+            return false;
+        }
+        memcpy(data + out, compressed + in, literal_length);
+        in += literal_length;
+        out += literal_length;
+        if (in == compressed_size)
+        {
+            /* Last sequence, literals only */
+            break;
+        }
+
+        if (compressed_size - in < 2)
+        {
+            return false;
+        }
+        size_t offset = compressed[in] | (compressed[in + 1] << 8);
+        in += 2;
+        size_t match_length = token & 0x0F;
+        if (match_length == 15 && !readLength(compressed, compressed_size, in, match_length))
+        {
+            return false;
+        }
+        match_length += MIN_MATCH;
+        if (offset == 0 || offset > out || match_length > size - out)
+        {
+            return false;
+        }
+        uint8_t* match = data + out - offset;
+        if (offset >= match_length)
+        {
+            memcpy(data + out, match, match_length);
+        }
+        else
+        {
+            /* Overlapping match: repeats the last offset bytes */
+            for (size_t index = 0; index < match_length; ++index)
+            {
+                data[out + index] = match[index];
+            }
+        }
+        out += match_length;
+    }
+    return out == size;
+}
+
+void BlockCodec::appendFrame(const uint8_t* data, size_t size, std::vector<uint8_t>& stream)
+{
+    std::vector<uint8_t> compressed;
+    compress(data, size, compressed);
+    bool stored = compressed.size() >= size;
+    size_t payload_size = stored ? 0 : compressed.size();
+    stream.push_back(static_cast<uint8_t>((size - 1) >> 8));
+    stream.push_back(static_cast<uint8_t>((size - 1) & 0xFF));
+    stream.push_back(static_cast<uint8_t>(payload_size >> 8));
+    stream.push_back(static_cast<uint8_t>(payload_size & 0xFF));
+    if (stored)
+    {
+        stream.insert(stream.end(), data, data + size);
+    }
+    else
+    {
+        stream.insert(stream.end(), compressed.begin(), compressed.end());
+    }
+}
+
+void BlockStreamDecoder::reset()
+{
+    pending.clear();
+}
+
+bool BlockStreamDecoder::feed(const uint8_t* data, size_t size, const Sink& sink)
+{
+    /* The frames are read from the block itself, only a partial frame is copied */
+    bool buffered = !pending.empty();
+    if (buffered)
+    {
+        pending.insert(pending.end(), data, data + size);
+        data = pending.data();
+        size = pending.size();
+    }
+    size_t offset = 0;
+    bool valid = true;
+    while (size - offset >= BLOCK_CODEC_FRAME_HEADER_BYTES)
+    {
+        const uint8_t* header = data + offset;
+        size_t raw_size = ((header[0] << 8) | header[1]) + 1;
+        size_t payload_size = (header[2] << 8) | header[3];
+        size_t frame_size = BLOCK_CODEC_FRAME_HEADER_BYTES + (payload_size == 0 ? raw_size : payload_size);
+        if (size - offset < frame_size)
+        {
+            break;
+        }
+        const uint8_t* payload = header + BLOCK_CODEC_FRAME_HEADER_BYTES;
+        if (payload_size == 0)
+        {
+            valid = sink(payload, raw_size);
+        }
+        else
+        {
+            window.resize(raw_size);
+            valid = BlockCodec::decompress(payload, payload_size, window.data(), raw_size) && sink(window.data(), raw_size);
+        }
+        if (!valid)
+        {
+            break;
+        }
+        offset += frame_size;
+    }
+    if (!valid)
+    {
+        pending.clear();
+        return false;
+    }
+    if (buffered)
+    {
+        pending.erase(pending.begin(), pending.begin() + offset);
+    }
+    else
+    {
+        pending.assign(data + offset, data + size);
+    }
+    return true;
+}
+
+bool BlockStreamDecoder::isEmpty() const
+{
+    return pending.empty();
+}
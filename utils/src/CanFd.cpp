@@ -0,0 +1,104 @@
+#include "CanFd.h"
+
+#include <cstring>
+#include <algorithm>
+
+std::array<std::atomic<bool>, CAN_FD_SOCKETS> CanFd::fd_sockets{};
+std::array<std::atomic<bool>, 256> CanFd::fd_peers{};
+
+namespace
+{
+    /* Data length of every CAN FD DLC */
+    const size_t DLC_LENGTHS[16] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 12, 16, 20, 24, 32, 48, 64};
+}
+
+uint8_t CanFd::lengthToDlc(size_t length)
+{
+    uint8_t dlc = 0;
+    while (dlc < 15 && DLC_LENGTHS[dlc] < length)
+    {
+        ++dlc;
+    }
+    return dlc;
+}
+
+size_t CanFd::dlcToLength(uint8_t dlc)
+{
+    return DLC_LENGTHS[std::min<uint8_t>(dlc, 15)];
+}
+
+size_t CanFd::paddedLength(size_t length)
+{
+    return dlcToLength(lengthToDlc(length));
+}
+
+void CanFd::setSocketFd(int socket, bool enabled)
+{
+    if (socket >= 0 && socket < CAN_FD_SOCKETS)
+    {
+        fd_sockets[socket] = enabled;
+    }
+}
+
+bool CanFd::isSocketFd(int socket)
+{
+    return socket >= 0 && socket < CAN_FD_SOCKETS && fd_sockets[socket];
+}
+
+void CanFd::setPeerFd(uint8_t node_id, bool enabled)
+{
+    if (node_id != CAN_FD_CLASSIC_PEER)
+    {
+        fd_peers[node_id] = enabled;
+    }
+}
+
+bool CanFd::isPeerFd(uint8_t node_id)
+{
+    return fd_peers[node_id];
+}
+
+bool CanFd::useFd(int socket, canid_t can_id)
+{
+    return isSocketFd(socket) && isPeerFd(can_id & 0xFF);
+}
+
+void CanFd::learnPeer(int socket, canid_t can_id)
+{
+    if (isSocketFd(socket))
+    {
+        setPeerFd((can_id >> 8) & 0xFF, true);
+    }
+}
+
+struct canfd_frame CanFd::toFdFrame(const struct can_frame& frame)
+{
+    struct canfd_frame fd_frame;
+    memset(&fd_frame, 0, sizeof(fd_frame));
+    fd_frame.can_id = frame.can_id;
+    fd_frame.len = std::min<uint8_t>(frame.can_dlc, CAN_MAX_DLEN);
+    memcpy(fd_frame.data, frame.data, fd_frame.len);
+    return fd_frame;
+}
+
+struct can_frame CanFd::toClassicFrame(const struct canfd_frame& frame)
+{
+    struct can_frame classic_frame;
+    memset(&classic_frame, 0, sizeof(classic_frame));
+    classic_frame.can_id = frame.can_id;
+    classic_frame.can_dlc = std::min<uint8_t>(frame.len, CAN_MAX_DLEN);
+    memcpy(classic_frame.data, frame.data, classic_frame.can_dlc);
+    return classic_frame;
+}
+
+void CanFd::reset()
+{
+    for (std::atomic<bool>& socket : fd_sockets)
+    {
+        socket = false;
+    }
+    for (std::atomic<bool>& peer : fd_peers)
+    {
+        peer = false;
+    }
+}
@@ -1,5 +1,7 @@
 #include "CreateInterface.h"
 
+#include <unistd.h>
+
 /* Initialize static instance to nullptr */
 CreateInterface* CreateInterface::create_interface_instance = nullptr;
 
@@ -66,6 +68,17 @@ bool CreateInterface::createInterface()
             /* Set the flag to false if the first command fails */
             command_check  = false;
         }
+#if CAN_FD_ENABLED
+        else
+        {
+            /* The MTU can only be changed while the interface is down; without it the bus stays classic */
+            std::string cmd_mtu = "sudo ip link set vcan" + std::to_string(first_four_bits) + " mtu " + std::to_string(CANFD_MTU);
+            if (system(cmd_mtu.c_str()))
+            {
+                LOG_WARN(logger.GET_LOGGER(),"Error when trying to set the CAN FD MTU on the first interface");
+            }
+        }
+#endif
     }
     command_check_vcan_exists = "ip link show vcan" + std::to_string(last_four_bits) + " >/dev/null 2>&1";
     if(system(command_check_vcan_exists.c_str()) != 0)
@@ -84,6 +97,10 @@ bool CreateInterface::createInterface()
 }
 
 int CreateInterface::createSocket(uint8_t interface_number) {
+    return createSocket(interface_number, {});
+}
+
+int CreateInterface::createSocket(uint8_t interface_number, const std::vector<struct can_filter>& filters) {
     unsigned char lowerbits = interface_number & 0X0F;
     /* Create the read socket for the first interface */
     int socket_fd;
@@ -97,6 +114,13 @@ int CreateInterface::createSocket(uint8_t interface_number) {
     int reuse = 1;
     setsockopt(socket_fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
 
+    /* Install the filters before binding, so the other modules' traffic never reaches the socket */
+    if (!filters.empty() && !setReceiveFilters(socket_fd, filters))
+    {
+        close(socket_fd);
+        return 1;
+    }
+
     /* Binding read socket */  
     std::string vcan_interface_ecu =  "vcan" + std::to_string(lowerbits);    
     strcpy(ifr.ifr_name, vcan_interface_ecu.c_str() );    
@@ -116,6 +140,73 @@ int CreateInterface::createSocket(uint8_t interface_number) {
     return socket_fd;
 }
 
+bool CreateInterface::enableFdFrames(int socket, uint8_t interface_number)
+{
+    CanFd::setSocketFd(socket, false);
+#if CAN_FD_ENABLED
+    /* An interface with the classic MTU refuses the CAN FD frames, keep the socket classic */
+    struct ifreq mtu_request;
+    memset(&mtu_request, 0, sizeof(mtu_request));
+    std::string vcan_interface = "vcan" + std::to_string(interface_number & 0x0F);
+    strncpy(mtu_request.ifr_name, vcan_interface.c_str(), IFNAMSIZ - 1);
+    if (ioctl(socket, SIOCGIFMTU, &mtu_request) < 0 || mtu_request.ifr_mtu != CANFD_MTU)
+    {
+        LOG_INFO(logger.GET_LOGGER(), "{} has no CAN FD MTU, socket {} stays classic CAN", vcan_interface, socket);
+        return false;
+    }
+    int enable = 1;
+    if (setsockopt(socket, SOL_CAN_RAW, CAN_RAW_FD_FRAMES, &enable, sizeof(enable)) < 0)
+    {
+        LOG_WARN(logger.GET_LOGGER(), "Error when trying to enable CAN FD frames: {}", strerror(errno));
+        return false;
+    }
+    CanFd::setSocketFd(socket, true);
+    LOG_INFO(logger.GET_LOGGER(), "CAN FD frames enabled on socket {}", socket);
+    return true;
+#else
+    (void)interface_number;
+    return false;
+#endif
+}
+
+bool CreateInterface::setReceiveFilters(int socket, const std::vector<struct can_filter>& filters)
+{
+    if (filters.empty())
+    {
+        return true;
+    }
+    if (setsockopt(socket, SOL_CAN_RAW, CAN_RAW_FILTER, filters.data(),
+                   filters.size() * sizeof(struct can_filter)) < 0)
+    {
+        LOG_ERROR(logger.GET_LOGGER(), "Error when trying to set the receive filters: {}", strerror(errno));
+        return false;
+    }
+    LOG_INFO(logger.GET_LOGGER(), "{} receive filter(s) installed on socket {}", filters.size(), socket);
+    return true;
+}
+
+std::vector<struct can_filter> CreateInterface::receiverFilters(uint8_t module_id, const std::vector<uint8_t>& extra_receivers)
+{
+    /* A frame passes if (can_id & can_mask) == (filter.can_id & can_mask), so the
+       mask keeps only the receiver byte for both standard and extended frames */
+    std::vector<struct can_filter> filters;
+    filters.push_back({module_id, CAN_RECEIVER_MASK});
+    for (uint8_t receiver : extra_receivers)
+    {
+        if (receiver != module_id)
+        {
+            filters.push_back({receiver, CAN_RECEIVER_MASK});
+        }
+    }
+    return filters;
+}
+
+std::vector<struct can_filter> CreateInterface::excludeReceiverFilters(uint8_t receiver_id)
+{
+    /* CAN_INV_FILTER inverts the match: everything except this receiver passes */
+    return {{static_cast<canid_t>(receiver_id) | CAN_INV_FILTER, CAN_RECEIVER_MASK}};
+}
+
 /* Method to start a vcan interface */
 bool CreateInterface::startInterface()
 {
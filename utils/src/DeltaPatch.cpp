@@ -0,0 +1,224 @@
+#include "DeltaPatch.h"
+#include "ImageDigest.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+    inline uint32_t readNumber(const uint8_t* data)
+    {
+        return (static_cast<uint32_t>(data[0]) << 24) | (static_cast<uint32_t>(data[1]) << 16) |
+               (static_cast<uint32_t>(data[2]) << 8) | data[3];
+    }
+
+    inline void writeNumber(std::vector<uint8_t>& out, size_t value)
+    {
+        for (int byte = 3; byte >= 0; --byte)
+        {
+            out.push_back(static_cast<uint8_t>(value >> (8 * byte)));
+        }
+    }
+
+    /* Hash of the DELTA_PATCH_SEED_BYTES bytes at data */
+    inline uint32_t hashSeed(const uint8_t* data, int bits)
+    {
+        uint64_t low;
+        uint64_t high;
+        memcpy(&low, data, sizeof(low));
+        memcpy(&high, data + 8, sizeof(high));
+        uint64_t hash = (low * 0x9E3779B97F4A7C15ull) ^ (high * 0xC2B2AE3D27D4EB4Full);
+        return static_cast<uint32_t>((hash ^ (hash >> 29)) >> (64 - bits));
+    }
+
+    void writeInsert(std::vector<uint8_t>& patch, const uint8_t* data, size_t size)
+    {
+        if (size == 0)
+        {
+            return;
+        }
+        patch.push_back(DELTA_PATCH_INSERT);
+        writeNumber(patch, size);
+        patch.insert(patch.end(), data, data + size);
+    }
+
+    void writeCopy(std::vector<uint8_t>& patch, size_t offset, size_t size)
+    {
+        patch.push_back(DELTA_PATCH_COPY);
+        writeNumber(patch, offset);
+        writeNumber(patch, size);
+    }
+}
+
+void DeltaPatch::create(const uint8_t* base, size_t base_size, const uint8_t* target, size_t target_size, std::vector<uint8_t>& patch)
+{
+    patch.clear();
+    writeNumber(patch, base_size);
+    writeNumber(patch, ImageDigest::updateCrc32c(0xFFFFFFFF, base, base_size) ^ 0xFFFFFFFF);
+
+    size_t literal_start = 0;
+    if (base_size >= DELTA_PATCH_SEED_BYTES && target_size >= DELTA_PATCH_SEED_BYTES)
+    {
+        /* Index of the base: position + 1 of a seed with each hash, 0 = empty */
+        int bits = 10;
+        while (bits < 24 && (static_cast<size_t>(1) << bits) < 2 * (base_size / DELTA_PATCH_INDEX_STEP))
+        {
+            ++bits;
+        }
+        std::vector<uint32_t> index(static_cast<size_t>(1) << bits, 0);
+        for (size_t position = 0; position + DELTA_PATCH_SEED_BYTES <= base_size; position += DELTA_PATCH_INDEX_STEP)
+        {
+            index[hashSeed(base + position, bits)] = static_cast<uint32_t>(position + 1);
+        }
+
+        size_t position = 0;
+        while (position + DELTA_PATCH_SEED_BYTES <= target_size)
+        {
+            size_t candidate = index[hashSeed(target + position, bits)];
+            if (candidate == 0 || memcmp(base + candidate - 1, target + position, DELTA_PATCH_SEED_BYTES) != 0)
+            {
+                ++position;
+                continue;
+            }
+            /* Common part around the seed */
+            size_t base_start = candidate - 1;
+            size_t target_start = position;
+            while (target_start > literal_start && base_start > 0 && target[target_start - 1] == base[base_start - 1])
+            {
+                --target_start;
+                --base_start;
+            }
+            size_t length = position - target_start + DELTA_PATCH_SEED_BYTES;
+            while (target_start + length < target_size && base_start + length < base_size &&
+                   target[target_start + length] == base[base_start + length])
+            {
+                ++length;
+            }
+            writeInsert(patch, target + literal_start, target_start - literal_start);
+            writeCopy(patch, base_start, length);
+            position = target_start + length;
+            literal_start = position;
+        }
+    }
+    writeInsert(patch, target + literal_start, target_size - literal_start);
+}
+
+void DeltaPatchDecoder::reset(const uint8_t* base, size_t base_size)
+{
+    this->base = base;
+    this->base_size = base_size;
+    header_checked = false;
+    fields.clear();
+    insert_remaining = 0;
+    output_size = 0;
+    error.clear();
+}
+
+bool DeltaPatchDecoder::feed(const uint8_t* data, size_t size, const Sink& sink)
+{
+    while (size > 0)
+    {
+        if (insert_remaining > 0)
+        {
+            /* New bytes go to the sink straight from the block */
+            size_t bytes = std::min(size, insert_remaining);
+            if (!sink(data, bytes))
+            {
+                return fail("Rebuilt image could not be written.");
+            }
+            output_size += bytes;
+            insert_remaining -= bytes;
+            data += bytes;
+            size -= bytes;
+            continue;
+        }
+
+        size_t needed;
+        if (!header_checked)
+        {
+            needed = DELTA_PATCH_HEADER_BYTES;
+        }
+        else
+        {
+            needed = instructionSize(fields.empty() ? data[0] : fields[0]);
+            if (needed == 0)
+            {
+                return fail("Unknown patch instruction.");
+            }
+        }
+        size_t bytes = std::min(size, needed - fields.size());
+        fields.insert(fields.end(), data, data + bytes);
+        data += bytes;
+        size -= bytes;
+        if (fields.size() < needed)
+        {
+            break;
+        }
+
+        if (!header_checked)
+        {
+            uint32_t crc = ImageDigest::updateCrc32c(0xFFFFFFFF, base, base_size) ^ 0xFFFFFFFF;
+            if (readNumber(fields.data()) != base_size || readNumber(fields.data() + 4) != crc)
+            {
+                return fail("Patch made for another version of the installed image.");
+            }
+            header_checked = true;
+        }
+        else if (fields[0] == DELTA_PATCH_COPY)
+        {
+            size_t offset = readNumber(fields.data() + 1);
+            size_t length = readNumber(fields.data() + 5);
+            if (offset > base_size || length > base_size - offset)
+            {
+                return fail("Copy outside the installed image.");
+            }
+            if (!sink(base + offset, length))
+            {
+                return fail("Rebuilt image could not be written.");
+            }
+            output_size += length;
+        }
+        else
+        {
+            insert_remaining = readNumber(fields.data() + 1);
+        }
+        fields.clear();
+    }
+    return true;
+}
+
+bool DeltaPatchDecoder::isEmpty() const
+{
+    return header_checked && fields.empty() && insert_remaining == 0;
+}
+
+uint64_t DeltaPatchDecoder::getOutputSize() const
+{
+    return output_size;
+}
+
+const std::string& DeltaPatchDecoder::getError() const
+{
+    return error;
+}
+
+size_t DeltaPatchDecoder::instructionSize(uint8_t opcode)
+{
+    switch (opcode)
+    {
+        case DELTA_PATCH_COPY:
+            return 9;
+        case DELTA_PATCH_INSERT:
+            return 5;
+        default:
+            return 0;
+    }
+}
+
+bool DeltaPatchDecoder::fail(const std::string& reason)
+{
+    error = reason;
+    fields.clear();
+    insert_remaining = 0;
+    return false;
+}
@@ -0,0 +1,258 @@
+#include "DeviceSession.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#include <fcntl.h>
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace
+{
+    /* MBR layout */
+    const size_t MBR_PARTITIONS_OFFSET = 446;
+    const size_t MBR_ENTRY_SIZE = 16;
+    const size_t MBR_ENTRIES = 4;
+    const uint8_t MBR_BOOT_FLAG = 0x80;
+    const uint8_t MBR_TYPE_GPT_PROTECTIVE = 0xEE;
+    const uint8_t MBR_TYPE_EXTENDED = 0x05;
+    const uint8_t MBR_TYPE_EXTENDED_LBA = 0x0F;
+    /* GPT layout */
+    const char GPT_SIGNATURE[] = "EFI PART";
+    const uint64_t GPT_LEGACY_BIOS_BOOTABLE = 1ULL << 2;
+    const uint32_t GPT_MAX_ENTRIES = 128;
+
+    uint64_t readLittleEndian(const uint8_t* data, size_t bytes)
+    {
+        uint64_t value = 0;
+        for (size_t index = bytes; index > 0; --index)
+        {
+            value = (value << 8) | data[index - 1];
+        }
+        return value;
+    }
+}
+
+DeviceSession::~DeviceSession()
+{
+    close();
+}
+
+bool DeviceSession::open(const std::string& path, Logger& logger)
+{
+    close();
+    this->logger = &logger;
+    fd = ::open(path.c_str(), O_RDWR | O_CLOEXEC);
+    if (fd < 0)
+    {
+        LOG_ERROR(logger.GET_LOGGER(), "Error opening SD card device: {} ({})", path, strerror(errno));
+        return false;
+    }
+    this->path = path;
+
+    struct stat device_stat;
+    memset(&device_stat, 0, sizeof(device_stat));
+    fstat(fd, &device_stat);
+    uint64_t block_device_size = 0;
+    if (S_ISBLK(device_stat.st_mode))
+    {
+        int logical_sector_size = 0;
+        if (ioctl(fd, BLKGETSIZE64, &block_device_size) == 0)
+        {
+            device_size = static_cast<off_t>(block_device_size);
+        }
+        if (ioctl(fd, BLKSSZGET, &logical_sector_size) == 0 && logical_sector_size > 0)
+        {
+            sector_size = static_cast<size_t>(logical_sector_size);
+        }
+    }
+    else
+    {
+        /* Image file */
+        device_size = device_stat.st_size;
+    }
+
+    readPartitionTable();
+    LOG_INFO(logger.GET_LOGGER(), "Device {} opened: {} bytes, {} partitions.", path, device_size, partitions.size());
+    return true;
+}
+
+void DeviceSession::readPartitionTable()
+{
+    std::vector<uint8_t> mbr(sector_size);
+    if (!read(0, mbr.data(), mbr.size()) || mbr[510] != 0x55 || mbr[511] != 0xAA)
+    {
+        LOG_WARN(logger->GET_LOGGER(), "No partition table found on {}.", path);
+        return;
+    }
+    for (size_t entry = 0; entry < MBR_ENTRIES; ++entry)
+    {
+        const uint8_t* record = mbr.data() + MBR_PARTITIONS_OFFSET + entry * MBR_ENTRY_SIZE;
+        uint8_t type = record[4];
+        uint64_t first_sector = readLittleEndian(record + 8, 4);
+        uint64_t sectors = readLittleEndian(record + 12, 4);
+        if (type == MBR_TYPE_GPT_PROTECTIVE)
+        {
+            partitions.clear();
+            readGpt();
+            return;
+        }
+        if (type == 0 || sectors == 0 || type == MBR_TYPE_EXTENDED || type == MBR_TYPE_EXTENDED_LBA)
+        {
+            continue;
+        }
+        Partition partition;
+        partition.start = static_cast<off_t>(first_sector * sector_size);
+        partition.end = static_cast<off_t>((first_sector + sectors) * sector_size);
+        partition.boot = (record[0] & MBR_BOOT_FLAG) != 0;
+        partitions.push_back(partition);
+    }
+}
+
+void DeviceSession::readGpt()
+{
+    std::vector<uint8_t> header(sector_size);
+    if (!read(sector_size, header.data(), header.size()) || memcmp(header.data(), GPT_SIGNATURE, 8) != 0)
+    {
+        LOG_WARN(logger->GET_LOGGER(), "Invalid GPT header on {}.", path);
+        return;
+    }
+    uint64_t entries_lba = readLittleEndian(header.data() + 72, 8);
+    uint32_t entries = static_cast<uint32_t>(readLittleEndian(header.data() + 80, 4));
+    uint32_t entry_size = static_cast<uint32_t>(readLittleEndian(header.data() + 84, 4));
+    if (entry_size < 56 || entries == 0)
+    {
+        return;
+    }
+    entries = std::min(entries, GPT_MAX_ENTRIES);
+
+    std::vector<uint8_t> table(static_cast<size_t>(entries) * entry_size);
+    if (!read(static_cast<off_t>(entries_lba * sector_size), table.data(), table.size()))
+    {
+        LOG_WARN(logger->GET_LOGGER(), "Cannot read the GPT entries of {}.", path);
+        return;
+    }
+    for (uint32_t entry = 0; entry < entries; ++entry)
+    {
+        const uint8_t* record = table.data() + static_cast<size_t>(entry) * entry_size;
+        /* Unused entries have a zero type GUID */
+        bool used = false;
+        for (size_t byte = 0; byte < 16 && !used; ++byte)
+        {
+            used = record[byte] != 0;
+        }
+        if (!used)
+        {
+            continue;
+        }
+        Partition partition;
+        partition.start = static_cast<off_t>(readLittleEndian(record + 32, 8) * sector_size);
+        partition.end = static_cast<off_t>((readLittleEndian(record + 40, 8) + 1) * sector_size);
+        partition.boot = (readLittleEndian(record + 48, 8) & GPT_LEGACY_BIOS_BOOTABLE) != 0;
+        partitions.push_back(partition);
+    }
+}
+
+void DeviceSession::close()
+{
+    if (fd >= 0)
+    {
+        ::close(fd);
+        fd = -1;
+    }
+    path.clear();
+    device_size = 0;
+    sector_size = 512;
+    partitions.clear();
+}
+
+bool DeviceSession::isOpen() const
+{
+    return fd >= 0;
+}
+
+const std::string& DeviceSession::getPath() const
+{
+    return path;
+}
+
+off_t DeviceSession::getDeviceSize() const
+{
+    return device_size;
+}
+
+const std::vector<DeviceSession::Partition>& DeviceSession::getPartitions() const
+{
+    return partitions;
+}
+
+off_t DeviceSession::getBootEnd() const
+{
+    for (const Partition& partition : partitions)
+    {
+        if (partition.boot)
+        {
+            return partition.end;
+        }
+    }
+    return -1;
+}
+
+bool DeviceSession::contains(off_t offset, size_t size) const
+{
+    for (const Partition& partition : partitions)
+    {
+        if (!partition.boot && offset >= partition.start && offset < partition.end)
+        {
+            return static_cast<off_t>(size) <= partition.end - offset;
+        }
+    }
+    return false;
+}
+
+bool DeviceSession::write(off_t offset, const uint8_t* data, size_t size)
+{
+    size_t written = 0;
+    while (written < size)
+    {
+        ssize_t bytes_written = pwrite(fd, data + written, size - written, offset + written);
+        if (bytes_written < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (bytes_written <= 0)
+        {
+            LOG_ERROR(logger->GET_LOGGER(), "Error writing data to address {} on {}: {}", offset + written, path, strerror(errno));
+            return false;
+        }
+        written += static_cast<size_t>(bytes_written);
+    }
+    return true;
+}
+
+bool DeviceSession::read(off_t offset, uint8_t* data, size_t size)
+{
+    size_t done = 0;
+    while (done < size)
+    {
+        ssize_t bytes_read = pread(fd, data + done, size - done, offset + done);
+        if (bytes_read < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (bytes_read <= 0)
+        {
+            return false;
+        }
+        done += static_cast<size_t>(bytes_read);
+    }
+    return true;
+}
+
+bool DeviceSession::sync()
+{
+    return fd >= 0 && fdatasync(fd) == 0;
+}
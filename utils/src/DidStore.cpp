@@ -0,0 +1,395 @@
+#include "DidStore.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <fcntl.h>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <thread>
+#include <unistd.h>
+
+static_assert(std::atomic<uint32_t>::is_always_lock_free && std::atomic<uint8_t>::is_always_lock_free,
+              "The records are shared between processes");
+
+namespace
+{
+    inline size_t recordIndex(uint16_t did)
+    {
+        return (did * 2654435761u >> 12) & (DID_STORE_CAPACITY - 1);
+    }
+
+    /* Stores of the process, by file name */
+    std::map<std::string, std::unique_ptr<DidStore>>& stores()
+    {
+        static std::map<std::string, std::unique_ptr<DidStore>> stores;
+        return stores;
+    }
+
+    /* Stores of files replaced since, kept mapped for the readers still using them */
+    std::vector<std::unique_ptr<DidStore>>& replacedStores()
+    {
+        static std::vector<std::unique_ptr<DidStore>> replaced_stores;
+        return replaced_stores;
+    }
+
+    std::mutex& storesMutex()
+    {
+        static std::mutex stores_mutex;
+        return stores_mutex;
+    }
+
+    /* Exclusive flock() of a file for the life of the object */
+    class FileLock
+    {
+    public:
+        explicit FileLock(int file_descriptor) : file_descriptor(file_descriptor)
+        {
+            while (flock(file_descriptor, LOCK_EX) != 0 && errno == EINTR)
+            {
+            }
+        }
+        ~FileLock()
+        {
+            flock(file_descriptor, LOCK_UN);
+        }
+    private:
+        int file_descriptor;
+    };
+}
+
+DidStore& DidStore::forFile(const std::string& file_name, bool create)
+{
+    std::lock_guard<std::mutex> lock(storesMutex());
+    struct stat file_status;
+    bool exists = stat(file_name.c_str(), &file_status) == 0;
+    std::unique_ptr<DidStore>& store = stores()[file_name];
+    if (store && exists && store->isFile(file_status))
+    {
+        return *store;
+    }
+    if (!exists && !create)
+    {
+        throw std::runtime_error("Failed to open file: " + file_name);
+    }
+    std::unique_ptr<DidStore> new_store(new DidStore(file_name, create));
+    if (store)
+    {
+        replacedStores().push_back(std::move(store));
+    }
+    store = std::move(new_store);
+    return *store;
+}
+
+bool DidStore::restore(const std::string& file_name, const std::unordered_map<uint16_t, std::vector<uint8_t>>& default_values,
+                       const std::vector<uint16_t>& kept_dids)
+{
+    DidStore* store = nullptr;
+    try
+    {
+        store = &forFile(file_name);
+    }
+    catch (const std::runtime_error&)
+    {
+        /* No database yet, or not a database: made again below */
+    }
+    if (store != nullptr && store->header->keep_values.exchange(0) != 0)
+    {
+        std::vector<uint8_t> value;
+        for (const auto& [did, data] : default_values)
+        {
+            if (!store->get(did, value))
+            {
+                store->set(did, data, true);
+            }
+        }
+        return true;
+    }
+
+    /* A temporary file of this process, another module may restore its database at the same time */
+    std::string temporary_name = file_name + ".tmp." + std::to_string(getpid());
+    {
+        /* The writes of the other processes wait until the new database replaces the file, then set()
+           makes them in the new database */
+        std::unique_lock<std::mutex> write_lock;
+        std::unique_ptr<FileLock> file_lock;
+        /* Values that survive every restart, taken before the file is replaced */
+        std::unordered_map<uint16_t, std::vector<uint8_t>> kept_values;
+        if (store != nullptr)
+        {
+            write_lock = std::unique_lock<std::mutex>(store->write_mutex);
+            file_lock.reset(new FileLock(store->file_descriptor));
+            std::vector<uint8_t> value;
+            for (uint16_t did : kept_dids)
+            {
+                if (store->get(did, value))
+                {
+                    kept_values[did] = value;
+                }
+            }
+        }
+
+        /* The new database is complete before it replaces the file */
+        std::remove(temporary_name.c_str());
+        {
+            DidStore new_store(temporary_name, true);
+            for (const auto& [did, data] : default_values)
+            {
+                new_store.set(did, data, true);
+            }
+            for (const auto& [did, data] : kept_values)
+            {
+                new_store.set(did, data, true);
+            }
+            new_store.flush();
+        }
+        if (rename(temporary_name.c_str(), file_name.c_str()) != 0)
+        {
+            std::remove(temporary_name.c_str());
+            throw std::runtime_error("Failed to open file: " + file_name);
+        }
+    }
+    forFile(file_name);
+    return false;
+}
+
+void DidStore::flushAll()
+{
+    std::lock_guard<std::mutex> lock(storesMutex());
+    for (auto& [file_name, store] : stores())
+    {
+        if (store)
+        {
+            store->flush();
+        }
+    }
+}
+
+DidStore::DidStore(const std::string& file_name, bool create) : file_name(file_name)
+{
+    file_descriptor = open(file_name.c_str(), O_RDWR | O_CLOEXEC | (create ? O_CREAT : 0), 0666);
+    if (file_descriptor < 0)
+    {
+        throw std::runtime_error("Failed to open file: " + file_name);
+    }
+    const size_t database_size = sizeof(Header) + DID_STORE_CAPACITY * sizeof(Record);
+    void* map = MAP_FAILED;
+    {
+        FileLock lock(file_descriptor);
+        struct stat file_status;
+        bool valid = fstat(file_descriptor, &file_status) == 0 && static_cast<size_t>(file_status.st_size) == database_size;
+        if (valid)
+        {
+            Header file_header;
+            valid = pread(file_descriptor, &file_header, sizeof(file_header), 0) == sizeof(file_header) &&
+                    file_header.magic == DID_STORE_MAGIC && file_header.version == DID_STORE_VERSION &&
+                    file_header.record_size == sizeof(Record) && file_header.capacity == DID_STORE_CAPACITY;
+        }
+        if (!valid && create)
+        {
+            /* Zero bytes: all the records free */
+            Header new_header = {};
+            new_header.magic = DID_STORE_MAGIC;
+            new_header.version = DID_STORE_VERSION;
+            new_header.record_size = sizeof(Record);
+            new_header.capacity = DID_STORE_CAPACITY;
+            valid = ftruncate(file_descriptor, 0) == 0 && ftruncate(file_descriptor, database_size) == 0 &&
+                    pwrite(file_descriptor, &new_header, sizeof(new_header), 0) == sizeof(new_header) &&
+                    fstat(file_descriptor, &file_status) == 0;
+        }
+        if (valid)
+        {
+            file_device = file_status.st_dev;
+            file_inode = file_status.st_ino;
+            map = mmap(nullptr, database_size, PROT_READ | PROT_WRITE, MAP_SHARED, file_descriptor, 0);
+        }
+        if (map != MAP_FAILED)
+        {
+            header = static_cast<Header*>(map);
+            records = reinterpret_cast<Record*>(static_cast<uint8_t*>(map) + sizeof(Header));
+            /* A writer stopped in the middle of a value leaves an odd sequence */
+            for (size_t index = 0; index < DID_STORE_CAPACITY; ++index)
+            {
+                uint32_t sequence = records[index].sequence.load(std::memory_order_relaxed);
+                if (sequence & 1)
+                {
+                    records[index].sequence.store(sequence + 1, std::memory_order_release);
+                }
+            }
+        }
+    }
+    if (map == MAP_FAILED)
+    {
+        close(file_descriptor);
+        throw std::runtime_error("Not a DID database: " + file_name);
+    }
+}
+
+DidStore::~DidStore()
+{
+    munmap(header, sizeof(Header) + DID_STORE_CAPACITY * sizeof(Record));
+    close(file_descriptor);
+}
+
+bool DidStore::get(uint16_t did, std::vector<uint8_t>& value) const
+{
+    const Record* record = find(did);
+    if (record == nullptr)
+    {
+        return false;
+    }
+    uint8_t bytes[DID_STORE_MAX_VALUE];
+    size_t length;
+    while (true)
+    {
+        uint32_t sequence = record->sequence.load(std::memory_order_acquire);
+        if (sequence & 1)
+        {
+            /* A writer is in the middle of the value */
+            std::this_thread::yield();
+            continue;
+        }
+        length = std::min<size_t>(record->length.load(std::memory_order_relaxed), DID_STORE_MAX_VALUE);
+        for (size_t index = 0; index < length; ++index)
+        {
+            bytes[index] = record->value[index].load(std::memory_order_relaxed);
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (record->sequence.load(std::memory_order_relaxed) == sequence)
+        {
+            break;
+        }
+    }
+    value.assign(bytes, bytes + length);
+    return true;
+}
+
+bool DidStore::read(uint16_t did, size_t position, size_t size, uint8_t* destination) const
+{
+    const Record* record = find(did);
+    if (record == nullptr || position + size > DID_STORE_MAX_VALUE)
+    {
+        return false;
+    }
+    while (true)
+    {
+        uint32_t sequence = record->sequence.load(std::memory_order_acquire);
+        if (sequence & 1)
+        {
+            std::this_thread::yield();
+            continue;
+        }
+        size_t length = record->length.load(std::memory_order_relaxed);
+        for (size_t index = 0; index < size; ++index)
+        {
+            destination[index] = record->value[position + index].load(std::memory_order_relaxed);
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (record->sequence.load(std::memory_order_relaxed) == sequence)
+        {
+            return position + size <= length;
+        }
+    }
+}
+
+bool DidStore::set(uint16_t did, const std::vector<uint8_t>& value, bool add)
+{
+    if (value.size() > DID_STORE_MAX_VALUE)
+    {
+        throw std::runtime_error("Value too long for DID " + std::to_string(did) + " in " + file_name);
+    }
+    {
+        std::lock_guard<std::mutex> lock(write_mutex);
+        FileLock file_lock(file_descriptor);
+        struct stat file_status;
+        if (fstat(file_descriptor, &file_status) != 0 || file_status.st_nlink != 0)
+        {
+            Record* record = find(did);
+            if (record != nullptr)
+            {
+                write(*record, value);
+                return true;
+            }
+            if (!add)
+            {
+                return false;
+            }
+            for (size_t probe = 0, index = recordIndex(did); probe < DID_STORE_CAPACITY; ++probe, index = (index + 1) & (DID_STORE_CAPACITY - 1))
+            {
+                if (records[index].used.load(std::memory_order_relaxed) == 0)
+                {
+                    records[index].did.store(did, std::memory_order_relaxed);
+                    write(records[index], value);
+                    /* Readers find the record only now, with its value */
+                    records[index].used.store(1, std::memory_order_release);
+                    return true;
+                }
+            }
+            throw std::runtime_error("DID database full: " + file_name);
+        }
+    }
+    /* The file was replaced by restore() while this write waited for the lock: written in the new database */
+    return forFile(file_name).set(did, value, add);
+}
+
+std::unordered_map<uint16_t, std::vector<uint8_t>> DidStore::snapshot() const
+{
+    std::unordered_map<uint16_t, std::vector<uint8_t>> data_map;
+    for (size_t index = 0; index < DID_STORE_CAPACITY; ++index)
+    {
+        if (records[index].used.load(std::memory_order_acquire) != 0)
+        {
+            uint16_t did = records[index].did.load(std::memory_order_relaxed);
+            get(did, data_map[did]);
+        }
+    }
+    return data_map;
+}
+
+void DidStore::flush()
+{
+    msync(header, sizeof(Header) + DID_STORE_CAPACITY * sizeof(Record), MS_SYNC);
+}
+
+void DidStore::keepValuesOnRestart()
+{
+    header->keep_values.store(1);
+    flush();
+}
+
+DidStore::Record* DidStore::find(uint16_t did) const
+{
+    for (size_t probe = 0, index = recordIndex(did); probe < DID_STORE_CAPACITY; ++probe, index = (index + 1) & (DID_STORE_CAPACITY - 1))
+    {
+        if (records[index].used.load(std::memory_order_acquire) == 0)
+        {
+            return nullptr;
+        }
+        if (records[index].did.load(std::memory_order_relaxed) == did)
+        {
+            return &records[index];
+        }
+    }
+    return nullptr;
+}
+
+void DidStore::write(Record& record, const std::vector<uint8_t>& value)
+{
+    uint32_t sequence = record.sequence.load(std::memory_order_relaxed);
+    record.sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    record.length.store(static_cast<uint8_t>(value.size()), std::memory_order_relaxed);
+    for (size_t index = 0; index < value.size(); ++index)
+    {
+        record.value[index].store(value[index], std::memory_order_relaxed);
+    }
+    record.sequence.store(sequence + 2, std::memory_order_release);
+}
+
+bool DidStore::isFile(const struct stat& file_status) const
+{
+    return file_status.st_dev == file_device && file_status.st_ino == file_inode;
+}
@@ -0,0 +1,204 @@
+#include "DynamicDidTable.h"
+#include "MemoryManager.h"
+
+#include <algorithm>
+
+DynamicDidTable& DynamicDidTable::getInstance()
+{
+    static DynamicDidTable instance;
+    return instance;
+}
+
+bool DynamicDidTable::isDynamic(uint16_t did)
+{
+    return did >= DYNAMIC_DID_FIRST && did <= DYNAMIC_DID_LAST;
+}
+
+uint32_t DynamicDidTable::key(uint8_t server, uint16_t dynamic_did)
+{
+    return (static_cast<uint32_t>(server) << 16) | dynamic_did;
+}
+
+void DynamicDidTable::append(Definition& definition, const Field& field)
+{
+    if (!definition.fields.empty())
+    {
+        Field& last = definition.fields.back();
+        if (last.source == field.source && last.did == field.did &&
+            last.offset + static_cast<off_t>(last.size) == field.offset)
+        {
+            /* Next bytes of the same source: one copy instead of two */
+            last.size += field.size;
+            definition.length += field.size;
+            return;
+        }
+    }
+    Field compiled = field;
+    compiled.destination = definition.length;
+    definition.fields.push_back(compiled);
+    definition.length += field.size;
+}
+
+bool DynamicDidTable::defineByIdentifier(uint8_t server, uint16_t dynamic_did, const DidStore& store, const std::vector<SourceRange>& ranges, Logger& logger)
+{
+    if (!isDynamic(dynamic_did) || ranges.empty())
+    {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(table_mutex);
+    /* Compiled on a copy, so the definition does not change if a range is refused */
+    Definition definition = find(server, dynamic_did);
+    uint8_t bytes[DID_STORE_MAX_VALUE];
+    for (const SourceRange& range : ranges)
+    {
+        /* A dynamic DID is not a source: its fields are copied instead */
+        if (isDynamic(range.did) || range.position == 0 || range.size == 0 ||
+            !store.read(range.did, range.position - 1, range.size, bytes))
+        {
+            LOG_ERROR(logger.GET_LOGGER(), "Bytes {}-{} of DID 0x{:04X} can not be used in DID 0x{:04X}.",
+                      range.position, range.position + range.size - 1, range.did, dynamic_did);
+            return false;
+        }
+        Field field;
+        field.source = Field::SOURCE_DID;
+        field.did = range.did;
+        field.offset = range.position - 1;
+        field.size = range.size;
+        append(definition, field);
+    }
+    return commit(server, dynamic_did, std::move(definition), logger);
+}
+
+bool DynamicDidTable::defineByMemoryAddress(uint8_t server, uint16_t dynamic_did, const std::vector<MemoryRange>& ranges, Logger& logger)
+{
+    if (!isDynamic(dynamic_did) || ranges.empty())
+    {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(table_mutex);
+    Definition definition = find(server, dynamic_did);
+    MemoryManager* memory_manager = MemoryManager::getInstance(ranges.front().address, DEV_LOOP, logger);
+    for (const MemoryRange& range : ranges)
+    {
+        if (range.size <= 0 || range.size > DYNAMIC_DID_MAX_LENGTH ||
+            !memory_manager->availableAddress(range.address) ||
+            !memory_manager->availableAddress(range.address + range.size - 1))
+        {
+            LOG_ERROR(logger.GET_LOGGER(), "Memory range 0x{:X}, {} bytes can not be used in DID 0x{:04X}.",
+                      range.address, range.size, dynamic_did);
+            return false;
+        }
+        Field field;
+        field.source = Field::SOURCE_MEMORY;
+        field.offset = range.address;
+        field.size = range.size;
+        append(definition, field);
+    }
+    definition.device = memory_manager->getPath();
+    return commit(server, dynamic_did, std::move(definition), logger);
+}
+
+bool DynamicDidTable::commit(uint8_t server, uint16_t dynamic_did, Definition&& definition, Logger& logger)
+{
+    if (definition.length > DYNAMIC_DID_MAX_LENGTH || definition.fields.size() > DYNAMIC_DID_MAX_FIELDS)
+    {
+        LOG_ERROR(logger.GET_LOGGER(), "DID 0x{:04X} too long: {} bytes in {} fields.", dynamic_did,
+                  definition.length, definition.fields.size());
+        return false;
+    }
+    auto existing = definitions.find(key(server, dynamic_did));
+    if (existing == definitions.end() && countDefinitions(server) >= DYNAMIC_DID_MAX_DEFINITIONS)
+    {
+        LOG_ERROR(logger.GET_LOGGER(), "No room for DID 0x{:04X}: {} dynamic DIDs defined.", dynamic_did,
+                  DYNAMIC_DID_MAX_DEFINITIONS);
+        return false;
+    }
+    LOG_INFO(logger.GET_LOGGER(), "DID 0x{:04X} defined: {} bytes gathered from {} fields.", dynamic_did,
+             definition.length, definition.fields.size());
+    definitions[key(server, dynamic_did)] = std::move(definition);
+    return true;
+}
+
+size_t DynamicDidTable::clear(uint8_t server, uint16_t dynamic_did)
+{
+    std::lock_guard<std::mutex> lock(table_mutex);
+    return definitions.erase(key(server, dynamic_did));
+}
+
+size_t DynamicDidTable::clear(uint8_t server)
+{
+    std::lock_guard<std::mutex> lock(table_mutex);
+    size_t count = 0;
+    for (auto it = definitions.begin(); it != definitions.end();)
+    {
+        if ((it->first >> 16) == server)
+        {
+            it = definitions.erase(it);
+            ++count;
+        }
+        else
+        {
+            ++it;
+        }
+    }
+    return count;
+}
+
+bool DynamicDidTable::isDefined(uint8_t server, uint16_t dynamic_did) const
+{
+    std::lock_guard<std::mutex> lock(table_mutex);
+    return definitions.count(key(server, dynamic_did)) != 0;
+}
+
+size_t DynamicDidTable::getFieldCount(uint8_t server, uint16_t dynamic_did) const
+{
+    std::lock_guard<std::mutex> lock(table_mutex);
+    return find(server, dynamic_did).fields.size();
+}
+
+DynamicDidTable::Definition DynamicDidTable::find(uint8_t server, uint16_t dynamic_did) const
+{
+    auto it = definitions.find(key(server, dynamic_did));
+    return it == definitions.end() ? Definition() : it->second;
+}
+
+size_t DynamicDidTable::countDefinitions(uint8_t server) const
+{
+    return std::count_if(definitions.begin(), definitions.end(),
+        [server](const std::pair<const uint32_t, Definition>& entry) { return (entry.first >> 16) == server; });
+}
+
+bool DynamicDidTable::read(uint8_t server, uint16_t dynamic_did, const DidStore& store, std::vector<uint8_t>& value, Logger& logger) const
+{
+    Definition definition;
+    {
+        /* The fields are copied, the sources are read without the lock */
+        std::lock_guard<std::mutex> lock(table_mutex);
+        definition = find(server, dynamic_did);
+    }
+    if (definition.fields.empty())
+    {
+        return false;
+    }
+    value.resize(definition.length);
+    for (const Field& field : definition.fields)
+    {
+        if (field.source == Field::SOURCE_DID)
+        {
+            if (!store.read(field.did, field.offset, field.size, value.data() + field.destination))
+            {
+                LOG_ERROR(logger.GET_LOGGER(), "DID 0x{:04X} of DID 0x{:04X} can no longer be read.", field.did, dynamic_did);
+                return false;
+            }
+            continue;
+        }
+        std::vector<uint8_t> data = MemoryManager::readFromAddress(definition.device, field.offset, field.size, logger);
+        if (data.size() != field.size)
+        {
+            LOG_ERROR(logger.GET_LOGGER(), "Memory 0x{:X} of DID 0x{:04X} can no longer be read.", field.offset, dynamic_did);
+            return false;
+        }
+        std::copy(data.begin(), data.end(), value.begin() + field.destination);
+    }
+    return true;
+}
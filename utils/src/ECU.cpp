@@ -1,14 +1,15 @@
 #include "ECU.h"
 
-std::map<uint8_t, double> ECU::timing_parameters;
-std::map<uint8_t, std::future<void>> ECU::active_timers;
-std::map<uint8_t, std::atomic<bool>> ECU::stop_flags;
+std::array<std::atomic<double>, SID_COUNT> ECU::timing_parameters;
+std::array<std::atomic<bool>, SID_COUNT> ECU::stop_flags;
 
 ECU::ECU(uint8_t module_id, Logger& logger) : _module_id(module_id),
                                             _can_interface(CreateInterface::getInstance(0x00, logger)),
                                             _logger(logger)
 {
-    _ecu_socket = _can_interface->createSocket(ECU_INTERFACE_NUMBER);
+    /* Let the kernel drop the frames addressed to the other modules */
+    _ecu_socket = _can_interface->createSocket(ECU_INTERFACE_NUMBER, CreateInterface::receiverFilters(_module_id));
+    _can_interface->enableFdFrames(_ecu_socket, ECU_INTERFACE_NUMBER);
     _frame_receiver = new ReceiveFrames(_ecu_socket, _module_id, _logger);
     sendNotificationToMCU();
 }
@@ -18,8 +19,8 @@ void ECU::sendNotificationToMCU()
     /* Create an instance of GenerateFrames with the CAN socket */
     GenerateFrames notifyFrame = GenerateFrames(_ecu_socket, _logger);
 
-    /* Create a vector of uint8_t (bytes) containing the data to be sent */
-    std::vector<uint8_t> data = {0x01, 0xD9};
+    /* Create a vector of uint8_t (bytes) containing the data to be sent, with the CAN FD support of the ECU */
+    std::vector<uint8_t> data = {0x02, 0xD9, static_cast<uint8_t>(CanFd::isSocketFd(_ecu_socket) ? CAN_FD_CAPABLE : 0x00)};
 
     /* Send the CAN frame with ID sender-ECU, receiver-MCU and the data vector */
     uint16_t frame_id = (_module_id << 8) | MCU_ID;
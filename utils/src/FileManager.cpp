@@ -1,4 +1,5 @@
 #include "FileManager.h"
+#include "DidStore.h"
 #include <unistd.h>
 #include <zip.h>
 
@@ -123,9 +124,9 @@ void FileManager::writeDTC(std::unordered_map<uint16_t, std::vector<uint8_t>>& d
 bool FileManager::getEcuPath(uint8_t ecu_id, std::string& ecu_path, uint8_t param, Logger& logger, const std::string& version)
 {
     static std::string zip_ecu_path;
-    if(param > 3)
+    if(param > 4)
     {
-        /* Only 0, 1, 2 and 3 valid values */
+        /* Only 0, 1, 2, 3 and 4 valid values */
         return 0;
     }
 
@@ -207,6 +208,14 @@ bool FileManager::getEcuPath(uint8_t ecu_id, std::string& ecu_path, uint8_t para
             return 0;
         break;
     }
+    if(param == 4)
+    {
+        /* Installed executable, in the directory the new software is extracted to */
+        static const std::unordered_map<uint8_t, std::string> executables = {
+            {0x10, "main_mcu"}, {0x11, "main_battery"}, {0x12, "main_engine"}, {0x13, "main_doors"}, {0x14, "main_hvac"}
+        };
+        ecu_path += executables.at(ecu_id);
+    }
     /* Checks for valid path here */
     // if(param == 1 && access((ecu_path).c_str(), F_OK) == -1)
     // {
@@ -314,23 +323,23 @@ void FileManager::setDidValue(const uint16_t did, const std::vector<uint8_t>& va
     switch (receiver_id)
     {
         case 0x10:
-        file_path += "/backend/mcu/mcu_data.txt";           
+        file_path += "/backend/mcu/mcu_data.db";           
         break;
         
         case 0x11:
-        file_path += "/backend/ecu_simulation/BatteryModule/battery_data.txt";
+        file_path += "/backend/ecu_simulation/BatteryModule/battery_data.db";
         break;
 
         case 0x12:
-        file_path += "/backend/ecu_simulation/EngineModule/engine_data.txt";
+        file_path += "/backend/ecu_simulation/EngineModule/engine_data.db";
         break;
         
         case 0x13:
-        file_path += "/backend/ecu_simulation/DoorsModule/doors_data.txt";
+        file_path += "/backend/ecu_simulation/DoorsModule/doors_data.db";
         break;
 
         case 0x14:
-        file_path += "/backend/ecu_simulation/HVACModule/hvac_data.txt";
+        file_path += "/backend/ecu_simulation/HVACModule/hvac_data.db";
         break;
        
         default:
@@ -338,17 +347,12 @@ void FileManager::setDidValue(const uint16_t did, const std::vector<uint8_t>& va
         break;
      }
 
-    auto data_map = FileManager::readMapFromFile(file_path);
-    auto did_it = data_map.find(did);
-
-    if(did_it == data_map.end())
+    /* Seen at once by the processes mapping the database */
+    if (!DidStore::forFile(file_path).set(did, value))
     {
         LOG_WARN(logger.GET_LOGGER(), "DID {} not found when trying to set value", did);
         return;
     }
-    did_it->second = value;
-
-    FileManager::writeMapToFile(file_path, data_map);
 
     uint8_t target_id = (can_id & 0x00FF0000) >> 16;
         
@@ -389,23 +393,23 @@ const std::vector<uint8_t> FileManager::getDidValue(const uint16_t did, canid_t
     switch (receiver_id)
     {
         case 0x10:
-        file_path += "/backend/mcu/mcu_data.txt";           
+        file_path += "/backend/mcu/mcu_data.db";           
         break;
         
         case 0x11:
-        file_path += "/backend/ecu_simulation/BatteryModule/battery_data.txt";
+        file_path += "/backend/ecu_simulation/BatteryModule/battery_data.db";
         break;
 
         case 0x12:
-        file_path += "/backend/ecu_simulation/EngineModule/engine_data.txt";
+        file_path += "/backend/ecu_simulation/EngineModule/engine_data.db";
         break;
         
         case 0x13:
-        file_path += "/backend/ecu_simulation/DoorsModule/doors_data.txt";
+        file_path += "/backend/ecu_simulation/DoorsModule/doors_data.db";
         break;
 
         case 0x14:
-        file_path += "/backend/ecu_simulation/HVACModule/hvac_data.txt";
+        file_path += "/backend/ecu_simulation/HVACModule/hvac_data.db";
         break;
        
         default:
@@ -413,11 +417,11 @@ const std::vector<uint8_t> FileManager::getDidValue(const uint16_t did, canid_t
         break;
     }
 
-    auto data_map = FileManager::readMapFromFile(file_path);
-    if(data_map.find(did) == data_map.end())
+    std::vector<uint8_t> value;
+    if (!DidStore::forFile(file_path).get(did, value))
     {
         LOG_WARN(logger.GET_LOGGER(), "DID {} not found when trying to get value", did);
         throw std::runtime_error("DID not found in data map");
     }
-    return data_map.at(did);
+    return value;
 }
\ No newline at end of file
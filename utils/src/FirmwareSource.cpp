@@ -0,0 +1,157 @@
+#include "FirmwareSource.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+FirmwareSource::~FirmwareSource()
+{
+    close();
+}
+
+bool FirmwareSource::open(const std::string& path, Logger& logger)
+{
+    close();
+    this->logger = &logger;
+    fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        LOG_ERROR(logger.GET_LOGGER(), "Error opening firmware image {}: {}", path, strerror(errno));
+        return false;
+    }
+
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) == 0 && S_ISREG(file_stat.st_mode) && file_stat.st_size > 0)
+    {
+        image_size = static_cast<size_t>(file_stat.st_size);
+        void* address = mmap(nullptr, image_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (address != MAP_FAILED)
+        {
+            /* The image is read once, from the start to the end */
+            madvise(address, image_size, MADV_SEQUENTIAL);
+            mapping = static_cast<const uint8_t*>(address);
+            LOG_INFO(logger.GET_LOGGER(), "Firmware image {} of {} bytes mapped.", path, image_size);
+            return true;
+        }
+        LOG_WARN(logger.GET_LOGGER(), "Firmware image {} cannot be mapped ({}), reading it in windows.", path, strerror(errno));
+    }
+    else
+    {
+        /* Not a regular file (e.g. a block device): fstat gives no size, so seek to the end for it */
+        off_t end = lseek(fd, 0, SEEK_END);
+        if (end <= 0 || lseek(fd, 0, SEEK_SET) < 0)
+        {
+            LOG_ERROR(logger.GET_LOGGER(), "Firmware image {} has no size.", path);
+            close();
+            return false;
+        }
+        image_size = static_cast<size_t>(end);
+    }
+    window.reserve(FIRMWARE_READ_AHEAD_BYTES);
+    LOG_INFO(logger.GET_LOGGER(), "Firmware image {} of {} bytes opened.", path, image_size);
+    return true;
+}
+
+FirmwareSource::Chunk FirmwareSource::chunk(size_t offset, size_t length)
+{
+    Chunk view;
+    if (fd < 0 || offset >= image_size)
+    {
+        return view;
+    }
+    length = std::min(length, image_size - offset);
+
+    if (mapping != nullptr)
+    {
+        releaseBefore(offset);
+        view.data = mapping + offset;
+        view.size = length;
+        return view;
+    }
+
+    if (offset < window_offset || offset + length > window_offset + window.size())
+    {
+        if (!readAhead(offset, length))
+        {
+            return view;
+        }
+    }
+    view.data = window.data() + (offset - window_offset);
+    view.size = length;
+    return view;
+}
+
+void FirmwareSource::releaseBefore(size_t offset)
+{
+    static const size_t page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    size_t page_end = offset - offset % page_size;
+    if (page_end > released)
+    {
+        /* Clean private pages of a read-only mapping: dropping them only frees memory */
+        madvise(const_cast<uint8_t*>(mapping) + released, page_end - released, MADV_DONTNEED);
+        released = page_end;
+    }
+}
+
+bool FirmwareSource::readAhead(size_t offset, size_t length)
+{
+    size_t window_size = std::min(std::max(length, static_cast<size_t>(FIRMWARE_READ_AHEAD_BYTES)), image_size - offset);
+    window.resize(window_size);
+    window_offset = offset;
+    size_t filled = 0;
+    while (filled < window_size)
+    {
+        ssize_t bytes_read = pread(fd, window.data() + filled, window_size - filled, offset + filled);
+        if (bytes_read < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (bytes_read <= 0)
+        {
+            LOG_ERROR(logger->GET_LOGGER(), "Failed to read the firmware image at offset {}.", offset + filled);
+            window.clear();
+            return false;
+        }
+        filled += static_cast<size_t>(bytes_read);
+    }
+    return true;
+}
+
+void FirmwareSource::close()
+{
+    if (mapping != nullptr)
+    {
+        munmap(const_cast<uint8_t*>(mapping), image_size);
+        mapping = nullptr;
+    }
+    if (fd >= 0)
+    {
+        ::close(fd);
+        fd = -1;
+    }
+    image_size = 0;
+    released = 0;
+    window.clear();
+    window.shrink_to_fit();
+    window_offset = 0;
+}
+
+size_t FirmwareSource::size() const
+{
+    return image_size;
+}
+
+bool FirmwareSource::isMapped() const
+{
+    return mapping != nullptr;
+}
+
+bool FirmwareSource::isOpen() const
+{
+    return fd >= 0;
+}
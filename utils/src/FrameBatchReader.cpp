@@ -0,0 +1,124 @@
+#include "FrameBatchReader.h"
+
+#include <cerrno>
+#include <cstring>
+#include <algorithm>
+
+/* Room for one SO_TIMESTAMPNS control message per frame */
+static constexpr size_t CONTROL_BUFFER_SIZE = CMSG_SPACE(sizeof(struct timespec));
+
+FrameBatchReader::FrameBatchReader(int socket, size_t batch_size) : socket(socket), batch_size(0)
+{
+    /* Ask the kernel to attach the receive time to every frame. If the option
+       is not supported the frames are stamped when they are read. */
+    int enable = 1;
+    setsockopt(socket, SOL_SOCKET, SO_TIMESTAMPNS, &enable, sizeof(enable));
+    setBatchSize(batch_size);
+}
+
+void FrameBatchReader::setBatchSize(size_t batch_size)
+{
+    if (batch_size == 0)
+    {
+        batch_size = 1;
+    }
+    else if (batch_size > MAX_RECV_BATCH_SIZE)
+    {
+        batch_size = MAX_RECV_BATCH_SIZE;
+    }
+    this->batch_size = batch_size;
+
+    frame_buffers.assign(batch_size, canfd_frame{});
+    iovecs.assign(batch_size, iovec{});
+    messages.assign(batch_size, mmsghdr{});
+    control_buffers.assign(batch_size * CONTROL_BUFFER_SIZE, 0);
+
+    for (size_t index = 0; index < batch_size; ++index)
+    {
+        iovecs[index].iov_base = &frame_buffers[index];
+        iovecs[index].iov_len = sizeof(struct canfd_frame);
+        messages[index].msg_hdr.msg_iov = &iovecs[index];
+        messages[index].msg_hdr.msg_iovlen = 1;
+        messages[index].msg_hdr.msg_control = &control_buffers[index * CONTROL_BUFFER_SIZE];
+        messages[index].msg_hdr.msg_controllen = CONTROL_BUFFER_SIZE;
+    }
+}
+
+size_t FrameBatchReader::getBatchSize() const
+{
+    return batch_size;
+}
+
+int FrameBatchReader::getSocket() const
+{
+    return socket;
+}
+
+int FrameBatchReader::readBatch(std::vector<TimestampedFrame>& frames)
+{
+    frames.clear();
+
+    /* recvmmsg overwrites the control length, restore it before every call */
+    for (size_t index = 0; index < batch_size; ++index)
+    {
+        messages[index].msg_hdr.msg_controllen = CONTROL_BUFFER_SIZE;
+        messages[index].msg_hdr.msg_flags = 0;
+    }
+
+    int received;
+    do
+    {
+        received = recvmmsg(socket, messages.data(), batch_size, MSG_DONTWAIT, nullptr);
+    } while (received < 0 && errno == EINTR);
+
+    if (received < 0)
+    {
+        if (errno == EAGAIN || errno == EWOULDBLOCK)
+        {
+            return 0;
+        }
+        return BATCH_READ_ERROR;
+    }
+
+    for (int index = 0; index < received; ++index)
+    {
+        if (messages[index].msg_len == 0)
+        {
+            /* Only stream sockets report end of file this way */
+            return frames.empty() ? BATCH_CONNECTION_CLOSED : static_cast<int>(frames.size());
+        }
+        if (messages[index].msg_len == CANFD_MTU)
+        {
+            /* The sender talks CAN FD, the answers to it can use CAN FD too */
+            CanFd::learnPeer(socket, frame_buffers[index].can_id);
+        }
+        else if (messages[index].msg_len == CAN_MTU)
+        {
+            /* Classic frame: only the first 8 data bytes were written */
+            frame_buffers[index].len = std::min<uint8_t>(frame_buffers[index].len, CAN_MAX_DLEN);
+        }
+        else
+        {
+            /* Truncated frame, nothing useful can be done with it */
+            continue;
+        }
+        struct timespec timestamp;
+        extractTimestamp(messages[index].msg_hdr, timestamp);
+        frames.emplace_back(frame_buffers[index], timestamp);
+    }
+    return static_cast<int>(frames.size());
+}
+
+void FrameBatchReader::extractTimestamp(const struct msghdr& message, struct timespec& timestamp)
+{
+    for (struct cmsghdr* control = CMSG_FIRSTHDR(&message); control != nullptr;
+         control = CMSG_NXTHDR(const_cast<struct msghdr*>(&message), control))
+    {
+        if (control->cmsg_level == SOL_SOCKET && control->cmsg_type == SO_TIMESTAMPNS)
+        {
+            std::memcpy(&timestamp, CMSG_DATA(control), sizeof(timestamp));
+            return;
+        }
+    }
+    clock_gettime(CLOCK_REALTIME, &timestamp);
+}
@@ -0,0 +1,214 @@
+#include "FrameRingBuffer.h"
+
+#include <unistd.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+
+FrameRingBuffer::FrameRingBuffer(size_t capacity)
+    : event_fd(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)),
+      enqueue_position(0), dequeue_position(0), consumer_waiting(false),
+      dropped_frames(0), peak_occupancy(0)
+{
+    /* Round up to a power of two so the index wraps with a mask */
+    size_t rounded_capacity = 2;
+    while (rounded_capacity < capacity)
+    {
+        rounded_capacity <<= 1;
+    }
+    mask = rounded_capacity - 1;
+    slots.reset(new Slot[rounded_capacity]);
+    for (size_t index = 0; index < rounded_capacity; ++index)
+    {
+        slots[index].sequence.store(index, std::memory_order_relaxed);
+    }
+}
+
+FrameRingBuffer::~FrameRingBuffer()
+{
+    if (event_fd >= 0)
+    {
+        close(event_fd);
+    }
+}
+
+bool FrameRingBuffer::tryPush(const TimestampedFrame& frame)
+{
+    if (!enqueue(frame))
+    {
+        dropped_frames.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    return true;
+}
+
+bool FrameRingBuffer::enqueue(const TimestampedFrame& frame)
+{
+    size_t position = enqueue_position.load(std::memory_order_relaxed);
+    Slot* slot;
+    while (true)
+    {
+        slot = &slots[position & mask];
+        size_t sequence = slot->sequence.load(std::memory_order_acquire);
+        intptr_t difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+        if (difference == 0)
+        {
+            /* Slot is free, claim it */
+            if (enqueue_position.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+            {
+                break;
+            }
+        }
+        else if (difference < 0)
+        {
+            /* Consumer did not release this slot yet, the buffer is full */
+            return false;
+        }
+        else
+        {
+            /* Another producer took the slot, try the next position */
+            position = enqueue_position.load(std::memory_order_relaxed);
+        }
+    }
+    slot->value = frame;
+    slot->sequence.store(position + 1, std::memory_order_release);
+
+    size_t occupancy = size();
+    size_t peak = peak_occupancy.load(std::memory_order_relaxed);
+    while (occupancy > peak && !peak_occupancy.compare_exchange_weak(peak, occupancy, std::memory_order_relaxed))
+    {
+    }
+    return true;
+}
+
+bool FrameRingBuffer::push(const TimestampedFrame& frame)
+{
+    bool pushed = tryPush(frame);
+    notify();
+    return pushed;
+}
+
+bool FrameRingBuffer::offer(const TimestampedFrame& frame)
+{
+    bool pushed = enqueue(frame);
+    notify();
+    return pushed;
+}
+
+void FrameRingBuffer::recordDrop()
+{
+    dropped_frames.fetch_add(1, std::memory_order_relaxed);
+}
+
+bool FrameRingBuffer::tryPop(TimestampedFrame& frame)
+{
+    size_t position = dequeue_position.load(std::memory_order_relaxed);
+    Slot* slot;
+    while (true)
+    {
+        slot = &slots[position & mask];
+        size_t sequence = slot->sequence.load(std::memory_order_acquire);
+        intptr_t difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position + 1);
+        if (difference == 0)
+        {
+            if (dequeue_position.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+            {
+                break;
+            }
+        }
+        else if (difference < 0)
+        {
+            /* Nothing published at this position yet */
+            return false;
+        }
+        else
+        {
+            position = dequeue_position.load(std::memory_order_relaxed);
+        }
+    }
+    frame = slot->value;
+    /* Hand the slot back to the producers for the next lap */
+    slot->sequence.store(position + mask + 1, std::memory_order_release);
+    return true;
+}
+
+bool FrameRingBuffer::waitPop(TimestampedFrame& frame, int timeout_ms)
+{
+    if (tryPop(frame))
+    {
+        return true;
+    }
+
+    /* Announce that we are going to sleep, then check again so a frame pushed
+       in between is not missed. Pairs with the fence in notify(). */
+    consumer_waiting.store(true, std::memory_order_seq_cst);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (tryPop(frame))
+    {
+        consumer_waiting.store(false, std::memory_order_relaxed);
+        return true;
+    }
+
+    struct pollfd poll_fd = {event_fd, POLLIN, 0};
+    if (poll(&poll_fd, 1, timeout_ms) > 0)
+    {
+        uint64_t counter;
+        /* Reset the eventfd counter, the value itself is not used */
+        if (read(event_fd, &counter, sizeof(counter)) < 0)
+        {
+            counter = 0;
+        }
+    }
+    consumer_waiting.store(false, std::memory_order_relaxed);
+    return tryPop(frame);
+}
+
+void FrameRingBuffer::notify()
+{
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (consumer_waiting.load(std::memory_order_seq_cst))
+    {
+        wakeUp();
+    }
+}
+
+void FrameRingBuffer::wakeUp()
+{
+    uint64_t increment = 1;
+    if (write(event_fd, &increment, sizeof(increment)) < 0)
+    {
+        /* Counter already signalled, the consumer will wake up anyway */
+        increment = 0;
+    }
+}
+
+size_t FrameRingBuffer::size() const
+{
+    size_t enqueued = enqueue_position.load(std::memory_order_acquire);
+    size_t dequeued = dequeue_position.load(std::memory_order_acquire);
+    return enqueued > dequeued ? enqueued - dequeued : 0;
+}
+
+bool FrameRingBuffer::empty() const
+{
+    return size() == 0;
+}
+
+size_t FrameRingBuffer::capacity() const
+{
+    return mask + 1;
+}
+
+size_t FrameRingBuffer::getPeakOccupancy() const
+{
+    return peak_occupancy.load(std::memory_order_relaxed);
+}
+
+uint64_t FrameRingBuffer::getDroppedFrames() const
+{
+    return dropped_frames.load(std::memory_order_relaxed);
+}
+
+int FrameRingBuffer::getEventFd() const
+{
+    return event_fd;
+}
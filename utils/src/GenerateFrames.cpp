@@ -1,5 +1,11 @@
 #include "GenerateFrames.h"
 
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <cstring>
+#include <algorithm>
+
 GenerateFrames::GenerateFrames(Logger& logger)
     : logger(logger)
 {}
@@ -14,9 +20,35 @@ int GenerateFrames::getSocket()
     return this->socket;
 }
 
-struct can_frame GenerateFrames::createFrame(int &id,  std::vector<uint8_t> &data, FrameType frameType)
+namespace
 {
-    struct can_frame frame;
+    /* Transmit counters, one slot per socket descriptor */
+    struct SocketCounters
+    {
+        std::atomic<uint64_t> frames_sent{0};
+        std::atomic<uint64_t> send_errors{0};
+        std::atomic<int> last_error{0};
+    };
+    SocketCounters transmit_counters[TX_STATS_SOCKETS];
+
+    SocketCounters& countersFor(int socket)
+    {
+        if (socket < 0 || socket >= TX_STATS_SOCKETS)
+        {
+            return transmit_counters[TX_STATS_SOCKETS - 1];
+        }
+        return transmit_counters[socket];
+    }
+}
+
+bool GenerateFrames::fillFrame(struct can_frame& frame, int id, const uint8_t* data, size_t length, FrameType frameType)
+{
+    bool fits = length <= CAN_MAX_DLEN;
+    if (!fits)
+    {
+        length = CAN_MAX_DLEN;
+    }
+    memset(&frame, 0, sizeof(frame));
     switch (frameType)
     {
         case ERROR_FRAME:
@@ -27,57 +59,284 @@ struct can_frame GenerateFrames::createFrame(int &id,  std::vector<uint8_t> &dat
         break;
         case DATA_FRAME:
             frame.can_id = (id & CAN_EFF_MASK) | CAN_EFF_FLAG;
-            frame.can_dlc = data.size();
-            for (uint8_t byte = 0; byte < frame.can_dlc; byte++)
+            frame.can_dlc = length;
+            if (length > 0)
             {
-                frame.data[byte] = data[byte];
+                memcpy(frame.data, data, length);
             }
             break;
         case REMOTE_FRAME:
             frame.can_id = (id & CAN_EFF_MASK) | CAN_EFF_FLAG;
             frame.can_id |= CAN_RTR_FLAG;
-            frame.can_dlc = data.size();
-            for (uint8_t byte = 0; byte < frame.can_dlc; byte++)
+            frame.can_dlc = length;
+            if (length > 0)
             {
-                frame.data[byte] = data[byte];
+                memcpy(frame.data, data, length);
             }
             break;
     }
-    return frame;
+    return fits;
 }
 
-bool GenerateFrames::sendFrame(int id, std::vector<uint8_t > data, FrameType frameType)
+bool GenerateFrames::fillFrame(struct canfd_frame& frame, int id, const uint8_t* data, size_t length)
 {
-    struct can_frame frame = createFrame(id, data, frameType);
-    int nbytes = write(this->socket, &frame, sizeof(frame));
-    if (nbytes != sizeof(frame))
+    bool fits = length <= CANFD_MAX_DLEN;
+    if (!fits)
     {
-        /* std::cout<<"Write error\n"; */
-        LOG_WARN(logger.GET_LOGGER(), "Write error\n");
-        return -1;
+        length = CANFD_MAX_DLEN;
+    }
+    memset(&frame, 0, sizeof(frame));
+    frame.can_id = (id & CAN_EFF_MASK) | CAN_EFF_FLAG;
+    /* Above 8 bytes only some data lengths exist, the rest of the frame is padding */
+    frame.len = length <= CAN_MAX_DLEN ? length : CanFd::paddedLength(length);
+    if (length > 0)
+    {
+        memcpy(frame.data, data, length);
     }
-    return 0;
+    memset(frame.data + length, CAN_FD_PADDING, frame.len - length);
+    return fits;
+}
+
+bool GenerateFrames::sendFrame(int id, const std::vector<uint8_t>& data, FrameType frameType)
+{
+    return sendPayload(id, data.data(), data.size(), frameType);
 }
 
-int GenerateFrames::sendFrame(int can_id, std::vector<uint8_t> data, int s, FrameType frameType) 
+bool GenerateFrames::sendPayload(int id, const uint8_t* data, size_t length, FrameType frameType)
+{
+    struct can_frame frame;
+    if (!fillFrame(frame, id, data, length, frameType))
+    {
+        rejectOversized(this->socket, length);
+        return false;
+    }
+    return transmit(&frame, 1, this->socket) == 1;
+}
+
+int GenerateFrames::sendFrame(int can_id, const std::vector<uint8_t>& data, int s, FrameType frameType) 
+{
+    return sendFrame(can_id, data.data(), data.size(), s, frameType);
+}
+
+int GenerateFrames::sendFrame(int can_id, const uint8_t* data, size_t length, int s, FrameType frameType)
 {
     if (s < 0)
     {
-        throw std::runtime_error("Socket not initialized");
         LOG_ERROR(logger.GET_LOGGER(), "Socket not initialized");
+        throw std::runtime_error("Socket not initialized");
     }
 
     /* Create the CAN frame */
-    struct can_frame frame = createFrame(can_id, data, frameType);
+    struct can_frame frame;
+    if (!fillFrame(frame, can_id, data, length, frameType))
+    {
+        rejectOversized(s, length);
+        return -1;
+    }
 
     /* Send the CAN frame */
-    if (write(s, &frame, sizeof(frame)) != sizeof(frame)) 
+    return transmit(&frame, 1, s) == 1 ? 0 : -1;
+}
+
+int GenerateFrames::sendFrames(const struct can_frame* frames, size_t count, int s)
+{
+    if (s < 0)
     {
-        perror("Write");
-        return -1;
+        LOG_ERROR(logger.GET_LOGGER(), "Socket not initialized");
+        throw std::runtime_error("Socket not initialized");
+    }
+    return transmit(frames, count, s);
+}
+
+int GenerateFrames::sendFrames(const struct canfd_frame* frames, size_t count, int s)
+{
+    if (s < 0)
+    {
+        LOG_ERROR(logger.GET_LOGGER(), "Socket not initialized");
+        throw std::runtime_error("Socket not initialized");
+    }
+    return transmitFd(frames, count, s);
+}
+
+int GenerateFrames::sendMultiFrame(int id, const uint8_t* data, size_t length, int s)
+{
+    if (s < 0)
+    {
+        LOG_ERROR(logger.GET_LOGGER(), "Socket not initialized");
+        throw std::runtime_error("Socket not initialized");
+    }
+    return sendSegmented(id, data, length, true, true, s);
+}
+
+int GenerateFrames::transmit(const struct can_frame* frames, size_t count, int s)
+{
+    if (count == 0 || !CanFd::useFd(s, frames[0].can_id))
+    {
+        return writeFrames(frames, sizeof(struct can_frame), count, s);
+    }
+    /* The receiver talks CAN FD: the same frames, in the CAN FD format */
+    struct canfd_frame fd_frames[TX_BATCH_SIZE];
+    size_t sent = 0;
+    while (sent < count)
+    {
+        size_t batch = std::min(count - sent, static_cast<size_t>(TX_BATCH_SIZE));
+        for (size_t index = 0; index < batch; ++index)
+        {
+            fd_frames[index] = CanFd::toFdFrame(frames[sent + index]);
+        }
+        int result = transmitFd(fd_frames, batch, s);
+        sent += result;
+        if (static_cast<size_t>(result) < batch)
+        {
+            break;
+        }
+    }
+    return sent;
+}
+
+int GenerateFrames::transmitFd(const struct canfd_frame* frames, size_t count, int s)
+{
+    if (count == 0)
+    {
+        return 0;
+    }
+    bool fits_classic = std::all_of(frames, frames + count,
+        [](const struct canfd_frame& frame) { return frame.len <= CAN_MAX_DLEN; });
+    if (CanFd::useFd(s, frames[0].can_id) || !fits_classic)
+    {
+        int sent = writeFrames(frames, sizeof(struct canfd_frame), count, s);
+        if (sent != 0 || errno != EINVAL || !CanFd::isSocketFd(s))
+        {
+            return sent;
+        }
+        /* The interface has the classic MTU (e.g. recreated without CAN FD) */
+        LOG_WARN(logger.GET_LOGGER(), "CAN FD frames refused on socket {}, back to classic CAN", s);
+        CanFd::setSocketFd(s, false);
+        if (!fits_classic)
+        {
+            return 0;
+        }
+    }
+    /* Classic receiver: the frames go out in the classic format */
+    struct can_frame classic_frames[TX_BATCH_SIZE];
+    size_t sent = 0;
+    while (sent < count)
+    {
+        size_t batch = std::min(count - sent, static_cast<size_t>(TX_BATCH_SIZE));
+        for (size_t index = 0; index < batch; ++index)
+        {
+            classic_frames[index] = CanFd::toClassicFrame(frames[sent + index]);
+        }
+        int result = writeFrames(classic_frames, sizeof(struct can_frame), batch, s);
+        sent += result;
+        if (static_cast<size_t>(result) < batch)
+        {
+            break;
+        }
     }
-    return 0;
+    return sent;
 }
+
+int GenerateFrames::writeFrames(const void* frames, size_t mtu, size_t count, int s)
+{
+    const uint8_t* frame_bytes = static_cast<const uint8_t*>(frames);
+    struct mmsghdr messages[TX_BATCH_SIZE];
+    struct iovec vectors[TX_BATCH_SIZE];
+    size_t sent = 0;
+    int retries = 0;
+    int error = 0;
+
+    while (sent < count)
+    {
+        size_t batch = std::min(count - sent, static_cast<size_t>(TX_BATCH_SIZE));
+        memset(messages, 0, batch * sizeof(struct mmsghdr));
+        for (size_t index = 0; index < batch; ++index)
+        {
+            vectors[index].iov_base = const_cast<uint8_t*>(frame_bytes + (sent + index) * mtu);
+            vectors[index].iov_len = mtu;
+            messages[index].msg_hdr.msg_iov = &vectors[index];
+            messages[index].msg_hdr.msg_iovlen = 1;
+        }
+
+        int result = sendmmsg(s, messages, batch, 0);
+        if (result < 0 && errno == ENOTSOCK)
+        {
+            /* Not a socket (e.g. a pipe in the tests), fall back to one write per frame */
+            result = 0;
+            while (static_cast<size_t>(result) < batch &&
+                   write(s, frame_bytes + (sent + result) * mtu, mtu) == static_cast<ssize_t>(mtu))
+            {
+                ++result;
+            }
+            if (result == 0)
+            {
+                result = -1;
+            }
+        }
+        if (result > 0)
+        {
+            sent += result;
+            retries = 0;
+            continue;
+        }
+        if ((errno == ENOBUFS || errno == EAGAIN) && retries++ < TX_RETRY_LIMIT)
+        {
+            /* The transmit queue of the interface is full, give it time to drain */
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            continue;
+        }
+        error = errno;
+        break;
+    }
+    recordTransmit(s, sent, error);
+    /* The logging may have changed errno, the caller gets the error of the write */
+    errno = error;
+    return sent;
+}
+
+void GenerateFrames::recordTransmit(int s, size_t sent, int error)
+{
+    SocketCounters& counters = countersFor(s);
+    counters.frames_sent.fetch_add(sent, std::memory_order_relaxed);
+    if (error == 0)
+    {
+        return;
+    }
+    counters.last_error.store(error, std::memory_order_relaxed);
+    uint64_t errors = counters.send_errors.fetch_add(1, std::memory_order_relaxed) + 1;
+    if ((errors & (errors - 1)) == 0)
+    {
+        LOG_WARN(logger.GET_LOGGER(), "Write error on socket {}: {} ({} failed writes so far)", s, strerror(error), errors);
+    }
+}
+
+void GenerateFrames::rejectOversized(int s, size_t length)
+{
+    /* Always logged: this is a caller error, not a bus condition */
+    SocketCounters& counters = countersFor(s);
+    counters.send_errors.fetch_add(1, std::memory_order_relaxed);
+    counters.last_error.store(EMSGSIZE, std::memory_order_relaxed);
+    LOG_WARN(logger.GET_LOGGER(), "Write error: {} bytes do not fit in a CAN frame, frame not sent", length);
+}
+
+TransmitStats GenerateFrames::getTransmitStats(int socket)
+{
+    SocketCounters& counters = countersFor(socket);
+    TransmitStats stats;
+    stats.frames_sent = counters.frames_sent.load(std::memory_order_relaxed);
+    stats.send_errors = counters.send_errors.load(std::memory_order_relaxed);
+    stats.last_error = counters.last_error.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void GenerateFrames::resetTransmitStats(int socket)
+{
+    SocketCounters& counters = countersFor(socket);
+    counters.frames_sent = 0;
+    counters.send_errors = 0;
+    counters.last_error = 0;
+}
+
 void GenerateFrames::addSocket(int socket)
 {
     if (socket >= 0)
@@ -92,78 +351,70 @@ void GenerateFrames::addSocket(int socket)
 
 void GenerateFrames::sessionControl(int id, uint8_t sub_function, bool response)
 {
-    std::vector<uint8_t> data(3);
-    if (!response)
-    {
-        data = {0x2,0x10,sub_function};
-        this->sendFrame(id,data);
-        return;
-    }
-    data = {0x2,0x50,sub_function};
-    this->sendFrame(id, data);
+    const uint8_t data[] = {0x2, static_cast<uint8_t>(response ? 0x50 : 0x10), sub_function};
+    this->sendPayload(id, data, sizeof(data));
     return;
 }
 
 void GenerateFrames::ecuReset(int id, uint8_t sub_function, bool response)
 {
-    std::vector<uint8_t> data(3);
-    if (!response)
-    {
-        data = {0x2,0x11,sub_function};
-        this->sendFrame(id, data);
-        return;
-    }
-    data = {0x2,0x51,sub_function};
-    this->sendFrame(id, data);
+    const uint8_t data[] = {0x2, static_cast<uint8_t>(response ? 0x51 : 0x11), sub_function};
+    this->sendPayload(id, data, sizeof(data));
     return;
 }
 
 void GenerateFrames::ecuReset(int id, uint8_t sub_function, int socket, bool response)
 {
-    std::vector<uint8_t> data(3);
-    if (!response)
-    {
-        data = {0x2,0x11,sub_function};
-        this->sendFrame(id, data, socket, FrameType::DATA_FRAME);
-        return;
-    }
-    data = {0x2,0x51,sub_function};
-    this->sendFrame(id, data, socket, FrameType::DATA_FRAME);
+    const uint8_t data[] = {0x2, static_cast<uint8_t>(response ? 0x51 : 0x11), sub_function};
+    this->sendFrame(id, data, sizeof(data), socket, FrameType::DATA_FRAME);
     return;
 }
 
-void GenerateFrames::securityAccessRequestSeed(int id, const std::vector<uint8_t> &seed)
+void GenerateFrames::securityAccessRequestSeed(int id, const std::vector<uint8_t> &seed, IsoTpTransmitter::CompletionCallback on_done)
 {
     if (seed.size() == 0)
     {
-        std::vector<uint8_t> data = {0x02, 0x27, 0x1};
-        this->sendFrame(id, data);
+        const uint8_t data[] = {0x02, 0x27, 0x1};
+        this->sendPayload(id, data, sizeof(data));
         return;
     }
-    std::vector<uint8_t> data = {(uint8_t)(seed.size() + 2), 0x67, 0x1};
-    for (uint8_t data_seed: seed)
-    {
-        data.push_back(data_seed);
+    std::vector<uint8_t> data;
+    data.reserve(3 + seed.size());
+    /* The length byte is only used by a single frame, the transmitter takes the size of the message */
+    data.push_back((uint8_t)(seed.size() + 2));
+    data.push_back(0x67);
+    data.push_back(0x1);
+    data.insert(data.end(), seed.begin(), seed.end());
+    if (data.size() <= CAN_MAX_DLEN)
+    {
+        this->sendPayload(id, data.data(), data.size());
+        return;
     }
-    this->sendFrame(id, data);
-    return;
+    /* A seed longer than 5 bytes does not fit in a single frame */
+    GenerateConsecutiveFrames(id, data, true, std::move(on_done));
 }
 
-void GenerateFrames::securityAccessSendKey(int id, const std::vector<uint8_t> &key)
+void GenerateFrames::securityAccessSendKey(int id, const std::vector<uint8_t> &key, IsoTpTransmitter::CompletionCallback on_done)
 {
-    if (key.size() > 0 )
+    if (key.size() == 0)
     {
-        std::vector<uint8_t> data = {(uint8_t)(key.size() + 2), 0x27, 0x2};
-        for (uint8_t data_key: key)
-        {
-            data.push_back(data_key);
-        }
-        this->sendFrame(id, data);
+        const uint8_t data[] = {0x02,0x67,0x02};
+        this->sendPayload(id, data, sizeof(data));
         return;
     }
-    std::vector<uint8_t> data = {0x02,0x67,0x02};
-    this->sendFrame(id, data);
-    return;
+    std::vector<uint8_t> data;
+    data.reserve(3 + key.size());
+    data.push_back((uint8_t)(key.size() + 2));
+    data.push_back(0x27);
+    data.push_back(0x2);
+    data.insert(data.end(), key.begin(), key.end());
+    if (data.size() <= CAN_MAX_DLEN)
+    {
+        this->sendPayload(id, data.data(), data.size());
+        return;
+    }
+    /* A key longer than 5 bytes does not fit in a single frame */
+    GenerateConsecutiveFrames(id, data, true, std::move(on_done));
 }
 
 void GenerateFrames::routineControl(int id, uint8_t sub_function, uint16_t routine_identifier, std::vector<uint8_t>& routine_result, bool response)
@@ -183,14 +434,8 @@ void GenerateFrames::routineControl(int id, uint8_t sub_function, uint16_t routi
 
 void GenerateFrames::testerPresent(int id, bool response)
 {
-    if (!response)
-    {
-        std::vector<uint8_t> data = {0x02,0x3E,0x00};
-        this->sendFrame(id, data);
-        return;
-    }
-    std::vector<uint8_t> data = {0x02,0x7E,0x00};
-    this->sendFrame(id, data);
+    const uint8_t data[] = {0x02, static_cast<uint8_t>(response ? 0x7E : 0x3E), 0x00};
+    this->sendPayload(id, data, sizeof(data));
     return;
 }
 
@@ -198,19 +443,16 @@ void GenerateFrames::readDataByIdentifier(int id,int identifier, std::vector<uin
 {
     if (response.size() == 0)
     {
-        std::vector<uint8_t> data = {0x03, 0x22, (uint8_t)(identifier/0x100), (uint8_t)(identifier%0x100)};
-        this->sendFrame(id, data);
+        const uint8_t data[] = {0x03, 0x22, (uint8_t)(identifier/0x100), (uint8_t)(identifier%0x100)};
+        this->sendPayload(id, data, sizeof(data));
         return;
     }
     int length_response = response.size();
     if (length_response <= 4)
     {
-        std::vector<uint8_t> data = {(uint8_t)(length_response + 3), 0x62, (uint8_t)(identifier/0x100), (uint8_t)(identifier%0x100)};
-        for (uint8_t data_response: response)
-        {
-            data.push_back(data_response);
-        }
-        this->sendFrame(id, data);
+        uint8_t data[CAN_MAX_DLEN] = {(uint8_t)(length_response + 3), 0x62, (uint8_t)(identifier/0x100), (uint8_t)(identifier%0x100)};
+        memcpy(data + 4, response.data(), length_response);
+        this->sendPayload(id, data, length_response + 4);
         return;
     }
     /* std::cout<<"ERROR: The frame is to long!, consider using method ReadDataByIdentifierLongResponse\n"; */
@@ -224,7 +466,7 @@ void GenerateFrames::readDataByIdentifier(int id,int identifier, std::vector<uin
     */
 }
 
-void GenerateFrames::readDataByIdentifierLongResponse(int id,uint16_t identifier, std::vector<uint8_t> response, bool first_frame)
+void GenerateFrames::readDataByIdentifierLongResponse(int id,uint16_t identifier, std::vector<uint8_t> response, bool first_frame, IsoTpTransmitter::CompletionCallback on_done)
 {
     int length_response = response.size();
     std::vector<uint8_t> data = {(uint8_t)(length_response + 3), 0x62, (uint8_t)(identifier/0x100), (uint8_t)(identifier%0x100)};
@@ -235,7 +477,7 @@ void GenerateFrames::readDataByIdentifierLongResponse(int id,uint16_t identifier
     
     if (data.size() > 8)
     {
-        GenerateConsecutiveFrames(id,data,first_frame);
+        GenerateConsecutiveFrames(id,data,first_frame,on_done);
     }
      else
     {
@@ -243,9 +485,87 @@ void GenerateFrames::readDataByIdentifierLongResponse(int id,uint16_t identifier
     }
 }
 
+void GenerateFrames::readDataByIdentifier(int id, const std::vector<uint16_t>& identifiers, IsoTpTransmitter::CompletionCallback on_done)
+{
+    std::vector<uint8_t> data;
+    data.reserve(2 + 2 * identifiers.size());
+    data.push_back((uint8_t)(1 + 2 * identifiers.size()));
+    data.push_back(0x22);
+    for (uint16_t identifier : identifiers)
+    {
+        data.push_back((uint8_t)(identifier / 0x100));
+        data.push_back((uint8_t)(identifier % 0x100));
+    }
+    if (data.size() <= CAN_MAX_DLEN)
+    {
+        this->sendPayload(id, data.data(), data.size());
+        return;
+    }
+    GenerateConsecutiveFrames(id, data, true, std::move(on_done));
+}
+
+void GenerateFrames::readDataByIdentifierRecords(int id, const std::vector<uint8_t>& records, IsoTpTransmitter::CompletionCallback on_done)
+{
+    std::vector<uint8_t> data;
+    data.reserve(2 + records.size());
+    /* The length byte is only used by a single frame, the transmitter takes the size of the message */
+    data.push_back((uint8_t)(records.size() + 1));
+    data.push_back(0x62);
+    data.insert(data.end(), records.begin(), records.end());
+    if (data.size() <= CAN_MAX_DLEN)
+    {
+        this->sendPayload(id, data.data(), data.size());
+        return;
+    }
+    GenerateConsecutiveFrames(id, data, true, std::move(on_done));
+}
+
+void GenerateFrames::readDataByPeriodicIdentifier(int id, uint8_t transmission_mode, const std::vector<uint16_t>& identifiers, bool response)
+{
+    if (response)
+    {
+        const uint8_t data[] = {0x01, 0x6A};
+        this->sendPayload(id, data, sizeof(data));
+        return;
+    }
+    std::vector<uint8_t> data;
+    data.reserve(3 + 2 * identifiers.size());
+    data.push_back((uint8_t)(2 + 2 * identifiers.size()));
+    data.push_back(0x2A);
+    data.push_back(transmission_mode);
+    for (uint16_t identifier : identifiers)
+    {
+        data.push_back((uint8_t)(identifier / 0x100));
+        data.push_back((uint8_t)(identifier % 0x100));
+    }
+    if (data.size() <= CAN_MAX_DLEN)
+    {
+        this->sendPayload(id, data.data(), data.size());
+        return;
+    }
+    GenerateConsecutiveFrames(id, data, true);
+}
+
+void GenerateFrames::dynamicallyDefineDataIdentifier(int id, uint8_t sub_function, const std::vector<uint8_t>& definition, bool response)
+{
+    std::vector<uint8_t> data;
+    data.reserve(3 + definition.size());
+    data.push_back((uint8_t)(2 + definition.size()));
+    data.push_back(response ? 0x6C : 0x2C);
+    data.push_back(sub_function);
+    data.insert(data.end(), definition.begin(), definition.end());
+    if (data.size() <= CAN_MAX_DLEN)
+    {
+        this->sendPayload(id, data.data(), data.size());
+        return;
+    }
+    GenerateConsecutiveFrames(id, data, true);
+}
+
 void GenerateFrames::flowControlFrame(int id)
 {
-    this->sendFrame(id, {0x30,0x00,0x00,0x00});
+    const uint8_t data[] = {0x30,0x00,0x00,0x00};
+    this->sendPayload(id, data, sizeof(data));
 }
 
 void GenerateFrames::readMemoryByAddress(int id, int memory_address, int memory_size, std::vector<uint8_t> response )
@@ -285,7 +605,7 @@ void GenerateFrames::readMemoryByAddress(int id, int memory_address, int memory_
     }
 }
 
-void GenerateFrames::readMemoryByAddressLongResponse(int id, int memory_address, int memory_size, std::vector<uint8_t> response, bool first_frame)
+void GenerateFrames::readMemoryByAddressLongResponse(int id, int memory_address, int memory_size, std::vector<uint8_t> response, bool first_frame, IsoTpTransmitter::CompletionCallback on_done)
 {
     uint8_t length_memory_size = (countDigits(memory_size) +1) / 2;
     uint8_t length_memory_address = (countDigits(memory_address) + 1) / 2;
@@ -302,7 +622,7 @@ void GenerateFrames::readMemoryByAddressLongResponse(int id, int memory_address,
 
     if (data.size() > 8)
     {
-        GenerateConsecutiveFrames(id,data,first_frame);
+        GenerateConsecutiveFrames(id,data,first_frame,on_done);
     }
      else
     {
@@ -316,12 +636,9 @@ void GenerateFrames::writeDataByIdentifier(int id, uint16_t identifier, std::vec
     {
         if (data_parameter.size() <= 4)
         {
-            std::vector<uint8_t> data = {(uint8_t)(data_parameter.size() + 3),0x2E, (uint8_t)(identifier/0x100),(uint8_t)(identifier%0x100)};
-            for (uint8_t data_byte: data_parameter)
-            {
-                data.push_back(data_byte);
-            }
-            this->sendFrame(id, data);
+            uint8_t data[CAN_MAX_DLEN] = {(uint8_t)(data_parameter.size() + 3),0x2E, (uint8_t)(identifier/0x100),(uint8_t)(identifier%0x100)};
+            memcpy(data + 4, data_parameter.data(), data_parameter.size());
+            this->sendPayload(id, data, data_parameter.size() + 4);
             return;
         }
         else
@@ -331,12 +648,12 @@ void GenerateFrames::writeDataByIdentifier(int id, uint16_t identifier, std::vec
             return;
         }
     }
-    std::vector<uint8_t> data = {0x03, 0x6E, (uint8_t)(identifier/0x100),(uint8_t)(identifier%0x100)};
-    this->sendFrame(id, data);
+    const uint8_t data[] = {0x03, 0x6E, (uint8_t)(identifier/0x100),(uint8_t)(identifier%0x100)};
+    this->sendPayload(id, data, sizeof(data));
     return;
 }
 
-void GenerateFrames::writeDataByIdentifierLongData(int id, uint16_t identifier, std::vector<uint8_t> data_parameter, bool first_frame)
+void GenerateFrames::writeDataByIdentifierLongData(int id, uint16_t identifier, std::vector<uint8_t> data_parameter, bool first_frame, IsoTpTransmitter::CompletionCallback on_done)
 {
     std::vector<uint8_t> data = {(uint8_t)(data_parameter.size() + 3),0x2E, (uint8_t)(identifier/0x100),(uint8_t)(identifier%0x100)};
     for (uint8_t data_byte: data_parameter)
@@ -345,7 +662,7 @@ void GenerateFrames::writeDataByIdentifierLongData(int id, uint16_t identifier,
     }
     if (data.size() > 8)
     {
-        GenerateConsecutiveFrames(id,data,first_frame);
+        GenerateConsecutiveFrames(id,data,first_frame,on_done);
     }
      else
     {
@@ -355,15 +672,15 @@ void GenerateFrames::writeDataByIdentifierLongData(int id, uint16_t identifier,
 
 void GenerateFrames::readDtcInformation(int id, uint8_t sub_function, uint8_t dtc_status_mask)
 {
-    std::vector<uint8_t> data = {0x03, 0x19, sub_function, dtc_status_mask};
-    this->sendFrame(id, data);
+    const uint8_t data[] = {0x03, 0x19, sub_function, dtc_status_mask};
+    this->sendPayload(id, data, sizeof(data));
     return;
 }
 
 void GenerateFrames::readDtcInformationResponse01(int id, uint8_t status_availability_mask, uint8_t dtc_format_identifier, uint16_t dtc_count)
 {
-    std::vector<uint8_t> data = {0x06, 0x59, 0x01, status_availability_mask, dtc_format_identifier, uint8_t(dtc_count / 0x100), uint8_t(dtc_count % 0x100)};
-    this->sendFrame(id, data);
+    const uint8_t data[] = {0x06, 0x59, 0x01, status_availability_mask, dtc_format_identifier, uint8_t(dtc_count / 0x100), uint8_t(dtc_count % 0x100)};
+    this->sendPayload(id, data, sizeof(data));
     return;
 }
 
@@ -389,7 +706,7 @@ void GenerateFrames::readDtcInformationResponse02(int id, uint8_t status_availab
     return;
 }
 
-void GenerateFrames::readDtcInformationResponse02Long(int id, uint8_t status_availability_mask, std::vector<std::pair<int,int>> dtc_and_status_list, bool first_frame)
+void GenerateFrames::readDtcInformationResponse02Long(int id, uint8_t status_availability_mask, std::vector<std::pair<int,int>> dtc_and_status_list, bool first_frame, IsoTpTransmitter::CompletionCallback on_done)
 {
     std::vector<uint8_t> data = {0x00, 0x59, 0x02, status_availability_mask};
     uint8_t pci_l=3;
@@ -407,7 +724,7 @@ void GenerateFrames::readDtcInformationResponse02Long(int id, uint8_t status_ava
     data[0] = pci_l ;
     if (data.size() > 8)
     {
-        GenerateConsecutiveFrames(id,data,first_frame);
+        GenerateConsecutiveFrames(id,data,first_frame,on_done);
     }
      else
     {
@@ -416,36 +733,62 @@ void GenerateFrames::readDtcInformationResponse02Long(int id, uint8_t status_ava
     }
 }
 
-void GenerateFrames::GenerateConsecutiveFrames(int id, std::vector<uint8_t> data, bool first_frame)
+void GenerateFrames::GenerateConsecutiveFrames(int id, const std::vector<uint8_t>& data, bool first_frame, IsoTpTransmitter::CompletionCallback on_done)
 {
-    
     if (first_frame)
     {
-        std::vector<uint8_t> data_in_frame = {0x10};
-        data_in_frame.insert(data_in_frame.end(), data.begin(), data.begin() + 7);
-        this->sendFrame(id, data_in_frame);
+        /* The first frame is sent now, the consecutive frames follow the flow control
+           frames of the client (block size, STmin) without blocking the service */
+        IsoTpTransmitter::getInstance().send(this->socket, id, std::vector<uint8_t>(data.begin() + 1, data.end()), logger, std::move(on_done));
+        return;
     }
-    else
+    /* Consecutive frames only, sent together */
+    sendSegmented(id, data.data(), data.size(), false, true, this->socket);
+}
+
+int GenerateFrames::sendSegmented(int id, const uint8_t* data, size_t length, bool first_frame, bool consecutive_frames, int s)
+{
+    struct can_frame frames[TX_BATCH_SIZE];
+    size_t count = 0;
+    int sent = 0;
+    /* The first frame carries the first 7 bytes of the message */
+    size_t offset = std::min(length, static_cast<size_t>(7));
+
+    if (first_frame)
+    {
+        struct can_frame& frame = frames[count++];
+        fillFrame(frame, id, nullptr, 0);
+        frame.can_dlc = offset + 1;
+        frame.data[0] = 0x10;
+        memcpy(frame.data + 1, data, offset);
+    }
+    uint8_t sequence_number = 0;
+    while (consecutive_frames && offset < length)
     {
-        data.erase(data.begin(), data.begin() + 7);
-        uint8_t index = 0;
-        while (data.size())
+        if (count == TX_BATCH_SIZE)
         {
-            uint8_t head = 0x20 + (++index)  % 0xFF;
-            std::vector<uint8_t> data_in_frame = { head };
-            if (data.size() >=8)
+            int batch_sent = transmit(frames, count, s);
+            sent += batch_sent;
+            if (batch_sent != static_cast<int>(count))
             {
-                data_in_frame.insert(data_in_frame.end(), data.begin(), data.begin() + 7);
-                data.erase(data.begin(), data.begin() + 7);
+                return sent;
             }
-            else
-            {
-                data_in_frame.insert(data_in_frame.end(), data.begin(), data.begin() + data.size());
-                data.erase(data.begin(), data.begin() + data.size());
-            }
-            this->sendFrame(id, data_in_frame);
+            count = 0;
         }
+        size_t chunk = std::min(length - offset, static_cast<size_t>(7));
+        sequence_number = (sequence_number + 1) & 0x0F;
+        struct can_frame& frame = frames[count++];
+        fillFrame(frame, id, nullptr, 0);
+        frame.can_dlc = chunk + 1;
+        frame.data[0] = 0x20 | sequence_number;
+        memcpy(frame.data + 1, data + offset, chunk);
+        offset += chunk;
+    }
+    if (count > 0)
+    {
+        sent += transmit(frames, count, s);
     }
+    return sent;
 }
 
 void GenerateFrames::clearDiagnosticInformation(int id, std::vector<uint8_t> group_of_dtc, bool response)
@@ -473,8 +816,8 @@ void GenerateFrames::clearDiagnosticInformation(int id, std::vector<uint8_t> gro
         
     }
     /* Response */
-    data = {0x01, 0x54};
-    this->sendFrame(id, data);
+    const uint8_t response_data[] = {0x01, 0x54};
+    this->sendPayload(id, response_data, sizeof(response_data));
     return;
 }
 
@@ -482,14 +825,14 @@ void GenerateFrames::accessTimingParameters(int id, uint8_t sub_function, std::v
 {
     if (!response)
     {
-        std::vector<uint8_t> data = {0x02, 0x83, sub_function};
-        this->sendFrame(id, data);
+        const uint8_t data[] = {0x02, 0x83, sub_function};
+        this->sendPayload(id, data, sizeof(data));
         return;
     }
     else if(!data_parameter.size())
     {
-        std::vector<uint8_t> data = {0x02, 0xc3, sub_function};
-        this->sendFrame(id, data);
+        const uint8_t data[] = {0x02, 0xc3, sub_function};
+        this->sendPayload(id, data, sizeof(data));
         return;
     }
     else
@@ -501,8 +844,8 @@ void GenerateFrames::accessTimingParameters(int id, uint8_t sub_function, std::v
 
 void GenerateFrames::negativeResponse(int id, uint8_t sid, uint8_t nrc)
 {
-    std::vector<uint8_t> data = {0x03, 0x7F, sid, nrc};
-    this->sendFrame(id, data);
+    const uint8_t data[] = {0x03, 0x7F, sid, nrc};
+    this->sendPayload(id, data, sizeof(data));
     return;
 }
 
@@ -522,20 +865,20 @@ void GenerateFrames::requestDownload(int id, uint8_t data_format_identifier, int
     return;
 }
 
-void GenerateFrames::requestDownloadLong(int id, uint8_t data_format_identifier, int memory_address, int memory_size, uint8_t download_type, bool first_frame) 
+void GenerateFrames::requestDownloadLong(int id, uint8_t data_format_identifier, int memory_address, int memory_size, uint8_t download_type, bool first_frame, IsoTpTransmitter::CompletionCallback on_done) 
 {
     /* Request Frame add lengths of of memory size/address to the frame */
     uint8_t length_memory_size = (countDigits(memory_size ) + 1) / 2;
     uint8_t length_memory_address = (countDigits(memory_address) + 1 )/ 2;
     uint8_t length_memory = length_memory_size * 0x10 + length_memory_address;
-    uint8_t pci_length = length_memory_size + length_memory_address + 3 + 2;
+    uint8_t pci_length = length_memory_size + length_memory_address + 4;
     std::vector<uint8_t> data = {pci_length, 0x34, data_format_identifier, length_memory};
     /* add memory address and size to the frame */
     insertBytes(data, memory_address, length_memory_address);
     insertBytes(data, memory_size, length_memory_size);
     data.push_back(download_type);
     /* Send only 3 first bytes of data */
-    this->GenerateConsecutiveFrames(id, data, first_frame);
+    this->GenerateConsecutiveFrames(id, data, first_frame, on_done);
     return;
     
 }
@@ -571,12 +914,9 @@ void GenerateFrames::transferData(int id, uint8_t block_sequence_counter, std::v
     {
         if (transfer_request.size() <= 5)
         {
-             std::vector<uint8_t> data = {(uint8_t)(transfer_request.size() + 2), 0x36, block_sequence_counter};
-            for (uint8_t data_transfer: transfer_request)
-            {
-                data.push_back(data_transfer);
-            }
-            this->sendFrame(id, data);
+            uint8_t data[CAN_MAX_DLEN] = {(uint8_t)(transfer_request.size() + 2), 0x36, block_sequence_counter};
+            memcpy(data + 3, transfer_request.data(), transfer_request.size());
+            this->sendPayload(id, data, transfer_request.size() + 3);
             return;
         } else
         {
@@ -586,12 +926,12 @@ void GenerateFrames::transferData(int id, uint8_t block_sequence_counter, std::v
         }
     }
     /* Response frame */
-    std::vector<uint8_t> data = {0x02,0x76,block_sequence_counter};
-    this->sendFrame(id, data);
+    const uint8_t data[] = {0x02,0x76,block_sequence_counter};
+    this->sendPayload(id, data, sizeof(data));
     return;
 }
 
-void GenerateFrames::transferDataLong(int id, uint8_t block_sequence_counter, std::vector<uint8_t> transfer_request, bool first_frame)
+void GenerateFrames::transferDataLong(int id, uint8_t block_sequence_counter, std::vector<uint8_t> transfer_request, bool first_frame, IsoTpTransmitter::CompletionCallback on_done)
 {
     std::vector<uint8_t> data = {(uint8_t)(transfer_request.size() + 2), 0x36, block_sequence_counter};
     for (uint8_t data_transfer: transfer_request)
@@ -600,7 +940,7 @@ void GenerateFrames::transferDataLong(int id, uint8_t block_sequence_counter, st
     }
     if (data.size() > 8)
     {
-        GenerateConsecutiveFrames(id,data,first_frame);
+        GenerateConsecutiveFrames(id,data,first_frame,on_done);
     }
      else
     {
@@ -610,14 +950,8 @@ void GenerateFrames::transferDataLong(int id, uint8_t block_sequence_counter, st
 
 void GenerateFrames::requestTransferExit(int id, bool response)
 {
-    if (!response)
-    {
-        std::vector<uint8_t> data = {0x01, 0x37};
-        this->sendFrame(id, data);
-        return;
-    }
-    std::vector<uint8_t> data = {0x01,0x77};
-    this->sendFrame(id, data);
+    const uint8_t data[] = {0x01, static_cast<uint8_t>(response ? 0x77 : 0x37)};
+    this->sendPayload(id, data, sizeof(data));
     return;
 }
 
@@ -10,117 +10,108 @@ HandleFrames::HandleFrames(int socket, Logger& logger)
 /* Method to handle a can frame */
 void HandleFrames::handleFrame(int can_socket, const struct can_frame &frame) 
 {
-    /* Indicates whether the first frame has been received */
-    static bool first_frame_received = false;
-    /* Number of expected bytes of payload for multi-frame sequence */
-    static uint8_t expected_payload = 0;
-    /* frame data - for both single and multi frame sequence */
-    static std::vector<uint8_t> frame_data;
-    /* remember SID in case of multi-frame sequence*/
-    static uint8_t sid = 0;
-    /* check if the data is split across multiple frames */
-    static bool is_multi_frame = false;
-    /* Expected sequence number for consecutive frames */
-    static uint8_t expected_sequence_number = 0x21;
+    handleFrame(can_socket, CanFd::toFdFrame(frame));
+}
 
+/* Method to handle a can fd frame */
+void HandleFrames::handleFrame(int can_socket, const struct canfd_frame &frame) 
+{
     /* frame integrity checks will remain in Receive class for now */
     /* id < 0x10 == single frame*/
     if (frame.data[0] < 0x10) 
     {
+        /* CAN FD single frame: 0x00 followed by SF_DL; the services get the classic layout (SF_DL, SID, ...) */
+        size_t offset = 0;
+        size_t length = std::min<size_t>(frame.len, CAN_MAX_DLEN);
+        if (frame.data[0] == 0x00 && frame.len > CAN_MAX_DLEN)
+        {
+            offset = 1;
+            length = std::min<size_t>(frame.data[1] + 1, frame.len - 1);
+        }
         /* if frame is negative response, return */
-        if (frame.data[1] == 0x7F)
+        if (frame.data[offset + 1] == 0x7F)
         {
             LOG_INFO(_logger.GET_LOGGER(), "Negative response received.");
             return;
         }
 
-        sid = frame.data[1];  
+        uint8_t sid = frame.data[offset + 1];
         LOG_DEBUG(_logger.GET_LOGGER(), "Single Frame received:");
-        for (uint8_t data_pos = 0; data_pos < frame.can_dlc; ++data_pos) 
-        {
-            frame_data.push_back(frame.data[data_pos]);
-        }
-        std::cout << std::endl;
-        is_multi_frame = false;
+        std::vector<uint8_t> frame_data(frame.data + offset, frame.data + offset + length);
         /* Enter the switch case */
-        processFrameData(can_socket, frame.can_id, sid, frame_data, is_multi_frame);
-        /* clear data to be used by a future frame */
-        frame_data.clear();
-    /* id == 0x10 == first frame */
-    } 
-    else if (frame.data[0] == 0x10) 
-    {   
-        /* Number of expected bytes of payload */
-        expected_payload = frame.data[1];
-        /* Number of expected frames */
-        uint8_t expected_frames = frame.data[1] / 7;
-        if(frame.data[1] % 7 > 0)
-        {
-            expected_frames++;
-        }
-        /* get SID from the first frame */
-        sid = frame.data[2];
-        LOG_DEBUG(_logger.GET_LOGGER(), "Multi-frame Sequence with {} {}", (int)expected_frames, "frames");
-
-        /* Clear the multi_frame_data vector when receiving the first frame */
-        frame_data.clear();
+        processFrameData(can_socket, frame.can_id, sid, frame_data, false);
+        return;
+    }
 
-        /* Concatenate the data from the first frame into multi_frame_data */
-        for (uint8_t data_pos = 1; data_pos < frame.can_dlc; ++data_pos) 
+    uint8_t frame_type = frame.data[0] & 0xF0;
+    if (frame_type == 0x30)
+    {
+        /* Answer of the receiver to a multi-frame sequence sent by this module */
+        LOG_DEBUG(_logger.GET_LOGGER(), "Flow control frame received: status {} block size {} STmin {}",
+                  int(frame.data[0] & 0x0F), int(frame.data[1]), int(frame.data[2]));
+        if (!IsoTpTransmitter::getInstance().onFlowControl(frame))
         {
-            frame_data.push_back(frame.data[data_pos]);
+            LOG_WARN(_logger.GET_LOGGER(), "Flow control frame without a multi-frame sequence in progress.");
         }
-        /* Make sure sequenceNumber is set after receiving the first frame */
-        expected_sequence_number = 0x21;
-        first_frame_received = true;
-    /* id >= 0x20 == consecutive frame */
-    } 
-    else if (frame.data[0] >= 0x21 && frame.data[0] < 0x30) 
+        return;
+    }
+    if (frame_type != 0x10 && frame_type != 0x20)
+    {
+        LOG_ERROR(_logger.GET_LOGGER(), "Invalid frame type.");
+        return;
+    }
+    if (frame_type == 0x20)
     {
         LOG_DEBUG(_logger.GET_LOGGER(), "Consecutive frames received.");
-        if (!first_frame_received) 
-        {
-            /* Ignore consecutive frames until the first frame is received */
-            return;
-        }
-        /* Check if the frame's sequence number matches the expected sequence number */
-        if (frame.data[0] != expected_sequence_number) 
-        {
-            LOG_ERROR(_logger.GET_LOGGER(), "Invalid consecutive frame sequence: expected {} {} {}", int(expected_sequence_number), "but received", int(frame.data[0]));
-            return;
-        }
+    }
 
-        /* Concatenate the data from consecutive frames into multi_frame_data */
-        for (uint8_t data_pos = 1; data_pos < frame.can_dlc; ++data_pos) 
-        {
-            frame_data.push_back(frame.data[data_pos]);
-        }
-        /* Increment sequenceNumber after each concatenation*/
-        expected_sequence_number++;
-        /* Check if all multi-frames have been received */
-        if (frame_data.size() >= expected_payload) 
-        { 
-            LOG_DEBUG(_logger.GET_LOGGER(), "Data is: ");
-            for (uint8_t data_pos = 0; data_pos < (int)frame_data.size(); ++data_pos) 
-            {
-                LOG_INFO(_logger.GET_LOGGER(), int(frame_data[data_pos]));
-            }
-            std::cout << std::endl;
-            is_multi_frame = true;
+    /* First and consecutive frames are reassembled per sender, the message is processed
+       when its last consecutive frame is received */
+    std::vector<uint8_t> frame_data;
+    IsoTpReassembler::Result result = iso_tp.handleFrame(frame, frame_data);
+    if (result.send_flow_control)
+    {
+        sendFlowControl(can_socket, result);
+    }
+    switch (result.status)
+    {
+        case IsoTpReassembler::FIRST_FRAME:
+            LOG_DEBUG(_logger.GET_LOGGER(), "Multi-frame Sequence with {} {}", result.frame_count, "frames");
+            break;
+        case IsoTpReassembler::COMPLETE:
+            LOG_DEBUG(_logger.GET_LOGGER(), "Multi-frame message of {} bytes received.", result.message_length);
             /* Enter the switch case */
-            processFrameData(can_socket, frame.can_id, sid, frame_data, is_multi_frame);
-            /* Reset sequenceNumber for the next sequence */
-            expected_sequence_number = 0x21;
-            /* Reset variables */
-            first_frame_received = false;
-            expected_payload = 0;
-            frame_data.clear();
-        }
-    } 
-    else 
+            processFrameData(can_socket, frame.can_id, frame_data[1], frame_data, true);
+            break;
+        case IsoTpReassembler::NO_CONTEXT:
+            /* Ignore consecutive frames until the first frame is received */
+            break;
+        case IsoTpReassembler::TIMEOUT:
+            LOG_ERROR(_logger.GET_LOGGER(), "Multi-frame sequence from 0x{:x} timed out (N_Cr).", frame.can_id & CAN_EFF_MASK);
+            break;
+        case IsoTpReassembler::WRONG_SEQUENCE:
+            LOG_ERROR(_logger.GET_LOGGER(), "Invalid consecutive frame sequence: expected {} {} {}", int(result.expected_pci), "but received", int(result.received_pci));
+            break;
+        case IsoTpReassembler::BUFFER_OVERFLOW:
+            LOG_ERROR(_logger.GET_LOGGER(), "Multi-frame Sequence of {} bytes rejected: no buffer available.", result.message_length);
+            break;
+        case IsoTpReassembler::IGNORED:
+            LOG_ERROR(_logger.GET_LOGGER(), "Invalid first frame length.");
+            break;
+        default:
+            break;
+    }
+}
+
+/* Method to answer a multi-frame sequence with a flow control frame */
+void HandleFrames::sendFlowControl(int can_socket, const IsoTpReassembler::Result& result)
+{
+    if (can_socket < 0)
     {
-        LOG_ERROR(_logger.GET_LOGGER(), "Invalid frame type.");
+        return;
     }
+    GenerateFrames generate_frames(can_socket, _logger);
+    generate_frames.sendFrame(result.flow_control_id, result.flow_control.data(), result.flow_control.size(), can_socket);
 }
 
 /* Method to call the service or handle the response*/
@@ -209,6 +200,24 @@ void HandleFrames::processFrameData(int can_socket, canid_t frame_id, uint8_t si
             read_data_by_identifier.readDataByIdentifier(frame_id, frame_data, true);
             break;
         }
+        case 0x2A:
+        {
+            /* ReadDataByPeriodicIdentifier(sid, frame_data[2], DIDs); */
+            /* This service can be called in any session */
+            LOG_INFO(_logger.GET_LOGGER(), "ReadDataByPeriodicIdentifier called.");
+            ReadDataByPeriodicIdentifier read_data_by_periodic_identifier(can_socket, _logger);
+            read_data_by_periodic_identifier.readDataByPeriodicIdentifier(frame_id, frame_data);
+            break;
+        }
+        case 0x2C:
+        {
+            /* DynamicallyDefineDataIdentifier(sid, frame_data[2], dynamic DID, definition); */
+            /* This service can be called in any session */
+            LOG_INFO(_logger.GET_LOGGER(), "DynamicallyDefineDataIdentifier called.");
+            DynamicallyDefineDataIdentifier dynamically_define_data_identifier(can_socket, _logger);
+            dynamically_define_data_identifier.dynamicallyDefineDataIdentifier(frame_id, frame_data);
+            break;
+        }
         case 0x23:
         {
             /* ReadMemoryByAddress(frame_data[2], frame_data[3] << 8) | frame_data[4], frame_data[5] << 8) | frame_data[6]); */
@@ -337,6 +346,12 @@ void HandleFrames::processFrameData(int can_socket, canid_t frame_id, uint8_t si
             }
             break;
         }
+        case 0x6C:
+        {
+            /* Response from DynamicallyDefineDataIdentifier() service */
+            LOG_INFO(_logger.GET_LOGGER(), "Response from DynamicallyDefineDataIdentifier received.");
+            break;
+        }
         case 0x6E:
         {
             /* Response from WriteDataByIdentifier() service */
@@ -385,27 +400,28 @@ void HandleFrames::processFrameData(int can_socket, canid_t frame_id, uint8_t si
         case 0x36:
         {
             /* TransferData(sid, frame_data[2], frame_data[3], frame_data[4]); */
+            /* Blocks bigger than 5 bytes (max_number_block from Request Download) come in multiple frames */
             if(is_multi_frame)
             {
                 LOG_DEBUG(_logger.GET_LOGGER(), "TransferData called with multiple frames.");
             }
-            else 
+            /* This service can be called in PROGRAMMING_SESSION */
+            if(DiagnosticSessionControl::getCurrentSessionToString() == "PROGRAMMING_SESSION" ||
+                DiagnosticSessionControl::getCurrentSessionToString() == "EXTENDED_DIAGNOSTIC_SESSION")
             {
-                /* This service can be called in PROGRAMMING_SESSION */
-                if(DiagnosticSessionControl::getCurrentSessionToString() == "PROGRAMMING_SESSION" ||
-                    DiagnosticSessionControl::getCurrentSessionToString() == "EXTENDED_DIAGNOSTIC_SESSION")
+                TransferData transfer_data(can_socket, _logger);
+                transfer_data.transferData(frame_id, frame_data);
+                if(!is_multi_frame)
                 {
-                    TransferData transfer_data(can_socket, _logger);
-                    transfer_data.transferData(frame_id, frame_data);
                     LOG_DEBUG(_logger.GET_LOGGER(), "TransferData called with one frame.");
                 }
-                else
-                {
-                    LOG_INFO(_logger.GET_LOGGER(), "Subfunction not supported in active session.");
-                    int new_id = ((frame_id & 0xFF) << 8) | ((frame_id >> 8) & 0xFF);
-                    NegativeResponse negative_response(can_socket, _logger);
-                    negative_response.sendNRC(new_id, 0x36, 0x7F);
-                }
+            }
+            else
+            {
+                LOG_INFO(_logger.GET_LOGGER(), "Subfunction not supported in active session.");
+                int new_id = ((frame_id & 0xFF) << 8) | ((frame_id >> 8) & 0xFF);
+                NegativeResponse negative_response(can_socket, _logger);
+                negative_response.sendNRC(new_id, 0x36, 0x7F);
             }
             break;
         }
@@ -0,0 +1,330 @@
+#include "ImageDigest.h"
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <nmmintrin.h>
+#define IMAGE_DIGEST_X86_CRC 1
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#define IMAGE_DIGEST_ARM_CRC 1
+#endif
+
+namespace
+{
+    /* Reflected CRC32C polynomial */
+    const uint32_t CRC32C_POLYNOMIAL = 0x82F63B78;
+
+    struct Crc32cTables
+    {
+        uint32_t table[8][256];
+        Crc32cTables()
+        {
+            for (uint32_t byte = 0; byte < 256; ++byte)
+            {
+                uint32_t crc = byte;
+                for (int bit = 0; bit < 8; ++bit)
+                {
+                    crc = (crc >> 1) ^ ((crc & 1) ? CRC32C_POLYNOMIAL : 0);
+                }
+                table[0][byte] = crc;
+            }
+            for (uint32_t byte = 0; byte < 256; ++byte)
+            {
+                for (int slice = 1; slice < 8; ++slice)
+                {
+                    table[slice][byte] = (table[slice - 1][byte] >> 8) ^ table[0][table[slice - 1][byte] & 0xFF];
+                }
+            }
+        }
+    };
+
+    /* Portable version, 8 bytes per step */
+    uint32_t crc32cTable(uint32_t crc, const uint8_t* data, size_t size)
+    {
+        static const Crc32cTables tables;
+        while (size >= 8)
+        {
+            uint32_t low;
+            uint32_t high;
+            memcpy(&low, data, 4);
+            memcpy(&high, data + 4, 4);
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+            low = __builtin_bswap32(low);
+            high = __builtin_bswap32(high);
+#endif
+            low ^= crc;
+            crc = tables.table[7][low & 0xFF] ^ tables.table[6][(low >> 8) & 0xFF] ^
+                  tables.table[5][(low >> 16) & 0xFF] ^ tables.table[4][low >> 24] ^
+                  tables.table[3][high & 0xFF] ^ tables.table[2][(high >> 8) & 0xFF] ^
+                  tables.table[1][(high >> 16) & 0xFF] ^ tables.table[0][high >> 24];
+            data += 8;
+            size -= 8;
+        }
+        while (size-- > 0)
+        {
+            crc = (crc >> 8) ^ tables.table[0][(crc ^ *data++) & 0xFF];
+        }
+        return crc;
+    }
+
+#if defined(IMAGE_DIGEST_X86_CRC)
+    __attribute__((target("sse4.2")))
+    uint32_t crc32cHardware(uint32_t crc, const uint8_t* data, size_t size)
+    {
+#if defined(__x86_64__)
+        uint64_t crc64 = crc;
+        while (size >= 8)
+        {
+            uint64_t word;
+            memcpy(&word, data, 8);
+            crc64 = _mm_crc32_u64(crc64, word);
+            data += 8;
+            size -= 8;
+        }
+        crc = static_cast<uint32_t>(crc64);
+#endif
+        while (size-- > 0)
+        {
+            crc = _mm_crc32_u8(crc, *data++);
+        }
+        return crc;
+    }
+#elif defined(IMAGE_DIGEST_ARM_CRC)
+    uint32_t crc32cHardware(uint32_t crc, const uint8_t* data, size_t size)
+    {
+        while (size >= 8)
+        {
+            uint64_t word;
+            memcpy(&word, data, 8);
+            crc = __crc32cd(crc, word);
+            data += 8;
+            size -= 8;
+        }
+        while (size-- > 0)
+        {
+            crc = __crc32cb(crc, *data++);
+        }
+        return crc;
+    }
+#endif
+
+    const uint32_t SHA256_INITIAL_STATE[8] = {
+        0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+    };
+
+    const uint32_t SHA256_ROUND_CONSTANTS[64] = {
+        0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+        0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+        0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+        0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+        0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+        0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+        0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+        0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+    };
+
+    inline uint32_t rotateRight(uint32_t value, int bits)
+    {
+        return (value >> bits) | (value << (32 - bits));
+    }
+}
+
+ImageDigest::ImageDigest(bool sha256)
+{
+    reset(sha256);
+}
+
+void ImageDigest::reset(bool sha256)
+{
+    crc = 0xFFFFFFFF;
+    length = 0;
+    sha256_enabled = sha256;
+    memcpy(sha256_state, SHA256_INITIAL_STATE, sizeof(sha256_state));
+    sha256_block_size = 0;
+}
+
+void ImageDigest::update(const uint8_t* data, size_t size)
+{
+    crc = updateCrc32c(crc, data, size);
+    length += size;
+    if (!sha256_enabled)
+    {
+        return;
+    }
+    while (size > 0)
+    {
+        size_t bytes = std::min(size, sizeof(sha256_block) - sha256_block_size);
+        memcpy(sha256_block + sha256_block_size, data, bytes);
+        sha256_block_size += bytes;
+        data += bytes;
+        size -= bytes;
+        if (sha256_block_size == sizeof(sha256_block))
+        {
+            sha256Transform(sha256_state, sha256_block);
+            sha256_block_size = 0;
+        }
+    }
+}
+
+uint32_t ImageDigest::getCrc32c() const
+{
+    return crc ^ 0xFFFFFFFF;
+}
+
+std::vector<uint8_t> ImageDigest::getSha256() const
+{
+    if (!sha256_enabled)
+    {
+        return {};
+    }
+    /* Padding on copies, the running digest can be updated again */
+    uint32_t state[8];
+    uint8_t block[64];
+    memcpy(state, sha256_state, sizeof(state));
+    memcpy(block, sha256_block, sha256_block_size);
+    size_t block_size = sha256_block_size;
+    block[block_size++] = 0x80;
+    if (block_size > 56)
+    {
+        memset(block + block_size, 0, 64 - block_size);
+        sha256Transform(state, block);
+        block_size = 0;
+    }
+    memset(block + block_size, 0, 56 - block_size);
+    uint64_t bits = length * 8;
+    for (int byte = 0; byte < 8; ++byte)
+    {
+        block[63 - byte] = static_cast<uint8_t>(bits >> (8 * byte));
+    }
+    sha256Transform(state, block);
+
+    std::vector<uint8_t> digest(IMAGE_DIGEST_SHA256_LENGTH);
+    for (size_t word = 0; word < 8; ++word)
+    {
+        for (size_t byte = 0; byte < 4; ++byte)
+        {
+            digest[word * 4 + byte] = static_cast<uint8_t>(state[word] >> (24 - 8 * byte));
+        }
+    }
+    return digest;
+}
+
+uint64_t ImageDigest::getLength() const
+{
+    return length;
+}
+
+std::vector<uint8_t> ImageDigest::getRecord() const
+{
+    std::vector<uint8_t> record;
+    record.push_back(sha256_enabled ? IMAGE_DIGEST_CRC32C_SHA256 : IMAGE_DIGEST_CRC32C);
+    uint32_t value = getCrc32c();
+    for (int byte = 3; byte >= 0; --byte)
+    {
+        record.push_back(static_cast<uint8_t>(value >> (8 * byte)));
+    }
+    if (sha256_enabled)
+    {
+        std::vector<uint8_t> sha256 = getSha256();
+        record.insert(record.end(), sha256.begin(), sha256.end());
+    }
+    return record;
+}
+
+bool ImageDigest::matches(const std::vector<uint8_t>& record) const
+{
+    if (record.empty() || record.size() != getRecordLength(record[0]))
+    {
+        return false;
+    }
+    std::vector<uint8_t> expected = getRecord();
+    if (record[0] == IMAGE_DIGEST_CRC32C_SHA256 && !sha256_enabled)
+    {
+        /* The SHA-256 was not computed on this side */
+        return false;
+    }
+    /* Type byte and CRC32C, then the SHA-256 if the record has one */
+    return std::equal(record.begin() + 1, record.end(), expected.begin() + 1);
+}
+
+size_t ImageDigest::getRecordLength(uint8_t type)
+{
+    switch (type)
+    {
+        case IMAGE_DIGEST_CRC32C:
+            return 1 + IMAGE_DIGEST_CRC32C_LENGTH;
+        case IMAGE_DIGEST_CRC32C_SHA256:
+            return 1 + IMAGE_DIGEST_CRC32C_LENGTH + IMAGE_DIGEST_SHA256_LENGTH;
+        default:
+            return 0;
+    }
+}
+
+uint32_t ImageDigest::updateCrc32c(uint32_t crc, const uint8_t* data, size_t size)
+{
+#if defined(IMAGE_DIGEST_X86_CRC) || defined(IMAGE_DIGEST_ARM_CRC)
+    static const bool hardware = hasHardwareCrc32c();
+    if (hardware)
+    {
+        return crc32cHardware(crc, data, size);
+    }
+#endif
+    return crc32cTable(crc, data, size);
+}
+
+bool ImageDigest::hasHardwareCrc32c()
+{
+#if defined(IMAGE_DIGEST_X86_CRC)
+    return __builtin_cpu_supports("sse4.2");
+#elif defined(IMAGE_DIGEST_ARM_CRC)
+    return true;
+#else
+    return false;
+#endif
+}
+
+void ImageDigest::sha256Transform(uint32_t state[8], const uint8_t block[64])
+{
+    uint32_t words[64];
+    for (int index = 0; index < 16; ++index)
+    {
+        words[index] = (static_cast<uint32_t>(block[index * 4]) << 24) | (static_cast<uint32_t>(block[index * 4 + 1]) << 16) |
+                       (static_cast<uint32_t>(block[index * 4 + 2]) << 8) | block[index * 4 + 3];
+    }
+    for (int index = 16; index < 64; ++index)
+    {
+        uint32_t s0 = rotateRight(words[index - 15], 7) ^ rotateRight(words[index - 15], 18) ^ (words[index - 15] >> 3);
+        uint32_t s1 = rotateRight(words[index - 2], 17) ^ rotateRight(words[index - 2], 19) ^ (words[index - 2] >> 10);
+        words[index] = words[index - 16] + s0 + words[index - 7] + s1;
+    }
+
+    uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+    uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+    for (int index = 0; index < 64; ++index)
+    {
+        uint32_t s1 = rotateRight(e, 6) ^ rotateRight(e, 11) ^ rotateRight(e, 25);
+        uint32_t choice = (e & f) ^ (~e & g);
+        uint32_t temp1 = h + s1 + choice + SHA256_ROUND_CONSTANTS[index] + words[index];
+        uint32_t s0 = rotateRight(a, 2) ^ rotateRight(a, 13) ^ rotateRight(a, 22);
+        uint32_t majority = (a & b) ^ (a & c) ^ (b & c);
+        uint32_t temp2 = s0 + majority;
+        h = g;
+        g = f;
+        f = e;
+        e = d + temp1;
+        d = c;
+        c = b;
+        b = a;
+        a = temp1 + temp2;
+    }
+    state[0] += a;
+    state[1] += b;
+    state[2] += c;
+    state[3] += d;
+    state[4] += e;
+    state[5] += f;
+    state[6] += g;
+    state[7] += h;
+}
@@ -0,0 +1,234 @@
+#include "IsoTpReassembler.h"
+#include "CanFd.h"
+
+#include <algorithm>
+
+IsoTpReassembler::IsoTpReassembler(uint8_t block_size, uint8_t st_min, unsigned n_cr_ms)
+    : block_size(block_size), st_min(st_min), n_cr_ms(n_cr_ms == 0 ? 1 : n_cr_ms)
+{
+    /* One byte more for the length byte in front of the payload */
+    for (Context& context : contexts)
+    {
+        context.buffer.reserve(ISOTP_MAX_12BIT_LENGTH + 1);
+    }
+}
+
+IsoTpReassembler::Result IsoTpReassembler::handleFrame(const struct can_frame& frame, std::vector<uint8_t>& message)
+{
+    return handleFrame(CanFd::toFdFrame(frame), message);
+}
+
+IsoTpReassembler::Result IsoTpReassembler::handleFrame(const struct canfd_frame& frame, std::vector<uint8_t>& message)
+{
+    size_t length = std::min(static_cast<size_t>(frame.len), static_cast<size_t>(CANFD_MAX_DLEN));
+    if (length == 0)
+    {
+        return Result();
+    }
+    switch (frame.data[0] & 0xF0)
+    {
+        case 0x10:
+            return handleFirstFrame(frame, length);
+        case 0x20:
+            return handleConsecutiveFrame(frame, length, message);
+        default:
+            return Result();
+    }
+}
+
+IsoTpReassembler::Result IsoTpReassembler::handleFirstFrame(const struct canfd_frame& frame, size_t length)
+{
+    Result result;
+    if (length < 2)
+    {
+        return result;
+    }
+    canid_t id = frame.can_id & CAN_EFF_MASK;
+    size_t message_length = (static_cast<size_t>(frame.data[0] & 0x0F) << 8) | frame.data[1];
+    size_t offset = 2;
+    if (message_length == 0)
+    {
+        /* Escape sequence: FF_DL is given on the next 4 bytes */
+        if (length < 6)
+        {
+            return result;
+        }
+        message_length = (static_cast<size_t>(frame.data[2]) << 24) | (static_cast<size_t>(frame.data[3]) << 16) |
+                         (static_cast<size_t>(frame.data[4]) << 8) | frame.data[5];
+        offset = 6;
+        if (message_length <= ISOTP_MAX_12BIT_LENGTH)
+        {
+            /* Only used for the lengths that do not fit on 12 bits */
+            return result;
+        }
+    }
+    else if (message_length < CAN_MAX_DLEN)
+    {
+        /* Fits in a single frame */
+        return result;
+    }
+
+    size_t first_bytes = std::min(length - offset, message_length);
+    /* The consecutive frames have the length of the first frame: 8 bytes, or up to 64 with CAN FD */
+    size_t consecutive_bytes = length - 1;
+    result.message_length = message_length;
+    result.frame_count = 1 + (message_length - first_bytes + consecutive_bytes - 1) / consecutive_bytes;
+
+    std::lock_guard<std::mutex> lock(contexts_mutex);
+    Clock::time_point now = Clock::now();
+    Context* context = nullptr;
+    if (message_length <= ISOTP_MAX_MESSAGE_SIZE)
+    {
+        /* A new first frame restarts the message of the sender */
+        context = findContext(id);
+        if (context == nullptr)
+        {
+            context = acquireContext(id, now);
+        }
+    }
+    if (context == nullptr)
+    {
+        result.status = BUFFER_OVERFLOW;
+        setFlowControlFrame(result, id, ISOTP_FLOW_OVERFLOW);
+        return result;
+    }
+
+    context->active = true;
+    context->id = id;
+    context->expected_length = message_length;
+    context->next_sequence = 1;
+    context->block_count = 0;
+    context->block_size = block_size;
+    context->deadline = now + std::chrono::milliseconds(n_cr_ms);
+    context->buffer.clear();
+    context->buffer.reserve(message_length + 1);
+    context->buffer.push_back(static_cast<uint8_t>(message_length & 0xFF));
+    context->buffer.insert(context->buffer.end(), frame.data + offset, frame.data + offset + first_bytes);
+
+    result.status = FIRST_FRAME;
+    setFlowControlFrame(result, id, ISOTP_FLOW_CONTINUE);
+    return result;
+}
+
+IsoTpReassembler::Result IsoTpReassembler::handleConsecutiveFrame(const struct canfd_frame& frame, size_t length, std::vector<uint8_t>& message)
+{
+    Result result;
+    canid_t id = frame.can_id & CAN_EFF_MASK;
+
+    std::lock_guard<std::mutex> lock(contexts_mutex);
+    Clock::time_point now = Clock::now();
+    Context* context = findContext(id);
+    if (context == nullptr)
+    {
+        result.status = NO_CONTEXT;
+        return result;
+    }
+    result.message_length = context->expected_length;
+    if (now > context->deadline)
+    {
+        /* N_Cr elapsed, the sender gave up or lost frames */
+        context->active = false;
+        result.status = TIMEOUT;
+        return result;
+    }
+    uint8_t sequence = frame.data[0] & 0x0F;
+    if (sequence != context->next_sequence)
+    {
+        result.expected_pci = 0x20 | context->next_sequence;
+        result.received_pci = frame.data[0];
+        context->active = false;
+        result.status = WRONG_SEQUENCE;
+        return result;
+    }
+
+    /* The buffer starts with the length byte; the padding of the last frame is dropped */
+    size_t received = context->buffer.size() - 1;
+    size_t chunk = std::min(length - 1, context->expected_length - received);
+    context->buffer.insert(context->buffer.end(), frame.data + 1, frame.data + 1 + chunk);
+    /* 0x2F is followed by 0x20 */
+    context->next_sequence = (context->next_sequence + 1) & 0x0F;
+
+    if (received + chunk >= context->expected_length)
+    {
+        message.assign(context->buffer.begin(), context->buffer.end());
+        context->active = false;
+        result.status = COMPLETE;
+        return result;
+    }
+
+    context->deadline = now + std::chrono::milliseconds(n_cr_ms);
+    result.status = IN_PROGRESS;
+    if (context->block_size != 0 && ++context->block_count == context->block_size)
+    {
+        /* End of the block, the sender waits for the next flow control */
+        context->block_count = 0;
+        setFlowControlFrame(result, id, ISOTP_FLOW_CONTINUE);
+    }
+    return result;
+}
+
+void IsoTpReassembler::setFlowControl(uint8_t block_size, uint8_t st_min)
+{
+    std::lock_guard<std::mutex> lock(contexts_mutex);
+    this->block_size = block_size;
+    this->st_min = st_min;
+}
+
+size_t IsoTpReassembler::getActiveCount() const
+{
+    std::lock_guard<std::mutex> lock(contexts_mutex);
+    return std::count_if(contexts.begin(), contexts.end(), [](const Context& context) { return context.active; });
+}
+
+canid_t IsoTpReassembler::reverseId(canid_t can_id)
+{
+    return (can_id & ~static_cast<canid_t>(0xFFFF)) | ((can_id & 0xFF) << 8) | ((can_id >> 8) & 0xFF);
+}
+
+IsoTpReassembler::Context* IsoTpReassembler::findContext(canid_t id)
+{
+    for (Context& context : contexts)
+    {
+        if (context.active && context.id == id)
+        {
+            return &context;
+        }
+    }
+    return nullptr;
+}
+
+IsoTpReassembler::Context* IsoTpReassembler::acquireContext(canid_t id, Clock::time_point now)
+{
+    Context* expired = nullptr;
+    for (Context& context : contexts)
+    {
+        if (!context.active)
+        {
+            context.id = id;
+            return &context;
+        }
+        if (expired == nullptr && now > context.deadline)
+        {
+            expired = &context;
+        }
+    }
+    if (expired != nullptr)
+    {
+        expired->id = id;
+    }
+    return expired;
+}
+
+void IsoTpReassembler::setFlowControlFrame(Result& result, canid_t id, uint8_t flow_status) const
+{
+    result.send_flow_control = true;
+    result.flow_control_id = reverseId(id);
+    if (flow_status == ISOTP_FLOW_CONTINUE)
+    {
+        result.flow_control = {flow_status, block_size, st_min};
+    }
+    else
+    {
+        result.flow_control = {flow_status, 0x00, 0x00};
+    }
+}
@@ -0,0 +1,328 @@
+#include "IsoTpTransmitter.h"
+#include "IsoTpReassembler.h"
+#include "GenerateFrames.h"
+#include "CanFd.h"
+
+#include <algorithm>
+
+IsoTpTransmitter& IsoTpTransmitter::getInstance()
+{
+    /* Built on first use, destroyed (timer thread stopped) at exit */
+    static IsoTpTransmitter instance;
+    return instance;
+}
+
+IsoTpTransmitter::IsoTpTransmitter() : wheel(ISOTP_TX_TICK_MS)
+{
+    wheel.start();
+}
+
+IsoTpTransmitter::~IsoTpTransmitter()
+{
+    /* The timer thread uses the sessions, stop it before they are destroyed */
+    wheel.stop();
+}
+
+bool IsoTpTransmitter::send(int s, canid_t id, std::vector<uint8_t> payload, Logger& logger, CompletionCallback on_done)
+{
+    id &= CAN_EFF_MASK;
+    if (s < 0)
+    {
+        LOG_ERROR(logger.GET_LOGGER(), "Socket not initialized");
+        if (on_done)
+        {
+            on_done(SEND_ERROR);
+        }
+        return false;
+    }
+
+    /* TX_DL: 8 bytes per frame, 64 if the receiver talks CAN FD */
+    bool fd = CanFd::useFd(s, id);
+    size_t frame_length = fd ? CANFD_MAX_DLEN : CAN_MAX_DLEN;
+    uint8_t data[CANFD_MAX_DLEN] = {};
+    size_t length = payload.size();
+    size_t header = 2;
+    struct canfd_frame frame;
+    if (length < CAN_MAX_DLEN || (fd && length <= CANFD_MAX_DLEN - 2))
+    {
+        /* Fits in a single frame, no flow control. Above 7 bytes (CAN FD only) the first
+           byte is 0x00 and SF_DL is on the second one */
+        size_t offset = 1;
+        if (length < CAN_MAX_DLEN)
+        {
+            data[0] = static_cast<uint8_t>(length);
+        }
+        else
+        {
+            data[1] = static_cast<uint8_t>(length);
+            offset = 2;
+        }
+        std::copy(payload.begin(), payload.end(), data + offset);
+        GenerateFrames::fillFrame(frame, id, data, length + offset);
+        bool sent = GenerateFrames(s, logger).sendFrames(&frame, 1, s) == 1;
+        if (on_done)
+        {
+            on_done(sent ? COMPLETE : SEND_ERROR);
+        }
+        return sent;
+    }
+
+    /* First frame: FF_DL on 12 bits, or the escape sequence for the longer messages */
+    if (length <= ISOTP_MAX_12BIT_LENGTH)
+    {
+        data[0] = 0x10 | static_cast<uint8_t>(length >> 8);
+        data[1] = static_cast<uint8_t>(length & 0xFF);
+    }
+    else
+    {
+        data[0] = 0x10;
+        for (int byte = 0; byte < 4; ++byte)
+        {
+            data[2 + byte] = static_cast<uint8_t>(length >> (8 * (3 - byte)));
+        }
+        header = 6;
+    }
+    size_t first_bytes = frame_length - header;
+    std::copy(payload.begin(), payload.begin() + first_bytes, data + header);
+    GenerateFrames::fillFrame(frame, id, data, frame_length);
+
+    Completion aborted;
+    Completion failed;
+    bool sent = false;
+    {
+        std::lock_guard<std::mutex> lock(sessions_mutex);
+        if (sessions.count(id) > 0)
+        {
+            LOG_WARN(logger.GET_LOGGER(), "Multi-frame message on 0x{:x} replaced by a new one.", id);
+            aborted = finish(id, ABORTED);
+        }
+
+        /* Registered before the first frame is sent, the flow control frame may come back at once */
+        Session& session = sessions[id];
+        session.socket = s;
+        session.id = id;
+        session.logger = logger;
+        session.payload = std::move(payload);
+        session.offset = first_bytes;
+        session.frame_length = frame_length;
+        session.on_done = std::move(on_done);
+        session.generation = ++next_generation;
+
+        if (GenerateFrames(s, logger).sendFrames(&frame, 1, s) != 1)
+        {
+            failed = finish(id, SEND_ERROR);
+        }
+        else
+        {
+            /* The consecutive frames are sent when the flow control frame arrives */
+            armFlowControlTimeout(session);
+            sent = true;
+        }
+    }
+    notify(aborted);
+    notify(failed);
+    return sent;
+}
+
+bool IsoTpTransmitter::onFlowControl(const struct can_frame& frame)
+{
+    return onFlowControl(CanFd::toFdFrame(frame));
+}
+
+bool IsoTpTransmitter::onFlowControl(const struct canfd_frame& frame)
+{
+    if ((frame.data[0] & 0xF0) != 0x30)
+    {
+        return false;
+    }
+    /* The receiver answers with sender and receiver swapped */
+    canid_t id = IsoTpReassembler::reverseId(frame.can_id & CAN_EFF_MASK);
+    Completion completion;
+    {
+        std::lock_guard<std::mutex> lock(sessions_mutex);
+        auto it = sessions.find(id);
+        if (it == sessions.end() || !it->second.waiting_flow_control)
+        {
+            return false;
+        }
+        Session& session = it->second;
+        switch (frame.data[0] & 0x0F)
+        {
+            case 0x00:
+                /* ContinueToSend */
+                session.block_size = frame.len > 1 ? frame.data[1] : 0;
+                session.st_min_ms = decodeStMin(frame.len > 2 ? frame.data[2] : 0);
+                session.block_sent = 0;
+                session.wait_count = 0;
+                session.waiting_flow_control = false;
+                session.generation = ++next_generation;
+                completion = sendBlock(session);
+                break;
+            case 0x01:
+                /* Wait: the receiver is not ready yet, N_Bs starts again */
+                if (++session.wait_count > ISOTP_MAX_WAIT_FRAMES)
+                {
+                    LOG_ERROR(session.logger.GET_LOGGER(), "Too many flow control WAIT frames for 0x{:x}.", id);
+                    completion = finish(id, TIMEOUT);
+                }
+                else
+                {
+                    session.generation = ++next_generation;
+                    armFlowControlTimeout(session);
+                }
+                break;
+            case 0x02:
+                LOG_ERROR(session.logger.GET_LOGGER(), "Multi-frame message on 0x{:x} refused: receiver overflow.", id);
+                completion = finish(id, RECEIVER_OVERFLOW);
+                break;
+            default:
+                LOG_ERROR(session.logger.GET_LOGGER(), "Invalid flow status {} for 0x{:x}.", int(frame.data[0] & 0x0F), id);
+                completion = finish(id, ABORTED);
+                break;
+        }
+    }
+    notify(completion);
+    return true;
+}
+
+IsoTpTransmitter::Completion IsoTpTransmitter::sendBlock(Session& session)
+{
+    struct canfd_frame frames[TX_BATCH_SIZE];
+    size_t length = session.payload.size();
+    bool block_end = false;
+    do
+    {
+        /* Without STmin the block goes out in batches, otherwise one frame per step */
+        size_t count = 0;
+        while (session.offset < length && count < TX_BATCH_SIZE && !block_end)
+        {
+            size_t chunk = std::min(length - session.offset, session.frame_length - 1);
+            uint8_t data[CANFD_MAX_DLEN];
+            data[0] = 0x20 | session.sequence;
+            std::copy(session.payload.begin() + session.offset, session.payload.begin() + session.offset + chunk, data + 1);
+            GenerateFrames::fillFrame(frames[count++], session.id, data, chunk + 1);
+            session.offset += chunk;
+            /* 0x2F is followed by 0x20 */
+            session.sequence = (session.sequence + 1) & 0x0F;
+            block_end = session.block_size != 0 && ++session.block_sent == session.block_size;
+            if (session.st_min_ms != 0)
+            {
+                break;
+            }
+        }
+        if (GenerateFrames(session.socket, session.logger).sendFrames(frames, count, session.socket) != static_cast<int>(count))
+        {
+            return finish(session.id, SEND_ERROR);
+        }
+    } while (session.st_min_ms == 0 && !block_end && session.offset < length);
+
+    if (session.offset >= length)
+    {
+        return finish(session.id, COMPLETE);
+    }
+
+    session.generation = ++next_generation;
+    if (block_end)
+    {
+        /* The receiver sends the next flow control frame */
+        session.block_sent = 0;
+        session.waiting_flow_control = true;
+        armFlowControlTimeout(session);
+        return Completion();
+    }
+
+    canid_t id = session.id;
+    uint32_t generation = session.generation;
+    /* Next frame after STmin */
+    wheel.schedule(session.st_min_ms,
+        [this, id, generation] {
+            std::lock_guard<std::mutex> lock(sessions_mutex);
+            auto it = sessions.find(id);
+            return it != sessions.end() && it->second.generation == generation;
+        },
+        [this, id, generation] {
+            Completion completion;
+            {
+                std::lock_guard<std::mutex> lock(sessions_mutex);
+                auto it = sessions.find(id);
+                if (it != sessions.end() && it->second.generation == generation)
+                {
+                    completion = sendBlock(it->second);
+                }
+            }
+            notify(completion);
+        });
+    return Completion();
+}
+
+void IsoTpTransmitter::armFlowControlTimeout(Session& session)
+{
+    canid_t id = session.id;
+    uint32_t generation = session.generation;
+    wheel.schedule(ISOTP_N_BS_TIMEOUT_MS,
+        [this, id, generation] {
+            std::lock_guard<std::mutex> lock(sessions_mutex);
+            auto it = sessions.find(id);
+            return it != sessions.end() && it->second.generation == generation;
+        },
+        [this, id, generation] {
+            Completion completion;
+            {
+                std::lock_guard<std::mutex> lock(sessions_mutex);
+                auto it = sessions.find(id);
+                if (it != sessions.end() && it->second.generation == generation && it->second.waiting_flow_control)
+                {
+                    LOG_ERROR(it->second.logger.GET_LOGGER(), "Timeout. Flow control frame not received for 0x{:x}.", id);
+                    completion = finish(id, TIMEOUT);
+                }
+            }
+            notify(completion);
+        });
+}
+
+IsoTpTransmitter::Completion IsoTpTransmitter::finish(canid_t id, TransmitStatus status)
+{
+    Completion completion;
+    auto it = sessions.find(id);
+    if (it == sessions.end())
+    {
+        return completion;
+    }
+    completion.on_done = std::move(it->second.on_done);
+    completion.status = status;
+    sessions.erase(it);
+    return completion;
+}
+
+void IsoTpTransmitter::notify(Completion& completion)
+{
+    if (completion.on_done)
+    {
+        completion.on_done(completion.status);
+    }
+}
+
+bool IsoTpTransmitter::isBusy(canid_t id) const
+{
+    std::lock_guard<std::mutex> lock(sessions_mutex);
+    return sessions.count(id & CAN_EFF_MASK) > 0;
+}
+
+size_t IsoTpTransmitter::getActiveCount() const
+{
+    std::lock_guard<std::mutex> lock(sessions_mutex);
+    return sessions.size();
+}
+
+unsigned IsoTpTransmitter::decodeStMin(uint8_t st_min)
+{
+    if (st_min <= 0x7F)
+    {
+        return st_min;
+    }
+    if (st_min >= 0xF1 && st_min <= 0xF9)
+    {
+        return 1;
+    }
+    return 0x7F;
+}
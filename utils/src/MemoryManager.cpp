@@ -25,29 +25,41 @@ MemoryManager* MemoryManager::getInstance(off_t address, std::string path, Logge
     return instance;
 }
 
-MemoryManager::MemoryManager(off_t address, std::string path, Logger& logger) : logger(logger)
+MemoryManager::MemoryManager(off_t address, std::string path, Logger& logger) : logger(logger), write_behind(logger)
 {
     this->address = address;
     this->address_continue_to_write = address;
     this->path = path;
 } 
 
-int MemoryManager::to_int(std::string number)
-{
-    return std::stoi(number);
-}
-
 void MemoryManager::setAddress(off_t address)
 {
+    /* The staged data belongs to the previous address */
+    flushStagedWrites();
     this->address = address;
     this->address_continue_to_write = address;
 }
 
 void MemoryManager::setPath(std::string path)
 {
+    if (path != this->path)
+    {
+        /* The next access opens the new device */
+        flushStagedWrites();
+        device.close();
+    }
     this->path = path;
 }
 
+bool MemoryManager::openDevice()
+{
+    if (device.isOpen() && device.getPath() == path)
+    {
+        return true;
+    }
+    return device.open(path, logger);
+}
+
 off_t MemoryManager::getAddress()
 {
     return this->address;
@@ -64,27 +76,6 @@ void MemoryManager::resetInstance()
     instance = nullptr;
 }
 
-std::string MemoryManager::runCommand(char command[])
-{
-    char buffer[128];
-    std::string result = "";
-    FILE* pipe = popen(command, "r");
-    if (!pipe) throw std::runtime_error("popen() failed!");
-    try
-    {
-        while (fgets(buffer, sizeof buffer, pipe) != NULL)
-        {
-            result += buffer;
-        }
-    } catch (...)
-    {
-        pclose(pipe);
-        throw;
-    }
-    pclose(pipe);
-    return result;
-}
-
 bool MemoryManager::availableAddress(off_t address)
 {
     if (address == -1)
@@ -92,23 +83,18 @@ bool MemoryManager::availableAddress(off_t address)
         LOG_ERROR(logger.GET_LOGGER(), "Error: the address was not initialized correctly.");
         return false;
     }
+    if (!openDevice())
+    {
+        return false;
+    }
 
-    char verify_address_command[256];
-    sprintf(verify_address_command, "sudo fdisk -l %s | grep '^/dev/' | grep '*' | awk '{print $3,$4}'", path.c_str());
-
-    std::string result = runCommand(verify_address_command);
-    if (result.length() < 3)
+    off_t boot_end_byte = device.getBootEnd();
+    if (boot_end_byte == -1)
     {
         /* LOG_WARN(logger.GET_LOGGER(), "No boot partition found"); */
         return true;
     }
-    std::string::size_type pos = result.find(' ');
-    /* off_t start_position = to_int(result.substr(0,pos)); */
-    off_t end_position = to_int(result.substr(pos+ 1));
-
-    /* off_t boot_start_byte = start_position * SECTOR_SIZE; */
-    off_t boot_end_byte = (end_position + 1) * SECTOR_SIZE - 1;
-    if ( address <= boot_end_byte)
+    if (address < boot_end_byte)
     {
         LOG_ERROR(logger.GET_LOGGER(), "Error:Address in boot partition.");
         return false;
@@ -118,16 +104,12 @@ bool MemoryManager::availableAddress(off_t address)
 
 bool MemoryManager::availableMemory(off_t size_of_data)
 {
-    char verify_memory_command[256];
-    sprintf(verify_memory_command, "sudo fdisk -l %s | grep '^/dev/' | grep -v '*' | awk '{print $3}'", path.c_str());
-    std::string result = runCommand(verify_memory_command);
-    if (result.length() < 3)
+    if (!openDevice() || device.getPartitions().empty())
     {
         LOG_WARN(logger.GET_LOGGER(), "No partition found");
         return false;
     }
-    off_t last_memory_address = to_int(result) * SECTOR_SIZE;
-    if ( address + size_of_data >= last_memory_address)
+    if (size_of_data < 0 || !device.contains(address_continue_to_write, static_cast<size_t>(size_of_data)))
     {
         LOG_ERROR(logger.GET_LOGGER(), "Error: Not enough memory.");
         return false;
@@ -137,41 +119,82 @@ bool MemoryManager::availableMemory(off_t size_of_data)
 
 bool MemoryManager::writeToAddress(std::vector<uint8_t>& data) 
 {
+    if (!flushStagedWrites())
+    {
+        LOG_ERROR(logger.GET_LOGGER(), "Error: Aborting, staged data not written.");
+        return false;
+    }
     if(!availableAddress(this->address_continue_to_write) || !availableMemory(data.size()))
     {
         LOG_ERROR(logger.GET_LOGGER(), "Error: Aborting.");
         return false;
     }
-    int sd_fd = open(path.c_str(), O_RDWR );
-    if (sd_fd < 0)
+
+    /* The device stays opened, the data goes at the tracked offset */
+    if (!device.write(address_continue_to_write, data.data(), data.size()))
     {
-        perror("Error opening SD card device");
-        LOG_ERROR(logger.GET_LOGGER(), "Error opening SD card device: {} ", path);
+        LOG_ERROR(logger.GET_LOGGER(), "Error writing data to address: " + std::to_string(address_continue_to_write));
         return false;
     }
+    std::cout << "\nbytes written in memory: " << data.size() << std::endl;
 
-    if (lseek(sd_fd, address_continue_to_write, SEEK_SET) < 0)
+    LOG_INFO(logger.GET_LOGGER(), "Data successfully written to address " + std::to_string(address) + " on "+path);
+    address_continue_to_write += data.size();
+    return true;
+}
+
+bool MemoryManager::stageWrite(const uint8_t* data, size_t size)
+{
+    if (!staging)
     {
-       LOG_ERROR(logger.GET_LOGGER(), "Error seeking to address: " + std::to_string(address_continue_to_write));
-        close(sd_fd);
+        if (!availableAddress(address_continue_to_write))
+        {
+            LOG_ERROR(logger.GET_LOGGER(), "Error: Aborting.");
+            return false;
+        }
+        write_behind.begin(device, address_continue_to_write);
+        staging = true;
+    }
+    if (!availableMemory(size))
+    {
+        LOG_ERROR(logger.GET_LOGGER(), "Error: Aborting.");
         return false;
     }
-
-    ssize_t bytes_written = write(sd_fd, data.data(), data.size());
-    std::cout << "\nbytes written in memory: " << bytes_written << std::endl;
-    if (bytes_written != static_cast<ssize_t>(data.size()))
+    if (!write_behind.append(data, size))
     {
-        LOG_ERROR(logger.GET_LOGGER(), "Error writing data to address: " + std::to_string(address));
-        close(sd_fd);
+        LOG_ERROR(logger.GET_LOGGER(), "Error writing data to address: " + std::to_string(address_continue_to_write));
         return false;
     }
-
-    close(sd_fd);
-    LOG_INFO(logger.GET_LOGGER(), "Data successfully written to address " + std::to_string(address) + " on "+path);
-    address_continue_to_write += data.size();
+    address_continue_to_write += size;
     return true;
 }
 
+bool MemoryManager::flushStagedWrites()
+{
+    if (!staging)
+    {
+        return true;
+    }
+    staging = false;
+    bool written = write_behind.flush();
+    if (written)
+    {
+        LOG_INFO(logger.GET_LOGGER(), "Data successfully written to address " + std::to_string(address) + " on "+path);
+    }
+    else
+    {
+        LOG_ERROR(logger.GET_LOGGER(), "Error writing the staged data to address: " + std::to_string(address));
+    }
+    return written;
+}
+
+bool MemoryManager::skipWrite(size_t size)
+{
+    bool written = flushStagedWrites();
+    address_continue_to_write += size;
+    return written;
+}
+
 bool MemoryManager::writeToFile(std::vector<uint8_t> &data, std::string path_file, Logger& logger)
 {
     std::ofstream sd_card(path_file, std::ios::out | std::ios::binary | std::ios::app);
@@ -214,14 +237,14 @@ std::vector<uint8_t> MemoryManager::readBinary(std::string path_to_binary, Logge
     std::streamsize size = sd_card.tellg();
     sd_card.seekg(0, std::ios::beg);
 
-    std::vector<char> buffer(size);
-    if (!sd_card.read(buffer.data(),size))
+    /* Read straight in the returned buffer, without an intermediate copy */
+    std::vector<uint8_t> uint8Buffer(size);
+    if (!sd_card.read(reinterpret_cast<char*>(uint8Buffer.data()),size))
     {
         LOG_ERROR(logger.GET_LOGGER(), "Failed to read from file " + path_to_binary);
         return {};
     }
     sd_card.close();
-    std::vector<uint8_t> uint8Buffer(buffer.begin(), buffer.end());
     LOG_INFO(logger.GET_LOGGER(), "Successfully readed from file: " + path_to_binary);
     return uint8Buffer;
 }
@@ -233,6 +256,18 @@ std::vector<uint8_t> MemoryManager::readFromAddress(std::string path, off_t addr
         LOG_ERROR(logger.GET_LOGGER(), "Error trying to read from address: " + std::to_string(address_start));
         return {};
     }
+    if (instance->device.isOpen() && instance->device.getPath() == path)
+    {
+        /* Same device as the writes, no need to open it again */
+        std::vector<uint8_t> data(size);
+        if (!instance->device.read(address_start, data.data(), data.size()))
+        {
+            LOG_ERROR(logger.GET_LOGGER(), "Failed to read the file " + path);
+            return {};
+        }
+        LOG_INFO(logger.GET_LOGGER(), "Data successfully readed from address " + std::to_string(address_start) + " on "+path );
+        return data;
+    }
     int sd_fd = open(path.c_str(), O_RDWR );
     if (sd_fd < 0)
     {
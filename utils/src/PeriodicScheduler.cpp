@@ -0,0 +1,232 @@
+#include "PeriodicScheduler.h"
+#include "GenerateFrames.h"
+#include "DidStore.h"
+#include "DynamicDidTable.h"
+
+#include <algorithm>
+
+PeriodicScheduler& PeriodicScheduler::getInstance()
+{
+    /* Built on first use, destroyed (timer thread stopped) at exit */
+    static PeriodicScheduler instance;
+    return instance;
+}
+
+PeriodicScheduler::PeriodicScheduler()
+{
+    wheel.start();
+}
+
+PeriodicScheduler::~PeriodicScheduler()
+{
+    /* The timer thread uses the subscriptions, stop it before they are destroyed */
+    wheel.stop();
+}
+
+unsigned PeriodicScheduler::getPeriodMs(Rate rate)
+{
+    switch (rate)
+    {
+        case FAST_RATE:
+            return PERIODIC_FAST_RATE_MS;
+        case MEDIUM_RATE:
+            return PERIODIC_MEDIUM_RATE_MS;
+        default:
+            return PERIODIC_SLOW_RATE_MS;
+    }
+}
+
+unsigned PeriodicScheduler::framesPerSecond(const std::vector<Subscription>& subscriptions)
+{
+    unsigned frames = 0;
+    for (const Subscription& subscription : subscriptions)
+    {
+        frames += 1000 / getPeriodMs(subscription.rate);
+    }
+    return frames;
+}
+
+PeriodicScheduler::Status PeriodicScheduler::subscribe(int s, canid_t response_id, const std::string& file_name, const std::vector<uint16_t>& dids, Rate rate, Logger& logger)
+{
+    if (!wheel.isRunning() && !wheel.start())
+    {
+        return NOT_RUNNING;
+    }
+    std::lock_guard<std::mutex> lock(scheduler_mutex);
+    /* Checked on a copy, so the subscriptions do not change if the DIDs are refused */
+    std::vector<Subscription> updated = subscriptions;
+    for (uint16_t did : dids)
+    {
+        auto existing = std::find_if(updated.begin(), updated.end(), [&](const Subscription& subscription)
+            { return subscription.response_id == response_id && subscription.did == did; });
+        if (existing != updated.end())
+        {
+            /* Already sent to this tester: only the rate changes */
+            existing->rate = rate;
+            existing->socket = s;
+            continue;
+        }
+        updated.push_back({s, response_id, file_name, did, rate});
+    }
+    if (updated.size() > PERIODIC_MAX_DIDS)
+    {
+        return TOO_MANY_DIDS;
+    }
+    if (framesPerSecond(updated) > PERIODIC_MAX_FRAMES_PER_SECOND)
+    {
+        return BUDGET_EXCEEDED;
+    }
+    subscriptions.swap(updated);
+    this->logger = logger;
+    arm(rate);
+    return ACCEPTED;
+}
+
+size_t PeriodicScheduler::unsubscribe(canid_t response_id, const std::vector<uint16_t>& dids)
+{
+    std::lock_guard<std::mutex> lock(scheduler_mutex);
+    size_t count = subscriptions.size();
+    /* The timer of a rate without DIDs is not armed again on its next deadline */
+    subscriptions.erase(std::remove_if(subscriptions.begin(), subscriptions.end(), [&](const Subscription& subscription)
+        {
+            return subscription.response_id == response_id &&
+                   (dids.empty() || std::find(dids.begin(), dids.end(), subscription.did) != dids.end());
+        }), subscriptions.end());
+    return count - subscriptions.size();
+}
+
+void PeriodicScheduler::clear()
+{
+    std::lock_guard<std::mutex> lock(scheduler_mutex);
+    subscriptions.clear();
+    for (RateTimer& timer : timers)
+    {
+        timer.armed = false;
+        ++timer.generation;
+    }
+}
+
+size_t PeriodicScheduler::getSubscriptionCount() const
+{
+    std::lock_guard<std::mutex> lock(scheduler_mutex);
+    return subscriptions.size();
+}
+
+unsigned PeriodicScheduler::getFramesPerSecond() const
+{
+    std::lock_guard<std::mutex> lock(scheduler_mutex);
+    return framesPerSecond(subscriptions);
+}
+
+void PeriodicScheduler::arm(Rate rate)
+{
+    RateTimer& timer = timers[rate - 1];
+    if (timer.armed)
+    {
+        return;
+    }
+    unsigned period_ms = getPeriodMs(rate);
+    uint32_t generation = ++timer.generation;
+    timer.armed = true;
+    timer.next_due = std::chrono::steady_clock::now() + std::chrono::milliseconds(period_ms);
+    wheel.schedule(period_ms,
+        [this, rate, generation]() { return timers[rate - 1].generation == generation; },
+        [this, rate, generation]() { onTick(rate, generation); });
+}
+
+void PeriodicScheduler::onTick(Rate rate, uint32_t generation)
+{
+    std::vector<Subscription> due;
+    Logger tick_logger;
+    {
+        std::lock_guard<std::mutex> lock(scheduler_mutex);
+        RateTimer& timer = timers[rate - 1];
+        if (timer.generation != generation)
+        {
+            return;
+        }
+        for (const Subscription& subscription : subscriptions)
+        {
+            if (subscription.rate == rate)
+            {
+                due.push_back(subscription);
+            }
+        }
+        if (due.empty())
+        {
+            /* Last DID of the rate unsubscribed */
+            timer.armed = false;
+            return;
+        }
+        /* Next deadline from the previous one; after a late tick, skip the missed periods */
+        auto now = std::chrono::steady_clock::now();
+        auto period = std::chrono::milliseconds(getPeriodMs(rate));
+        timer.next_due += period;
+        if (timer.next_due <= now)
+        {
+            timer.next_due = now + period;
+        }
+        unsigned delay_ms = std::chrono::duration_cast<std::chrono::milliseconds>(timer.next_due - now).count();
+        uint32_t next_generation = ++timer.generation;
+        wheel.schedule(delay_ms,
+            [this, rate, next_generation]() { return timers[rate - 1].generation == next_generation; },
+            [this, rate, next_generation]() { onTick(rate, next_generation); });
+        tick_logger = logger;
+    }
+    send(due, tick_logger);
+}
+
+void PeriodicScheduler::send(const std::vector<Subscription>& due, Logger& tick_logger)
+{
+    struct can_frame frames[PERIODIC_MAX_DIDS];
+    std::vector<bool> done(due.size(), false);
+    std::vector<uint8_t> value;
+    for (size_t first = 0; first < due.size(); ++first)
+    {
+        if (done[first])
+        {
+            continue;
+        }
+        /* All the frames of a socket go out together */
+        int s = due[first].socket;
+        size_t count = 0;
+        for (size_t index = first; index < due.size(); ++index)
+        {
+            const Subscription& subscription = due[index];
+            if (done[index] || subscription.socket != s)
+            {
+                continue;
+            }
+            done[index] = true;
+            try
+            {
+                /* A dynamically defined DID is gathered from the definition of its server (high byte of the id) */
+                DidStore& store = DidStore::forFile(subscription.file_name);
+                bool found = DynamicDidTable::isDynamic(subscription.did)
+                    ? DynamicDidTable::getInstance().read(subscription.response_id >> 8 & 0xFF, subscription.did, store, value, tick_logger)
+                    : store.get(subscription.did, value);
+                if (!found || value.empty() || value.size() > PERIODIC_MAX_DATA_LENGTH)
+                {
+                    continue;
+                }
+            }
+            catch (const std::exception& e)
+            {
+                LOG_ERROR(tick_logger.GET_LOGGER(), "Periodic DID 0x{:04X} not read: {}", subscription.did, e.what());
+                continue;
+            }
+            uint8_t data[CAN_MAX_DLEN] = {static_cast<uint8_t>(value.size() + 3), 0x6A,
+                                          static_cast<uint8_t>(subscription.did >> 8), static_cast<uint8_t>(subscription.did & 0xFF)};
+            std::copy(value.begin(), value.end(), data + 4);
+            GenerateFrames::fillFrame(frames[count++], subscription.response_id, data, value.size() + 4);
+        }
+        if (count > 0 && s >= 0)
+        {
+            int sent = GenerateFrames(s, tick_logger).sendFrames(frames, count, s);
+            if (sent != static_cast<int>(count))
+            {
+                LOG_WARN(tick_logger.GET_LOGGER(), "{} of {} periodic frames sent on socket {}", sent, count, s);
+            }
+        }
+    }
+}
@@ -8,6 +8,7 @@ ReceiveFrames::ReceiveFrames(int socket, int current_module_id, Logger& receive_
                                                                                             current_module_id(current_module_id),
                                                                                             running(true), 
                                                                                             receive_logger(receive_logger),
+                                                                                            frame_reader(socket),
                                                                                             handle_frame(socket, receive_logger)
 {
     if (socket < 0) 
@@ -29,11 +30,18 @@ ReceiveFrames::ReceiveFrames(int socket, int current_module_id, Logger& receive_
 
     /* Print the frame_id for debugging */ 
     LOG_INFO(receive_logger.GET_LOGGER(), "Module ID: 0x{0:x}", this->current_module_id);
+
+    /* One thread serves the P2/P2* deadlines of all the requests */
+    if (!response_timers.start())
+    {
+        LOG_ERROR(receive_logger.GET_LOGGER(), "Failed to start the response timers: {}", strerror(errno));
+    }
 }
 
 ReceiveFrames::~ReceiveFrames() 
 {
     stop();
+    response_timers.stop();
 }
 
 bool ReceiveFrames::getEcuState()
@@ -55,17 +63,34 @@ void ReceiveFrames::receive(HandleFrames &handle_frame)
 /* Set the socket to non-blocking mode. */
 void ReceiveFrames::stop() 
 {   
-    {
-        std::unique_lock<std::mutex> lock(mtx);
-        running = false;
-    }
-    cv.notify_all();
+    running = false;
+    frame_buffer.wakeUp();
     if (bufferFrameInThread.joinable())
     {
     bufferFrameInThread.join();
     }
 }
 
+void ReceiveFrames::setBatchSize(size_t batch_size)
+{
+    frame_reader.setBatchSize(batch_size);
+}
+
+size_t ReceiveFrames::getBatchSize() const
+{
+    return frame_reader.getBatchSize();
+}
+
+size_t ReceiveFrames::getQueueOccupancy() const
+{
+    return frame_buffer.size();
+}
+
+uint64_t ReceiveFrames::getDroppedFrames() const
+{
+    return frame_buffer.getDroppedFrames();
+}
+
 void ReceiveFrames::bufferFrameIn() 
 {
     /* Define a pollfd structure to monitor the socket */ 
@@ -74,6 +99,9 @@ void ReceiveFrames::bufferFrameIn()
     pfd.fd = this->socket; 
     /* We are interested in read events -use POLLING */ 
     pfd.events = POLLIN;    
+    /* Frames read with one syscall, reused between batches */
+    std::vector<TimestampedFrame> batch;
+    batch.reserve(frame_reader.getBatchSize());
 
     while (running) 
     {
@@ -84,14 +112,36 @@ void ReceiveFrames::bufferFrameIn()
         {
             if (pfd.revents & POLLIN) 
             {
-                struct can_frame frame = {};
-                int nbytes = read(this->socket, &frame, sizeof(struct can_frame));
-                uint8_t frame_receiver = frame.can_id & 0xFF;
-                if (nbytes > 0 && frame_receiver == current_module_id) 
+                /* Drain the socket in batches, one wake up per batch */
+                int received;
+                while ((received = frame_reader.readBatch(batch)) > 0)
+                {
+                    bool accepted = false;
+                    for (const TimestampedFrame& received_frame : batch)
+                    {
+                        /* The socket filters already drop other receivers; keep the check for unfiltered sockets */
+                        uint8_t frame_receiver = received_frame.frame.can_id & 0xFF;
+                        if (frame_receiver == current_module_id)
+                        {
+                            if (frame_buffer.tryPush(received_frame))
+                            {
+                                accepted = true;
+                            }
+                            else
+                            {
+                                LOG_WARN(receive_logger.GET_LOGGER(), "Frame buffer full, frame 0x{:x} dropped ({} dropped in total).",
+                                         received_frame.frame.can_id, frame_buffer.getDroppedFrames());
+                            }
+                        }
+                    }
+                    if (accepted)
+                    {
+                        frame_buffer.notify();
+                    }
+                }
+                if (received == BATCH_READ_ERROR)
                 {
-                    std::unique_lock<std::mutex> lock(mtx);
-                    frame_buffer.push_back(std::make_tuple(frame, nbytes));
-                    cv.notify_one();
+                    LOG_ERROR(receive_logger.GET_LOGGER(), "read error: {}", strerror(errno));
                 }
             }
         } 
@@ -113,20 +163,14 @@ void ReceiveFrames::bufferFrameOut(HandleFrames &handle_frame)
 {
     while (running) 
     {
-        label1: 
-        std::unique_lock<std::mutex> lock(mtx);
-        cv.wait(lock, [this]{ return !frame_buffer.empty() || !running; });
-        if (!running && frame_buffer.empty()) 
+        /* Sleep until a frame arrives, waking up every second to check the running flag */
+        TimestampedFrame queued_frame;
+        if (!frame_buffer.waitPop(queued_frame, 1000))
         {
-            break;
+            continue;
         }
 
-        /* Extract frame and nbytes from the tuple in frame_buffer */ 
-        auto frameTuple = frame_buffer.front();
-        frame_buffer.pop_front();
-        lock.unlock();
-
-        struct can_frame frame = std::get<0>(frameTuple);
+        const struct canfd_frame& frame = queued_frame.frame;
 
         /* Print the frame for debugging */ 
         printFrame(frame);
@@ -151,14 +195,14 @@ void ReceiveFrames::bufferFrameOut(HandleFrames &handle_frame)
         {
             LOG_INFO(receive_logger.GET_LOGGER(), "Notification from the MCU that the server is unlocked.");
             ecu_state = true;
-            goto label1;
+            continue;
         }
         /* Notify from MCU to tell ECU's that MCU state is locked */
         else if (frame.data[0] == 0x01 && frame.data[1] == 0xCF)
         {
             LOG_INFO(receive_logger.GET_LOGGER(), "Notification from the MCU that the server is locked.");
             ecu_state = false;
-            goto label1;
+            continue;
         }
 
         /* Check if the frame is a request of type 'Up-Notification' from MCU */
@@ -168,15 +212,15 @@ void ReceiveFrames::bufferFrameOut(HandleFrames &handle_frame)
             /* Create and instance of GenerateFrames with the CAN socket */
             GenerateFrames frame = GenerateFrames(this->socket, receive_logger);
 
-            /* Create a vector of uint8_t (bytes) containing the data to be sent */
-            std::vector<uint8_t> data = {0x01, 0xD9};
+            /* Create a vector of uint8_t (bytes) containing the data to be sent, with the CAN FD support of the ECU */
+            std::vector<uint8_t> data = {0x02, 0xD9, static_cast<uint8_t>(CanFd::isSocketFd(socket) ? CAN_FD_CAPABLE : 0x00)};
             
             uint16_t id = (frame_dest_id << 8) | 0x10;
             frame.sendFrame(id, data);
             LOG_DEBUG(receive_logger.GET_LOGGER(), "Response sent to MCU");
 
             std::this_thread::sleep_for(std::chrono::milliseconds(100));
-            goto label1;
+            continue;
         }
         /* Process the received frame */
         LOG_DEBUG(receive_logger.GET_LOGGER(), "Calling HandleFrames module to parse the frame.");
@@ -196,207 +240,75 @@ void ReceiveFrames::startTimer(uint8_t frame_dest_id, uint8_t sid) {
 
     LOG_INFO(receive_logger.GET_LOGGER(), "Started frame processing timing for frame with SID {:x} with max_time = {} on ECU with id {}.", sid, timer_value, frame_dest_id);
 
-    auto start_time = std::chrono::steady_clock::now();
-    switch(frame_dest_id)
+    if (!isEcuId(frame_dest_id))
     {
-    case 0x11:
-        battery->_ecu->timing_parameters[sid] = start_time.time_since_epoch().count();
-
-        // Initialize stop flag for this SID
-        battery->_ecu->stop_flags[sid] = true;
-
-        battery->_ecu->active_timers[sid] = std::async(std::launch::async, [sid, this, start_time, timer_value, frame_dest_id]() {
-            while (battery->_ecu->stop_flags[sid]) {
-                auto now = std::chrono::steady_clock::now();
-                std::chrono::duration<double> elapsed = now - start_time;
-                if (elapsed.count() > timer_value / 20.0) {
-                    stopTimer(frame_dest_id, sid);
-                }
-                std::this_thread::sleep_for(std::chrono::milliseconds(10));
-            }
-        });
-        break;
-    case 0x12:
-        engine->_ecu->timing_parameters[sid] = start_time.time_since_epoch().count();
-
-        // Initialize stop flag for this SID
-        engine->_ecu->stop_flags[sid] = true;
-
-        engine->_ecu->active_timers[sid] = std::async(std::launch::async, [sid, this, start_time, timer_value, frame_dest_id]() {
-            while (engine->_ecu->stop_flags[sid]) {
-                auto now = std::chrono::steady_clock::now();
-                std::chrono::duration<double> elapsed = now - start_time;
-                if (elapsed.count() > timer_value / 20.0) {
-                    stopTimer(frame_dest_id, sid);
-                }
-                std::this_thread::sleep_for(std::chrono::milliseconds(10));
-            }
-        });
-        break;
-    case 0x13:
-        doors->_ecu->timing_parameters[sid] = start_time.time_since_epoch().count();
-
-        // Initialize stop flag for this SID
-        doors->_ecu->stop_flags[sid] = true;
-
-        doors->_ecu->active_timers[sid] = std::async(std::launch::async, [sid, this, start_time, timer_value, frame_dest_id]() {
-            while (doors->_ecu->stop_flags[sid]) {
-                auto now = std::chrono::steady_clock::now();
-                std::chrono::duration<double> elapsed = now - start_time;
-                if (elapsed.count() > timer_value / 20.0) {
-                    stopTimer(frame_dest_id, sid);
-                }
-                std::this_thread::sleep_for(std::chrono::milliseconds(10));
-            }
-        });
-        break;
-    case 0x14:
-        hvac->_ecu->timing_parameters[sid] = start_time.time_since_epoch().count();
-
-        // Initialize stop flag for this SID
-        hvac->_ecu->stop_flags[sid] = true;
-
-        hvac->_ecu->active_timers[sid] = std::async(std::launch::async, [sid, this, start_time, timer_value, frame_dest_id]() {
-            while (hvac->_ecu->stop_flags[sid]) {
-                auto now = std::chrono::steady_clock::now();
-                std::chrono::duration<double> elapsed = now - start_time;
-                if (elapsed.count() > timer_value / 20.0) {
-                    stopTimer(frame_dest_id, sid);
-                }
-                std::this_thread::sleep_for(std::chrono::milliseconds(10));
-            }
-        });
-        break;
-    default:
         LOG_INFO(receive_logger.GET_LOGGER(), "starTimer function called with an ecu id unknown {:x}.", frame_dest_id);
-        break;
+        return;
     }
+
+    auto start_time = std::chrono::steady_clock::now();
+    ECU::timing_parameters[sid] = start_time.time_since_epoch().count();
+
+    /* A new request for the same SID makes the previous deadline stale */
+    uint32_t generation = ++timer_generations[sid];
+    ECU::stop_flags[sid] = true;
+
+    /* The deadline is dropped if the service clears the stop flag before it expires */
+    response_timers.schedule(timer_value * P2_TIME_UNIT_MS,
+        [this, sid, generation]() { return ECU::stop_flags[sid] && timer_generations[sid] == generation; },
+        [this, frame_dest_id, sid]() { stopTimer(frame_dest_id, sid); });
 }
 
 void ReceiveFrames::stopTimer(uint8_t frame_dest_id, uint8_t sid) {
     LOG_INFO(receive_logger.GET_LOGGER(), "stopTimer function called for frame with SID {:x}.", sid);
-    
-    auto end_time = std::chrono::steady_clock::now();
 
-    std::chrono::time_point<std::chrono::steady_clock> start_time;
-    std::chrono::duration<double> processing_time;
-
-    switch (frame_dest_id) {
-    case 0x11:
-        start_time = std::chrono::steady_clock::time_point(
-            std::chrono::duration_cast<std::chrono::steady_clock::duration>(
-                std::chrono::nanoseconds((long long)battery->_ecu->timing_parameters[sid])
-            )
-        );
-        processing_time = end_time - start_time;
-
-        battery->_ecu->timing_parameters[sid] = processing_time.count();
-
-        if (battery->_ecu->active_timers.find(sid) != battery->_ecu->active_timers.end()) {
-            /* Set stop flag to false for this SID */
-            if (battery->_ecu->stop_flags[sid]) {
-                int id = ((sid & 0xFF) << 8) | ((sid >> 8) & 0xFF);
-                LOG_INFO(receive_logger.GET_LOGGER(), 
-                         "Service with SID {:x} sent the response pending frame.", sid);
-                
-                NegativeResponse negative_response(socket, receive_logger);
-                negative_response.sendNRC(id, sid, 0x78);
-                battery->_ecu->stop_flags[sid] = false;
-            }
-            battery->_ecu->stop_flags.erase(sid);
-            battery->_ecu->active_timers[sid].wait();
-        }
-        break;
-    case 0x12:
-        start_time = std::chrono::steady_clock::time_point(
-            std::chrono::duration_cast<std::chrono::steady_clock::duration>(
-                std::chrono::nanoseconds((long long)engine->_ecu->timing_parameters[sid])
-            )
-        );
-        processing_time = end_time - start_time;
-
-        engine->_ecu->timing_parameters[sid] = processing_time.count();
-
-        if (engine->_ecu->active_timers.find(sid) != engine->_ecu->active_timers.end()) {
-            /* Set stop flag to false for this SID */
-            if (engine->_ecu->stop_flags[sid]) {
-                int id = ((sid & 0xFF) << 8) | ((sid >> 8) & 0xFF);
-                LOG_INFO(receive_logger.GET_LOGGER(), 
-                         "Service with SID {:x} sent the response pending frame.", sid);
-                
-                NegativeResponse negative_response(socket, receive_logger);
-                negative_response.sendNRC(id, sid, 0x78);
-                engine->_ecu->stop_flags[sid] = false;
-            }
-            engine->_ecu->stop_flags.erase(sid);
-            engine->_ecu->active_timers[sid].wait();
-        }
-        break;
-    case 0x13:
-        start_time = std::chrono::steady_clock::time_point(
-            std::chrono::duration_cast<std::chrono::steady_clock::duration>(
-                std::chrono::nanoseconds((long long)doors->_ecu->timing_parameters[sid])
-            )
-        );
-        processing_time = end_time - start_time;
-
-        doors->_ecu->timing_parameters[sid] = processing_time.count();
-
-        if (doors->_ecu->active_timers.find(sid) != doors->_ecu->active_timers.end()) {
-            /* Set stop flag to false for this SID */
-            if (doors->_ecu->stop_flags[sid]) {
-                int id = ((sid & 0xFF) << 8) | ((sid >> 8) & 0xFF);
-                LOG_INFO(receive_logger.GET_LOGGER(), 
-                         "Service with SID {:x} sent the response pending frame.", sid);
-                
-                NegativeResponse negative_response(socket, receive_logger);
-                negative_response.sendNRC(id, sid, 0x78);
-                doors->_ecu->stop_flags[sid] = false;
-            }
-            doors->_ecu->stop_flags.erase(sid);
-            doors->_ecu->active_timers[sid].wait();
-        }
-        break;
-    case 0x14:
-        start_time = std::chrono::steady_clock::time_point(
-            std::chrono::duration_cast<std::chrono::steady_clock::duration>(
-                std::chrono::nanoseconds((long long)hvac->_ecu->timing_parameters[sid])
-            )
-        );
-        processing_time = end_time - start_time;
-
-        hvac->_ecu->timing_parameters[sid] = processing_time.count();
-
-        if (hvac->_ecu->active_timers.find(sid) != hvac->_ecu->active_timers.end()) {
-            /* Set stop flag to false for this SID */
-            if (hvac->_ecu->stop_flags[sid]) {
-                int id = ((sid & 0xFF) << 8) | ((sid >> 8) & 0xFF);
-                LOG_INFO(receive_logger.GET_LOGGER(), 
-                         "Service with SID {:x} sent the response pending frame.", sid);
-                
-                NegativeResponse negative_response(socket, receive_logger);
-                negative_response.sendNRC(id, sid, 0x78);
-                hvac->_ecu->stop_flags[sid] = false;
-            }
-            hvac->_ecu->stop_flags.erase(sid);
-            hvac->_ecu->active_timers[sid].wait();
-        }
-        break;
-    default:
+    if (!isEcuId(frame_dest_id))
+    {
         LOG_INFO(receive_logger.GET_LOGGER(), "stopTimer function called with an ecu id unknown {:x}.", frame_dest_id);
-        break;
+        return;
+    }
+
+    auto end_time = std::chrono::steady_clock::now();
+    auto start_time = std::chrono::steady_clock::time_point(
+        std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+            std::chrono::nanoseconds((long long)ECU::timing_parameters[sid])
+        )
+    );
+    std::chrono::duration<double> processing_time = end_time - start_time;
+    ECU::timing_parameters[sid] = processing_time.count();
+
+    /* Still pending: the service did not answer in time, tell the client to wait */
+    if (ECU::stop_flags[sid].exchange(false))
+    {
+        int id = ((sid & 0xFF) << 8) | ((sid >> 8) & 0xFF);
+        LOG_INFO(receive_logger.GET_LOGGER(), 
+                 "Service with SID {:x} sent the response pending frame.", sid);
+
+        NegativeResponse negative_response(socket, receive_logger);
+        negative_response.sendNRC(id, sid, 0x78);
     }
 }
 
-void ReceiveFrames::printFrame(const struct can_frame &frame) 
+bool ReceiveFrames::isEcuId(uint8_t module_id)
+{
+    /* Battery, Engine, Doors, HVAC */
+    return module_id >= 0x11 && module_id <= 0x14;
+}
+
+size_t ReceiveFrames::getPendingTimers() const
+{
+    return response_timers.getPendingCount();
+}
+
+void ReceiveFrames::printFrame(const struct canfd_frame &frame) 
 {
     LOG_DEBUG(receive_logger.GET_LOGGER(), "");
     LOG_DEBUG(receive_logger.GET_LOGGER(), "Received CAN frame");
     LOG_DEBUG(receive_logger.GET_LOGGER(), fmt::format("CAN ID: 0x{:x}", frame.can_id));
-    LOG_DEBUG(receive_logger.GET_LOGGER(), "Data Length: {}", int(frame.can_dlc));
+    LOG_DEBUG(receive_logger.GET_LOGGER(), "Data Length: {}", int(frame.len));
     std::ostringstream dataStream;
     dataStream << "Data:";
-    for (int frame_byte = 0; frame_byte < frame.can_dlc; ++frame_byte) 
+    for (int frame_byte = 0; frame_byte < frame.len; ++frame_byte) 
     {
         dataStream << " 0x" << std::hex << int(frame.data[frame_byte]);
     }
@@ -0,0 +1,204 @@
+#include "TimerWheel.h"
+
+#include <unistd.h>
+#include <poll.h>
+#include <sys/timerfd.h>
+#include <sys/eventfd.h>
+
+TimerWheel::TimerWheel(unsigned tick_ms, size_t slot_count)
+    : tick_ms(tick_ms == 0 ? 1 : tick_ms), slots(slot_count == 0 ? 1 : slot_count),
+      current_tick(0), pending(0), ticking(false), timer_fd(-1), wake_fd(-1), running(false)
+{
+}
+
+TimerWheel::~TimerWheel()
+{
+    stop();
+}
+
+bool TimerWheel::start()
+{
+    std::lock_guard<std::mutex> lock(wheel_mutex);
+    if (running)
+    {
+        return true;
+    }
+    timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (timer_fd < 0 || wake_fd < 0)
+    {
+        if (timer_fd >= 0)
+        {
+            close(timer_fd);
+        }
+        if (wake_fd >= 0)
+        {
+            close(wake_fd);
+        }
+        timer_fd = wake_fd = -1;
+        return false;
+    }
+    running = true;
+    worker = std::thread(&TimerWheel::run, this);
+    return true;
+}
+
+void TimerWheel::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(wheel_mutex);
+        if (!running)
+        {
+            return;
+        }
+        running = false;
+        uint64_t increment = 1;
+        if (write(wake_fd, &increment, sizeof(increment)) < 0)
+        {
+            /* The thread also checks the running flag on every tick */
+            increment = 0;
+        }
+    }
+    if (worker.joinable() && worker.get_id() != std::this_thread::get_id())
+    {
+        worker.join();
+    }
+    else if (worker.joinable())
+    {
+        /* Stopped from one of its own callbacks */
+        worker.detach();
+    }
+
+    std::lock_guard<std::mutex> lock(wheel_mutex);
+    for (auto& slot : slots)
+    {
+        slot.clear();
+    }
+    pending = 0;
+    ticking = false;
+    close(timer_fd);
+    close(wake_fd);
+    timer_fd = wake_fd = -1;
+}
+
+bool TimerWheel::schedule(unsigned delay_ms, PendingCheck still_pending, ExpiryCallback on_expiry)
+{
+    std::lock_guard<std::mutex> lock(wheel_mutex);
+    if (!running)
+    {
+        return false;
+    }
+    /* Round up, a deadline never fires early. If the timerfd is already ticking the
+       next tick is less than tick_ms away, so it does not count. */
+    uint64_t ticks = (delay_ms + tick_ms - 1) / tick_ms;
+    if (ticks == 0)
+    {
+        ticks = 1;
+    }
+    if (ticking)
+    {
+        ++ticks;
+    }
+    uint64_t expiry_tick = current_tick + ticks;
+    slots[expiry_tick % slots.size()].push_back({expiry_tick, std::move(still_pending), std::move(on_expiry)});
+    ++pending;
+    if (!ticking)
+    {
+        setTicking(true);
+    }
+    return true;
+}
+
+void TimerWheel::run()
+{
+    struct pollfd poll_fds[2] = {{timer_fd, POLLIN, 0}, {wake_fd, POLLIN, 0}};
+    while (running)
+    {
+        if (poll(poll_fds, 2, -1) < 0)
+        {
+            continue;
+        }
+        if (poll_fds[1].revents & POLLIN)
+        {
+            break;
+        }
+        uint64_t expirations = 0;
+        if ((poll_fds[0].revents & POLLIN) && read(timer_fd, &expirations, sizeof(expirations)) == sizeof(expirations))
+        {
+            advance(expirations);
+        }
+    }
+}
+
+void TimerWheel::advance(uint64_t ticks)
+{
+    std::vector<Entry> expired;
+    {
+        std::lock_guard<std::mutex> lock(wheel_mutex);
+        /* Late wake ups report several expirations, catch up bucket by bucket */
+        for (uint64_t step = 0; step < ticks && pending > 0; ++step)
+        {
+            ++current_tick;
+            std::vector<Entry>& slot = slots[current_tick % slots.size()];
+            for (size_t index = 0; index < slot.size();)
+            {
+                if (slot[index].expiry_tick <= current_tick)
+                {
+                    expired.push_back(std::move(slot[index]));
+                    slot[index] = std::move(slot.back());
+                    slot.pop_back();
+                    --pending;
+                }
+                else
+                {
+                    /* Due in a later round of the wheel */
+                    ++index;
+                }
+            }
+        }
+        if (pending == 0 && ticking)
+        {
+            setTicking(false);
+        }
+    }
+
+    /* Callbacks run without the lock, so they can arm new deadlines */
+    for (Entry& entry : expired)
+    {
+        if (entry.still_pending && entry.still_pending())
+        {
+            entry.on_expiry();
+        }
+    }
+}
+
+void TimerWheel::setTicking(bool enable)
+{
+    struct itimerspec spec = {};
+    if (enable)
+    {
+        spec.it_interval.tv_sec = tick_ms / 1000;
+        spec.it_interval.tv_nsec = (tick_ms % 1000) * 1000000L;
+        spec.it_value = spec.it_interval;
+    }
+    if (timerfd_settime(timer_fd, 0, &spec, nullptr) == 0)
+    {
+        ticking = enable;
+    }
+}
+
+size_t TimerWheel::getPendingCount() const
+{
+    std::lock_guard<std::mutex> lock(wheel_mutex);
+    return pending;
+}
+
+unsigned TimerWheel::getTickMs() const
+{
+    return tick_ms;
+}
+
+bool TimerWheel::isRunning() const
+{
+    return running;
+}
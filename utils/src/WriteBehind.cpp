@@ -0,0 +1,153 @@
+#include "WriteBehind.h"
+
+#include <algorithm>
+
+WriteBehind::WriteBehind(Logger& logger) : logger(logger)
+{
+}
+
+WriteBehind::~WriteBehind()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (current != nullptr && !current->data.empty())
+        {
+            queueCurrent();
+        }
+        stopping = true;
+    }
+    work_condition.notify_all();
+    if (io_thread.joinable())
+    {
+        io_thread.join();
+    }
+}
+
+void WriteBehind::begin(DeviceSession& device, off_t offset)
+{
+    flush();
+    std::lock_guard<std::mutex> lock(mutex);
+    this->device = &device;
+    next_offset = offset;
+    failed = false;
+    if (!io_thread.joinable())
+    {
+        io_thread = std::thread(&WriteBehind::run, this);
+    }
+}
+
+bool WriteBehind::append(const uint8_t* data, size_t size)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    if (device == nullptr)
+    {
+        LOG_ERROR(logger.GET_LOGGER(), "Write-behind used before begin().");
+        return false;
+    }
+    while (size > 0 && !failed)
+    {
+        if (current == nullptr)
+        {
+            current = takeBuffer(lock);
+            if (current == nullptr)
+            {
+                break;
+            }
+            current->offset = next_offset;
+        }
+        /* The buffer ends at the next aligned offset of the device */
+        off_t buffer_end = (current->offset / WRITE_BEHIND_BUFFER_BYTES + 1) * WRITE_BEHIND_BUFFER_BYTES;
+        size_t room = static_cast<size_t>(buffer_end - current->offset) - current->data.size();
+        size_t bytes = std::min(room, size);
+        current->data.insert(current->data.end(), data, data + bytes);
+        next_offset += bytes;
+        data += bytes;
+        size -= bytes;
+        if (bytes == room)
+        {
+            queueCurrent();
+        }
+    }
+    return !failed;
+}
+
+bool WriteBehind::flush()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    if (current != nullptr && !current->data.empty())
+    {
+        queueCurrent();
+    }
+    done_condition.wait(lock, [this] { return queue.empty() && !writing; });
+    if (device != nullptr && !failed && !device->sync())
+    {
+        LOG_ERROR(logger.GET_LOGGER(), "Error syncing the device {}.", device->getPath());
+        failed = true;
+    }
+    return !failed;
+}
+
+bool WriteBehind::hasPending() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return writing || !queue.empty() || (current != nullptr && !current->data.empty());
+}
+
+std::unique_ptr<WriteBehind::Buffer> WriteBehind::takeBuffer(std::unique_lock<std::mutex>& lock)
+{
+    if (free_buffers.empty() && allocated_buffers < WRITE_BEHIND_MAX_BUFFERS)
+    {
+        ++allocated_buffers;
+        std::unique_ptr<Buffer> buffer(new Buffer());
+        buffer->data.reserve(WRITE_BEHIND_BUFFER_BYTES);
+        return buffer;
+    }
+    /* All the buffers are queued: back-pressure on the transfer */
+    done_condition.wait(lock, [this] { return !free_buffers.empty() || failed; });
+    if (free_buffers.empty())
+    {
+        return nullptr;
+    }
+    std::unique_ptr<Buffer> buffer = std::move(free_buffers.back());
+    free_buffers.pop_back();
+    return buffer;
+}
+
+void WriteBehind::queueCurrent()
+{
+    queue.push_back(std::move(current));
+    work_condition.notify_one();
+}
+
+void WriteBehind::run()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true)
+    {
+        work_condition.wait(lock, [this] { return stopping || !queue.empty(); });
+        if (queue.empty())
+        {
+            break;
+        }
+        std::unique_ptr<Buffer> buffer = std::move(queue.front());
+        queue.pop_front();
+        writing = true;
+        DeviceSession* target = device;
+        bool skip = failed;
+        lock.unlock();
+
+        /* After a failed write the rest of the transfer is dropped */
+        bool written = skip || target->write(buffer->offset, buffer->data.data(), buffer->data.size());
+
+        lock.lock();
+        writing = false;
+        if (!written)
+        {
+            LOG_ERROR(logger.GET_LOGGER(), "Write-behind of {} bytes at address {} failed.", buffer->data.size(), buffer->offset);
+            failed = true;
+        }
+        buffer->data.clear();
+        free_buffers.push_back(std::move(buffer));
+        done_condition.notify_all();
+    }
+}
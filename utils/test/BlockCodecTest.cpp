@@ -0,0 +1,138 @@
+/**
+ * @file BlockCodecTest.cpp
+ * @brief Unit test for BlockCodec and BlockStreamDecoder
+ * @version 0.1
+ * @date 2024-09-09
+ */
+#include "../include/BlockCodec.h"
+
+#include <gtest/gtest.h>
+#include <random>
+
+/* Image with repeated sections, like the code and string tables of an ELF */
+static std::vector<uint8_t> makeImage(size_t size)
+{
+    std::mt19937 generator(7);
+    std::vector<uint8_t> image;
+    while (image.size() < size)
+    {
+        if (image.size() > 64 && generator() % 2 == 0)
+        {
+            size_t start = generator() % (image.size() - 32);
+            size_t length = 4 + generator() % 300;
+            for (size_t index = 0; index < length; ++index)
+            {
+                image.push_back(image[start + index]);
+            }
+        }
+        else
+        {
+            for (int index = 0; index < 16; ++index)
+            {
+                image.push_back(static_cast<uint8_t>(generator()));
+            }
+        }
+    }
+    image.resize(size);
+    return image;
+}
+
+/* Test compression and decompression of data that compresses, data that does not and short buffers */
+TEST(BlockCodecTest, RoundTrip)
+{
+    std::vector<std::vector<uint8_t>> inputs = {
+        makeImage(BLOCK_CODEC_WINDOW_BYTES),
+        std::vector<uint8_t>(5000, 0x00),
+        {1, 2, 3},
+        {}
+    };
+    std::mt19937 generator(3);
+    std::vector<uint8_t> random(10000);
+    for (auto& byte : random)
+    {
+        byte = static_cast<uint8_t>(generator());
+    }
+    inputs.push_back(random);
+
+    for (const auto& input : inputs)
+    {
+        std::vector<uint8_t> compressed;
+        BlockCodec::compress(input.data(), input.size(), compressed);
+        std::vector<uint8_t> output(input.size());
+        ASSERT_TRUE(BlockCodec::decompress(compressed.data(), compressed.size(), output.data(), output.size()));
+        EXPECT_EQ(output, input);
+    }
+
+    std::vector<uint8_t> zeros(5000, 0x00);
+    std::vector<uint8_t> compressed;
+    BlockCodec::compress(zeros.data(), zeros.size(), compressed);
+    EXPECT_LT(compressed.size(), 100u);
+}
+
+/* Test that corrupted input is rejected without writing outside the output buffer */
+TEST(BlockCodecTest, CorruptedInput)
+{
+    std::vector<uint8_t> image = makeImage(4000);
+    std::vector<uint8_t> compressed;
+    BlockCodec::compress(image.data(), image.size(), compressed);
+    std::vector<uint8_t> output(image.size());
+
+    /* Truncated, wrong size */
+    EXPECT_FALSE(BlockCodec::decompress(compressed.data(), compressed.size() / 2, output.data(), output.size()));
+    EXPECT_FALSE(BlockCodec::decompress(compressed.data(), compressed.size(), output.data(), output.size() - 1));
+    /* Match before the start of the output */
+    std::vector<uint8_t> bad_offset = {0x10, 'a', 0x10, 0x00, 0x50};
+    EXPECT_FALSE(BlockCodec::decompress(bad_offset.data(), bad_offset.size(), output.data(), output.size()));
+    /* Length bytes missing */
+    std::vector<uint8_t> bad_length = {0xF0, 0xFF};
+    EXPECT_FALSE(BlockCodec::decompress(bad_length.data(), bad_length.size(), output.data(), output.size()));
+}
+
+/* Test that the stream is decoded whatever the size of the blocks it is cut in */
+TEST(BlockCodecTest, StreamInBlocks)
+{
+    std::vector<uint8_t> image = makeImage(3 * BLOCK_CODEC_WINDOW_BYTES + 1234);
+    /* The last window is random data, stored uncompressed */
+    std::mt19937 generator(11);
+    for (size_t index = 3 * BLOCK_CODEC_WINDOW_BYTES; index < image.size(); ++index)
+    {
+        image[index] = static_cast<uint8_t>(generator());
+    }
+    std::vector<uint8_t> stream;
+    for (size_t offset = 0; offset < image.size(); offset += BLOCK_CODEC_WINDOW_BYTES)
+    {
+        BlockCodec::appendFrame(image.data() + offset, std::min<size_t>(BLOCK_CODEC_WINDOW_BYTES, image.size() - offset), stream);
+    }
+    EXPECT_LT(stream.size(), image.size());
+
+    for (size_t block_size : {1u, 7u, 4093u, 100000u})
+    {
+        BlockStreamDecoder decoder;
+        std::vector<uint8_t> output;
+        for (size_t offset = 0; offset < stream.size(); offset += block_size)
+        {
+            ASSERT_TRUE(decoder.feed(stream.data() + offset, std::min(block_size, stream.size() - offset),
+                [&output](const uint8_t* data, size_t size)
+                {
+                    output.insert(output.end(), data, data + size);
+                    return true;
+                }));
+        }
+        EXPECT_TRUE(decoder.isEmpty());
+        EXPECT_EQ(output, image);
+    }
+
+    /* Partial frame at the end, then a failing sink */
+    BlockStreamDecoder decoder;
+    auto sink = [](const uint8_t*, size_t) { return true; };
+    EXPECT_TRUE(decoder.feed(stream.data(), 10, sink));
+    EXPECT_FALSE(decoder.isEmpty());
+    decoder.reset();
+    EXPECT_FALSE(decoder.feed(stream.data(), stream.size(), [](const uint8_t*, size_t) { return false; }));
+}
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
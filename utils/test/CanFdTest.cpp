@@ -0,0 +1,92 @@
+/**
+ * @file CanFdTest.cpp
+ * @brief Unit test for CanFd
+ * @version 0.1
+ * @date 2024-08-30
+ */
+#include "../include/CanFd.h"
+
+#include <gtest/gtest.h>
+
+struct CanFdTest : testing::Test
+{
+    ~CanFdTest()
+    {
+        CanFd::reset();
+    }
+};
+
+/* Test the conversion between data lengths and CAN FD DLCs */
+TEST_F(CanFdTest, DlcMapping)
+{
+    EXPECT_EQ(CanFd::lengthToDlc(0), 0);
+    EXPECT_EQ(CanFd::lengthToDlc(8), 8);
+    EXPECT_EQ(CanFd::lengthToDlc(9), 9);
+    EXPECT_EQ(CanFd::lengthToDlc(12), 9);
+    EXPECT_EQ(CanFd::lengthToDlc(33), 14);
+    EXPECT_EQ(CanFd::lengthToDlc(64), 15);
+    EXPECT_EQ(CanFd::dlcToLength(9), 12u);
+    EXPECT_EQ(CanFd::dlcToLength(13), 32u);
+    EXPECT_EQ(CanFd::dlcToLength(15), 64u);
+    EXPECT_EQ(CanFd::paddedLength(7), 7u);
+    EXPECT_EQ(CanFd::paddedLength(21), 24u);
+    EXPECT_EQ(CanFd::paddedLength(49), 64u);
+}
+
+/* Test that CAN FD is used only when both the socket and the receiver support it */
+TEST_F(CanFdTest, PeerFallback)
+{
+    const int socket = 5;
+    EXPECT_FALSE(CanFd::useFd(socket, 0x1011));
+    CanFd::setPeerFd(0x11, true);
+    EXPECT_FALSE(CanFd::useFd(socket, 0x1011));
+    CanFd::setSocketFd(socket, true);
+    EXPECT_TRUE(CanFd::useFd(socket, 0x1011));
+    /* Another ECU on the same socket stays classic */
+    EXPECT_FALSE(CanFd::useFd(socket, 0x1012));
+    /* The ECU restarted without CAN FD */
+    CanFd::setPeerFd(0x11, false);
+    EXPECT_FALSE(CanFd::useFd(socket, 0x1011));
+    /* Descriptors without state are classic */
+    CanFd::setSocketFd(CAN_FD_SOCKETS, true);
+    EXPECT_FALSE(CanFd::isSocketFd(CAN_FD_SOCKETS));
+}
+
+/* Test that a CAN FD frame teaches the sender, except for the tester */
+TEST_F(CanFdTest, LearnPeer)
+{
+    const int socket = 6;
+    CanFd::learnPeer(socket, 0x1110);
+    EXPECT_FALSE(CanFd::isPeerFd(0x11));
+    CanFd::setSocketFd(socket, true);
+    CanFd::learnPeer(socket, 0x1110 | CAN_EFF_FLAG);
+    EXPECT_TRUE(CanFd::isPeerFd(0x11));
+    CanFd::learnPeer(socket, 0xFA11);
+    EXPECT_FALSE(CanFd::isPeerFd(CAN_FD_CLASSIC_PEER));
+}
+
+/* Test the copies between classic and CAN FD frames */
+TEST_F(CanFdTest, FrameConversion)
+{
+    struct can_frame frame = {};
+    frame.can_id = 0x1011 | CAN_EFF_FLAG;
+    frame.can_dlc = 3;
+    frame.data[0] = 0x02;
+    frame.data[1] = 0x3E;
+    frame.data[2] = 0x00;
+    struct canfd_frame fd_frame = CanFd::toFdFrame(frame);
+    EXPECT_EQ(fd_frame.can_id, frame.can_id);
+    EXPECT_EQ(fd_frame.len, 3);
+    EXPECT_EQ(fd_frame.data[1], 0x3E);
+
+    fd_frame.len = 64;
+    struct can_frame classic_frame = CanFd::toClassicFrame(fd_frame);
+    EXPECT_EQ(classic_frame.can_dlc, CAN_MAX_DLEN);
+    EXPECT_EQ(classic_frame.data[1], 0x3E);
+}
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -146,6 +146,45 @@ TEST(InterfaceTestSuite, setSocketBlockingError)
     interface->deleteInterface();
 }
 
+/* test the filter set built for a module and its extra receivers */
+TEST(InterfaceTestSuite, ReceiverFilters)
+{
+    std::vector<struct can_filter> filters = CreateInterface::receiverFilters(0x10, {0xFF, 0xFA, 0x10});
+    /* The module id is not added twice */
+    ASSERT_EQ(filters.size(), 3u);
+    EXPECT_EQ(filters[0].can_id, 0x10u);
+    EXPECT_EQ(filters[1].can_id, 0xFFu);
+    EXPECT_EQ(filters[2].can_id, 0xFAu);
+    for (const struct can_filter& filter : filters)
+    {
+        EXPECT_EQ(filter.can_mask, static_cast<canid_t>(CAN_RECEIVER_MASK));
+        /* An extended frame sent from the battery to the MCU matches only the first filter */
+        canid_t frame_id = 0x1110 | CAN_EFF_FLAG;
+        EXPECT_EQ((frame_id & filter.can_mask) == (filter.can_id & filter.can_mask), filter.can_id == 0x10u);
+    }
+}
+
+/* test the inverted filter set used by the API socket */
+TEST(InterfaceTestSuite, ExcludeReceiverFilters)
+{
+    std::vector<struct can_filter> filters = CreateInterface::excludeReceiverFilters(0xFA);
+    ASSERT_EQ(filters.size(), 1u);
+    EXPECT_TRUE(filters[0].can_id & CAN_INV_FILTER);
+    EXPECT_EQ(filters[0].can_id & CAN_RECEIVER_MASK, 0xFAu);
+}
+
+/* test the setReceiveFilters method on a closed socket */
+TEST(InterfaceTestSuite, setReceiveFiltersError)
+{
+    CreateInterface* interface = CreateInterface::getInstance(0x01, logger);
+    testing::internal::CaptureStdout();
+    EXPECT_FALSE(interface->setReceiveFilters(-1, CreateInterface::receiverFilters(0x11)));
+    std::string output = testing::internal::GetCapturedStdout();
+    EXPECT_NE(output.find("Error when trying to set the receive filters"), std::string::npos);
+    /* An empty set keeps the default filter and never fails */
+    EXPECT_TRUE(interface->setReceiveFilters(-1, {}));
+}
+
 int main(int argc, char* argv[])
 {
     testing::InitGoogleTest(&argc, argv);
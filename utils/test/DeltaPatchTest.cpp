@@ -0,0 +1,122 @@
+/**
+ * @file DeltaPatchTest.cpp
+ * @brief Unit test for DeltaPatch and DeltaPatchDecoder
+ * @version 0.1
+ * @date 2024-09-10
+ */
+#include "../include/DeltaPatch.h"
+
+#include <gtest/gtest.h>
+#include <random>
+
+static std::vector<uint8_t> randomImage(size_t size, unsigned seed)
+{
+    std::mt19937 generator(seed);
+    std::vector<uint8_t> image(size);
+    for (auto& byte : image)
+    {
+        byte = static_cast<uint8_t>(generator());
+    }
+    return image;
+}
+
+/* Applies a patch in blocks of block_size bytes */
+static bool applyPatch(const std::vector<uint8_t>& base, const std::vector<uint8_t>& patch, size_t block_size,
+                       std::vector<uint8_t>& target, DeltaPatchDecoder& decoder)
+{
+    decoder.reset(base.data(), base.size());
+    target.clear();
+    for (size_t offset = 0; offset < patch.size(); offset += block_size)
+    {
+        bool valid = decoder.feed(patch.data() + offset, std::min(block_size, patch.size() - offset),
+            [&target](const uint8_t* data, size_t size)
+            {
+                target.insert(target.end(), data, data + size);
+                return true;
+            });
+        if (!valid)
+        {
+            return false;
+        }
+    }
+    return decoder.isEmpty();
+}
+
+/* Test that a small change in a large image gives a small patch that rebuilds the new image */
+TEST(DeltaPatchTest, SmallChange)
+{
+    std::vector<uint8_t> base = randomImage(500000, 1);
+    std::vector<uint8_t> target = base;
+    /* Changed bytes, inserted and removed parts */
+    target[1000] ^= 0xFF;
+    target.insert(target.begin() + 200000, 300, 0xAA);
+    target.erase(target.begin() + 400000, target.begin() + 400100);
+
+    std::vector<uint8_t> patch;
+    DeltaPatch::create(base.data(), base.size(), target.data(), target.size(), patch);
+    EXPECT_LT(patch.size(), 1000u);
+
+    for (size_t block_size : {1u, 13u, 4093u})
+    {
+        DeltaPatchDecoder decoder;
+        std::vector<uint8_t> rebuilt;
+        ASSERT_TRUE(applyPatch(base, patch, block_size, rebuilt, decoder));
+        EXPECT_EQ(rebuilt, target);
+        EXPECT_EQ(decoder.getOutputSize(), target.size());
+    }
+}
+
+/* Test unrelated and empty images */
+TEST(DeltaPatchTest, UnrelatedImages)
+{
+    std::vector<uint8_t> base = randomImage(10000, 2);
+    std::vector<uint8_t> target = randomImage(12000, 3);
+    std::vector<uint8_t> patch;
+    DeltaPatch::create(base.data(), base.size(), target.data(), target.size(), patch);
+    EXPECT_LT(patch.size(), target.size() + 100);
+
+    DeltaPatchDecoder decoder;
+    std::vector<uint8_t> rebuilt;
+    ASSERT_TRUE(applyPatch(base, patch, 4093, rebuilt, decoder));
+    EXPECT_EQ(rebuilt, target);
+
+    std::vector<uint8_t> empty;
+    DeltaPatch::create(empty.data(), 0, target.data(), target.size(), patch);
+    ASSERT_TRUE(applyPatch(empty, patch, 4093, rebuilt, decoder));
+    EXPECT_EQ(rebuilt, target);
+}
+
+/* Test that a patch is refused on another base image and that invalid instructions are rejected */
+TEST(DeltaPatchTest, InvalidPatch)
+{
+    std::vector<uint8_t> base = randomImage(10000, 4);
+    std::vector<uint8_t> target = base;
+    target[5000] ^= 0x01;
+    std::vector<uint8_t> patch;
+    DeltaPatch::create(base.data(), base.size(), target.data(), target.size(), patch);
+
+    DeltaPatchDecoder decoder;
+    std::vector<uint8_t> rebuilt;
+    std::vector<uint8_t> other_base = base;
+    other_base[0] ^= 0x01;
+    EXPECT_FALSE(applyPatch(other_base, patch, 4093, rebuilt, decoder));
+    EXPECT_FALSE(decoder.getError().empty());
+
+    /* Copy after the end of the base */
+    std::vector<uint8_t> bad_copy(patch.begin(), patch.begin() + DELTA_PATCH_HEADER_BYTES);
+    bad_copy.insert(bad_copy.end(), {DELTA_PATCH_COPY, 0x00, 0x00, 0x27, 0x00, 0x00, 0x00, 0x01, 0x00});
+    EXPECT_FALSE(applyPatch(base, bad_copy, 4093, rebuilt, decoder));
+    /* Unknown instruction */
+    std::vector<uint8_t> bad_opcode(patch.begin(), patch.begin() + DELTA_PATCH_HEADER_BYTES);
+    bad_opcode.push_back(0x7F);
+    EXPECT_FALSE(applyPatch(base, bad_opcode, 4093, rebuilt, decoder));
+    /* Patch cut in the middle of an insert */
+    std::vector<uint8_t> cut(patch.begin(), patch.end() - 1);
+    EXPECT_FALSE(applyPatch(base, cut, 4093, rebuilt, decoder));
+}
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
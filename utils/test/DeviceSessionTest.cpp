@@ -0,0 +1,143 @@
+/**
+ * @file DeviceSessionTest.cpp
+ * @brief Unit test for DeviceSession, on image files with a MBR or a GPT partition table
+ * @version 0.1
+ * @date 2024-09-04
+ */
+#include "../include/DeviceSession.h"
+
+#include <gtest/gtest.h>
+#include <fstream>
+
+Logger* logger = new Logger("test", "test_device_session.log");
+const std::string image_path = "test_device_session.img";
+const off_t image_size = 8192 * 512;
+
+struct DeviceSessionTest : testing::Test
+{
+    std::vector<uint8_t> image;
+    DeviceSessionTest() : image(3 * 512, 0)
+    {
+    }
+    ~DeviceSessionTest()
+    {
+        std::remove(image_path.c_str());
+    }
+
+    void put(size_t offset, uint64_t value, size_t bytes)
+    {
+        for (size_t index = 0; index < bytes; ++index)
+        {
+            image[offset + index] = static_cast<uint8_t>(value >> (8 * index));
+        }
+    }
+
+    void addMbrPartition(size_t entry, uint8_t flags, uint8_t type, uint32_t first_sector, uint32_t sectors)
+    {
+        size_t record = 446 + entry * 16;
+        image[record] = flags;
+        image[record + 4] = type;
+        put(record + 8, first_sector, 4);
+        put(record + 12, sectors, 4);
+        image[510] = 0x55;
+        image[511] = 0xAA;
+    }
+
+    void writeImage()
+    {
+        std::ofstream file(image_path, std::ios::out | std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char*>(image.data()), image.size());
+        file.close();
+        truncate(image_path.c_str(), image_size);
+    }
+};
+
+/* Test the partitions read from a MBR, the boot partition and the bounds of the writes */
+TEST_F(DeviceSessionTest, MbrPartitions)
+{
+    addMbrPartition(0, 0x80, 0x0C, 2048, 2048);
+    addMbrPartition(1, 0x00, 0x06, 4096, 2048);
+    writeImage();
+
+    DeviceSession device;
+    ASSERT_TRUE(device.open(image_path, *logger));
+    EXPECT_EQ(device.getDeviceSize(), image_size);
+    ASSERT_EQ(device.getPartitions().size(), 2u);
+    EXPECT_EQ(device.getBootEnd(), 4096 * 512);
+    /* Inside the data partition, overflowing it, in the boot partition */
+    EXPECT_TRUE(device.contains(4096 * 512, 2048 * 512));
+    EXPECT_FALSE(device.contains(4096 * 512 + 1, 2048 * 512));
+    EXPECT_FALSE(device.contains(2048 * 512, 4));
+    EXPECT_FALSE(device.contains(100, 4));
+}
+
+/* Test that the GPT behind a protective MBR is used */
+TEST_F(DeviceSessionTest, GptPartitions)
+{
+    addMbrPartition(0, 0x00, 0xEE, 1, 8191);
+    memcpy(image.data() + 512, "EFI PART", 8);
+    put(512 + 72, 2, 8);
+    put(512 + 80, 2, 4);
+    put(512 + 84, 128, 4);
+    image.resize(512 * 2 + 2 * 128, 0);
+    size_t first_entry = 1024;
+    image[first_entry] = 0x28;
+    put(first_entry + 32, 2048, 8);
+    put(first_entry + 40, 4095, 8);
+    put(first_entry + 48, 1ULL << 2, 8);
+    size_t second_entry = first_entry + 128;
+    image[second_entry] = 0xAF;
+    put(second_entry + 32, 4096, 8);
+    put(second_entry + 40, 6143, 8);
+    writeImage();
+
+    DeviceSession device;
+    ASSERT_TRUE(device.open(image_path, *logger));
+    ASSERT_EQ(device.getPartitions().size(), 2u);
+    EXPECT_EQ(device.getBootEnd(), 4096 * 512);
+    EXPECT_TRUE(device.contains(6143 * 512, 512));
+    EXPECT_FALSE(device.contains(6143 * 512, 513));
+}
+
+/* Test the writes and reads at offsets, with the device kept opened */
+TEST_F(DeviceSessionTest, WriteRead)
+{
+    addMbrPartition(0, 0x00, 0x06, 2048, 4096);
+    writeImage();
+
+    DeviceSession device;
+    ASSERT_TRUE(device.open(image_path, *logger));
+    EXPECT_EQ(device.getBootEnd(), -1);
+    std::vector<uint8_t> first = {1, 2, 3, 4, 5};
+    std::vector<uint8_t> second = {6, 7, 8};
+    EXPECT_TRUE(device.write(2048 * 512, first.data(), first.size()));
+    EXPECT_TRUE(device.write(2048 * 512 + first.size(), second.data(), second.size()));
+    std::vector<uint8_t> data(8);
+    EXPECT_TRUE(device.read(2048 * 512, data.data(), data.size()));
+    EXPECT_EQ(data, std::vector<uint8_t>({1, 2, 3, 4, 5, 6, 7, 8}));
+    /* Nothing to read past the end of the image */
+    EXPECT_FALSE(device.read(image_size, data.data(), 1));
+
+    device.close();
+    EXPECT_FALSE(device.isOpen());
+    EXPECT_TRUE(device.getPartitions().empty());
+}
+
+/* Test the errors for a missing device and an image without partition table */
+TEST_F(DeviceSessionTest, InvalidDevice)
+{
+    DeviceSession device;
+    EXPECT_FALSE(device.open("/path/to/nonexistent/device", *logger));
+    EXPECT_FALSE(device.isOpen());
+
+    writeImage();
+    ASSERT_TRUE(device.open(image_path, *logger));
+    EXPECT_TRUE(device.getPartitions().empty());
+    EXPECT_FALSE(device.contains(0, 1));
+}
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
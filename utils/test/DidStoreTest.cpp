@@ -0,0 +1,171 @@
+/**
+ * @file DidStoreTest.cpp
+ * @brief Unit test for DidStore
+ * @version 0.2
+ * @date 2024-09-13
+ */
+#include "../include/DidStore.h"
+
+#include <gtest/gtest.h>
+#include <atomic>
+#include <cstdio>
+#include <thread>
+#include <unistd.h>
+
+static const std::string TEST_FILE = "did_store_test_data.db";
+/* Other name of the same file: a second mapping, like the one of another process */
+static const std::string OTHER_MAPPING = "./did_store_test_data.db";
+
+static const std::unordered_map<uint16_t, std::vector<uint8_t>> DEFAULT_VALUES =
+{
+    {0x01A0, {0x00}},
+    {0x01B0, {0x01, 0x02, 0xFF}},
+    {0xE001, {0x20}}
+};
+
+/* Test reads and writes of a new database */
+TEST(DidStoreTest, ReadWrite)
+{
+    EXPECT_FALSE(DidStore::restore(TEST_FILE, DEFAULT_VALUES));
+    DidStore& store = DidStore::forFile(TEST_FILE);
+    std::vector<uint8_t> value;
+    ASSERT_TRUE(store.get(0x01B0, value));
+    EXPECT_EQ(value, std::vector<uint8_t>({0x01, 0x02, 0xFF}));
+    EXPECT_FALSE(store.get(0x1234, value));
+
+    EXPECT_TRUE(store.set(0xE001, {0x30}));
+    EXPECT_FALSE(store.set(0x0200, {0x01}));
+    /* Enough DIDs for collisions in the table */
+    for (uint16_t did = 0x0300; did < 0x0380; ++did)
+    {
+        EXPECT_TRUE(store.set(did, {static_cast<uint8_t>(did)}, true));
+    }
+    ASSERT_TRUE(store.get(0x037F, value));
+    EXPECT_EQ(value, std::vector<uint8_t>({0x7F}));
+    ASSERT_TRUE(store.get(0xE001, value));
+    EXPECT_EQ(value, std::vector<uint8_t>({0x30}));
+    EXPECT_EQ(store.snapshot().size(), 3u + 0x80u);
+    EXPECT_THROW(store.set(0xE001, std::vector<uint8_t>(DID_STORE_MAX_VALUE + 1)), std::runtime_error);
+
+    EXPECT_EQ(&DidStore::forFile(TEST_FILE), &store);
+    EXPECT_THROW(DidStore::forFile("did_store_missing_file.db"), std::runtime_error);
+}
+
+/* Test that the values are kept only after a key off reset */
+TEST(DidStoreTest, Restore)
+{
+    DidStore::restore(TEST_FILE, DEFAULT_VALUES);
+    DidStore::forFile(TEST_FILE).set(0x01A0, {0x55});
+    DidStore::forFile(TEST_FILE).set(0x0400, {0x01}, true);
+    DidStore::forFile(TEST_FILE).keepValuesOnRestart();
+
+    std::unordered_map<uint16_t, std::vector<uint8_t>> new_defaults = DEFAULT_VALUES;
+    new_defaults[0xE002] = {0x00};
+    EXPECT_TRUE(DidStore::restore(TEST_FILE, new_defaults));
+    std::vector<uint8_t> value;
+    ASSERT_TRUE(DidStore::forFile(TEST_FILE).get(0x01A0, value));
+    EXPECT_EQ(value, std::vector<uint8_t>({0x55}));
+    EXPECT_TRUE(DidStore::forFile(TEST_FILE).get(0x0400, value));
+    EXPECT_TRUE(DidStore::forFile(TEST_FILE).get(0xE002, value));
+
+    /* Next start without key off reset */
+    EXPECT_FALSE(DidStore::restore(TEST_FILE, DEFAULT_VALUES));
+    ASSERT_TRUE(DidStore::forFile(TEST_FILE).get(0x01A0, value));
+    EXPECT_EQ(value, std::vector<uint8_t>({0x00}));
+    EXPECT_FALSE(DidStore::forFile(TEST_FILE).get(0x0400, value));
+}
+
+/* Test that a kept DID survives a start without key off reset */
+TEST(DidStoreTest, RestoreKeepsDids)
+{
+    std::unordered_map<uint16_t, std::vector<uint8_t>> defaults = DEFAULT_VALUES;
+    defaults[0xE002] = {0x00};
+    DidStore::restore(TEST_FILE, defaults);
+    DidStore::forFile(TEST_FILE).set(0xE002, {0x01, 0x02, 0x03, 0x04});
+    DidStore::forFile(TEST_FILE).set(0x01A0, {0x55});
+
+    EXPECT_FALSE(DidStore::restore(TEST_FILE, defaults, {0xE002}));
+    std::vector<uint8_t> value;
+    ASSERT_TRUE(DidStore::forFile(TEST_FILE).get(0xE002, value));
+    EXPECT_EQ(value, std::vector<uint8_t>({0x01, 0x02, 0x03, 0x04}));
+    ASSERT_TRUE(DidStore::forFile(TEST_FILE).get(0x01A0, value));
+    EXPECT_EQ(value, std::vector<uint8_t>({0x00}));
+}
+
+/* Test that a write through the mapping of a replaced file goes to the new database */
+TEST(DidStoreTest, WriteAfterReplace)
+{
+    DidStore::restore(TEST_FILE, DEFAULT_VALUES);
+    DidStore& old_store = DidStore::forFile(OTHER_MAPPING);
+    DidStore::restore(TEST_FILE, DEFAULT_VALUES);
+    EXPECT_TRUE(old_store.set(0x01A0, {0x77}));
+    std::vector<uint8_t> value;
+    ASSERT_TRUE(DidStore::forFile(TEST_FILE).get(0x01A0, value));
+    EXPECT_EQ(value, std::vector<uint8_t>({0x77}));
+    /* The temporary file of the process is renamed */
+    struct stat file_status;
+    EXPECT_NE(stat((TEST_FILE + ".tmp." + std::to_string(getpid())).c_str(), &file_status), 0);
+}
+
+/* Test the reads of a byte range of a value */
+TEST(DidStoreTest, ReadRange)
+{
+    DidStore::restore(TEST_FILE, DEFAULT_VALUES);
+    DidStore& store = DidStore::forFile(TEST_FILE);
+    uint8_t bytes[3] = {};
+    ASSERT_TRUE(store.read(0x01B0, 1, 2, bytes));
+    EXPECT_EQ(bytes[0], 0x02);
+    EXPECT_EQ(bytes[1], 0xFF);
+    EXPECT_TRUE(store.read(0x01B0, 0, 3, bytes));
+    EXPECT_FALSE(store.read(0x01B0, 2, 2, bytes));
+    EXPECT_FALSE(store.read(0x1234, 0, 1, bytes));
+    EXPECT_FALSE(store.read(0x01A0, DID_STORE_MAX_VALUE, 1, bytes));
+}
+
+/* Test that a reader of another mapping sees each value whole while it is written */
+TEST(DidStoreTest, SharedMapping)
+{
+    DidStore::restore(TEST_FILE, DEFAULT_VALUES);
+    DidStore& writer_store = DidStore::forFile(TEST_FILE);
+    DidStore& reader_store = DidStore::forFile(OTHER_MAPPING);
+    ASSERT_NE(&writer_store, &reader_store);
+
+    writer_store.set(0x0500, {0x01}, true);
+    std::vector<uint8_t> value;
+    ASSERT_TRUE(reader_store.get(0x0500, value));
+
+    std::atomic<bool> done(false);
+    std::thread writer([&writer_store, &done]()
+    {
+        for (int round = 1; round < 20000; ++round)
+        {
+            /* Value of n bytes equal to n */
+            uint8_t length = static_cast<uint8_t>(round % 40 + 1);
+            writer_store.set(0x0500, std::vector<uint8_t>(length, length));
+        }
+        done = true;
+    });
+    bool torn = false;
+    while (!done && !torn)
+    {
+        ASSERT_TRUE(reader_store.get(0x0500, value));
+        for (uint8_t byte : value)
+        {
+            torn = torn || byte != value.size();
+        }
+    }
+    writer.join();
+    EXPECT_FALSE(torn);
+
+    /* The file replaced by another process is mapped again */
+    DidStore::restore(TEST_FILE, DEFAULT_VALUES);
+    EXPECT_FALSE(DidStore::forFile(OTHER_MAPPING).get(0x0500, value));
+    std::remove(TEST_FILE.c_str());
+    EXPECT_THROW(DidStore::forFile(TEST_FILE), std::runtime_error);
+}
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
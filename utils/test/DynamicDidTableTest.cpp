@@ -0,0 +1,127 @@
+/**
+ * @file DynamicDidTableTest.cpp
+ * @brief Unit test for DynamicDidTable
+ * @version 0.1
+ * @date 2024-09-18
+ */
+#include "../include/DynamicDidTable.h"
+
+#include <gtest/gtest.h>
+#include <cstdio>
+
+Logger logger;
+
+static const std::string TEST_FILE = "dynamic_did_table_test_data.db";
+static const uint8_t BATTERY = 0x11;
+
+struct DynamicDidTableTest : testing::Test
+{
+    DynamicDidTable& table = DynamicDidTable::getInstance();
+    DidStore* store;
+
+    DynamicDidTableTest()
+    {
+        DidStore::restore(TEST_FILE, {});
+        store = &DidStore::forFile(TEST_FILE);
+        /* Voltage, percentage, state of charge and temperature */
+        store->set(0x01B0, {0x0C, 0x80}, true);
+        store->set(0x01C0, {0x5A}, true);
+        store->set(0x01D0, {0x02}, true);
+        store->set(0x01E0, {0x19}, true);
+        store->set(0x0100, {0x01, 0x02, 0x03, 0x04}, true);
+    }
+    ~DynamicDidTableTest()
+    {
+        table.clear(BATTERY);
+        table.clear(0x12);
+    }
+};
+
+/* Test the fields of a bundle are gathered in the order of the definition */
+TEST_F(DynamicDidTableTest, DefineByIdentifier)
+{
+    ASSERT_TRUE(table.defineByIdentifier(BATTERY, 0xF300, *store,
+        {{0x01B0, 1, 2}, {0x01C0, 1, 1}, {0x01E0, 1, 1}, {0x01D0, 1, 1}}, logger));
+    EXPECT_TRUE(table.isDefined(BATTERY, 0xF300));
+    EXPECT_FALSE(table.isDefined(0x12, 0xF300));
+    std::vector<uint8_t> value;
+    ASSERT_TRUE(table.read(BATTERY, 0xF300, *store, value, logger));
+    EXPECT_EQ(value, std::vector<uint8_t>({0x0C, 0x80, 0x5A, 0x19, 0x02}));
+
+    /* The current values of the sources are read */
+    store->set(0x01C0, {0x59});
+    ASSERT_TRUE(table.read(BATTERY, 0xF300, *store, value, logger));
+    EXPECT_EQ(value, std::vector<uint8_t>({0x0C, 0x80, 0x59, 0x19, 0x02}));
+}
+
+/* Test adjacent byte ranges of a DID are merged into one field */
+TEST_F(DynamicDidTableTest, MergesAdjacentRanges)
+{
+    ASSERT_TRUE(table.defineByIdentifier(BATTERY, 0xF301, *store, {{0x0100, 1, 2}, {0x0100, 3, 1}, {0x01C0, 1, 1}}, logger));
+    EXPECT_EQ(table.getFieldCount(BATTERY, 0xF301), 2u);
+    /* A new definition appends its ranges */
+    ASSERT_TRUE(table.defineByIdentifier(BATTERY, 0xF301, *store, {{0x0100, 2, 1}}, logger));
+    EXPECT_EQ(table.getFieldCount(BATTERY, 0xF301), 3u);
+    std::vector<uint8_t> value;
+    ASSERT_TRUE(table.read(BATTERY, 0xF301, *store, value, logger));
+    EXPECT_EQ(value, std::vector<uint8_t>({0x01, 0x02, 0x03, 0x5A, 0x02}));
+}
+
+/* Test a refused range leaves the definition as it was */
+TEST_F(DynamicDidTableTest, InvalidRanges)
+{
+    ASSERT_TRUE(table.defineByIdentifier(BATTERY, 0xF302, *store, {{0x01B0, 1, 2}}, logger));
+    /* Missing DID, range after the end of the value, position 0, dynamic source */
+    EXPECT_FALSE(table.defineByIdentifier(BATTERY, 0xF302, *store, {{0x01C0, 1, 1}, {0x1234, 1, 1}}, logger));
+    EXPECT_FALSE(table.defineByIdentifier(BATTERY, 0xF302, *store, {{0x01B0, 2, 2}}, logger));
+    EXPECT_FALSE(table.defineByIdentifier(BATTERY, 0xF302, *store, {{0x01B0, 0, 1}}, logger));
+    EXPECT_FALSE(table.defineByIdentifier(BATTERY, 0xF302, *store, {{0xF302, 1, 1}}, logger));
+    /* Not a dynamic DID */
+    EXPECT_FALSE(table.defineByIdentifier(BATTERY, 0x01A0, *store, {{0x01B0, 1, 2}}, logger));
+    std::vector<uint8_t> value;
+    ASSERT_TRUE(table.read(BATTERY, 0xF302, *store, value, logger));
+    EXPECT_EQ(value, std::vector<uint8_t>({0x0C, 0x80}));
+}
+
+/* Test a dynamic DID whose source became shorter can not be read */
+TEST_F(DynamicDidTableTest, SourceChanged)
+{
+    ASSERT_TRUE(table.defineByIdentifier(BATTERY, 0xF303, *store, {{0x0100, 3, 2}}, logger));
+    store->set(0x0100, {0x01});
+    std::vector<uint8_t> value;
+    EXPECT_FALSE(table.read(BATTERY, 0xF303, *store, value, logger));
+    EXPECT_FALSE(table.read(BATTERY, 0xF3FF, *store, value, logger));
+}
+
+/* Test memory ranges outside of the device are refused */
+TEST_F(DynamicDidTableTest, DefineByMemoryAddress)
+{
+    EXPECT_FALSE(table.defineByMemoryAddress(BATTERY, 0xF304, {{0x1000, 0}}, logger));
+    EXPECT_FALSE(table.defineByMemoryAddress(BATTERY, 0x0100, {{0x1000, 4}}, logger));
+    EXPECT_FALSE(table.isDefined(BATTERY, 0xF304));
+}
+
+/* Test the clears and the limit of definitions of a server */
+TEST_F(DynamicDidTableTest, ClearAndLimits)
+{
+    for (uint16_t did = DYNAMIC_DID_FIRST; did < DYNAMIC_DID_FIRST + DYNAMIC_DID_MAX_DEFINITIONS; ++did)
+    {
+        ASSERT_TRUE(table.defineByIdentifier(BATTERY, did, *store, {{0x01C0, 1, 1}}, logger));
+    }
+    EXPECT_FALSE(table.defineByIdentifier(BATTERY, DYNAMIC_DID_LAST, *store, {{0x01C0, 1, 1}}, logger));
+    /* Another server has its own definitions */
+    EXPECT_TRUE(table.defineByIdentifier(0x12, DYNAMIC_DID_LAST, *store, {{0x01C0, 1, 1}}, logger));
+
+    EXPECT_EQ(table.clear(BATTERY, DYNAMIC_DID_FIRST), 1u);
+    EXPECT_EQ(table.clear(BATTERY, DYNAMIC_DID_FIRST), 0u);
+    EXPECT_EQ(table.clear(BATTERY), DYNAMIC_DID_MAX_DEFINITIONS - 1u);
+    EXPECT_TRUE(table.isDefined(0x12, DYNAMIC_DID_LAST));
+}
+
+int main(int argc, char* argv[])
+{
+    testing::InitGoogleTest(&argc, argv);
+    int result = RUN_ALL_TESTS();
+    std::remove(TEST_FILE.c_str());
+    return result;
+}
@@ -113,7 +113,8 @@ TEST_F(ECUTest, NotificationToMcu)
 {
     std::cerr << "Running NotificationToMcu" << std::endl;
 
-    struct can_frame result_frame = createFrame(0x1110, {0x01, 0xD9});
+    uint8_t capabilities = CanFd::isSocketFd(ecu->_ecu_socket) ? CAN_FD_CAPABLE : 0x00;
+    struct can_frame result_frame = createFrame(0x1110, {0x02, 0xD9, capabilities});
     ecu->sendNotificationToMCU();
     c1->capture();
     testFrames(result_frame, *c1);
@@ -147,7 +147,7 @@ TEST_F(FileManagerTest, WriteDTCWhenValueInBounds)
 TEST_F(FileManagerTest, GetEcuPathInvalidParam)
 {
     std::string ecu_path;
-    EXPECT_FALSE(fileManager.getEcuPath(0x10, ecu_path, 4, logger, "1.0"));
+    EXPECT_FALSE(fileManager.getEcuPath(0x10, ecu_path, 5, logger, "1.0"));
 }
 
 TEST_F(FileManagerTest, GetEcuPathMCU0Param)
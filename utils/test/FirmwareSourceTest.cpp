@@ -0,0 +1,88 @@
+/**
+ * @file FirmwareSourceTest.cpp
+ * @brief Unit test for FirmwareSource
+ * @version 0.1
+ * @date 2024-09-02
+ */
+#include "../include/FirmwareSource.h"
+
+#include <gtest/gtest.h>
+#include <fstream>
+
+Logger* logger = new Logger("test", "test_firmware_source.log");
+const std::string image_path = "test_firmware_source.bin";
+
+struct FirmwareSourceTest : testing::Test
+{
+    std::vector<uint8_t> image;
+    FirmwareSourceTest()
+    {
+        /* Larger than the read-ahead window and not a multiple of a page */
+        image.resize(FIRMWARE_READ_AHEAD_BYTES + 5000);
+        for (size_t index = 0; index < image.size(); ++index)
+        {
+            image[index] = static_cast<uint8_t>(index * 7 + 3);
+        }
+        std::ofstream file(image_path, std::ios::out | std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char*>(image.data()), image.size());
+    }
+    ~FirmwareSourceTest()
+    {
+        std::remove(image_path.c_str());
+    }
+};
+
+/* Test that a regular file is mapped and read in chunks, without copies */
+TEST_F(FirmwareSourceTest, MappedChunks)
+{
+    FirmwareSource source;
+    ASSERT_TRUE(source.open(image_path, *logger));
+    EXPECT_TRUE(source.isMapped());
+    EXPECT_EQ(source.size(), image.size());
+
+    size_t offset = 0;
+    while (offset < image.size())
+    {
+        FirmwareSource::Chunk chunk = source.chunk(offset, 4093);
+        ASSERT_GT(chunk.size, 0u);
+        ASSERT_TRUE(std::equal(chunk.data, chunk.data + chunk.size, image.begin() + offset));
+        offset += chunk.size;
+    }
+    EXPECT_EQ(offset, image.size());
+    /* The last chunk is shorter, nothing is returned past the end */
+    EXPECT_EQ(source.chunk(image.size() - 10, 4093).size, 10u);
+    EXPECT_EQ(source.chunk(image.size(), 1).size, 0u);
+}
+
+/* Test that the image can be read again from the start after a close */
+TEST_F(FirmwareSourceTest, ReopenAndClose)
+{
+    FirmwareSource source;
+    ASSERT_TRUE(source.open(image_path, *logger));
+    source.chunk(image.size() - 1, 1);
+    ASSERT_TRUE(source.open(image_path, *logger));
+    FirmwareSource::Chunk chunk = source.chunk(0, 16);
+    ASSERT_EQ(chunk.size, 16u);
+    EXPECT_EQ(chunk.data[5], image[5]);
+    source.close();
+    EXPECT_FALSE(source.isOpen());
+    EXPECT_EQ(source.chunk(0, 16).size, 0u);
+}
+
+/* Test the errors for missing and empty images */
+TEST_F(FirmwareSourceTest, InvalidImage)
+{
+    FirmwareSource source;
+    EXPECT_FALSE(source.open("missing_firmware_source.bin", *logger));
+    EXPECT_FALSE(source.isOpen());
+
+    std::ofstream(image_path, std::ios::out | std::ios::trunc).close();
+    EXPECT_FALSE(source.open(image_path, *logger));
+    EXPECT_EQ(source.size(), 0u);
+}
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,87 @@
+/**
+ * @file FrameBatchReaderTest.cpp
+ * @brief Unit test for FrameBatchReader
+ * @version 0.1
+ * @date 2024-08-20
+ */
+#include "../include/FrameBatchReader.h"
+
+#include <unistd.h>
+#include <sys/socket.h>
+#include <gtest/gtest.h>
+
+struct FrameBatchReaderTest : testing::Test
+{
+    int sockets[2];
+    FrameBatchReader* reader;
+    FrameBatchReaderTest()
+    {
+        /* Datagram pair keeps the frame boundaries like a CAN_RAW socket */
+        socketpair(AF_UNIX, SOCK_DGRAM, 0, sockets);
+        reader = new FrameBatchReader(sockets[0], 4);
+    }
+    ~FrameBatchReaderTest()
+    {
+        delete reader;
+        close(sockets[0]);
+        close(sockets[1]);
+    }
+    void sendFrames(int count)
+    {
+        for (int index = 0; index < count; ++index)
+        {
+            struct can_frame frame = {};
+            frame.can_id = 0x1011;
+            frame.can_dlc = 2;
+            frame.data[0] = 0x01;
+            frame.data[1] = static_cast<uint8_t>(index);
+            write(sockets[1], &frame, sizeof(frame));
+        }
+    }
+};
+
+TEST_F(FrameBatchReaderTest, EmptySocket)
+{
+    std::vector<TimestampedFrame> frames;
+    EXPECT_EQ(reader->readBatch(frames), 0);
+    EXPECT_TRUE(frames.empty());
+}
+
+TEST_F(FrameBatchReaderTest, ReadsWholeBatch)
+{
+    sendFrames(3);
+    std::vector<TimestampedFrame> frames;
+    EXPECT_EQ(reader->readBatch(frames), 3);
+    ASSERT_EQ(frames.size(), 3u);
+    for (int index = 0; index < 3; ++index)
+    {
+        EXPECT_EQ(frames[index].frame.can_id, 0x1011u);
+        EXPECT_EQ(frames[index].frame.data[1], index);
+        EXPECT_NE(frames[index].timestamp.tv_sec, 0);
+    }
+}
+
+TEST_F(FrameBatchReaderTest, SplitsAboveBatchSize)
+{
+    sendFrames(6);
+    std::vector<TimestampedFrame> frames;
+    EXPECT_EQ(reader->readBatch(frames), 4);
+    EXPECT_EQ(reader->readBatch(frames), 2);
+    EXPECT_EQ(frames[1].frame.data[1], 5);
+    EXPECT_EQ(reader->readBatch(frames), 0);
+}
+
+TEST_F(FrameBatchReaderTest, BatchSizeIsClamped)
+{
+    reader->setBatchSize(0);
+    EXPECT_EQ(reader->getBatchSize(), 1u);
+    reader->setBatchSize(MAX_RECV_BATCH_SIZE + 1);
+    EXPECT_EQ(reader->getBatchSize(), static_cast<size_t>(MAX_RECV_BATCH_SIZE));
+}
+
+TEST_F(FrameBatchReaderTest, InvalidSocket)
+{
+    FrameBatchReader invalid_reader(-1);
+    std::vector<TimestampedFrame> frames;
+    EXPECT_EQ(invalid_reader.readBatch(frames), BATCH_READ_ERROR);
+}
@@ -0,0 +1,171 @@
+/**
+ * @file FrameRingBufferTest.cpp
+ * @brief Unit test for FrameRingBuffer
+ * @version 0.1
+ * @date 2024-08-22
+ */
+#include "../include/FrameRingBuffer.h"
+
+#include <thread>
+#include <chrono>
+#include <gtest/gtest.h>
+
+static TimestampedFrame makeFrame(uint8_t value)
+{
+    struct can_frame frame = {};
+    frame.can_id = 0x1011;
+    frame.can_dlc = 2;
+    frame.data[0] = 0x01;
+    frame.data[1] = value;
+    return TimestampedFrame(frame);
+}
+
+TEST(FrameRingBufferTest, CapacityRoundedToPowerOfTwo)
+{
+    FrameRingBuffer ring(5);
+    EXPECT_EQ(ring.capacity(), 8u);
+    EXPECT_TRUE(ring.empty());
+}
+
+TEST(FrameRingBufferTest, PushPopKeepsOrder)
+{
+    FrameRingBuffer ring(8);
+    for (uint8_t index = 0; index < 5; ++index)
+    {
+        EXPECT_TRUE(ring.tryPush(makeFrame(index)));
+    }
+    EXPECT_EQ(ring.size(), 5u);
+
+    TimestampedFrame frame;
+    for (uint8_t index = 0; index < 5; ++index)
+    {
+        ASSERT_TRUE(ring.tryPop(frame));
+        EXPECT_EQ(frame.frame.data[1], index);
+    }
+    EXPECT_FALSE(ring.tryPop(frame));
+    EXPECT_TRUE(ring.empty());
+}
+
+TEST(FrameRingBufferTest, FullBufferDropsFrames)
+{
+    FrameRingBuffer ring(4);
+    for (uint8_t index = 0; index < 4; ++index)
+    {
+        EXPECT_TRUE(ring.tryPush(makeFrame(index)));
+    }
+    EXPECT_FALSE(ring.tryPush(makeFrame(4)));
+    EXPECT_FALSE(ring.push(makeFrame(5)));
+    EXPECT_EQ(ring.getDroppedFrames(), 2u);
+    EXPECT_EQ(ring.getPeakOccupancy(), 4u);
+
+    /* Slots are reused after the consumer releases them */
+    TimestampedFrame frame;
+    ASSERT_TRUE(ring.tryPop(frame));
+    EXPECT_EQ(frame.frame.data[1], 0);
+    EXPECT_TRUE(ring.tryPush(makeFrame(6)));
+    EXPECT_EQ(ring.size(), 4u);
+}
+
+TEST(FrameRingBufferTest, OfferOnFullBufferIsNotADrop)
+{
+    FrameRingBuffer ring(2);
+    EXPECT_TRUE(ring.offer(makeFrame(0)));
+    EXPECT_TRUE(ring.offer(makeFrame(1)));
+    for (int retry = 0; retry < 10; ++retry)
+    {
+        EXPECT_FALSE(ring.offer(makeFrame(2)));
+    }
+    EXPECT_EQ(ring.getDroppedFrames(), 0u);
+
+    /* Only an abandoned frame is counted */
+    ring.recordDrop();
+    EXPECT_EQ(ring.getDroppedFrames(), 1u);
+}
+
+TEST(FrameRingBufferTest, WaitPopTimeout)
+{
+    FrameRingBuffer ring(4);
+    TimestampedFrame frame;
+    auto start = std::chrono::steady_clock::now();
+    EXPECT_FALSE(ring.waitPop(frame, 50));
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    EXPECT_GE(std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count(), 40);
+}
+
+TEST(FrameRingBufferTest, WaitPopWokenByPush)
+{
+    FrameRingBuffer ring(4);
+    std::thread producer([&ring]()
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        ring.push(makeFrame(0x22));
+    });
+
+    TimestampedFrame frame;
+    bool received = false;
+    /* The producer may push before or after the consumer starts to wait */
+    for (int attempt = 0; attempt < 10 && !received; ++attempt)
+    {
+        received = ring.waitPop(frame, 1000);
+    }
+    producer.join();
+    ASSERT_TRUE(received);
+    EXPECT_EQ(frame.frame.data[1], 0x22);
+}
+
+TEST(FrameRingBufferTest, WakeUpReleasesConsumer)
+{
+    FrameRingBuffer ring(4);
+    std::thread stopper([&ring]()
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        ring.wakeUp();
+    });
+
+    TimestampedFrame frame;
+    auto start = std::chrono::steady_clock::now();
+    EXPECT_FALSE(ring.waitPop(frame, 5000));
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    stopper.join();
+    EXPECT_LT(std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count(), 5000);
+}
+
+TEST(FrameRingBufferTest, TwoProducersOneConsumer)
+{
+    FrameRingBuffer ring(64);
+    const int frames_per_producer = 2000;
+    auto produce = [&ring, frames_per_producer](uint8_t producer_id)
+    {
+        for (int index = 0; index < frames_per_producer; ++index)
+        {
+            while (!ring.push(makeFrame(producer_id)))
+            {
+                std::this_thread::yield();
+            }
+        }
+    };
+    std::thread first(produce, 1);
+    std::thread second(produce, 2);
+
+    int received[3] = {0, 0, 0};
+    TimestampedFrame frame;
+    while (received[1] + received[2] < 2 * frames_per_producer)
+    {
+        if (ring.waitPop(frame, 100))
+        {
+            ASSERT_TRUE(frame.frame.data[1] == 1 || frame.frame.data[1] == 2);
+            received[frame.frame.data[1]]++;
+        }
+    }
+    first.join();
+    second.join();
+    EXPECT_EQ(received[1], frames_per_producer);
+    EXPECT_EQ(received[2], frames_per_producer);
+    EXPECT_TRUE(ring.empty());
+}
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
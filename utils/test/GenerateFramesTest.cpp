@@ -7,6 +7,7 @@
 #include <sys/ioctl.h>
 #include <thread>
 #include <fcntl.h>
+#include <sys/socket.h>
 
 /* Global variables */
 /* Sockets for Recive/Send */
@@ -333,6 +334,36 @@ TEST_F(GenerateFramesTest, SecurityKeyTest)
     /* TEST */
     testFrames(result_frame, *c1);
 }
+/* Test for method securityAccessRequestSeed with a seed that needs a multi-frame message */
+TEST_F(GenerateFramesTest, SecuritySeedLongTest)
+{
+    /* Create expected frame */
+    struct can_frame result_frame = createFrame({0x10,0x09,0x67,0x1,0x01,0x02,0x03,0x04});
+    /* Start listening for frame in the CAN-BUS */
+    std::thread receive_thread([this]() {
+        c1->capture();
+    });
+    /* Send frame */
+    g1->securityAccessRequestSeed(id,{0x01,0x02,0x03,0x04,0x05,0x06,0x07});
+    receive_thread.join();
+    /* TEST */
+    testFrames(result_frame, *c1);
+}
+/* Test for method securityAccessSendKey with a key that needs a multi-frame message */
+TEST_F(GenerateFramesTest, SecurityKeyLongTest)
+{
+    /* Create expected frame */
+    struct can_frame result_frame = createFrame({0x10,0x09,0x27,0x2,0x01,0x02,0x03,0x04});
+    /* Start listening for frame in the CAN-BUS */
+    std::thread receive_thread([this]() {
+        c1->capture();
+    });
+    /* Send frame */
+    g1->securityAccessSendKey(id,{0x01,0x02,0x03,0x04,0x05,0x06,0x07});
+    receive_thread.join();
+    /* TEST */
+    testFrames(result_frame, *c1);
+}
 /* Test for method securityAccessSendKey as a response */
 TEST_F(GenerateFramesTest, SecurityKeyResponseTest) 
 {
@@ -456,6 +487,51 @@ TEST_F(GenerateFramesTest, ReadByIdentLongRespTest)
     /* TEST */
     testFrames(result_frame, *c1);
 }
+/* Test for Service ReadByIdentifier request with several DIDs */
+TEST_F(GenerateFramesTest, ReadByIdentMultipleDIDsTest) 
+{
+    /* Create expected frame */
+    struct can_frame result_frame = createFrame({0x05,0x22,0x12,0x34,0x56,0x78});
+    /* Start listening for frame in the CAN-BUS */
+    std::thread receive_thread([this]() {
+        c1->capture();
+    });
+    /* Send frame */
+    g1->readDataByIdentifier(id, std::vector<uint16_t>{0x1234,0x5678});
+    receive_thread.join();
+    /* TEST */
+    testFrames(result_frame, *c1);
+}
+/* Test for Service ReadByIdentifier response with several DIDs */
+TEST_F(GenerateFramesTest, ReadByIdentRecordsTest) 
+{
+    /* Create expected frame */
+    struct can_frame result_frame = createFrame({0x10,0x09,0x62,0x12,0x34,1,2,0x56});
+    /* Start listening for frame in the CAN-BUS */
+    std::thread receive_thread([this]() {
+        c1->capture();
+    });
+    /*Send frame simulation*/
+    g1->readDataByIdentifierRecords(id,{0x12,0x34,1,2,0x56,0x78,3,4});
+    receive_thread.join();
+    /* TEST */
+    testFrames(result_frame, *c1);
+}
+/* Test for Service DynamicallyDefineDataIdentifier */
+TEST_F(GenerateFramesTest, DynamicallyDefineDIDRespTest)
+{
+    /* Create expected frame */
+    struct can_frame result_frame = createFrame({0x04,0x6C,0x01,0xF3,0x00});
+    /* Start listening for frame in the CAN-BUS */
+    std::thread receive_thread([this]() {
+        c1->capture();
+    });
+    /*Send frame simulation*/
+    g1->dynamicallyDefineDataIdentifier(id,0x01,{0xF3,0x00},true);
+    receive_thread.join();
+    /* TEST */
+    testFrames(result_frame, *c1);
+}
 /* Test for Service ReadMemoryByAddress */
 TEST_F(GenerateFramesTest, ReadByAddressRespTest) 
 {
@@ -969,6 +1045,98 @@ TEST_F(GenerateFramesTest, ReqStatus2)
     EXPECT_EQ(response, false);
 }
 
+/* Socket pair keeping the frame boundaries, used by the batch tests */
+struct FramePair
+{
+    int fds[2];
+    FramePair() { socketpair(AF_UNIX, SOCK_DGRAM, 0, fds); }
+    ~FramePair() { close(fds[0]); close(fds[1]); }
+    bool read(struct can_frame& frame) { return ::read(fds[1], &frame, sizeof(frame)) == sizeof(frame); }
+};
+
+/* Test for fillFrame */
+TEST_F(GenerateFramesTest, FillFrameInPlace)
+{
+    struct can_frame frames[2];
+    const uint8_t data[] = {0x02, 0x3E, 0x00};
+    EXPECT_TRUE(GenerateFrames::fillFrame(frames[0], 0x10FA, data, sizeof(data)));
+    EXPECT_EQ(frames[0].can_id, (0x10FAu & CAN_EFF_MASK) | CAN_EFF_FLAG);
+    EXPECT_EQ(frames[0].can_dlc, 3);
+    EXPECT_EQ(frames[0].data[1], 0x3E);
+    const uint8_t long_data[10] = {0};
+    EXPECT_FALSE(GenerateFrames::fillFrame(frames[1], 0x10FA, long_data, sizeof(long_data)));
+    EXPECT_EQ(frames[1].can_dlc, CAN_MAX_DLEN);
+}
+
+/* Test for sendMultiFrame: first frame and consecutive frames in one batch */
+TEST_F(GenerateFramesTest, SendMultiFrameBatch)
+{
+    FramePair pair;
+    std::vector<uint8_t> message(20);
+    for (size_t index = 0; index < message.size(); ++index)
+    {
+        message[index] = index;
+    }
+    EXPECT_EQ(g1->sendMultiFrame(id, message.data(), message.size(), pair.fds[0]), 3);
+    struct can_frame frame;
+    ASSERT_TRUE(pair.read(frame));
+    EXPECT_EQ(frame.data[0], 0x10);
+    EXPECT_EQ(frame.can_dlc, 8);
+    EXPECT_EQ(frame.data[7], 6);
+    ASSERT_TRUE(pair.read(frame));
+    EXPECT_EQ(frame.data[0], 0x21);
+    EXPECT_EQ(frame.data[1], 7);
+    ASSERT_TRUE(pair.read(frame));
+    EXPECT_EQ(frame.data[0], 0x22);
+    EXPECT_EQ(frame.can_dlc, 7);
+    EXPECT_EQ(frame.data[6], 19);
+}
+
+/* Test for the sequence number of the consecutive frames, over more than one batch */
+TEST_F(GenerateFramesTest, SendMultiFrameSequenceWraps)
+{
+    FramePair pair;
+    /* First frame + 40 consecutive frames */
+    std::vector<uint8_t> message(7 + 7 * 40, 0xAB);
+    EXPECT_EQ(g1->sendMultiFrame(id, message.data(), message.size(), pair.fds[0]), 41);
+    struct can_frame frame;
+    ASSERT_TRUE(pair.read(frame));
+    for (int index = 1; index <= 40; ++index)
+    {
+        ASSERT_TRUE(pair.read(frame));
+        EXPECT_EQ(frame.data[0], 0x20 | (index & 0x0F));
+    }
+}
+
+/* Test for the transmit counters of a socket */
+TEST_F(GenerateFramesTest, TransmitStats)
+{
+    FramePair pair;
+    int socket_fd = pair.fds[0];
+    GenerateFrames::resetTransmitStats(socket_fd);
+    struct can_frame frames[2];
+    const uint8_t data[] = {0x01, 0x37};
+    GenerateFrames::fillFrame(frames[0], id, data, sizeof(data));
+    GenerateFrames::fillFrame(frames[1], id, data, sizeof(data));
+    EXPECT_EQ(g1->sendFrames(frames, 2, socket_fd), 2);
+    const uint8_t long_data[9] = {0};
+    EXPECT_EQ(g1->sendFrame(id, long_data, sizeof(long_data), socket_fd), -1);
+    TransmitStats stats = GenerateFrames::getTransmitStats(socket_fd);
+    EXPECT_EQ(stats.frames_sent, 2u);
+    EXPECT_EQ(stats.send_errors, 1u);
+    EXPECT_EQ(stats.last_error, EMSGSIZE);
+
+    /* Failed write on a closed socket */
+    int closed_fd = socket(AF_UNIX, SOCK_DGRAM, 0);
+    close(closed_fd);
+    GenerateFrames::resetTransmitStats(closed_fd);
+    EXPECT_EQ(g1->sendFrame(0x101, data, sizeof(data), closed_fd), -1);
+    stats = GenerateFrames::getTransmitStats(closed_fd);
+    EXPECT_EQ(stats.frames_sent, 0u);
+    EXPECT_EQ(stats.send_errors, 1u);
+    EXPECT_EQ(stats.last_error, EBADF);
+}
+
 int main(int argc, char* argv[])
 {
     s1 = createSocket();
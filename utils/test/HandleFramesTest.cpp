@@ -81,7 +81,7 @@ TEST_F(HandleFramesTest, HandleFrameEcuReset)
 /* Test for InvalidFrameType */
 TEST_F(HandleFramesTest, InvalidFrameType)
 {
-    struct can_frame testFrame = createFrame({0x31,0x11, 0x02});
+    struct can_frame testFrame = createFrame({0x41,0x11, 0x02});
     testing::internal::CaptureStdout();
     handler.handleFrame(skt, testFrame);
     std::string output = testing::internal::GetCapturedStdout();
@@ -536,6 +536,7 @@ TEST_F(HandleFramesTest, FirstFrame)
 
 TEST_F(HandleFramesTest, WrongConsecutiveFrames)
 {
+    handler.handleFrame(skt, createFrame({0x10, 0x08,0x05}));
     struct can_frame testFrame = createFrame({0x22, 0x0F,0x05});
     testing::internal::CaptureStdout();
     handler.handleFrame(skt, testFrame);
@@ -554,6 +555,27 @@ TEST_F(HandleFramesTest, ConsecutiveFrames)
     EXPECT_NE(output.find("Consecutive frames received."), std::string::npos);
 }
 
+TEST_F(HandleFramesTest, MultiFrameRequest)
+{
+    handler.handleFrame(skt, createFrame({0x10, 0x09, 0x2e, 0x01, 0xa0, 0x11, 0x12, 0x13}));
+    testing::internal::CaptureStdout();
+    handler.handleFrame(skt, createFrame({0x21, 0x14, 0x15, 0x16}));
+    std::string output = testing::internal::GetCapturedStdout();
+
+    EXPECT_NE(output.find("WriteDataByIdentifier service called!"), std::string::npos);
+}
+
+TEST_F(HandleFramesTest, FlowControlFrame)
+{
+    struct can_frame testFrame = createFrame({0x30, 0x00, 0x00});
+    testing::internal::CaptureStdout();
+    handler.handleFrame(skt, testFrame);
+    std::string output = testing::internal::GetCapturedStdout();
+
+    EXPECT_NE(output.find("Flow control frame received"), std::string::npos);
+    EXPECT_EQ(output.find("Invalid frame type."), std::string::npos);
+}
+
 int main(int argc, char **argv)
 {
 testing::InitGoogleTest(&argc, argv);
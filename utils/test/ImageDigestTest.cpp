@@ -0,0 +1,99 @@
+/**
+ * @file ImageDigestTest.cpp
+ * @brief Unit test for ImageDigest
+ * @version 0.1
+ * @date 2024-09-06
+ */
+#include "../include/ImageDigest.h"
+
+#include <gtest/gtest.h>
+#include <cstring>
+
+static std::vector<uint8_t> toBytes(const char* text)
+{
+    return std::vector<uint8_t>(text, text + strlen(text));
+}
+
+/* Test the CRC32C and SHA-256 check values */
+TEST(ImageDigestTest, KnownValues)
+{
+    std::vector<uint8_t> digits = toBytes("123456789");
+    ImageDigest digest(true);
+    digest.update(digits.data(), digits.size());
+    EXPECT_EQ(digest.getCrc32c(), 0xE3069283u);
+
+    std::vector<uint8_t> abc = toBytes("abc");
+    digest.reset(true);
+    digest.update(abc.data(), abc.size());
+    std::vector<uint8_t> expected = {
+        0xba, 0x78, 0x16, 0xbf, 0x8f, 0x01, 0xcf, 0xea, 0x41, 0x41, 0x40, 0xde, 0x5d, 0xae, 0x22, 0x23,
+        0xb0, 0x03, 0x61, 0xa3, 0x96, 0x17, 0x7a, 0x9c, 0xb4, 0x10, 0xff, 0x61, 0xf2, 0x00, 0x15, 0xad
+    };
+    EXPECT_EQ(digest.getSha256(), expected);
+
+    /* 56 bytes: the padding needs a second block */
+    std::vector<uint8_t> two_blocks = toBytes("abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq");
+    digest.reset(true);
+    digest.update(two_blocks.data(), two_blocks.size());
+    EXPECT_EQ(digest.getSha256()[0], 0x24);
+    EXPECT_EQ(digest.getSha256()[31], 0xc1);
+}
+
+/* Test that the digest does not depend on how the image is split in blocks */
+TEST(ImageDigestTest, IncrementalUpdates)
+{
+    std::vector<uint8_t> image(100000);
+    for (size_t index = 0; index < image.size(); ++index)
+    {
+        image[index] = static_cast<uint8_t>(index * 31 + 7);
+    }
+    ImageDigest whole(true);
+    whole.update(image.data(), image.size());
+
+    ImageDigest blocks(true);
+    for (size_t offset = 0; offset < image.size(); offset += 61)
+    {
+        blocks.update(image.data() + offset, std::min<size_t>(61, image.size() - offset));
+    }
+    EXPECT_EQ(blocks.getLength(), image.size());
+    EXPECT_EQ(blocks.getCrc32c(), whole.getCrc32c());
+    EXPECT_EQ(blocks.getSha256(), whole.getSha256());
+    /* Same result as the table version when the CPU instructions are used */
+    EXPECT_EQ(ImageDigest::updateCrc32c(0xFFFFFFFF, image.data(), image.size()) ^ 0xFFFFFFFF, whole.getCrc32c());
+}
+
+/* Test the digest records and their comparison */
+TEST(ImageDigestTest, Records)
+{
+    std::vector<uint8_t> image = toBytes("software image");
+    ImageDigest crc_only(false);
+    crc_only.update(image.data(), image.size());
+    std::vector<uint8_t> crc_record = crc_only.getRecord();
+    ASSERT_EQ(crc_record.size(), ImageDigest::getRecordLength(IMAGE_DIGEST_CRC32C));
+    EXPECT_EQ(crc_record[0], IMAGE_DIGEST_CRC32C);
+    EXPECT_TRUE(crc_only.matches(crc_record));
+
+    ImageDigest with_sha(true);
+    with_sha.update(image.data(), image.size());
+    std::vector<uint8_t> sha_record = with_sha.getRecord();
+    ASSERT_EQ(sha_record.size(), ImageDigest::getRecordLength(IMAGE_DIGEST_CRC32C_SHA256));
+    EXPECT_TRUE(with_sha.matches(sha_record));
+    /* A CRC32C record is checked on the CRC32C; a SHA-256 one needs the SHA-256 */
+    EXPECT_TRUE(with_sha.matches(crc_record));
+    EXPECT_FALSE(crc_only.matches(sha_record));
+
+    /* One flipped bit in the image */
+    sha_record[10] ^= 0x01;
+    EXPECT_FALSE(with_sha.matches(sha_record));
+    image[3] ^= 0x80;
+    ImageDigest corrupted(false);
+    corrupted.update(image.data(), image.size());
+    EXPECT_FALSE(corrupted.matches(crc_record));
+    EXPECT_FALSE(corrupted.matches({0x07, 0x00}));
+}
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
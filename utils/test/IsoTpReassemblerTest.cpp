@@ -0,0 +1,232 @@
+/**
+ * @file IsoTpReassemblerTest.cpp
+ * @brief Unit test for IsoTpReassembler
+ * @version 0.1
+ * @date 2024-08-28
+ */
+#include "../include/IsoTpReassembler.h"
+
+#include <thread>
+#include <gtest/gtest.h>
+
+/* Build a frame from the tester 0xFA to the MCU 0x10 */
+static struct can_frame createFrame(std::vector<uint8_t> data, canid_t can_id = 0xFA10)
+{
+    struct can_frame frame = {};
+    frame.can_id = can_id | CAN_EFF_FLAG;
+    frame.can_dlc = data.size();
+    std::copy(data.begin(), data.end(), frame.data);
+    return frame;
+}
+
+/* Send a whole message of the given length starting with the SID 0x2E, return the result of the last frame */
+static IsoTpReassembler::Result sendMessage(IsoTpReassembler& iso_tp, size_t length, std::vector<uint8_t>& message,
+                                            canid_t can_id = 0xFA10)
+{
+    std::vector<uint8_t> payload(length);
+    for (size_t index = 0; index < length; ++index)
+    {
+        payload[index] = static_cast<uint8_t>(index);
+    }
+    payload[0] = 0x2E;
+    std::vector<uint8_t> first = {static_cast<uint8_t>(0x10 | (length >> 8)), static_cast<uint8_t>(length & 0xFF)};
+    first.insert(first.end(), payload.begin(), payload.begin() + 6);
+    IsoTpReassembler::Result result = iso_tp.handleFrame(createFrame(first, can_id), message);
+    uint8_t sequence = 1;
+    for (size_t offset = 6; offset < length; offset += 7, sequence = (sequence + 1) & 0x0F)
+    {
+        std::vector<uint8_t> consecutive = {static_cast<uint8_t>(0x20 | sequence)};
+        consecutive.insert(consecutive.end(), payload.begin() + offset, payload.begin() + std::min(offset + 7, length));
+        result = iso_tp.handleFrame(createFrame(consecutive, can_id), message);
+    }
+    return result;
+}
+
+/* Test that the first frame opens a context and asks the sender to continue */
+TEST(IsoTpReassemblerTest, FirstFrameSendsFlowControl)
+{
+    IsoTpReassembler iso_tp(0, 5);
+    std::vector<uint8_t> message;
+    auto result = iso_tp.handleFrame(createFrame({0x10, 0x0A, 0x2E, 0x01, 0x02, 0x03, 0x04, 0x05}), message);
+    EXPECT_EQ(result.status, IsoTpReassembler::FIRST_FRAME);
+    EXPECT_EQ(result.message_length, 10u);
+    EXPECT_EQ(result.frame_count, 2u);
+    ASSERT_TRUE(result.send_flow_control);
+    EXPECT_EQ(result.flow_control_id & CAN_EFF_MASK, 0x10FAu);
+    EXPECT_EQ(result.flow_control[0], ISOTP_FLOW_CONTINUE);
+    EXPECT_EQ(result.flow_control[1], 0x00);
+    EXPECT_EQ(result.flow_control[2], 0x05);
+    EXPECT_EQ(iso_tp.getActiveCount(), 1u);
+}
+
+/* Test that a message over 255 bytes (12-bit FF_DL) is rebuilt with the sequence number wrapping */
+TEST(IsoTpReassemblerTest, LongMessageWrapsSequence)
+{
+    IsoTpReassembler iso_tp;
+    std::vector<uint8_t> message;
+    auto result = sendMessage(iso_tp, 1000, message);
+    ASSERT_EQ(result.status, IsoTpReassembler::COMPLETE);
+    ASSERT_EQ(message.size(), 1001u);
+    EXPECT_EQ(message[0], 1000 & 0xFF);
+    EXPECT_EQ(message[1], 0x2E);
+    EXPECT_EQ(message[1000], 999 & 0xFF);
+    EXPECT_EQ(iso_tp.getActiveCount(), 0u);
+}
+
+/* Test that the padding of the last consecutive frame is dropped */
+TEST(IsoTpReassemblerTest, PaddingDropped)
+{
+    IsoTpReassembler iso_tp;
+    std::vector<uint8_t> message;
+    iso_tp.handleFrame(createFrame({0x10, 0x08, 0x2E, 0x01, 0x02, 0x03, 0x04, 0x05}), message);
+    auto result = iso_tp.handleFrame(createFrame({0x21, 0x06, 0x07, 0xAA, 0xAA, 0xAA, 0xAA, 0xAA}), message);
+    ASSERT_EQ(result.status, IsoTpReassembler::COMPLETE);
+    EXPECT_EQ(message, std::vector<uint8_t>({0x08, 0x2E, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07}));
+}
+
+/* Test the 32-bit FF_DL escape sequence */
+TEST(IsoTpReassemblerTest, EscapeSequenceLength)
+{
+    IsoTpReassembler iso_tp;
+    std::vector<uint8_t> message;
+    auto result = iso_tp.handleFrame(createFrame({0x10, 0x00, 0x00, 0x00, 0x13, 0x88, 0x2E, 0x01}), message);
+    EXPECT_EQ(result.status, IsoTpReassembler::FIRST_FRAME);
+    EXPECT_EQ(result.message_length, 5000u);
+    uint8_t sequence = 1;
+    for (size_t received = 2; received < 5000; received += 7, sequence = (sequence + 1) & 0x0F)
+    {
+        result = iso_tp.handleFrame(createFrame({static_cast<uint8_t>(0x20 | sequence), 1, 2, 3, 4, 5, 6, 7}), message);
+    }
+    ASSERT_EQ(result.status, IsoTpReassembler::COMPLETE);
+    EXPECT_EQ(message.size(), 5001u);
+    EXPECT_EQ(message[1], 0x2E);
+
+    /* Lengths that fit on 12 bits must not use the escape sequence */
+    result = iso_tp.handleFrame(createFrame({0x10, 0x00, 0x00, 0x00, 0x00, 0x20, 0x2E, 0x01}), message);
+    EXPECT_EQ(result.status, IsoTpReassembler::IGNORED);
+    /* Messages over the maximum size are refused with an overflow flow control */
+    result = iso_tp.handleFrame(createFrame({0x10, 0x00, 0x00, 0x10, 0x00, 0x00, 0x2E, 0x01}), message);
+    EXPECT_EQ(result.status, IsoTpReassembler::BUFFER_OVERFLOW);
+    ASSERT_TRUE(result.send_flow_control);
+    EXPECT_EQ(result.flow_control[0], ISOTP_FLOW_OVERFLOW);
+}
+
+/* Test that two senders are reassembled independently */
+TEST(IsoTpReassemblerTest, ConcurrentSenders)
+{
+    IsoTpReassembler iso_tp;
+    std::vector<uint8_t> message;
+    iso_tp.handleFrame(createFrame({0x10, 0x09, 0x2E, 0x01, 0x02, 0x03, 0x04, 0x05}, 0xFA10), message);
+    iso_tp.handleFrame(createFrame({0x10, 0x08, 0x62, 0x11, 0x12, 0x13, 0x14, 0x15}, 0x1110), message);
+    EXPECT_EQ(iso_tp.getActiveCount(), 2u);
+
+    auto result = iso_tp.handleFrame(createFrame({0x21, 0x16, 0x17}, 0x1110), message);
+    ASSERT_EQ(result.status, IsoTpReassembler::COMPLETE);
+    EXPECT_EQ(message, std::vector<uint8_t>({0x08, 0x62, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17}));
+    result = iso_tp.handleFrame(createFrame({0x21, 0x06, 0x07, 0x08}, 0xFA10), message);
+    ASSERT_EQ(result.status, IsoTpReassembler::COMPLETE);
+    EXPECT_EQ(message, std::vector<uint8_t>({0x09, 0x2E, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08}));
+}
+
+/* Test that a flow control frame is sent after every block */
+TEST(IsoTpReassemblerTest, BlockSizeFlowControl)
+{
+    IsoTpReassembler iso_tp(2, 0);
+    std::vector<uint8_t> message;
+    iso_tp.handleFrame(createFrame({0x10, 0x30, 0x2E, 0x01, 0x02, 0x03, 0x04, 0x05}), message);
+    std::vector<bool> flow_controls;
+    for (uint8_t sequence = 1; sequence <= 6; ++sequence)
+    {
+        auto result = iso_tp.handleFrame(createFrame({static_cast<uint8_t>(0x20 | sequence), 1, 2, 3, 4, 5, 6, 7}), message);
+        flow_controls.push_back(result.send_flow_control);
+        if (sequence < 6)
+        {
+            EXPECT_EQ(result.status, IsoTpReassembler::IN_PROGRESS);
+        }
+        else
+        {
+            /* 6 + 6 * 7 = 48 bytes, no flow control after the last frame */
+            EXPECT_EQ(result.status, IsoTpReassembler::COMPLETE);
+        }
+    }
+    EXPECT_EQ(flow_controls, std::vector<bool>({false, true, false, true, false, false}));
+}
+
+/* Test that a wrong sequence number aborts the message */
+TEST(IsoTpReassemblerTest, WrongSequenceAborts)
+{
+    IsoTpReassembler iso_tp;
+    std::vector<uint8_t> message;
+    iso_tp.handleFrame(createFrame({0x10, 0x10, 0x2E, 0x01, 0x02, 0x03, 0x04, 0x05}), message);
+    auto result = iso_tp.handleFrame(createFrame({0x22, 1, 2, 3, 4, 5, 6, 7}), message);
+    EXPECT_EQ(result.status, IsoTpReassembler::WRONG_SEQUENCE);
+    EXPECT_EQ(result.expected_pci, 0x21);
+    EXPECT_EQ(result.received_pci, 0x22);
+    result = iso_tp.handleFrame(createFrame({0x21, 1, 2, 3, 4, 5, 6, 7}), message);
+    EXPECT_EQ(result.status, IsoTpReassembler::NO_CONTEXT);
+}
+
+/* Test that a consecutive frame received after N_Cr is refused */
+TEST(IsoTpReassemblerTest, ConsecutiveFrameTimeout)
+{
+    IsoTpReassembler iso_tp(0, 0, 20);
+    std::vector<uint8_t> message;
+    iso_tp.handleFrame(createFrame({0x10, 0x10, 0x2E, 0x01, 0x02, 0x03, 0x04, 0x05}), message);
+    std::this_thread::sleep_for(std::chrono::milliseconds(40));
+    auto result = iso_tp.handleFrame(createFrame({0x21, 1, 2, 3, 4, 5, 6, 7}), message);
+    EXPECT_EQ(result.status, IsoTpReassembler::TIMEOUT);
+    EXPECT_EQ(iso_tp.getActiveCount(), 0u);
+}
+
+/* Test that all the contexts can be used and that expired ones are reused */
+TEST(IsoTpReassemblerTest, ContextPoolExhausted)
+{
+    IsoTpReassembler iso_tp(0, 0, 20);
+    std::vector<uint8_t> message;
+    for (canid_t sender = 0; sender < ISOTP_MAX_CONTEXTS; ++sender)
+    {
+        auto result = iso_tp.handleFrame(createFrame({0x10, 0x10, 0x2E, 0x01}, ((0x20 + sender) << 8) | 0x10), message);
+        EXPECT_EQ(result.status, IsoTpReassembler::FIRST_FRAME);
+    }
+    auto result = iso_tp.handleFrame(createFrame({0x10, 0x10, 0x2E, 0x01}, 0xFA10), message);
+    EXPECT_EQ(result.status, IsoTpReassembler::BUFFER_OVERFLOW);
+    std::this_thread::sleep_for(std::chrono::milliseconds(40));
+    result = iso_tp.handleFrame(createFrame({0x10, 0x10, 0x2E, 0x01}, 0xFA10), message);
+    EXPECT_EQ(result.status, IsoTpReassembler::FIRST_FRAME);
+}
+
+/* Test that a message sent in 64-byte CAN FD frames is rebuilt */
+TEST(IsoTpReassemblerTest, CanFdFrames)
+{
+    IsoTpReassembler iso_tp;
+    std::vector<uint8_t> message;
+    struct canfd_frame frame = {};
+    frame.can_id = 0xFA10 | CAN_EFF_FLAG;
+    frame.len = CANFD_MAX_DLEN;
+    /* 200 bytes: 62 in the first frame, then 63 + 63 + 12 */
+    frame.data[0] = 0x10;
+    frame.data[1] = 200;
+    frame.data[2] = 0x2E;
+    auto result = iso_tp.handleFrame(frame, message);
+    ASSERT_EQ(result.status, IsoTpReassembler::FIRST_FRAME);
+    EXPECT_EQ(result.frame_count, 4u);
+    for (uint8_t sequence = 1; sequence <= 3; ++sequence)
+    {
+        frame.data[0] = 0x20 | sequence;
+        frame.data[1] = sequence;
+        frame.len = sequence < 3 ? CANFD_MAX_DLEN : 16;
+        result = iso_tp.handleFrame(frame, message);
+    }
+    ASSERT_EQ(result.status, IsoTpReassembler::COMPLETE);
+    ASSERT_EQ(message.size(), 201u);
+    EXPECT_EQ(message[1], 0x2E);
+    EXPECT_EQ(message[63], 1);
+    EXPECT_EQ(message[126], 2);
+    EXPECT_EQ(message[189], 3);
+}
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,279 @@
+/**
+ * @file IsoTpTransmitterTest.cpp
+ * @brief Unit test for IsoTpTransmitter
+ * @version 0.1
+ * @date 2024-08-29
+ */
+#include "../include/IsoTpTransmitter.h"
+#include "../include/CanFd.h"
+
+#include <poll.h>
+#include <future>
+#include <memory>
+#include <sys/socket.h>
+#include <gtest/gtest.h>
+
+Logger logger;
+
+/* MCU 0x10 answering the tester 0xFA */
+static const canid_t TX_ID = 0xFA10;
+
+struct IsoTpTransmitterTest : testing::Test
+{
+    int fds[2];
+    std::shared_ptr<std::promise<IsoTpTransmitter::TransmitStatus>> result;
+    std::future<IsoTpTransmitter::TransmitStatus> done;
+
+    IsoTpTransmitterTest() : result(std::make_shared<std::promise<IsoTpTransmitter::TransmitStatus>>())
+    {
+        socketpair(AF_UNIX, SOCK_DGRAM, 0, fds);
+        done = result->get_future();
+    }
+    ~IsoTpTransmitterTest()
+    {
+        close(fds[0]);
+        close(fds[1]);
+    }
+    IsoTpTransmitter::CompletionCallback callback()
+    {
+        auto promise = result;
+        return [promise](IsoTpTransmitter::TransmitStatus status) { promise->set_value(status); };
+    }
+    /* Read the next frame sent by the transmitter, false if none within timeout_ms */
+    bool readFrame(struct can_frame& frame, int timeout_ms = 200)
+    {
+        struct pollfd pfd = {fds[1], POLLIN, 0};
+        return poll(&pfd, 1, timeout_ms) > 0 && read(fds[1], &frame, sizeof(frame)) == sizeof(frame);
+    }
+    /* Flow control frame of the receiver, sender and receiver swapped */
+    static struct can_frame flowControl(uint8_t flow_status, uint8_t block_size, uint8_t st_min)
+    {
+        struct can_frame frame = {};
+        frame.can_id = 0x10FA | CAN_EFF_FLAG;
+        frame.can_dlc = 3;
+        frame.data[0] = flow_status;
+        frame.data[1] = block_size;
+        frame.data[2] = st_min;
+        return frame;
+    }
+    static std::vector<uint8_t> createPayload(size_t length)
+    {
+        std::vector<uint8_t> payload(length);
+        for (size_t index = 0; index < length; ++index)
+        {
+            payload[index] = static_cast<uint8_t>(index);
+        }
+        payload[0] = 0x62;
+        return payload;
+    }
+};
+
+/* Test that a short message goes out in a single frame without flow control */
+TEST_F(IsoTpTransmitterTest, SingleFrame)
+{
+    EXPECT_TRUE(IsoTpTransmitter::getInstance().send(fds[0], TX_ID, {0x62, 0x01, 0x02}, logger, callback()));
+    struct can_frame frame;
+    ASSERT_TRUE(readFrame(frame));
+    EXPECT_EQ(frame.can_dlc, 4);
+    EXPECT_EQ(frame.data[0], 0x03);
+    EXPECT_EQ(frame.data[1], 0x62);
+    ASSERT_EQ(done.wait_for(std::chrono::milliseconds(0)), std::future_status::ready);
+    EXPECT_EQ(done.get(), IsoTpTransmitter::COMPLETE);
+    EXPECT_FALSE(IsoTpTransmitter::getInstance().isBusy(TX_ID));
+}
+
+/* Test that the consecutive frames are sent only after the flow control frame */
+TEST_F(IsoTpTransmitterTest, WaitsForFlowControl)
+{
+    IsoTpTransmitter& transmitter = IsoTpTransmitter::getInstance();
+    ASSERT_TRUE(transmitter.send(fds[0], TX_ID, createPayload(20), logger, callback()));
+    struct can_frame frame;
+    ASSERT_TRUE(readFrame(frame));
+    EXPECT_EQ(frame.data[0], 0x10);
+    EXPECT_EQ(frame.data[1], 20);
+    EXPECT_EQ(frame.data[2], 0x62);
+    EXPECT_FALSE(readFrame(frame, 50));
+    EXPECT_TRUE(transmitter.isBusy(TX_ID));
+
+    EXPECT_TRUE(transmitter.onFlowControl(flowControl(0x30, 0, 0)));
+    ASSERT_TRUE(readFrame(frame));
+    EXPECT_EQ(frame.data[0], 0x21);
+    EXPECT_EQ(frame.data[1], 6);
+    ASSERT_TRUE(readFrame(frame));
+    EXPECT_EQ(frame.data[0], 0x22);
+    EXPECT_EQ(frame.can_dlc, 8);
+    EXPECT_EQ(frame.data[7], 19);
+    ASSERT_EQ(done.wait_for(std::chrono::milliseconds(200)), std::future_status::ready);
+    EXPECT_EQ(done.get(), IsoTpTransmitter::COMPLETE);
+    EXPECT_FALSE(transmitter.isBusy(TX_ID));
+}
+
+/* Test that a new flow control frame is awaited after every block */
+TEST_F(IsoTpTransmitterTest, BlockSize)
+{
+    IsoTpTransmitter& transmitter = IsoTpTransmitter::getInstance();
+    /* First frame + 5 consecutive frames */
+    ASSERT_TRUE(transmitter.send(fds[0], TX_ID, createPayload(6 + 7 * 5), logger, callback()));
+    struct can_frame frame;
+    ASSERT_TRUE(readFrame(frame));
+    uint8_t sequence = 1;
+    for (int block = 0; block < 3; ++block)
+    {
+        EXPECT_TRUE(transmitter.onFlowControl(flowControl(0x30, 2, 0)));
+        for (int index = 0; index < 2 && sequence <= 5; ++index, ++sequence)
+        {
+            ASSERT_TRUE(readFrame(frame));
+            EXPECT_EQ(frame.data[0], 0x20 | sequence);
+        }
+        if (sequence <= 5)
+        {
+            EXPECT_FALSE(readFrame(frame, 50));
+        }
+    }
+    ASSERT_EQ(done.wait_for(std::chrono::milliseconds(200)), std::future_status::ready);
+    EXPECT_EQ(done.get(), IsoTpTransmitter::COMPLETE);
+}
+
+/* Test that STmin separates the consecutive frames */
+TEST_F(IsoTpTransmitterTest, SeparationTime)
+{
+    IsoTpTransmitter& transmitter = IsoTpTransmitter::getInstance();
+    ASSERT_TRUE(transmitter.send(fds[0], TX_ID, createPayload(6 + 7 * 3), logger, callback()));
+    struct can_frame frame;
+    ASSERT_TRUE(readFrame(frame));
+    auto start = std::chrono::steady_clock::now();
+    EXPECT_TRUE(transmitter.onFlowControl(flowControl(0x30, 0, 20)));
+    for (int index = 0; index < 3; ++index)
+    {
+        ASSERT_TRUE(readFrame(frame));
+    }
+    ASSERT_EQ(done.wait_for(std::chrono::milliseconds(200)), std::future_status::ready);
+    EXPECT_EQ(done.get(), IsoTpTransmitter::COMPLETE);
+    EXPECT_GE(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(40));
+}
+
+/* Test the 32-bit FF_DL escape sequence and the sequence number wrapping */
+TEST_F(IsoTpTransmitterTest, LongMessage)
+{
+    IsoTpTransmitter& transmitter = IsoTpTransmitter::getInstance();
+    ASSERT_TRUE(transmitter.send(fds[0], TX_ID, createPayload(5000), logger, callback()));
+    struct can_frame frame;
+    ASSERT_TRUE(readFrame(frame));
+    EXPECT_EQ(frame.data[0], 0x10);
+    EXPECT_EQ(frame.data[1], 0x00);
+    EXPECT_EQ(frame.data[4], 0x13);
+    EXPECT_EQ(frame.data[5], 0x88);
+    EXPECT_EQ(frame.data[6], 0x62);
+    /* Small blocks so the socket buffer never fills up */
+    size_t received = 2;
+    uint8_t sequence = 1;
+    while (received < 5000)
+    {
+        ASSERT_TRUE(transmitter.onFlowControl(flowControl(0x30, 16, 0)));
+        for (int index = 0; index < 16 && received < 5000; ++index)
+        {
+            ASSERT_TRUE(readFrame(frame));
+            ASSERT_EQ(frame.data[0], 0x20 | sequence);
+            sequence = (sequence + 1) & 0x0F;
+            received += frame.can_dlc - 1;
+        }
+    }
+    EXPECT_EQ(received, 5000u);
+    ASSERT_EQ(done.wait_for(std::chrono::milliseconds(200)), std::future_status::ready);
+    EXPECT_EQ(done.get(), IsoTpTransmitter::COMPLETE);
+}
+
+/* Test that an overflow flow control frame ends the transmission */
+TEST_F(IsoTpTransmitterTest, ReceiverOverflow)
+{
+    IsoTpTransmitter& transmitter = IsoTpTransmitter::getInstance();
+    ASSERT_TRUE(transmitter.send(fds[0], TX_ID, createPayload(20), logger, callback()));
+    EXPECT_TRUE(transmitter.onFlowControl(flowControl(0x32, 0, 0)));
+    ASSERT_EQ(done.wait_for(std::chrono::milliseconds(0)), std::future_status::ready);
+    EXPECT_EQ(done.get(), IsoTpTransmitter::RECEIVER_OVERFLOW);
+    EXPECT_FALSE(transmitter.onFlowControl(flowControl(0x30, 0, 0)));
+}
+
+/* Test that the transmission ends after N_Bs without flow control frame */
+TEST_F(IsoTpTransmitterTest, FlowControlTimeout)
+{
+    IsoTpTransmitter& transmitter = IsoTpTransmitter::getInstance();
+    ASSERT_TRUE(transmitter.send(fds[0], TX_ID, createPayload(20), logger, callback()));
+    EXPECT_NE(done.wait_for(std::chrono::milliseconds(ISOTP_N_BS_TIMEOUT_MS / 2)), std::future_status::ready);
+    ASSERT_EQ(done.wait_for(std::chrono::milliseconds(ISOTP_N_BS_TIMEOUT_MS)), std::future_status::ready);
+    EXPECT_EQ(done.get(), IsoTpTransmitter::TIMEOUT);
+    EXPECT_EQ(transmitter.getActiveCount(), 0u);
+}
+
+/* Test that a new message on the same CAN id aborts the previous one */
+TEST_F(IsoTpTransmitterTest, ReplacedMessage)
+{
+    IsoTpTransmitter& transmitter = IsoTpTransmitter::getInstance();
+    ASSERT_TRUE(transmitter.send(fds[0], TX_ID, createPayload(20), logger, callback()));
+    std::promise<IsoTpTransmitter::TransmitStatus> second;
+    ASSERT_TRUE(transmitter.send(fds[0], TX_ID, createPayload(10), logger,
+        [&second](IsoTpTransmitter::TransmitStatus status) { second.set_value(status); }));
+    ASSERT_EQ(done.wait_for(std::chrono::milliseconds(0)), std::future_status::ready);
+    EXPECT_EQ(done.get(), IsoTpTransmitter::ABORTED);
+    EXPECT_TRUE(transmitter.onFlowControl(flowControl(0x30, 0, 0)));
+    EXPECT_EQ(second.get_future().get(), IsoTpTransmitter::COMPLETE);
+}
+
+/* Test that the frames for a CAN FD receiver carry up to 64 bytes */
+TEST_F(IsoTpTransmitterTest, CanFdFrames)
+{
+    IsoTpTransmitter& transmitter = IsoTpTransmitter::getInstance();
+    CanFd::setSocketFd(fds[0], true);
+    CanFd::setPeerFd(0x10, true);
+
+    /* 40 bytes fit in a CAN FD single frame, padded to 48 */
+    ASSERT_TRUE(transmitter.send(fds[0], TX_ID, createPayload(40), logger, callback()));
+    struct canfd_frame frame;
+    struct pollfd pfd = {fds[1], POLLIN, 0};
+    ASSERT_GT(poll(&pfd, 1, 200), 0);
+    ASSERT_EQ(read(fds[1], &frame, sizeof(frame)), static_cast<ssize_t>(CANFD_MTU));
+    EXPECT_EQ(frame.len, 48);
+    EXPECT_EQ(frame.data[0], 0x00);
+    EXPECT_EQ(frame.data[1], 40);
+    EXPECT_EQ(frame.data[2], 0x62);
+    EXPECT_EQ(frame.data[47], CAN_FD_PADDING);
+    EXPECT_EQ(done.get(), IsoTpTransmitter::COMPLETE);
+
+    /* 200 bytes: first frame with 62 bytes, then 63 + 63 + 12 */
+    std::promise<IsoTpTransmitter::TransmitStatus> second;
+    ASSERT_TRUE(transmitter.send(fds[0], TX_ID, createPayload(200), logger,
+        [&second](IsoTpTransmitter::TransmitStatus status) { second.set_value(status); }));
+    ASSERT_EQ(read(fds[1], &frame, sizeof(frame)), static_cast<ssize_t>(CANFD_MTU));
+    EXPECT_EQ(frame.len, CANFD_MAX_DLEN);
+    EXPECT_EQ(frame.data[0], 0x10);
+    EXPECT_EQ(frame.data[1], 200);
+    EXPECT_TRUE(transmitter.onFlowControl(flowControl(0x30, 0, 0)));
+    std::vector<uint8_t> lengths;
+    for (int index = 0; index < 3; ++index)
+    {
+        ASSERT_EQ(read(fds[1], &frame, sizeof(frame)), static_cast<ssize_t>(CANFD_MTU));
+        EXPECT_EQ(frame.data[0], 0x21 + index);
+        lengths.push_back(frame.len);
+    }
+    /* The last consecutive frame has 12 data bytes + PCI, padded to 16 */
+    EXPECT_EQ(lengths, std::vector<uint8_t>({64, 64, 16}));
+    EXPECT_EQ(frame.data[12], 199);
+    EXPECT_EQ(second.get_future().get(), IsoTpTransmitter::COMPLETE);
+    CanFd::reset();
+}
+
+/* Test the conversion of STmin to milliseconds */
+TEST(IsoTpTransmitterStMinTest, DecodeStMin)
+{
+    EXPECT_EQ(IsoTpTransmitter::decodeStMin(0x00), 0u);
+    EXPECT_EQ(IsoTpTransmitter::decodeStMin(0x7F), 127u);
+    EXPECT_EQ(IsoTpTransmitter::decodeStMin(0xF1), 1u);
+    EXPECT_EQ(IsoTpTransmitter::decodeStMin(0xF9), 1u);
+    EXPECT_EQ(IsoTpTransmitter::decodeStMin(0x80), 127u);
+}
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
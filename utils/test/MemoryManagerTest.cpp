@@ -62,6 +62,22 @@ TEST_F(MemoryManagerTest, WriteReadInAddress)
     EXPECT_EQ(data, data_from_address);
 }
 
+/* Test that the writes continue after the bytes kept on the device */
+TEST_F(MemoryManagerTest, SkipWrite)
+{
+    std::vector<uint8_t> kept = {97,98,99,100};
+    memory->writeToAddress(kept);
+    memory->setAddress(address);
+    std::vector<uint8_t> header = {1,2};
+    ASSERT_TRUE(memory->stageWrite(header.data(), header.size()));
+    EXPECT_TRUE(memory->skipWrite(2));
+    std::vector<uint8_t> data = {101,102};
+    ASSERT_TRUE(memory->stageWrite(data.data(), data.size()));
+    ASSERT_TRUE(memory->flushStagedWrites());
+    std::vector<uint8_t> expected_data = {1,2,99,100,101,102};
+    EXPECT_EQ(memory->readFromAddress(memory->getPath(),address,expected_data.size(), *logger), expected_data);
+}
+
 /* Test reading from an address with an invalid address */
 TEST_F(MemoryManagerTest, ReadFromAddress_ErrorTryingToRead) 
 {
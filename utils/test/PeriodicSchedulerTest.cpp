@@ -0,0 +1,172 @@
+/**
+ * @file PeriodicSchedulerTest.cpp
+ * @brief Unit test for PeriodicScheduler
+ * @version 0.1
+ * @date 2024-09-17
+ */
+#include "../include/PeriodicScheduler.h"
+#include "../include/DidStore.h"
+#include "../include/DynamicDidTable.h"
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <gtest/gtest.h>
+
+Logger logger;
+
+static const std::string TEST_FILE = "periodic_scheduler_test_data.db";
+/* Battery 0x11 pushing to the tester 0xFA */
+static const canid_t RESPONSE_ID = 0x11FA;
+
+struct PeriodicSchedulerTest : testing::Test
+{
+    int fds[2];
+    PeriodicScheduler& scheduler = PeriodicScheduler::getInstance();
+
+    PeriodicSchedulerTest()
+    {
+        socketpair(AF_UNIX, SOCK_DGRAM, 0, fds);
+        DidStore::restore(TEST_FILE, {{0x01A0, {0x30}}, {0x01B0, {0x0C, 0x80}}, {0x0100, {0x0B, 0xB8, 0x00, 0x01}}});
+        DidStore& store = DidStore::forFile(TEST_FILE);
+        store.set(0x01A0, {0x30});
+        store.set(0x01B0, {0x0C, 0x80});
+    }
+    ~PeriodicSchedulerTest()
+    {
+        scheduler.clear();
+        close(fds[0]);
+        close(fds[1]);
+    }
+    /* Read the next periodic frame, false if none within timeout_ms */
+    bool readFrame(struct can_frame& frame, int timeout_ms)
+    {
+        struct pollfd pfd = {fds[1], POLLIN, 0};
+        return poll(&pfd, 1, timeout_ms) > 0 && read(fds[1], &frame, sizeof(frame)) == sizeof(frame);
+    }
+    void drain()
+    {
+        struct can_frame frame;
+        while (readFrame(frame, 0))
+        {
+        }
+    }
+};
+
+/* Test the periodic frames carry the current value of the DID */
+TEST_F(PeriodicSchedulerTest, SendsPeriodicFrames)
+{
+    ASSERT_EQ(scheduler.subscribe(fds[0], RESPONSE_ID, TEST_FILE, {0x01B0}, PeriodicScheduler::FAST_RATE, logger),
+              PeriodicScheduler::ACCEPTED);
+    struct can_frame frame;
+    ASSERT_TRUE(readFrame(frame, 500));
+    EXPECT_EQ(frame.can_id & CAN_EFF_MASK, RESPONSE_ID);
+    EXPECT_EQ(frame.can_dlc, 6);
+    EXPECT_EQ(frame.data[0], 0x05);
+    EXPECT_EQ(frame.data[1], 0x6A);
+    EXPECT_EQ(frame.data[2], 0x01);
+    EXPECT_EQ(frame.data[3], 0xB0);
+    EXPECT_EQ(frame.data[4], 0x0C);
+    EXPECT_EQ(frame.data[5], 0x80);
+
+    /* A new value is sent on the next period */
+    DidStore::forFile(TEST_FILE).set(0x01B0, {0x0D, 0x00});
+    drain();
+    ASSERT_TRUE(readFrame(frame, 500));
+    EXPECT_EQ(frame.data[4], 0x0D);
+    EXPECT_EQ(frame.data[5], 0x00);
+}
+
+/* Test the DIDs of a rate go out in the same period */
+TEST_F(PeriodicSchedulerTest, SendsAllDIDsOfRate)
+{
+    ASSERT_EQ(scheduler.subscribe(fds[0], RESPONSE_ID, TEST_FILE, {0x01A0, 0x0100}, PeriodicScheduler::MEDIUM_RATE, logger),
+              PeriodicScheduler::ACCEPTED);
+    struct can_frame first, second;
+    ASSERT_TRUE(readFrame(first, 1000));
+    ASSERT_TRUE(readFrame(second, 50));
+    EXPECT_EQ(first.data[3], 0xA0);
+    EXPECT_EQ(first.can_dlc, 5);
+    EXPECT_EQ(second.data[3], 0x00);
+    EXPECT_EQ(second.can_dlc, 8);
+}
+
+/* Test a dynamically defined DID is sent with the value of its sources */
+TEST_F(PeriodicSchedulerTest, SendsDynamicDID)
+{
+    DynamicDidTable& table = DynamicDidTable::getInstance();
+    ASSERT_TRUE(table.defineByIdentifier(0x11, 0xF300, DidStore::forFile(TEST_FILE), {{0x01B0, 2, 1}, {0x01A0, 1, 1}}, logger));
+    ASSERT_EQ(scheduler.subscribe(fds[0], RESPONSE_ID, TEST_FILE, {0xF300}, PeriodicScheduler::FAST_RATE, logger),
+              PeriodicScheduler::ACCEPTED);
+    struct can_frame frame;
+    ASSERT_TRUE(readFrame(frame, 500));
+    EXPECT_EQ(frame.data[0], 0x05);
+    EXPECT_EQ(frame.data[2], 0xF3);
+    EXPECT_EQ(frame.data[3], 0x00);
+    EXPECT_EQ(frame.data[4], 0x80);
+    EXPECT_EQ(frame.data[5], 0x30);
+
+    /* No frame once the definition is cleared */
+    table.clear(0x11);
+    drain();
+    EXPECT_FALSE(readFrame(frame, 200));
+}
+
+/* Test no frame is sent once the DIDs are unsubscribed */
+TEST_F(PeriodicSchedulerTest, Unsubscribe)
+{
+    ASSERT_EQ(scheduler.subscribe(fds[0], RESPONSE_ID, TEST_FILE, {0x01A0, 0x01B0}, PeriodicScheduler::FAST_RATE, logger),
+              PeriodicScheduler::ACCEPTED);
+    EXPECT_EQ(scheduler.unsubscribe(RESPONSE_ID, {0x01A0}), 1u);
+    EXPECT_EQ(scheduler.getSubscriptionCount(), 1u);
+    /* Another tester keeps its DIDs */
+    EXPECT_EQ(scheduler.unsubscribe(0x12FA), 0u);
+    EXPECT_EQ(scheduler.unsubscribe(RESPONSE_ID), 1u);
+    EXPECT_EQ(scheduler.getSubscriptionCount(), 0u);
+    /* At most one tick was already running */
+    struct can_frame frame;
+    readFrame(frame, 100);
+    drain();
+    EXPECT_FALSE(readFrame(frame, 200));
+}
+
+/* Test a DID subscribed again only changes its rate */
+TEST_F(PeriodicSchedulerTest, Resubscribe)
+{
+    ASSERT_EQ(scheduler.subscribe(fds[0], RESPONSE_ID, TEST_FILE, {0x01A0}, PeriodicScheduler::SLOW_RATE, logger),
+              PeriodicScheduler::ACCEPTED);
+    EXPECT_EQ(scheduler.getFramesPerSecond(), 1u);
+    ASSERT_EQ(scheduler.subscribe(fds[0], RESPONSE_ID, TEST_FILE, {0x01A0}, PeriodicScheduler::FAST_RATE, logger),
+              PeriodicScheduler::ACCEPTED);
+    EXPECT_EQ(scheduler.getSubscriptionCount(), 1u);
+    EXPECT_EQ(scheduler.getFramesPerSecond(), 1000u / PERIODIC_FAST_RATE_MS);
+}
+
+/* Test the bus budget and the DID cap refuse the whole request */
+TEST_F(PeriodicSchedulerTest, Limits)
+{
+    std::vector<uint16_t> dids;
+    for (uint16_t did = 0x01A0; dids.size() * (1000 / PERIODIC_FAST_RATE_MS) <= PERIODIC_MAX_FRAMES_PER_SECOND; ++did)
+    {
+        dids.push_back(did);
+    }
+    EXPECT_EQ(scheduler.subscribe(fds[0], RESPONSE_ID, TEST_FILE, dids, PeriodicScheduler::FAST_RATE, logger),
+              PeriodicScheduler::BUDGET_EXCEEDED);
+    EXPECT_EQ(scheduler.getSubscriptionCount(), 0u);
+
+    dids.clear();
+    for (uint16_t did = 0x01A0; dids.size() <= PERIODIC_MAX_DIDS; ++did)
+    {
+        dids.push_back(did);
+    }
+    EXPECT_EQ(scheduler.subscribe(fds[0], RESPONSE_ID, TEST_FILE, dids, PeriodicScheduler::SLOW_RATE, logger),
+              PeriodicScheduler::TOO_MANY_DIDS);
+    EXPECT_EQ(scheduler.getSubscriptionCount(), 0u);
+}
+
+int main(int argc, char* argv[])
+{
+    testing::InitGoogleTest(&argc, argv);
+    int result = RUN_ALL_TESTS();
+    std::remove(TEST_FILE.c_str());
+    return result;
+}
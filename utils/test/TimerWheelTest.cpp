@@ -0,0 +1,109 @@
+/**
+ * @file TimerWheelTest.cpp
+ * @brief Unit test for TimerWheel
+ * @version 0.1
+ * @date 2024-08-26
+ */
+#include "../include/TimerWheel.h"
+
+#include <chrono>
+#include <gtest/gtest.h>
+
+struct TimerWheelTest : testing::Test
+{
+    TimerWheel wheel;
+    TimerWheelTest() : wheel(5, 16)
+    {
+        wheel.start();
+    }
+    ~TimerWheelTest()
+    {
+        wheel.stop();
+    }
+    /* Wait until the condition is true or the timeout elapses */
+    template <typename Condition>
+    static bool waitFor(Condition condition, int timeout_ms)
+    {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+        while (!condition() && std::chrono::steady_clock::now() < deadline)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return condition();
+    }
+};
+
+TEST_F(TimerWheelTest, ScheduleWhenStopped)
+{
+    TimerWheel stopped_wheel;
+    EXPECT_FALSE(stopped_wheel.isRunning());
+    EXPECT_FALSE(stopped_wheel.schedule(10, [] { return true; }, [] {}));
+}
+
+TEST_F(TimerWheelTest, ExpiresNotBeforeDeadline)
+{
+    std::atomic<bool> fired{false};
+    auto start = std::chrono::steady_clock::now();
+    std::chrono::steady_clock::time_point fired_at;
+    ASSERT_TRUE(wheel.schedule(50, [] { return true; }, [&] {
+        fired_at = std::chrono::steady_clock::now();
+        fired = true;
+    }));
+    EXPECT_EQ(wheel.getPendingCount(), 1u);
+    ASSERT_TRUE(waitFor([&] { return fired.load(); }, 1000));
+    EXPECT_GE(std::chrono::duration_cast<std::chrono::milliseconds>(fired_at - start).count(), 50);
+    EXPECT_EQ(wheel.getPendingCount(), 0u);
+}
+
+TEST_F(TimerWheelTest, CancelledByFlag)
+{
+    std::atomic<bool> pending{true};
+    std::atomic<bool> fired{false};
+    ASSERT_TRUE(wheel.schedule(30, [&] { return pending.load(); }, [&] { fired = true; }));
+    /* Cancel like AccessTimingParameter::stopTimingFlag does */
+    pending = false;
+    ASSERT_TRUE(waitFor([&] { return wheel.getPendingCount() == 0; }, 1000));
+    EXPECT_FALSE(fired);
+}
+
+TEST_F(TimerWheelTest, DeadlinesLongerThanOneRound)
+{
+    /* 16 slots of 5 ms: 200 ms wraps the wheel more than twice */
+    std::atomic<int> order{0};
+    std::atomic<int> short_position{0};
+    std::atomic<int> long_position{0};
+    wheel.schedule(200, [] { return true; }, [&] { long_position = ++order; });
+    wheel.schedule(20, [] { return true; }, [&] { short_position = ++order; });
+    ASSERT_TRUE(waitFor([&] { return order == 2; }, 2000));
+    EXPECT_EQ(short_position, 1);
+    EXPECT_EQ(long_position, 2);
+}
+
+TEST_F(TimerWheelTest, CallbackCanScheduleAgain)
+{
+    std::atomic<int> fired{0};
+    wheel.schedule(10, [] { return true; }, [&] {
+        fired++;
+        wheel.schedule(10, [] { return true; }, [&] { fired++; });
+    });
+    ASSERT_TRUE(waitFor([&] { return fired == 2; }, 1000));
+}
+
+TEST_F(TimerWheelTest, StopDropsPendingDeadlines)
+{
+    std::atomic<bool> fired{false};
+    wheel.schedule(500, [] { return true; }, [&] { fired = true; });
+    wheel.stop();
+    EXPECT_FALSE(wheel.isRunning());
+    EXPECT_EQ(wheel.getPendingCount(), 0u);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    EXPECT_FALSE(fired);
+    /* The wheel can be started again */
+    EXPECT_TRUE(wheel.start());
+}
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
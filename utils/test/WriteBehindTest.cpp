@@ -0,0 +1,89 @@
+/**
+ * @file WriteBehindTest.cpp
+ * @brief Unit test for WriteBehind, on an image file
+ * @version 0.1
+ * @date 2024-09-05
+ */
+#include "../include/WriteBehind.h"
+
+#include <gtest/gtest.h>
+#include <fstream>
+
+Logger* logger = new Logger("test", "test_write_behind.log");
+const std::string image_path = "test_write_behind.img";
+
+struct WriteBehindTest : testing::Test
+{
+    DeviceSession device;
+    WriteBehindTest()
+    {
+        std::ofstream(image_path, std::ios::out | std::ios::trunc).close();
+        truncate(image_path.c_str(), 2 * 1024 * 1024);
+        device.open(image_path, *logger);
+    }
+    ~WriteBehindTest()
+    {
+        device.close();
+        std::remove(image_path.c_str());
+    }
+};
+
+/* Test that small unaligned blocks are coalesced and all of them are on the device after flush */
+TEST_F(WriteBehindTest, CoalescedBlocks)
+{
+    WriteBehind write_behind(*logger);
+    const off_t address = 1000;
+    /* More data than the queued buffers can hold, the appends wait for the I/O thread */
+    std::vector<uint8_t> image((WRITE_BEHIND_MAX_BUFFERS + 2) * WRITE_BEHIND_BUFFER_BYTES + 123);
+    for (size_t index = 0; index < image.size(); ++index)
+    {
+        image[index] = static_cast<uint8_t>(index % 251);
+    }
+
+    write_behind.begin(device, address);
+    for (size_t offset = 0; offset < image.size(); offset += 4093)
+    {
+        size_t size = std::min<size_t>(4093, image.size() - offset);
+        ASSERT_TRUE(write_behind.append(image.data() + offset, size));
+    }
+    EXPECT_TRUE(write_behind.hasPending());
+    EXPECT_TRUE(write_behind.flush());
+    EXPECT_FALSE(write_behind.hasPending());
+
+    std::vector<uint8_t> data(image.size());
+    ASSERT_TRUE(device.read(address, data.data(), data.size()));
+    EXPECT_EQ(data, image);
+}
+
+/* Test that a failed write is reported by flush and by the next appends */
+TEST_F(WriteBehindTest, WriteFailure)
+{
+    WriteBehind write_behind(*logger);
+    std::vector<uint8_t> block(WRITE_BEHIND_BUFFER_BYTES, 0xAB);
+    write_behind.begin(device, 0);
+    device.close();
+    EXPECT_TRUE(write_behind.append(block.data(), 10));
+    EXPECT_FALSE(write_behind.flush());
+    EXPECT_FALSE(write_behind.append(block.data(), block.size()));
+
+    /* A new transfer starts without the error */
+    ASSERT_TRUE(device.open(image_path, *logger));
+    write_behind.begin(device, 0);
+    EXPECT_TRUE(write_behind.append(block.data(), 10));
+    EXPECT_TRUE(write_behind.flush());
+}
+
+/* Test that nothing is staged before begin */
+TEST_F(WriteBehindTest, AppendBeforeBegin)
+{
+    WriteBehind write_behind(*logger);
+    uint8_t byte = 0;
+    EXPECT_FALSE(write_behind.append(&byte, 1));
+    EXPECT_TRUE(write_behind.flush());
+}
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}